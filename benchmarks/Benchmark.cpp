@@ -0,0 +1,189 @@
+#include "Benchmark.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/Utils.hpp>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+#endif
+
+namespace Slic3r {
+namespace Benchmarks {
+
+static double wall_clock()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of all the threads of the process, user and system.
+static double process_cpu_time()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (! ::GetProcessTimes(::GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0.;
+    auto seconds = [](const FILETIME &t) { return double((uint64_t(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7; };
+    return seconds(kernel) + seconds(user);
+#else
+    rusage usage;
+    if (::getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.;
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + 1e-6 * double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#endif
+}
+
+// CPU time of the individual threads, read from /proc. The resolution is a clock tick, usually 10ms.
+static std::map<int64_t, double> thread_cpu_times()
+{
+    std::map<int64_t, double> out;
+#ifdef __linux__
+    static const double tick = 1. / double(::sysconf(_SC_CLK_TCK));
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it("/proc/self/task", ec), end; ! ec && it != end; it.increment(ec)) {
+        std::ifstream file((it->path() / "stat").string());
+        std::string   stat;
+        std::getline(file, stat);
+        // The thread name in parentheses may contain spaces, the fields are counted from the closing parenthesis.
+        // utime and stime are the 14th and 15th fields, the state following the name is the 3rd one.
+        size_t name_end = stat.rfind(')');
+        if (name_end == std::string::npos)
+            continue;
+        std::istringstream fields(stat.substr(name_end + 1));
+        std::string        field;
+        for (int i = 3; i < 14 && fields >> field; ++ i) ;
+        unsigned long long utime = 0, stime = 0;
+        if (fields >> utime >> stime)
+            out[std::atoll(it->path().filename().string().c_str())] = double(utime + stime) * tick;
+    }
+#endif
+    return out;
+}
+
+void Bench::start()
+{
+    m_start.thread_cpu_time = thread_cpu_times();
+    m_start.cpu_time        = process_cpu_time();
+    m_start.wall_time       = wall_clock();
+}
+
+void Bench::stop()
+{
+    Sample sample;
+    sample.wall_time = wall_clock() - m_start.wall_time;
+    sample.cpu_time  = process_cpu_time() - m_start.cpu_time;
+    for (const auto &[tid, time] : thread_cpu_times()) {
+        auto   it    = m_start.thread_cpu_time.find(tid);
+        double delta = time - (it == m_start.thread_cpu_time.end() ? 0. : it->second);
+        if (delta > 0.)
+            sample.thread_cpu_time[tid] = delta;
+    }
+    m_samples.emplace_back(std::move(sample));
+}
+
+static std::vector<BenchmarkCase>& benchmark_registry()
+{
+    static std::vector<BenchmarkCase> registry;
+    return registry;
+}
+
+void register_benchmark(const std::string &name, BenchmarkFn fn)
+{
+    benchmark_registry().push_back({ name, std::move(fn) });
+}
+
+const std::vector<BenchmarkCase>& registered_benchmarks()
+{
+    return benchmark_registry();
+}
+
+bool reset_peak_rss()
+{
+#ifdef __linux__
+    // Writing 5 to clear_refs resets the peak resident set size (VmHWM) to the current resident set size.
+    std::ofstream file("/proc/self/clear_refs");
+    file << "5";
+    file.close();
+    return bool(file);
+#else
+    return false;
+#endif
+}
+
+size_t peak_rss()
+{
+#ifdef __linux__
+    std::ifstream file("/proc/self/status");
+    for (std::string line; std::getline(file, line);)
+        if (boost::starts_with(line, "VmHWM:"))
+            return size_t(std::atoll(line.c_str() + 6)) * 1024;
+#endif
+    return peak_memory_usage();
+}
+
+size_t current_rss()
+{
+#ifdef __linux__
+    std::ifstream file("/proc/self/status");
+    for (std::string line; std::getline(file, line);)
+        if (boost::starts_with(line, "VmRSS:"))
+            return size_t(std::atoll(line.c_str() + 6)) * 1024;
+#endif
+    return 0;
+}
+
+const std::vector<std::string>& default_models()
+{
+    static const std::vector<std::string> models { "extruder_idler", "frog_legs", "A" };
+    return models;
+}
+
+std::string data_path(const std::string &file_name)
+{
+    return (boost::filesystem::path(BENCHMARK_DATA_DIR) / file_name).string();
+}
+
+Model load_model(const std::string &name)
+{
+    Model model = Model::read_from_file(data_path(name + ".obj"));
+    for (ModelObject *object : model.objects)
+        object->ensure_on_bed();
+    model.center_instances_around_point({ 100., 100. });
+    return model;
+}
+
+DynamicPrintConfig print_config(std::initializer_list<ConfigBase::SetDeserializeItem> items)
+{
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict(items);
+    return config;
+}
+
+std::unique_ptr<Print> process_print(const Model &model, const DynamicPrintConfig &config)
+{
+    auto print = std::make_unique<Print>();
+    print->apply(model, config);
+    print->validate();
+    print->set_status_silent();
+    print->process();
+    return print;
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
@@ -0,0 +1,109 @@
+#ifndef slic3r_benchmarks_Benchmark_hpp_
+#define slic3r_benchmarks_Benchmark_hpp_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <libslic3r/PrintConfig.hpp>
+
+namespace Slic3r {
+
+class Model;
+class Print;
+
+namespace Benchmarks {
+
+// Resources consumed by a single run of a benchmark.
+struct Sample
+{
+    double                      wall_time { 0. };
+    // CPU time of all the threads of the process.
+    double                      cpu_time  { 0. };
+    // CPU time per thread ID, only the threads which were running during the measurement.
+    // Empty on platforms, where the CPU time of the individual threads is not available.
+    std::map<int64_t, double>   thread_cpu_time;
+};
+
+// Passed to a benchmark, which prepares its input data and then calls run() with the code to be measured.
+class Bench
+{
+public:
+    explicit Bench(size_t repetitions) : m_repetitions(repetitions) {}
+
+    // Measures fn repetitions times.
+    template<typename Fn>
+    void run(Fn &&fn) { this->run([]{}, std::forward<Fn>(fn)); }
+
+    // Measures fn repetitions times, calling prepare before each measurement to reset the state modified by fn.
+    template<typename Prepare, typename Fn>
+    void run(Prepare &&prepare, Fn &&fn) {
+        for (size_t i = 0; i < m_repetitions; ++ i) {
+            prepare();
+            this->start();
+            fn();
+            this->stop();
+        }
+    }
+
+    // Records a property of the input data, for example the number of layers, reported together with the timings.
+    void counter(const std::string &name, double value) { m_counters[name] = value; }
+
+    const std::vector<Sample>&              samples()  const { return m_samples; }
+    const std::map<std::string, double>&    counters() const { return m_counters; }
+
+private:
+    void start();
+    void stop();
+
+    size_t                                  m_repetitions;
+    std::vector<Sample>                     m_samples;
+    std::map<std::string, double>           m_counters;
+    // State at start().
+    Sample                                  m_start;
+};
+
+using BenchmarkFn = std::function<void(Bench&)>;
+
+struct BenchmarkCase
+{
+    std::string name;
+    BenchmarkFn fn;
+};
+
+void                                register_benchmark(const std::string &name, BenchmarkFn fn);
+const std::vector<BenchmarkCase>&   registered_benchmarks();
+
+// Each source file of the suite registers its benchmarks through one of these, called in this order by main().
+void register_slicing_benchmarks();
+void register_print_benchmarks();
+void register_io_benchmarks();
+void register_sla_benchmarks();
+void register_placeholder_parser_benchmarks();
+
+// Resets the peak resident memory of the process to the current resident memory.
+// Returns false if not supported on this platform, then peak_rss() returns the peak of the whole process lifetime.
+bool reset_peak_rss();
+size_t peak_rss();
+// Current resident memory of the process, zero if not supported on this platform.
+size_t current_rss();
+
+// Models from tests/data used by the benchmarks by default.
+const std::vector<std::string>& default_models();
+// Full path to a file in tests/data.
+std::string data_path(const std::string &file_name);
+// Loads tests/data/<name>.obj, centered on the default bed.
+Model load_model(const std::string &name);
+// Full print config with the given values applied.
+DynamicPrintConfig print_config(std::initializer_list<ConfigBase::SetDeserializeItem> items = {});
+// Print of the model, processed up to the G-code export.
+std::unique_ptr<Print> process_print(const Model &model, const DynamicPrintConfig &config);
+
+} // namespace Benchmarks
+} // namespace Slic3r
+
+#endif // slic3r_benchmarks_Benchmark_hpp_
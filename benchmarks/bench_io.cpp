@@ -0,0 +1,65 @@
+#include "Benchmark.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Exception.hpp>
+#include <libslic3r/Format/3mf.hpp>
+#include <libslic3r/Format/STL.hpp>
+#include <libslic3r/Model.hpp>
+
+// Benchmarks of loading the models from tests/data converted to binary and ASCII STL and to 3MF.
+
+namespace Slic3r {
+namespace Benchmarks {
+
+// Directory with the converted models, removed once the benchmark finishes.
+struct TemporaryDirectory
+{
+    TemporaryDirectory() : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("benchmark-%%%%-%%%%"))
+        { boost::filesystem::create_directory(path); }
+    ~TemporaryDirectory() { boost::system::error_code ec; boost::filesystem::remove_all(path, ec); }
+    boost::filesystem::path path;
+};
+
+static void bench_load_stl(Bench &b, const std::string &model_name, bool binary)
+{
+    TemporaryDirectory dir;
+    const std::string  path  = (dir.path / (model_name + ".stl")).string();
+    Model              model = load_model(model_name);
+    if (! store_stl(path.c_str(), &model, binary))
+        throw RuntimeError("Failed to store " + path);
+    b.counter("bytes", double(boost::filesystem::file_size(path)));
+    b.run(
+        [&model]() { model.clear_objects(); },
+        [&model, &path]() { load_stl(path.c_str(), &model); });
+}
+
+static void bench_load_3mf(Bench &b, const std::string &model_name)
+{
+    TemporaryDirectory dir;
+    const std::string  path   = (dir.path / (model_name + ".3mf")).string();
+    Model              model  = load_model(model_name);
+    DynamicPrintConfig config = print_config();
+    if (! store_3mf(path.c_str(), &model, &config, false))
+        throw RuntimeError("Failed to store " + path);
+    b.counter("bytes", double(boost::filesystem::file_size(path)));
+    b.run(
+        [&model, &config]() { model.clear_objects(); config.clear(); },
+        [&model, &config, &path]() {
+            ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+            load_3mf(path.c_str(), config, ctxt, &model, false);
+        });
+}
+
+void register_io_benchmarks()
+{
+    for (const std::string &model : default_models()) {
+        register_benchmark("load_stl/binary/" + model, [model](Bench &b) { bench_load_stl(b, model, true); });
+        register_benchmark("load_stl/ascii/" + model, [model](Bench &b) { bench_load_stl(b, model, false); });
+        register_benchmark("load_3mf/" + model, [model](Bench &b) { bench_load_3mf(b, model); });
+    }
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
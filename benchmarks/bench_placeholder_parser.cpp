@@ -0,0 +1,74 @@
+#include "Benchmark.hpp"
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/PlaceholderParser.hpp>
+
+// Benchmarks of the evaluation of custom G-code templates, comparing the compiled programs with parsing the template
+// on each invocation, as done for the layer change and tool change templates of a tall multi-material print.
+
+namespace Slic3r {
+namespace Benchmarks {
+
+struct Template
+{
+    const char *name;
+    const char *text;
+};
+
+static const Template g_templates[] = {
+    { "layer_gcode",
+        ";AFTER_LAYER_CHANGE\n;Z:[layer_z]\n;HEIGHT:{layer_z - max(0, layer_num - 1) * layer_height}\n"
+        "M117 Layer {layer_num + 1} of {total_layer_count}\nG92 E0.0\n" },
+    { "before_layer_gcode",
+        ";BEFORE_LAYER_CHANGE\nG92 E0.0\n;[layer_z]\n"
+        "{if layer_num == 1}M106 S{max_fan_speed[0]}{elsif layer_z > 10}M220 S{speed_factor}{endif}\n"
+        "M104 S[temperature] T[current_extruder]\n" },
+    { "toolchange_gcode",
+        "; Change tool from {previous_extruder} to {next_extruder}\n"
+        "{local retract = retract_length[previous_extruder] + 0.5}\n"
+        "G1 E-{retract} F{retract_speed[previous_extruder] * 60}\n"
+        "{if next_extruder >= 0}M109 S{temperature[next_extruder]} T{next_extruder}{endif}\n"
+        "{if layer_z > 0.3}M204 S{max(500, 2000 - layer_num)}{else}M204 S800{endif}\n"
+        "T{next_extruder}\nG1 E{retract} F2400\n" },
+};
+
+static void bench_placeholder_parser(Bench &b, const Template &templ, bool compiled)
+{
+    // Number of evaluations, one per layer of a tall print.
+    static constexpr int num_layers = 3000;
+
+    PlaceholderParser parser;
+    parser.apply_config(print_config({ { "nozzle_diameter", "0.4,0.4,0.4,0.4" }, { "temperature", "215,240,230,250" } }));
+    parser.set("total_layer_count", num_layers);
+    parser.set("speed_factor", 100);
+    b.counter("evaluations", double(num_layers));
+
+    const std::string  text(templ.text);
+    const auto         program = PlaceholderParser::compile(text);
+    DynamicConfig      config;
+    size_t             output_size = 0;
+    b.run([&]() {
+        for (int layer_num = 0; layer_num < num_layers; ++ layer_num) {
+            config.set_key_value("layer_num",         new ConfigOptionInt(layer_num));
+            config.set_key_value("layer_z",           new ConfigOptionFloat(0.2 + 0.15 * layer_num));
+            config.set_key_value("current_extruder",  new ConfigOptionInt(layer_num % 4));
+            config.set_key_value("previous_extruder", new ConfigOptionInt(layer_num % 4));
+            config.set_key_value("next_extruder",     new ConfigOptionInt((layer_num + 1) % 4));
+            output_size += compiled ?
+                parser.process(*program, layer_num % 4, &config, nullptr, nullptr).size() :
+                parser.interpret(text, layer_num % 4, &config, nullptr, nullptr).size();
+        }
+    });
+    b.counter("output_bytes", double(output_size));
+}
+
+void register_placeholder_parser_benchmarks()
+{
+    for (const Template &templ : g_templates) {
+        register_benchmark(std::string("placeholder_parser/interpret/") + templ.name, [&templ](Bench &b) { bench_placeholder_parser(b, templ, false); });
+        register_benchmark(std::string("placeholder_parser/compiled/") + templ.name, [&templ](Bench &b) { bench_placeholder_parser(b, templ, true); });
+    }
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
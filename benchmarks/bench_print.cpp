@@ -0,0 +1,89 @@
+#include "Benchmark.hpp"
+
+#include <boost/filesystem.hpp>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/GCode/GCodeProcessor.hpp>
+#include <libslic3r/GCode/SeamPlacer.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/Support/TreeSupport.hpp>
+
+// Benchmarks of the steps of Print following the per layer steps of PrintObject: seam placement, tree supports,
+// G-code generation and the G-code processor.
+
+namespace Slic3r {
+namespace Benchmarks {
+
+// G-code file removed once the benchmark finishes.
+struct TemporaryGCode
+{
+    TemporaryGCode() : path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("benchmark-%%%%-%%%%.gcode")).string()) {}
+    ~TemporaryGCode() { boost::system::error_code ec; boost::filesystem::remove(path, ec); }
+    std::string path;
+};
+
+static void bench_seam_placer(Bench &b, const std::string &model_name)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config({ { "seam_position", "aligned" } }));
+    b.counter("layers", double(print->objects().front()->layer_count()));
+    b.run([&print]() {
+        SeamPlacer seam_placer;
+        seam_placer.init(*print, []() {});
+    });
+}
+
+static void bench_tree_support(Bench &b, const std::string &model_name)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name),
+        print_config({ { "support_material", "1" }, { "support_material_style", "organic" } }));
+    PrintObject &object = *print->objects_mutable().front();
+    b.counter("layers", double(object.layer_count()));
+    b.counter("support_layers", double(object.support_layer_count()));
+    b.run(
+        [&object]() { object.clear_support_layers(); },
+        [&object]() { fff_tree_support_generate(object); });
+}
+
+static void bench_gcode_export(Bench &b, const std::string &model_name)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config());
+    TemporaryGCode gcode;
+    b.counter("layers", double(print->objects().front()->layer_count()));
+    b.run([&print, &gcode]() {
+        GCodeProcessorResult result;
+        print->export_gcode(gcode.path, &result);
+    });
+}
+
+static void bench_gcode_processor(Bench &b, const std::string &model_name)
+{
+    TemporaryGCode gcode;
+    {
+        std::unique_ptr<Print> print = process_print(load_model(model_name), print_config());
+        GCodeProcessorResult result;
+        print->export_gcode(gcode.path, &result);
+    }
+    b.counter("bytes", double(boost::filesystem::file_size(gcode.path)));
+    b.run([&gcode]() {
+        GCodeProcessor processor;
+        processor.process_file(gcode.path);
+    });
+}
+
+void register_print_benchmarks()
+{
+    for (const std::string &model : default_models())
+        register_benchmark("seam_placer/" + model, [model](Bench &b) { bench_seam_placer(b, model); });
+    // Models with overhangs.
+    for (const std::string &model : { "frog_legs", "A_upsidedown" })
+        register_benchmark("tree_support/" + model, [model](Bench &b) { bench_tree_support(b, model); });
+    // Including GCode::process_layers() and the GCodeProcessor running on the G-code being generated.
+    for (const std::string &model : default_models())
+        register_benchmark("gcode_export/" + model, [model](Bench &b) { bench_gcode_export(b, model); });
+    for (const std::string &model : default_models())
+        register_benchmark("gcode_processor/" + model, [model](Bench &b) { bench_gcode_processor(b, model); });
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
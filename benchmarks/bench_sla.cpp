@@ -0,0 +1,58 @@
+#include "Benchmark.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/TriangleMeshSlicer.hpp>
+#include <libslic3r/SLA/RasterBase.hpp>
+
+// Benchmarks of the rasterization of SLA layers into the images of an SL1 archive.
+
+namespace Slic3r {
+namespace Benchmarks {
+
+// Rasterizes the slices of the model for a display of the Original Prusa SL1, optionally encoding the images to PNG.
+static void bench_sla_raster(Bench &b, const std::string &model_name, bool encode)
+{
+    TriangleMesh mesh = load_model(model_name).mesh();
+    const BoundingBoxf3 bbox = mesh.bounding_box();
+    mesh.translate(- float(bbox.center().x()), - float(bbox.center().y()), 0.f);
+    std::vector<float> zs;
+    for (double z = 0.025; z < bbox.max.z(); z += 0.05)
+        zs.emplace_back(float(z));
+    const std::vector<ExPolygons> slices = slice_mesh_ex(mesh.its, zs);
+    b.counter("layers", double(slices.size()));
+
+    const double           display_w = 120.96, display_h = 68.04;
+    const sla::Resolution  resolution { 2560, 1440 };
+    const sla::PixelDim    pixel_dim { display_w / double(resolution.width_px), display_h / double(resolution.height_px) };
+    sla::RasterBase::Trafo trafo;
+    trafo.center_x = scaled(0.5 * display_w);
+    trafo.center_y = scaled(0.5 * display_h);
+
+    b.run([&slices, &resolution, &pixel_dim, &trafo, encode]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, slices.size()),
+            [&slices, &resolution, &pixel_dim, &trafo, encode](const tbb::blocked_range<size_t> &range) {
+                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                    std::unique_ptr<sla::RasterBase> raster = sla::create_raster_grayscale_aa(resolution, pixel_dim, 1.0, trafo);
+                    for (const ExPolygon &expoly : slices[layer_idx])
+                        raster->draw(expoly);
+                    if (encode)
+                        raster->encode(sla::FastPNGRasterEncoder{});
+                }
+            });
+    });
+}
+
+void register_sla_benchmarks()
+{
+    for (const std::string &model : default_models()) {
+        register_benchmark("sla_raster/" + model, [model](Bench &b) { bench_sla_raster(b, model, false); });
+        register_benchmark("sla_raster/png/" + model, [model](Bench &b) { bench_sla_raster(b, model, true); });
+    }
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
@@ -0,0 +1,238 @@
+#include "Benchmark.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Arachne/WallToolPaths.hpp>
+#include <libslic3r/Fill/FillLightning.hpp>
+#include <libslic3r/Layer.hpp>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/TriangleMeshSlicer.hpp>
+
+// Benchmarks of the slicing of a mesh and of the per layer steps of PrintObject: perimeters and infill.
+// The per layer steps are measured on a processed Print, so that their input is the one of the real slicing.
+
+namespace Slic3r {
+namespace Benchmarks {
+
+static void for_each_layer(PrintObject &object, const std::function<void(Layer&)> &fn)
+{
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, object.layer_count()),
+        [&object, &fn](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                fn(*object.get_layer(int(layer_idx)));
+        });
+}
+
+static void bench_slice_mesh_ex(Bench &b, const std::string &model_name)
+{
+    TriangleMesh mesh = load_model(model_name).mesh();
+    std::vector<float> zs;
+    for (double z = 0.1; z < mesh.bounding_box().max.z(); z += 0.2)
+        zs.emplace_back(float(z));
+    b.counter("triangles", double(mesh.facets_count()));
+    b.counter("layers", double(zs.size()));
+
+    MeshSlicingParamsEx params;
+    params.closing_radius = 0.049;
+    b.run([&mesh, &zs, &params]() {
+        std::vector<ExPolygons> slices = slice_mesh_ex(mesh.its, zs, params);
+    });
+}
+
+static void bench_perimeters(Bench &b, const std::string &model_name, const char *perimeter_generator)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config({ { "perimeter_generator", perimeter_generator } }));
+    PrintObject &object = *print->objects_mutable().front();
+    b.counter("layers", double(object.layer_count()));
+    b.run([&object]() {
+        for_each_layer(object, [](Layer &layer) { layer.make_perimeters(); });
+    });
+}
+
+static void bench_wall_tool_paths(Bench &b, const std::string &model_name)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config());
+    const PrintObject &object = *print->objects().front();
+    // Inputs of the Arachne wall generator, one per slice.
+    struct Outline {
+        Polygons  polygons;
+        coord_t   spacing;
+        coordf_t  layer_height;
+    };
+    std::vector<Outline> outlines;
+    for (const Layer *layer : object.layers())
+        for (const LayerRegion *layerm : layer->regions())
+            for (const Surface &surface : layerm->slices())
+                outlines.push_back({ to_polygons(surface.expolygon), layerm->flow(frPerimeter).scaled_spacing(), layer->height });
+    b.counter("outlines", double(outlines.size()));
+
+    const PrintObjectConfig &object_config = object.config();
+    const PrintConfig       &config        = print->config();
+    b.run([&outlines, &object_config, &config]() {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, outlines.size()),
+            [&outlines, &object_config, &config](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i) {
+                    const Outline &outline = outlines[i];
+                    Arachne::WallToolPaths wall_tool_paths(outline.polygons, outline.spacing, outline.spacing, 3, 0, outline.layer_height, object_config, config);
+                    wall_tool_paths.generate();
+                }
+            });
+    });
+}
+
+static void bench_fill(Bench &b, const std::string &model_name, const char *pattern)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config({ { "fill_pattern", pattern }, { "fill_density", "20%" } }));
+    PrintObject &object = *print->objects_mutable().front();
+    b.counter("layers", double(object.layer_count()));
+    b.run([&object]() {
+        for_each_layer(object, [](Layer &layer) { layer.make_fills(); });
+    });
+}
+
+// Generation of the perimeters and infill of all layers, replacing the extrusions of the previous run.
+// Most of the extrusion entities of a print are allocated and released here.
+static void bench_extrusions(Bench &b, const std::string &model_name)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config());
+    PrintObject &object = *print->objects_mutable().front();
+    auto arena_stats = [&object]() {
+        std::pair<size_t, size_t> out { 0, 0 };
+        for (const Layer *layer : object.layers()) {
+            out.first  += layer->extrusion_arena().num_allocations();
+            out.second += layer->extrusion_arena().num_blocks();
+        }
+        return out;
+    };
+    const std::pair<size_t, size_t> stats_before = arena_stats();
+    b.counter("layers", double(object.layer_count()));
+    b.run([&object]() {
+        for_each_layer(object, [](Layer &layer) { layer.make_perimeters(); layer.make_fills(); });
+    });
+    // Summed over all runs: extrusion entities allocated and the heap allocations of the arena blocks serving them.
+    const std::pair<size_t, size_t> stats = arena_stats();
+    b.counter("entity_allocations", double(stats.first - stats_before.first));
+    b.counter("arena_blocks", double(stats.second - stats_before.second));
+}
+
+// Point storage of extrusions: number of points, bytes of the points and of the optional Z of nonplanar polylines.
+struct PointStorage
+{
+    size_t points      { 0 };
+    size_t point_bytes { 0 };
+    size_t z_bytes     { 0 };
+};
+
+static void collect_point_storage(const ExtrusionEntity &entity, PointStorage &out)
+{
+    auto add_path = [&out](const ExtrusionPath &path) {
+        out.points      += path.polyline.points.size();
+        out.point_bytes += path.polyline.points.capacity() * sizeof(Point);
+        out.z_bytes     += path.polyline.z.capacity() * sizeof(coord_t);
+    };
+    if (const auto *collection = dynamic_cast<const ExtrusionEntityCollection*>(&entity)) {
+        for (const ExtrusionEntity *child : collection->entities)
+            collect_point_storage(*child, out);
+    } else if (const auto *loop = dynamic_cast<const ExtrusionLoop*>(&entity)) {
+        for (const ExtrusionPath &path : loop->paths)
+            add_path(path);
+    } else if (const auto *multipath = dynamic_cast<const ExtrusionMultiPath*>(&entity)) {
+        for (const ExtrusionPath &path : multipath->paths)
+            add_path(path);
+    } else if (const auto *path = dynamic_cast<const ExtrusionPath*>(&entity))
+        add_path(*path);
+}
+
+// Resident memory of the extrusions of a planar print, measured by copying all of them.
+// The point storage counters are exact, the resident memory depends on the memory reused by the allocators.
+// Before the nonplanar Z was moved from Point to the optional Polyline::z, every point carried its Z,
+// the point storage of that layout is reported as point_bytes_with_z_in_point for comparison.
+// The test models are small, thus they are also measured scaled up to the size of a typical print.
+static void bench_extrusion_memory(Bench &b, const std::string &model_name, double scale)
+{
+    Model model = load_model(model_name);
+    for (ModelObject *object : model.objects) {
+        object->scale(scale);
+        object->ensure_on_bed();
+    }
+    model.center_instances_around_point({ 100., 100. });
+    std::unique_ptr<Print> print = process_print(model, print_config());
+    const PrintObject &object = *print->objects().front();
+    PointStorage storage;
+    for (const Layer *layer : object.layers())
+        for (const LayerRegion *layerm : layer->regions()) {
+            collect_point_storage(layerm->perimeters(), storage);
+            collect_point_storage(layerm->thin_fills(), storage);
+            collect_point_storage(layerm->fills(), storage);
+        }
+    b.counter("layers", double(object.layer_count()));
+    b.counter("points", double(storage.points));
+    b.counter("point_bytes", double(storage.point_bytes));
+    b.counter("z_bytes", double(storage.z_bytes));
+    b.counter("point_bytes_with_z_in_point", double(storage.point_bytes / sizeof(Point) * (sizeof(Point) + sizeof(coord_t))));
+
+    std::vector<ExtrusionEntityCollection> copies;
+    size_t                                 rss_extrusions = 0;
+    b.run(
+        [&copies]() { copies.clear(); copies.shrink_to_fit(); },
+        [&object, &copies, &rss_extrusions]() {
+            const size_t rss_before = current_rss();
+            copies.reserve(3 * object.layer_count() * object.num_printing_regions());
+            for (const Layer *layer : object.layers())
+                for (const LayerRegion *layerm : layer->regions()) {
+                    copies.emplace_back(layerm->perimeters());
+                    copies.emplace_back(layerm->thin_fills());
+                    copies.emplace_back(layerm->fills());
+                }
+            // Later runs may reuse the memory released by the allocators, thus the maximum is reported.
+            rss_extrusions = std::max(rss_extrusions, current_rss() - rss_before);
+        });
+    b.counter("extrusions_rss", double(rss_extrusions));
+}
+
+// Generation of the lightning infill trees limited to the given number of threads, to measure its scaling.
+static void bench_lightning_generator(Bench &b, const std::string &model_name, int num_threads)
+{
+    std::unique_ptr<Print> print = process_print(load_model(model_name), print_config({ { "fill_pattern", "lightning" }, { "fill_density", "20%" } }));
+    const PrintObject &object = *print->objects().front();
+    b.counter("layers", double(object.layer_count()));
+    b.counter("threads", double(num_threads));
+    tbb::task_arena arena(num_threads);
+    b.run([&object, &arena]() {
+        arena.execute([&object]() { FillLightning::GeneratorPtr generator = FillLightning::build_generator(object, 20., []() {}); });
+    });
+}
+
+void register_slicing_benchmarks()
+{
+    for (const std::string &model : default_models())
+        register_benchmark("slice_mesh_ex/" + model, [model](Bench &b) { bench_slice_mesh_ex(b, model); });
+    for (const std::string &model : default_models()) {
+        register_benchmark("perimeters/classic/" + model, [model](Bench &b) { bench_perimeters(b, model, "classic"); });
+        register_benchmark("perimeters/arachne/" + model, [model](Bench &b) { bench_perimeters(b, model, "arachne"); });
+    }
+    for (const std::string &model : default_models()) {
+        register_benchmark("extrusion_memory/" + model, [model](Bench &b) { bench_extrusion_memory(b, model, 1.); });
+        register_benchmark("extrusion_memory/x3/" + model, [model](Bench &b) { bench_extrusion_memory(b, model, 3.); });
+    }
+    for (const std::string &model : default_models())
+        register_benchmark("extrusions/" + model, [model](Bench &b) { bench_extrusions(b, model); });
+    for (const std::string &model : default_models())
+        register_benchmark("wall_tool_paths/" + model, [model](Bench &b) { bench_wall_tool_paths(b, model); });
+    // Lightning and adaptive cubic infills are left out, they need their generators built by PrintObject.
+    for (const char *pattern : { "rectilinear", "grid", "triangles", "honeycomb", "3dhoneycomb", "gyroid", "concentric", "hilbertcurve" })
+        for (const std::string &model : default_models())
+            register_benchmark(std::string("fill/") + pattern + "/" + model, [model, pattern](Bench &b) { bench_fill(b, model, pattern); });
+    // Thread counts doubling up to the number of hardware threads.
+    const int max_threads = tbb::this_task_arena::max_concurrency();
+    for (int num_threads = 1; num_threads <= max_threads; num_threads = num_threads < max_threads ? std::min(2 * num_threads, max_threads) : max_threads + 1)
+        for (const std::string &model : default_models())
+            register_benchmark("lightning_generator/threads_" + std::to_string(num_threads) + "/" + model, [model, num_threads](Bench &b) { bench_lightning_generator(b, model, num_threads); });
+}
+
+} // namespace Benchmarks
+} // namespace Slic3r
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/nowide/fstream.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <tbb/global_control.h>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Utils.hpp>
+
+#include "Benchmark.hpp"
+
+// Runs the benchmarks of the hot paths of libslic3r over the models in tests/data and reports the wall time,
+// the CPU time per thread and the peak resident memory of each of them in JSON, so that the results of different
+// commits may be compared. A benchmark prepares its input (for example processes a Print) outside of the measurement.
+
+const std::string USAGE_STR = {
+    "Usage: benchmarks [--list] [--filter <regex>] [--repetitions <n>] [--threads <n>] [--json <file>]\n"
+    "                  [--baseline <file> [--threshold <percent>]]\n"
+    "  --list         Print the names of the benchmarks.\n"
+    "  --filter       Run only the benchmarks with a name matching the regular expression.\n"
+    "  --repetitions  Number of measurements of each benchmark, 3 by default.\n"
+    "  --threads      Maximum number of threads, all the hardware threads by default.\n"
+    "  --json         Write the results into a file instead of the standard output.\n"
+    "  --baseline     Compare the median wall times with the results of a previous run.\n"
+    "  --threshold    Fail if a benchmark is slower than the baseline by more than the given percentage."
+};
+
+using namespace Slic3r;
+using namespace Slic3r::Benchmarks;
+
+struct Result
+{
+    std::string                     name;
+    std::string                     error;
+    std::vector<Sample>             samples;
+    std::map<std::string, double>   counters;
+    size_t                          peak_rss { 0 };
+
+    double median_wall_time() const {
+        std::vector<double> times;
+        for (const Sample &sample : samples)
+            times.emplace_back(sample.wall_time);
+        std::sort(times.begin(), times.end());
+        return times.empty() ? 0. : times.size() % 2 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+    }
+};
+
+static std::string escape_json(const std::string &str)
+{
+    std::string out;
+    out.reserve(str.size() + 2);
+    for (char c : str) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:   out += c;      break;
+        }
+    }
+    return out;
+}
+
+static std::string to_json(const std::vector<Result> &results, size_t num_threads, size_t repetitions, bool peak_rss_per_benchmark)
+{
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out << std::fixed << std::setprecision(6) << "{\n"
+        << "  \"version\": \"" << SLIC3R_VERSION << "\",\n"
+        << "  \"build\": \"" << escape_json(SLIC3R_BUILD_ID) << "\",\n"
+        << "  \"threads\": " << num_threads << ",\n"
+        << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"repetitions\": " << repetitions << ",\n"
+        // If false, the peak_rss of a benchmark is the peak of the process up to the end of the benchmark.
+        << "  \"peak_rss_per_benchmark\": " << (peak_rss_per_benchmark ? "true" : "false") << ",\n"
+        << "  \"benchmarks\": [";
+    for (const Result &result : results) {
+        out << (&result == &results.front() ? "\n" : ",\n") << "    { \"name\": \"" << escape_json(result.name) << "\", ";
+        if (! result.error.empty()) {
+            out << "\"error\": \"" << escape_json(result.error) << "\" }";
+            continue;
+        }
+        double wall_min = std::numeric_limits<double>::max(), wall_max = 0., wall_sum = 0., cpu_sum = 0.;
+        // Average CPU time of each thread.
+        std::map<int64_t, double> thread_cpu_time;
+        for (const Sample &sample : result.samples) {
+            wall_min  = std::min(wall_min, sample.wall_time);
+            wall_max  = std::max(wall_max, sample.wall_time);
+            wall_sum += sample.wall_time;
+            cpu_sum  += sample.cpu_time;
+            for (const auto &[tid, time] : sample.thread_cpu_time)
+                thread_cpu_time[tid] += time / double(result.samples.size());
+        }
+        const double num_samples = double(std::max<size_t>(1, result.samples.size()));
+        std::vector<double> thread_times;
+        for (const auto &[tid, time] : thread_cpu_time)
+            thread_times.emplace_back(time);
+        std::sort(thread_times.begin(), thread_times.end(), std::greater<double>());
+        out << "\"wall_time\": { \"min\": " << (result.samples.empty() ? 0. : wall_min) << ", \"median\": " << result.median_wall_time()
+            << ", \"mean\": " << wall_sum / num_samples << ", \"max\": " << wall_max << " }, "
+            << "\"cpu_time\": " << cpu_sum / num_samples << ", "
+            << "\"cpu_utilization\": " << (wall_sum > 0. ? cpu_sum / wall_sum : 0.) << ", "
+            << "\"thread_cpu_time\": [";
+        for (const double &time : thread_times)
+            out << (&time == &thread_times.front() ? "" : ", ") << time;
+        out << "], \"peak_rss\": " << result.peak_rss << ", \"counters\": {";
+        for (const auto &[name, value] : result.counters)
+            out << (name == result.counters.begin()->first ? " " : ", ") << "\"" << escape_json(name) << "\": " << value;
+        out << (result.counters.empty() ? "} }" : " } }");
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+
+// Prints the change of the median wall time against the baseline, returns false if any benchmark regressed by more than threshold percent.
+static bool compare_with_baseline(const std::vector<Result> &results, const std::string &baseline_path, std::optional<double> threshold)
+{
+    std::map<std::string, double> baseline;
+    try {
+        boost::nowide::ifstream ifs(baseline_path);
+        boost::property_tree::ptree tree;
+        boost::property_tree::read_json(ifs, tree);
+        for (const auto &[key, benchmark] : tree.get_child("benchmarks"))
+            if (auto median = benchmark.get_optional<double>("wall_time.median"); median)
+                baseline[benchmark.get<std::string>("name")] = *median;
+    } catch (const std::exception &ex) {
+        std::cerr << "Failed to read the baseline " << baseline_path << ": " << ex.what() << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    std::cerr << std::endl << "Median wall time against " << baseline_path << ":" << std::endl;
+    for (const Result &result : results) {
+        auto it = baseline.find(result.name);
+        if (! result.error.empty() || it == baseline.end() || it->second <= 0.)
+            continue;
+        const double change = 100. * (result.median_wall_time() / it->second - 1.);
+        const bool   failed = threshold && change > *threshold;
+        std::cerr << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << it->second << " s -> " << std::setw(10) << result.median_wall_time() << " s "
+                  << std::showpos << std::setprecision(1) << change << "%" << std::noshowpos << (failed ? "  REGRESSION" : "") << std::endl;
+        ok &= ! failed;
+    }
+    return ok;
+}
+
+int main(const int argc, const char *argv[])
+{
+    bool                        list = false;
+    std::optional<std::regex>   filter;
+    size_t                      repetitions = 3;
+    size_t                      num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::string                 json_path;
+    std::string                 baseline_path;
+    std::optional<double>       threshold;
+    try {
+        for (int i = 1; i < argc; ++ i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (++ i == argc)
+                    throw std::invalid_argument("Missing value of " + arg);
+                return argv[i];
+            };
+            if (arg == "--list")
+                list = true;
+            else if (arg == "--filter")
+                filter = std::regex(value());
+            else if (arg == "--repetitions")
+                repetitions = std::max<size_t>(1, std::stoul(value()));
+            else if (arg == "--threads")
+                num_threads = std::max<size_t>(1, std::stoul(value()));
+            else if (arg == "--json")
+                json_path = value();
+            else if (arg == "--baseline")
+                baseline_path = value();
+            else if (arg == "--threshold")
+                threshold = std::stod(value());
+            else
+                throw std::invalid_argument("Unknown argument " + arg);
+        }
+    } catch (const std::exception &ex) {
+        std::cerr << ex.what() << std::endl << USAGE_STR << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    register_slicing_benchmarks();
+    register_print_benchmarks();
+    register_io_benchmarks();
+    register_sla_benchmarks();
+    register_placeholder_parser_benchmarks();
+
+    std::vector<const BenchmarkCase*> cases;
+    for (const BenchmarkCase &benchmark : registered_benchmarks())
+        if (! filter || std::regex_search(benchmark.name, *filter))
+            cases.emplace_back(&benchmark);
+    if (list) {
+        for (const BenchmarkCase *benchmark : cases)
+            std::cout << benchmark->name << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // Don't let the logging of the slicing steps influence the timings.
+    set_logging_level(1);
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, num_threads);
+
+    std::vector<Result> results;
+    bool                peak_rss_per_benchmark = true;
+    for (const BenchmarkCase *benchmark : cases) {
+        Result &result = results.emplace_back();
+        result.name = benchmark->name;
+        peak_rss_per_benchmark &= reset_peak_rss();
+        try {
+            Bench bench(repetitions);
+            benchmark->fn(bench);
+            result.samples  = bench.samples();
+            result.counters = bench.counters();
+        } catch (const std::exception &ex) {
+            result.error = ex.what();
+        }
+        result.peak_rss = peak_rss();
+        if (result.error.empty())
+            std::cerr << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(10) << result.median_wall_time() << " s" << std::setw(10) << (result.peak_rss >> 20) << " MB" << std::endl;
+        else
+            std::cerr << std::left << std::setw(48) << result.name << " failed: " << result.error << std::endl;
+    }
+
+    const std::string json = to_json(results, num_threads, repetitions, peak_rss_per_benchmark);
+    if (json_path.empty())
+        std::cout << json;
+    else {
+        boost::nowide::ofstream ofs(json_path);
+        ofs << json;
+        if (! ofs) {
+            std::cerr << "Writing the results to " << json_path << " failed" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    bool ok = std::none_of(results.begin(), results.end(), [](const Result &result) { return ! result.error.empty(); });
+    if (! baseline_path.empty())
+        ok &= compare_with_baseline(results, baseline_path, threshold);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
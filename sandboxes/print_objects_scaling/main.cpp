@@ -0,0 +1,85 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/Model.hpp>
+#include <libslic3r/Print.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+
+#include <tbb/global_control.h>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Measures the time of Print::process() for a plate of many distinct small objects with an increasing number of threads,
+// to evaluate how well the PrintObjects being processed concurrently scale.
+
+const std::string USAGE_STR = {
+    "Usage: print_objects_scaling [number_of_objects]"
+};
+
+using namespace Slic3r;
+
+static void make_plate(Model &model, size_t num_objects)
+{
+    // Grid of small parts 15mm apart, each with a different shape or size, so that none of them are merged into instances.
+    const size_t cols = std::max<size_t>(1, size_t(std::ceil(std::sqrt(double(num_objects)))));
+    for (size_t i = 0; i < num_objects; ++ i) {
+        const double size = 4. + double(i % 7);
+        TriangleMesh mesh;
+        switch (i % 4) {
+        case 0:  mesh = make_cube(size, size * 0.8, size * 1.5); break;
+        case 1:  mesh = make_cylinder(size * 0.5, size * 2.); break;
+        case 2:  mesh = make_cone(size * 0.5, size * 1.5); break;
+        default: mesh = make_sphere(size * 0.5, 2. * PI / 90.); break;
+        }
+        ModelObject *object = model.add_object();
+        object->name = "part" + std::to_string(i) + ".stl";
+        object->add_volume(std::move(mesh));
+        object->add_instance()->set_offset(Vec3d(10. + 15. * double(i % cols), 10. + 15. * double(i / cols), 0.));
+        object->ensure_on_bed();
+    }
+}
+
+int main(const int argc, const char *argv[])
+{
+    size_t num_objects = 80;
+    if (argc > 2) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (argc == 2)
+        num_objects = std::stoul(argv[1]);
+
+    DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({ { "bed_shape", "0x0,400x0,400x400,0x400" }, { "fill_density", "20%" } });
+    Model model;
+    make_plate(model, num_objects);
+
+    const size_t max_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<size_t> thread_counts;
+    for (size_t num_threads = 1; num_threads < max_threads; num_threads *= 2)
+        thread_counts.emplace_back(num_threads);
+    thread_counts.emplace_back(max_threads);
+
+    std::cout << num_objects << " objects" << std::endl;
+    double time_single_thread = 0.;
+    for (size_t num_threads : thread_counts) {
+        tbb::global_control limit(tbb::global_control::max_allowed_parallelism, num_threads);
+        Print print;
+        print.apply(model, config);
+        print.set_status_silent();
+        Benchmark b;
+        b.start();
+        print.process();
+        b.stop();
+        const double time = b.getElapsedSec();
+        if (num_threads == 1)
+            time_single_thread = time;
+        std::cout << num_threads << " threads: " << time << " s, speedup " << time_single_thread / time << std::endl;
+    }
+
+    return EXIT_SUCCESS;
+}
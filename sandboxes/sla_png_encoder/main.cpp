@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <libslic3r/libslic3r.h>
+#include <libslic3r/PNGReadWrite.hpp>
+#include <libslic3r/SLA/RasterBase.hpp>
+#include <libslic3r/Format/ZipperArchiveImport.hpp>
+
+#include "libnest2d/tools/benchmark.h"
+
+// Compares the throughput and the output size of the PNG raster encoders on the layer images of an existing SL1 archive.
+
+const std::string USAGE_STR = {
+    "Usage: sla_png_encoder archive.sl1 [repetitions]"
+};
+
+using namespace Slic3r;
+
+struct EncoderStats {
+    const char *name;
+    double      seconds = 0.;
+    size_t      bytes   = 0;
+};
+
+template<class Encoder>
+static void measure(EncoderStats &stats, Encoder &&encoder, const std::vector<png::ImageGreyscale> &layers, size_t repetitions)
+{
+    Benchmark b;
+    b.start();
+    for (size_t rep = 0; rep < repetitions; ++ rep)
+        for (const png::ImageGreyscale &img : layers) {
+            sla::EncodedRaster enc = encoder(img.buf.data(), img.cols, img.rows, 1);
+            if (rep == 0)
+                stats.bytes += enc.size();
+        }
+    b.stop();
+    stats.seconds = b.getElapsedSec() / double(repetitions);
+}
+
+int main(const int argc, const char *argv[])
+{
+    if (argc < 2 || argc > 3) {
+        std::cout << USAGE_STR << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    size_t repetitions = argc == 3 ? std::max(1, std::atoi(argv[2])) : 3;
+
+    ZipperArchive arch = read_zipper_archive(argv[1], { "png" }, { "thumbnail" });
+
+    std::vector<png::ImageGreyscale> layers;
+    size_t original_bytes = 0, pixels = 0;
+    for (const EntryBuffer &entry : arch.entries) {
+        png::ImageGreyscale img;
+        if (! png::decode_png({ entry.buf.data(), entry.buf.size() }, img)) {
+            std::cerr << "Failed to decode " << entry.fname << std::endl;
+            continue;
+        }
+        original_bytes += entry.buf.size();
+        pixels         += img.buf.size();
+        layers.emplace_back(std::move(img));
+    }
+
+    if (layers.empty()) {
+        std::cerr << "No layer images found in " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << layers.size() << " layers, " << pixels / layers.size() << " pixels each, "
+              << original_bytes << " bytes as stored in the archive" << std::endl;
+
+    EncoderStats stats[] = { { "PNGRasterEncoder" }, { "FastPNGRasterEncoder" } };
+    measure(stats[0], sla::PNGRasterEncoder{}, layers, repetitions);
+    measure(stats[1], sla::FastPNGRasterEncoder{}, layers, repetitions);
+
+    for (const EncoderStats &s : stats)
+        std::cout << s.name << ": " << s.seconds << " s, "
+                  << double(pixels) / s.seconds / 1e6 << " Mpx/s, "
+                  << s.bytes << " bytes (" << double(s.bytes) / double(layers.size()) << " per layer)" << std::endl;
+
+    return EXIT_SUCCESS;
+}
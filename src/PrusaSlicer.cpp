@@ -17,15 +17,23 @@
     #endif /* SLIC3R_GUI */
 #endif /* WIN32 */
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <string>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
 #include <math.h>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/nowide/args.hpp>
 #include <boost/nowide/cenv.hpp>
+#include <boost/nowide/fstream.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <boost/nowide/integration/filesystem.hpp>
 #include <boost/dll/runtime_symbol_info.hpp>
@@ -37,12 +45,14 @@
 #include <boost/algorithm/string/split.hpp>
 #endif // ENABLE_GL_CORE_PROFILE
 #include "libslic3r/Config.hpp"
+#include "libslic3r/Exception.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
 #include "libslic3r/Model.hpp"
 #include "libslic3r/ModelArrange.hpp"
 #include "libslic3r/Platform.hpp"
 #include "libslic3r/Print.hpp"
+#include "libslic3r/PrintObjectCache.hpp"
 #include "libslic3r/SLAPrint.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/AMF.hpp"
@@ -52,6 +62,7 @@
 #include "libslic3r/Format/SL1.hpp"
 #include "libslic3r/Utils.hpp"
 #include "libslic3r/Thread.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/BlacklistedLibraryCheck.hpp"
 
 #include "PrusaSlicer.hpp"
@@ -504,6 +515,19 @@ int CLI::run(int argc, char **argv)
             for (auto &o : model.objects)
                 o->ensure_on_bed();
 
+    if (const std::string &cache_dir = m_config.opt_string("cache_dir"); ! cache_dir.empty()) {
+        try {
+            m_object_cache = std::make_shared<PrintObjectCache>(cache_dir, size_t(m_config.opt_int("cache_size")) * 1024 * 1024);
+        } catch (const std::exception &ex) {
+            boost::nowide::cerr << "error: " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+
+    const std::string &trace_path = m_config.opt_string("trace");
+    if (! trace_path.empty())
+        Trace::start();
+
     // loop through action options
     for (auto const &opt_key : m_actions) {
         if (opt_key == "help") {
@@ -579,6 +603,7 @@ int CLI::run(int argc, char **argv)
                 if (printer_technology == ptFFF) {
                     for (auto* mo : model.objects)
                         fff_print.auto_assign_extruders(mo);
+                    fff_print.set_object_cache(m_object_cache);
                 }
                 print->apply(model, m_print_config);
                 std::string err = print->validate();
@@ -591,6 +616,9 @@ int CLI::run(int argc, char **argv)
                 else
                     try {
                         std::string outfile_final;
+                        if (printer_technology == ptSLA)
+                            // The output path is known, let the layers be written into the archive as they are rasterized.
+                            sla_print.set_export_stream(sla_print.output_filepath(outfile));
                         print->process();
                         if (printer_technology == ptFFF) {
                             // The outfile is processed by a PlaceholderParser.
@@ -647,12 +675,22 @@ int CLI::run(int argc, char **argv)
                     << " (" << print.total_extruded_volume()/1000 << "cm3)" << std::endl;
 */
             }
+            if (! m_config.opt_string("batch").empty() && ! this->export_batch(printer_technology))
+                return 1;
         } else {
             boost::nowide::cerr << "error: option not supported yet: " << opt_key << std::endl;
             return 1;
         }
     }
 
+    if (! trace_path.empty()) {
+        Trace::stop();
+        if (! Trace::export_chrome_trace(trace_path)) {
+            boost::nowide::cerr << "error: failed to write the trace to " << trace_path << std::endl;
+            return 1;
+        }
+        boost::nowide::cout << "Trace exported to " << trace_path << std::endl;
+    }
 
     if (start_gui) {
 #ifdef SLIC3R_GUI
@@ -869,6 +907,196 @@ bool CLI::export_models(IO::ExportFormat format)
     return true;
 }
 
+static std::string escape_json(const std::string &str)
+{
+    std::string out;
+    out.reserve(str.size() + 2);
+    for (char c : str) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:   out += c;      break;
+        }
+    }
+    return out;
+}
+
+bool CLI::export_batch(PrinterTechnology printer_technology)
+{
+    struct BatchJob {
+        std::string input;
+        // Output path or template, empty to derive it from output_filename_format.
+        std::string output;
+        bool        success { false };
+        // Final output path or an error message.
+        std::string result;
+        double      time_load { 0. };
+        double      time_slice { 0. };
+        double      time_export { 0. };
+        // Peak memory of the whole process when the job finished. It is not the peak of the job itself,
+        // as the jobs run concurrently and they share the process.
+        size_t      process_peak_memory { 0 };
+    };
+
+    const std::string &manifest = m_config.opt_string("batch");
+    std::vector<BatchJob> jobs;
+    {
+        boost::nowide::ifstream ifs(manifest);
+        if (! ifs) {
+            boost::nowide::cerr << "Cannot read the batch manifest " << manifest << std::endl;
+            return false;
+        }
+        for (std::string line; std::getline(ifs, line);) {
+            boost::trim(line);
+            if (line.empty() || line.front() == '#')
+                continue;
+            BatchJob job;
+            if (size_t tab = line.find('\t'); tab == std::string::npos)
+                job.input = line;
+            else {
+                job.input  = boost::trim_copy(line.substr(0, tab));
+                job.output = boost::trim_copy(line.substr(tab + 1));
+            }
+            jobs.emplace_back(std::move(job));
+        }
+    }
+
+    size_t num_threads = m_config.opt_int("batch_jobs");
+    if (num_threads == 0)
+        num_threads = std::max<size_t>(1, std::thread::hardware_concurrency() / 4);
+    num_threads = std::min(num_threads, jobs.size());
+
+    // The print config was composed and validated once, the jobs only read it.
+    const Points        bed = get_bed_shape(m_print_config);
+    ArrangeParams       arrange_cfg;
+    arrange_cfg.min_obj_distance = scaled(min_object_distance(m_print_config));
+    const bool          dont_arrange  = m_config.opt_bool("dont_arrange");
+    const bool          ensure_on_bed = m_config.opt_bool("ensure_on_bed");
+
+    using clock = std::chrono::steady_clock;
+    auto seconds_since = [](clock::time_point start) { return std::chrono::duration<double>(clock::now() - start).count(); };
+
+    std::mutex cout_mutex;
+    auto process_job = [&](BatchJob &job) {
+        try {
+            clock::time_point start = clock::now();
+            Model model = Model::read_from_file(job.input, nullptr, nullptr, Model::LoadAttribute::AddDefaultInstances);
+            if (model.objects.empty())
+                throw Slic3r::RuntimeError("The file is empty");
+            if (ensure_on_bed)
+                for (ModelObject *o : model.objects)
+                    o->ensure_on_bed();
+            if (! dont_arrange)
+                arrange_objects(model, bed, arrange_cfg);
+            job.time_load = seconds_since(start);
+
+            start = clock::now();
+            Print     fff_print;
+            SLAPrint  sla_print;
+            PrintBase *print = (printer_technology == ptFFF) ? static_cast<PrintBase*>(&fff_print) : static_cast<PrintBase*>(&sla_print);
+            // Progress of concurrent jobs would be interleaved.
+            print->set_status_silent();
+            if (printer_technology == ptFFF) {
+                for (ModelObject *mo : model.objects)
+                    fff_print.auto_assign_extruders(mo);
+                fff_print.set_object_cache(m_object_cache);
+            }
+            print->apply(model, m_print_config);
+            if (std::string err = print->validate(); ! err.empty())
+                throw Slic3r::RuntimeError(err);
+            if (print->empty())
+                throw Slic3r::RuntimeError("Nothing to print. Either the print is empty or no object is fully inside the print volume.");
+            if (printer_technology == ptSLA)
+                sla_print.set_export_stream(sla_print.output_filepath(job.output));
+            print->process();
+            job.time_slice = seconds_since(start);
+
+            start = clock::now();
+            std::string outfile = job.output;
+            std::string outfile_final;
+            if (printer_technology == ptFFF) {
+                outfile = fff_print.export_gcode(outfile, nullptr, nullptr);
+                outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
+            } else {
+                outfile = sla_print.output_filepath(outfile);
+                outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
+                sla_print.export_print(outfile_final);
+            }
+            if (outfile != outfile_final) {
+                if (Slic3r::rename_file(outfile, outfile_final))
+                    throw Slic3r::RuntimeError("Renaming file " + outfile + " to " + outfile_final + " failed");
+                outfile = outfile_final;
+            }
+            if (printer_technology == ptFFF)
+                run_post_process_scripts(outfile, fff_print.full_print_config());
+            job.time_export = seconds_since(start);
+            job.success = true;
+            job.result  = outfile;
+        } catch (const std::exception &ex) {
+            job.result = ex.what();
+        }
+        job.process_peak_memory = peak_memory_usage();
+        std::scoped_lock<std::mutex> lock(cout_mutex);
+        if (job.success)
+            boost::nowide::cout << "Slicing result exported to " << job.result << std::endl;
+        else
+            boost::nowide::cerr << job.input << ": " << job.result << std::endl;
+    };
+
+    const clock::time_point start = clock::now();
+    // Name the worker threads of the thread pool and set their locales before the jobs start using it concurrently.
+    // The thread pool stays warm for all the jobs, each of them parallelizes its slicing steps over the shared pool.
+    name_tbb_thread_pool_threads_set_locale();
+    {
+        std::atomic<size_t>        next_job { 0 };
+        std::vector<boost::thread> threads;
+        for (size_t thread_idx = 0; thread_idx < num_threads; ++ thread_idx) {
+            threads.emplace_back(create_thread([&jobs, &next_job, &process_job]() {
+                for (size_t job_idx = next_job ++; job_idx < jobs.size(); job_idx = next_job ++)
+                    process_job(jobs[job_idx]);
+            }));
+            set_thread_name(threads.back(), "slic3r_batch" + std::to_string(thread_idx));
+        }
+        for (boost::thread &thread : threads)
+            thread.join();
+    }
+    const double time_total = seconds_since(start);
+
+    size_t num_failed = std::count_if(jobs.begin(), jobs.end(), [](const BatchJob &job) { return ! job.success; });
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(3) << "{\n"
+            << "  \"jobs_in_parallel\": " << num_threads << ",\n"
+            << "  \"succeeded\": " << jobs.size() - num_failed << ",\n"
+            << "  \"failed\": " << num_failed << ",\n"
+            << "  \"total_time\": " << time_total << ",\n"
+            << "  \"process_peak_memory\": " << peak_memory_usage() << ",\n"
+            << "  \"jobs\": [";
+    for (const BatchJob &job : jobs)
+        summary << (&job == &jobs.front() ? "\n" : ",\n")
+                << "    { \"input\": \"" << escape_json(job.input) << "\", "
+                << (job.success ? "\"output\": \"" : "\"error\": \"") << escape_json(job.result) << "\", "
+                << "\"load_time\": " << job.time_load << ", "
+                << "\"slice_time\": " << job.time_slice << ", "
+                << "\"export_time\": " << job.time_export << ", "
+                << "\"process_peak_memory\": " << job.process_peak_memory << " }";
+    summary << "\n  ]\n}\n";
+
+    if (const std::string &summary_path = m_config.opt_string("batch_summary"); summary_path.empty())
+        boost::nowide::cout << summary.str();
+    else {
+        boost::nowide::ofstream ofs(summary_path);
+        ofs << summary.str();
+        if (! ofs) {
+            boost::nowide::cerr << "Writing the batch summary to " << summary_path << " failed" << std::endl;
+            return false;
+        }
+    }
+    return num_failed == 0;
+}
+
 std::string CLI::output_filepath(const Model &model, IO::ExportFormat format) const
 {
     std::string ext;
@@ -6,6 +6,8 @@
 
 namespace Slic3r {
 
+class PrintObjectCache;
+
 namespace IO {
 	enum ExportFormat : int { 
         AMF, 
@@ -29,6 +31,8 @@ private:
     std::vector<std::string>    m_actions;
     std::vector<std::string>    m_transforms;
     std::vector<Model>          m_models;
+    // Results of slicing of the objects shared by all the prints, see --cache-dir.
+    std::shared_ptr<PrintObjectCache> m_object_cache;
 
     bool setup(int argc, char **argv);
     
@@ -38,6 +42,10 @@ private:
     /// Exports loaded models to a file of the specified format, according to the options affecting output filename.
     bool export_models(IO::ExportFormat format);
     
+    /// Slices the models listed in the --batch manifest with the shared print config, multiple models concurrently.
+    /// Returns false if any of the jobs failed.
+    bool export_batch(PrinterTechnology printer_technology);
+
     bool has_print_action() const { return m_config.opt_bool("export_gcode") || m_config.opt_bool("export_sla"); }
     
     std::string output_filepath(const Model &model, IO::ExportFormat format) const;
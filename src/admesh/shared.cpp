@@ -23,11 +23,18 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <array>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
 #include "stl.h"
 
 #include "libslic3r/LocalesUtils.hpp"
@@ -127,6 +134,64 @@ void stl_generate_shared_vertices(stl_file *stl, indexed_triangle_set &its)
 	}
 }
 
+// Map a coordinate to an unsigned integer, which sorts in the order of the coordinates.
+// Negative zero is mapped to positive zero and all NaNs to a single key ordered after all the numbers,
+// thus comparing the keys is a strict weak ordering even if some of the coordinates are NaN.
+static inline uint32_t coordinate_key(float f)
+{
+	if (std::isnan(f))
+		return std::numeric_limits<uint32_t>::max();
+	if (f == 0.f)
+		f = 0.f;
+	uint32_t u;
+	memcpy(&u, &f, sizeof(u));
+	return (u & 0x80000000u) ? ~ u : (u | 0x80000000u);
+}
+
+void stl_generate_shared_vertices_exact(const stl_file *stl, indexed_triangle_set &its)
+{
+	const size_t num_corners = size_t(stl->stats.number_of_facets) * 3;
+	auto corner = [stl](uint32_t idx) -> const stl_vertex& { return stl->facet_start[idx / 3].vertex[idx % 3]; };
+
+	// 1) Sort the facet corners lexicographically by coordinates AND corner index.
+	struct CornerKey {
+		std::array<uint32_t, 3> coords;
+		uint32_t                idx;
+		bool operator<(const CornerKey &rhs) const { return coords < rhs.coords || (coords == rhs.coords && idx < rhs.idx); }
+	};
+	std::vector<CornerKey> sorted(num_corners);
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, num_corners), [&sorted, &corner](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end(); ++ i) {
+			const stl_vertex &p = corner(uint32_t(i));
+			sorted[i] = { { coordinate_key(p.x()), coordinate_key(p.y()), coordinate_key(p.z()) }, uint32_t(i) };
+		}
+	});
+	tbb::parallel_sort(sorted.begin(), sorted.end());
+
+	// 2) Map each corner to the corner with the lowest index sharing its coordinates.
+	std::vector<uint32_t> first_corner(num_corners);
+	for (size_t i = 0; i < sorted.size();) {
+		const CornerKey &first = sorted[i];
+		size_t j = i;
+		for (; j < sorted.size() && sorted[j].coords == first.coords; ++ j)
+			first_corner[sorted[j].idx] = first.idx;
+		i = j;
+	}
+
+	// 3) Number the shared vertices in the order of their first corners.
+	its.indices.assign(stl->stats.number_of_facets, stl_triangle_vertex_indices(-1, -1, -1));
+	its.vertices.clear();
+	std::vector<int> vertex_idx(num_corners, -1);
+	for (uint32_t i = 0; i < uint32_t(num_corners); ++ i) {
+		const uint32_t first = first_corner[i];
+		if (first == i) {
+			vertex_idx[i] = int(its.vertices.size());
+			its.vertices.emplace_back(corner(i));
+		}
+		its.indices[i / 3][i % 3] = vertex_idx[first];
+	}
+}
+
 bool its_write_off(const indexed_triangle_set &its, const char *file)
 {
     Slic3r::CNumericLocalesSetter locales_setter;
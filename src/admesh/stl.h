@@ -299,6 +299,9 @@ extern void its_rotate_y(indexed_triangle_set &its, float angle);
 extern void its_rotate_z(indexed_triangle_set &its, float angle);
 
 extern void stl_generate_shared_vertices(stl_file *stl, indexed_triangle_set &its);
+// Merge the facet corners with exactly the same coordinates into shared vertices, in parallel.
+// Does not need the facet neighbors, thus it is used for meshes which are not repaired.
+extern void stl_generate_shared_vertices_exact(const stl_file *stl, indexed_triangle_set &its);
 extern bool its_write_obj(const indexed_triangle_set &its, const char *file);
 extern bool its_write_off(const indexed_triangle_set &its, const char *file);
 extern bool its_write_vrml(const indexed_triangle_set &its, const char *file);
@@ -26,222 +26,279 @@
 #include <math.h>
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <utility>
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/log/trivial.hpp>
-#include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <fast_float/fast_float.h>
+
 #include "stl.h"
 
 #include "libslic3r/LocalesUtils.hpp"
 
-#ifndef SEEK_SET
-#error "SEEK_SET not defined"
-#endif
-
 #if BOOST_ENDIAN_BIG_BYTE
 extern void stl_internal_reverse_quads(char *buf, size_t cnt);
 #endif /* BOOST_ENDIAN_BIG_BYTE */
 
-static FILE* stl_open_count_facets(stl_file *stl, const char *file) 
+// Memory map the file and detect whether it is a binary or an ASCII STL.
+static bool stl_open_map(stl_file *stl, const char *file, boost::iostreams::mapped_file_source &mapped)
+{
+	const boost::filesystem::path path(file);
+	boost::system::error_code ec;
+	const boost::uintmax_t file_size = boost::filesystem::file_size(path, ec);
+	if (ec) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open_map: Couldn't open " << file << " for reading";
+		return false;
+	}
+	// Check for binary or ASCII file.
+	const size_t chtest_size = 128;
+	if (file_size < HEADER_SIZE + chtest_size) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open_map: The input is an empty file: " << file;
+		return false;
+	}
+	try {
+		mapped.open(path);
+	} catch (const std::exception &ex) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open_map: Couldn't open " << file << " for reading: " << ex.what();
+		return false;
+	}
+	if (! mapped.is_open()) {
+		BOOST_LOG_TRIVIAL(error) << "stl_open_map: Couldn't open " << file << " for reading";
+		return false;
+	}
+	const unsigned char *chtest = reinterpret_cast<const unsigned char*>(mapped.data()) + HEADER_SIZE;
+	stl->stats.type = std::any_of(chtest, chtest + chtest_size, [](unsigned char c){ return c > 127; }) ? binary : ascii;
+	return true;
+}
+
+// Copy the facets of a binary STL in bulk.
+static bool stl_read_binary(stl_file *stl, const char *data, size_t size, const char *file)
 {
-  	// Open the file in binary mode first.
-  	FILE *fp = boost::nowide::fopen(file, "rb");
-  	if (fp == nullptr) {
-		BOOST_LOG_TRIVIAL(error) << "stl_open_count_facets: Couldn't open " << file << " for reading";
-    	return nullptr;
-  	}
-  	// Find size of file.
-  	fseek(fp, 0, SEEK_END);
-  	long file_size = ftell(fp);
-
-  	// Check for binary or ASCII file.
-  	fseek(fp, HEADER_SIZE, SEEK_SET);
-	unsigned char chtest[128];
-  	if (! fread(chtest, sizeof(chtest), 1, fp)) {
-		BOOST_LOG_TRIVIAL(error) << "stl_open_count_facets: The input is an empty file: " << file;
-    	fclose(fp);
-    	return nullptr;
-  	}
-  	stl->stats.type = ascii;
-  	for (size_t s = 0; s < sizeof(chtest); s++) {
-    	if (chtest[s] > 127) {
-      		stl->stats.type = binary;
-      		break;
-    	}
-  	}
-  	rewind(fp);
-
-  	uint32_t num_facets = 0;
-
-  	// Get the header and the number of facets in the .STL file.
-  	// If the .STL file is binary, then do the following:
-  	if (stl->stats.type == binary) {
-    	// Test if the STL file has the right size.
-    	if (((file_size - HEADER_SIZE) % SIZEOF_STL_FACET != 0) || (file_size < STL_MIN_FILE_SIZE)) {
-			BOOST_LOG_TRIVIAL(error) << "stl_open_count_facets: The file " << file << " has the wrong size.";
-      		fclose(fp);
-      		return nullptr;
-    	}
-    	num_facets = (file_size - HEADER_SIZE) / SIZEOF_STL_FACET;
-
-    	// Read the header.
-    	if (fread(stl->stats.header, LABEL_SIZE, 1, fp) > 79)
-      		stl->stats.header[80] = '\0';
-
-    	// Read the int following the header.  This should contain # of facets.
-	  	uint32_t header_num_facets;
-    	bool header_num_faces_read = fread(&header_num_facets, sizeof(uint32_t), 1, fp) != 0;
+	// Test if the STL file has the right size.
+	if (((size - HEADER_SIZE) % SIZEOF_STL_FACET != 0) || (size < STL_MIN_FILE_SIZE)) {
+		BOOST_LOG_TRIVIAL(error) << "stl_read_binary: The file " << file << " has the wrong size.";
+		return false;
+	}
+	const uint32_t num_facets = uint32_t((size - HEADER_SIZE) / SIZEOF_STL_FACET);
+
+	// Read the header.
+	memcpy(stl->stats.header, data, LABEL_SIZE);
+	stl->stats.header[LABEL_SIZE] = '\0';
+
+	// Read the int following the header.  This should contain # of facets.
+	uint32_t header_num_facets;
+	memcpy(&header_num_facets, data + LABEL_SIZE, sizeof(uint32_t));
 #if BOOST_ENDIAN_BIG_BYTE
-    	// Convert from little endian to big endian.
-    	stl_internal_reverse_quads((char*)&header_num_facets, 4);
+	// Convert from little endian to big endian.
+	stl_internal_reverse_quads((char*)&header_num_facets, 4);
 #endif /* BOOST_ENDIAN_BIG_BYTE */
-    	if (! header_num_faces_read || num_facets != header_num_facets)
-			BOOST_LOG_TRIVIAL(info) << "stl_open_count_facets: Warning: File size doesn't match number of facets in the header: " << file;
-  	}
-  	// Otherwise, if the .STL file is ASCII, then do the following:
-  	else
-  	{
-    	// Reopen the file in text mode (for getting correct newlines on Windows)
-    	// fix to silence a warning about unused return value.
-    	// obviously if it fails we have problems....
-    	fp = boost::nowide::freopen(file, "r", fp);
-
-		// do another null check to be safe
-    	if (fp == nullptr) {
-			BOOST_LOG_TRIVIAL(error) << "stl_open_count_facets: Couldn't open " << file << " for reading";
-      		fclose(fp);
-      		return nullptr;
-    	}
-    
-    	// Find the number of facets.
-		char linebuf[100];
-		int num_lines = 1;
-		while (fgets(linebuf, 100, fp) != nullptr) {
-		    // Don't count short lines.
-		    if (strlen(linebuf) <= 4)
-		    	continue;
-		    // Skip solid/endsolid lines as broken STL file generators may put several of them.
-		    if (strncmp(linebuf, "solid", 5) == 0 || strncmp(linebuf, "endsolid", 8) == 0)
-		    	continue;
-		    ++ num_lines;
-		}
+	if (num_facets != header_num_facets)
+		BOOST_LOG_TRIVIAL(info) << "stl_read_binary: Warning: File size doesn't match number of facets in the header: " << file;
 
-    	rewind(fp);
-    
-    	// Get the header.
-		int i = 0;
-    	for (; i < 80 && (stl->stats.header[i] = getc(fp)) != '\n'; ++ i) ;
-    	stl->stats.header[i] = '\0'; // Lose the '\n'
-    	stl->stats.header[80] = '\0';
+	stl->stats.number_of_facets += num_facets;
+	stl->stats.original_num_facets = stl->stats.number_of_facets;
+	stl_allocate(stl);
 
-    	num_facets = num_lines / ASCII_LINES_PER_FACET;
-  	}
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, num_facets, 65536), [stl, data](const tbb::blocked_range<size_t> &range) {
+		const char *src = data + HEADER_SIZE + range.begin() * SIZEOF_STL_FACET;
+		for (size_t i = range.begin(); i < range.end(); ++ i, src += SIZEOF_STL_FACET) {
+			stl_facet &facet = stl->facet_start[i];
+			// We assume little-endian architecture!
+			memcpy(&facet, src, SIZEOF_STL_FACET);
+#if BOOST_ENDIAN_BIG_BYTE
+			// Convert the loaded little endian data to big endian.
+			stl_internal_reverse_quads((char*)&facet, 48);
+#endif /* BOOST_ENDIAN_BIG_BYTE */
+		}
+	});
+	return true;
+}
 
-  	stl->stats.number_of_facets += num_facets;
-  	stl->stats.original_num_facets = stl->stats.number_of_facets;
-  	return fp;
+static inline bool stl_ascii_is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f'; }
+
+// Find the end of the first line at or after ptr, which starts with "endfacet". Blocks of an ASCII STL split at these positions
+// contain whole facets only.
+static const char* stl_ascii_next_block(const char *data, const char *ptr, const char *end)
+{
+	static constexpr std::string_view keyword = "endfacet";
+	for (;;) {
+		ptr = std::search(ptr, end, keyword.begin(), keyword.end());
+		if (ptr == end)
+			return end;
+		const char *line_start = ptr;
+		for (; line_start != data && (line_start[-1] == ' ' || line_start[-1] == '\t'); -- line_start) ;
+		ptr += keyword.size();
+		if (line_start == data || line_start[-1] == '\n' || line_start[-1] == '\r') {
+			for (; ptr != end && *ptr != '\n' && *ptr != '\r'; ++ ptr) ;
+			return ptr;
+		}
+	}
 }
 
-/* Reads the contents of the file pointed to by fp into the stl structure,
-   starting at facet first_facet.  The second argument says if it's our first
-   time running this for the stl and therefore we should reset our max and min stats. */
-static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
+// Parser of a block of facets of an ASCII STL.
+class StlAsciiParser
 {
-	if (stl->stats.type == binary)
-    	fseek(fp, HEADER_SIZE, SEEK_SET);
-  	else
-    	rewind(fp);
-
-  	char normal_buf[3][32];
-  	for (uint32_t i = first_facet; i < stl->stats.number_of_facets; ++ i) {
-  	  	stl_facet facet;
-
-    	if (stl->stats.type == binary) {
-      		// Read a single facet from a binary .STL file. We assume little-endian architecture!
-      		if (fread(&facet, 1, SIZEOF_STL_FACET, fp) != SIZEOF_STL_FACET)
-      			return false;
-#if BOOST_ENDIAN_BIG_BYTE
-      		// Convert the loaded little endian data to big endian.
-      		stl_internal_reverse_quads((char*)&facet, 48);
-#endif /* BOOST_ENDIAN_BIG_BYTE */
-    	} else {
-			// Read a single facet from an ASCII .STL file
-			// skip solid/endsolid
-			// (in this order, otherwise it won't work when they are paired in the middle of a file)
-			fscanf(fp, " endsolid%*[^\n]\n");
-			fscanf(fp, " solid%*[^\n]\n");  // name might contain spaces so %*s doesn't work and it also can be empty (just "solid")
-			// Leading space in the fscanf format skips all leading white spaces including numerous new lines and tabs.
-			int res_normal     = fscanf(fp, " facet normal %31s %31s %31s", normal_buf[0], normal_buf[1], normal_buf[2]);
-			assert(res_normal == 3);
-			int res_outer_loop = fscanf(fp, " outer loop");
-			assert(res_outer_loop == 0);
-			int res_vertex1    = fscanf(fp, " vertex %f %f %f", &facet.vertex[0](0), &facet.vertex[0](1), &facet.vertex[0](2));
-			assert(res_vertex1 == 3);
-			int res_vertex2    = fscanf(fp, " vertex %f %f %f", &facet.vertex[1](0), &facet.vertex[1](1), &facet.vertex[1](2));
-			assert(res_vertex2 == 3);
-			// Trailing whitespace is there to eat all whitespaces and empty lines up to the next non-whitespace.
-			int res_vertex3    = fscanf(fp, " vertex %f %f %f ", &facet.vertex[2](0), &facet.vertex[2](1), &facet.vertex[2](2));
-			assert(res_vertex3 == 3);
-			// Some G-code generators tend to produce text after "endloop" and "endfacet". Just ignore it.
-			char buf[2048];
-			fgets(buf, 2047, fp);
-			bool endloop_ok = strncmp(buf, "endloop", 7) == 0 && (buf[7] == '\r' || buf[7] == '\n' || buf[7] == ' ' || buf[7] == '\t');
-			assert(endloop_ok);
-			// Skip the trailing whitespaces and empty lines.
-			fscanf(fp, " ");
-			fgets(buf, 2047, fp);
-			bool endfacet_ok = strncmp(buf, "endfacet", 8) == 0 && (buf[8] == '\r' || buf[8] == '\n' || buf[8] == ' ' || buf[8] == '\t');
-			assert(endfacet_ok);
-			if (res_normal != 3 || res_outer_loop != 0 || res_vertex1 != 3 || res_vertex2 != 3 || res_vertex3 != 3 || ! endloop_ok || ! endfacet_ok) {
-				BOOST_LOG_TRIVIAL(error) << "Something is syntactically very wrong with this ASCII STL! ";
-				return false;
-			}
+public:
+	StlAsciiParser(const char *begin, const char *end, const char *file_end) : m_ptr(begin), m_end(end), m_file_end(file_end) {}
 
-			// The facet normal has been parsed as a single string as to workaround for not a numbers in the normal definition.
-			if (sscanf(normal_buf[0], "%f", &facet.normal(0)) != 1 ||
-			    sscanf(normal_buf[1], "%f", &facet.normal(1)) != 1 ||
-			    sscanf(normal_buf[2], "%f", &facet.normal(2)) != 1) {
-			    // Normal was mangled. Maybe denormals or "not a number" were stored?
-			  	// Just reset the normal and silently ignore it.
-			  	memset(&facet.normal, 0, sizeof(facet.normal));
+	// Returns false if something is syntactically very wrong.
+	bool parse(std::vector<stl_facet> &facets)
+	{
+		for (;;) {
+			std::string_view word = this->word();
+			if (word.empty())
+				return true;
+			// Skip solid / endsolid lines as broken STL file generators may put several of them.
+			// Name of the solid might contain spaces and it may be empty.
+			if (boost::starts_with(word, "solid") || boost::starts_with(word, "endsolid")) {
+				this->skip_line();
+				continue;
 			}
+			if (word != "facet")
+				// Some STL files contain garbage after the last facet, which is ignored.
+				return std::search(m_ptr, m_file_end, "endfacet", "endfacet" + 8) == m_file_end;
+			stl_facet &facet = facets.emplace_back();
+			facet.extra[0] = facet.extra[1] = 0;
+			if (this->word() != "normal")
+				return false;
+			// The facet normal is parsed word by word as a workaround for not a numbers in the normal definition.
+			bool normal_valid = true;
+			for (int i = 0; i < 3; ++ i)
+				normal_valid &= this->number(facet.normal(i));
+			if (! normal_valid)
+				// Normal was mangled. Maybe denormals or "not a number" were stored?
+				// Just reset the normal and silently ignore it.
+				facet.normal = stl_normal::Zero();
+			if (this->word() != "outer" || this->word() != "loop")
+				return false;
+			for (int j = 0; j < 3; ++ j)
+				if (this->word() != "vertex" || ! this->number(facet.vertex[j](0)) || ! this->number(facet.vertex[j](1)) || ! this->number(facet.vertex[j](2)))
+					return false;
+			// Some G-code generators tend to produce text after "endloop" and "endfacet". Just ignore it.
+			if (this->word() != "endloop")
+				return false;
+			this->skip_line();
+			if (this->word() != "endfacet")
+				return false;
+			this->skip_line();
 		}
+	}
 
-#if 0
-		// Report close to zero vertex coordinates. Due to the nature of the floating point numbers,
-		// close to zero values may be represented with singificantly higher precision than the rest of the vertices.
-		// It may be worth to round these numbers to zero during loading to reduce the number of errors reported
-		// during the STL import.
-		for (size_t j = 0; j < 3; ++ j) {
-		if (facet.vertex[j](0) > -1e-12f && facet.vertex[j](0) < 1e-12f)
-		    printf("stl_read: facet %d(0) = %e\r\n", j, facet.vertex[j](0));
-		if (facet.vertex[j](1) > -1e-12f && facet.vertex[j](1) < 1e-12f)
-		    printf("stl_read: facet %d(1) = %e\r\n", j, facet.vertex[j](1));
-		if (facet.vertex[j](2) > -1e-12f && facet.vertex[j](2) < 1e-12f)
-		    printf("stl_read: facet %d(2) = %e\r\n", j, facet.vertex[j](2));
-		}
-#endif
-
-		// Write the facet into memory.
-		stl->facet_start[i] = facet;
-		stl_facet_stats(stl, facet, first);
-  	}
-  
-  	stl->stats.size = stl->stats.max - stl->stats.min;
-  	stl->stats.bounding_diameter = stl->stats.size.norm();
-  	return true;
+private:
+	std::string_view word()
+	{
+		for (; m_ptr != m_end && stl_ascii_is_whitespace(*m_ptr); ++ m_ptr) ;
+		const char *begin = m_ptr;
+		for (; m_ptr != m_end && ! stl_ascii_is_whitespace(*m_ptr); ++ m_ptr) ;
+		return { begin, size_t(m_ptr - begin) };
+	}
+
+	bool number(float &out)
+	{
+		std::string_view word = this->word();
+		const char *begin = word.data();
+		const char *end   = begin + word.size();
+		// fast_float does not accept the leading plus sign.
+		if (begin != end && *begin == '+')
+			++ begin;
+		return fast_float::from_chars(begin, end, out).ptr != begin;
+	}
+
+	void skip_line() { for (; m_ptr != m_end && *m_ptr != '\n' && *m_ptr != '\r'; ++ m_ptr) ; }
+
+	const char *m_ptr;
+	const char *m_end;
+	const char *m_file_end;
+};
+
+// Parse an ASCII STL, blocks of facets are parsed in parallel.
+static bool stl_read_ascii(stl_file *stl, const char *data, size_t size, const char *file)
+{
+	const char *data_end = data + size;
+
+	// Get the header.
+	int i = 0;
+	for (; i < LABEL_SIZE && data[i] != '\n'; ++ i)
+		stl->stats.header[i] = data[i];
+	stl->stats.header[i] = '\0'; // Lose the '\n'
+
+	// Split the file into blocks of roughly 1MB.
+	std::vector<const char*> blocks { data };
+	while (blocks.back() != data_end)
+		blocks.emplace_back(stl_ascii_next_block(data, blocks.back() + std::min<size_t>(1 << 20, data_end - blocks.back()), data_end));
+
+	std::vector<std::vector<stl_facet>> facets(blocks.size() - 1);
+	std::atomic<bool> valid { true };
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, facets.size(), 1), [&blocks, &facets, &valid, data_end](const tbb::blocked_range<size_t> &range) {
+		for (size_t i = range.begin(); i < range.end() && valid; ++ i)
+			if (! StlAsciiParser(blocks[i], blocks[i + 1], data_end).parse(facets[i]))
+				valid = false;
+	});
+	if (! valid) {
+		BOOST_LOG_TRIVIAL(error) << "Something is syntactically very wrong with this ASCII STL! " << file;
+		return false;
+	}
+
+	size_t num_facets = 0;
+	for (const std::vector<stl_facet> &block : facets)
+		num_facets += block.size();
+	stl->stats.number_of_facets += uint32_t(num_facets);
+	stl->stats.original_num_facets = stl->stats.number_of_facets;
+	stl->facet_start.clear();
+	stl->facet_start.reserve(num_facets);
+	for (const std::vector<stl_facet> &block : facets)
+		stl->facet_start.insert(stl->facet_start.end(), block.begin(), block.end());
+	stl->neighbors_start.assign(num_facets, stl_neighbors());
+	return true;
+}
+
+// Calculate the bounding box and the shortest edge estimate of the facets read from a file.
+static void stl_read_stats(stl_file *stl)
+{
+	if (! stl->facet_start.empty()) {
+		bool first = true;
+		stl_facet_stats(stl, stl->facet_start.front(), first);
+		using BBox = std::pair<stl_vertex, stl_vertex>;
+		BBox bbox = tbb::parallel_reduce(tbb::blocked_range<size_t>(0, stl->facet_start.size(), 65536), BBox(stl->stats.min, stl->stats.max),
+			[stl](const tbb::blocked_range<size_t> &range, BBox bbox) {
+				for (size_t i = range.begin(); i < range.end(); ++ i)
+					for (const stl_vertex &v : stl->facet_start[i].vertex) {
+						bbox.first  = bbox.first.cwiseMin(v);
+						bbox.second = bbox.second.cwiseMax(v);
+					}
+				return bbox;
+			},
+			[](const BBox &l, const BBox &r) { return BBox(l.first.cwiseMin(r.first), l.second.cwiseMax(r.second)); });
+		stl->stats.min = bbox.first;
+		stl->stats.max = bbox.second;
+	}
+	stl->stats.size = stl->stats.max - stl->stats.min;
+	stl->stats.bounding_diameter = stl->stats.size.norm();
 }
 
 bool stl_open(stl_file *stl, const char *file)
 {
     Slic3r::CNumericLocalesSetter locales_setter;
 	stl->clear();
-	FILE *fp = stl_open_count_facets(stl, file);
-	if (fp == nullptr)
+	boost::iostreams::mapped_file_source mapped;
+	if (! stl_open_map(stl, file, mapped))
 		return false;
-	stl_allocate(stl);
-	bool result = stl_read(stl, fp, 0, true);
-  	fclose(fp);
+	bool result = stl->stats.type == binary ?
+		stl_read_binary(stl, mapped.data(), mapped.size(), file) :
+		stl_read_ascii(stl, mapped.data(), mapped.size(), file);
+	if (result)
+		stl_read_stats(stl);
   	return result;
 }
 
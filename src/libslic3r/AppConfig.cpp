@@ -92,6 +92,9 @@ void AppConfig::set_defaults()
         if (get("export_sources_full_pathnames").empty())
             set("export_sources_full_pathnames", "0");
 
+        if (get("archive_compression").empty())
+            set("archive_compression", "default"); // or "fast" or "max"
+
 #ifdef _WIN32
         if (get("associate_3mf").empty())
             set("associate_3mf", "0");
@@ -159,6 +159,11 @@ bool ExtrusionLoop::split_at_vertex(const Point &point, const double scaled_epsi
                 // just change the order of points
                 path->polyline.points.insert(path->polyline.points.end(), path->polyline.points.begin() + 1, path->polyline.points.begin() + idx + 1);
                 path->polyline.points.erase(path->polyline.points.begin(), path->polyline.points.begin() + idx);
+                if (std::vector<coord_t> &z = path->polyline.z; ! z.empty()) {
+                    std::vector<coord_t> z_new(z.begin() + idx, z.end());
+                    z_new.insert(z_new.end(), z.begin() + 1, z.begin() + idx + 1);
+                    z = std::move(z_new);
+                }
             } else {
                 // new paths list starts with the second half of current path
                 ExtrusionPaths new_paths;
@@ -166,6 +171,8 @@ bool ExtrusionLoop::split_at_vertex(const Point &point, const double scaled_epsi
                 {
                     ExtrusionPath p = *path;
                     p.polyline.points.erase(p.polyline.points.begin(), p.polyline.points.begin() + idx);
+                    if (p.polyline.has_z())
+                        p.polyline.z.erase(p.polyline.z.begin(), p.polyline.z.begin() + idx);
                     if (p.polyline.is_valid())
                         new_paths.emplace_back(std::move(p));
                 }
@@ -180,6 +187,8 @@ bool ExtrusionLoop::split_at_vertex(const Point &point, const double scaled_epsi
                 {
                     ExtrusionPath &p = *path;
                     p.polyline.points.erase(p.polyline.points.begin() + idx + 1, p.polyline.points.end());
+                    if (p.polyline.has_z())
+                        p.polyline.z.erase(p.polyline.z.begin() + idx + 1, p.polyline.z.end());
                     if (p.polyline.is_valid())
                         new_paths.emplace_back(std::move(p));
                 }
@@ -254,11 +263,14 @@ void ExtrusionLoop::split_at(const Point &point, bool prefer_non_overhang, const
     
     if (this->paths.size() == 1) {
         if (p2.polyline.is_valid()) {
-            if (p1.polyline.is_valid())
+            if (p1.polyline.is_valid()) {
                 p2.polyline.points.insert(p2.polyline.points.end(), p1.polyline.points.begin() + 1, p1.polyline.points.end());
-            this->paths.front().polyline.points = std::move(p2.polyline.points);
+                if (p2.polyline.has_z())
+                    p2.polyline.z.insert(p2.polyline.z.end(), p1.polyline.z.begin() + 1, p1.polyline.z.end());
+            }
+            this->paths.front().polyline = std::move(p2.polyline);
         } else
-            this->paths.front().polyline.points = std::move(p1.polyline.points);
+            this->paths.front().polyline = std::move(p1.polyline);
     } else {
         // install the two paths
         this->paths.erase(this->paths.begin() + path_idx);
@@ -2,6 +2,7 @@
 #define slic3r_ExtrusionEntity_hpp_
 
 #include "libslic3r.h"
+#include "ExtrusionEntityArena.hpp"
 #include "ExtrusionRole.hpp"
 #include "Polygon.hpp"
 #include "Polyline.hpp"
@@ -55,6 +56,10 @@ public:
     virtual Polylines as_polylines() const { Polylines dst; this->collect_polylines(dst); return dst; }
     virtual double length() const = 0;
     virtual double total_volume() const = 0;
+
+    // Allocated from the ExtrusionEntityArena bound to the current thread, if any.
+    static void* operator new(size_t size) { return ExtrusionEntityArena::allocate(size); }
+    static void  operator delete(void *ptr) { ExtrusionEntityArena::deallocate(ptr); }
 };
 
 typedef std::vector<ExtrusionEntity*> ExtrusionEntitiesPtr;
@@ -126,11 +131,6 @@ private:
     ExtrusionRole m_role;
 };
 
-class ExtrusionPath3 : public ExtrusionPath
-{
-    Polyline3 polyline;
-};
-
 class ExtrusionPathOriented : public ExtrusionPath
 {
 public:
@@ -0,0 +1,92 @@
+#include "ExtrusionEntityArena.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <new>
+
+namespace Slic3r {
+
+// Size of the blocks allocated by the arena. Objects bigger than a quarter of a block are allocated from the heap.
+static constexpr size_t arena_block_size = 64 * 1024;
+
+struct ExtrusionEntityArena::Block
+{
+    // Live objects allocated from this block, plus one while the arena allocates from this block.
+    std::atomic<size_t> refs { 1 };
+    // Bytes of the block used so far, including this header.
+    size_t              used { 0 };
+
+    static void unref(Block *block) {
+        if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block->~Block();
+            ::operator delete(block);
+        }
+    }
+};
+
+// Stored in front of each allocated object, so that operator delete() finds the block of the object.
+// nullptr for objects allocated from the heap.
+struct alignas(std::max_align_t) ExtrusionEntityArena::ObjectHeader
+{
+    Block *block;
+};
+
+static constexpr size_t align_up(size_t size) { return (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t); }
+
+static thread_local ExtrusionEntityArena *s_current_arena = nullptr;
+
+void ExtrusionEntityArena::release()
+{
+    if (m_block) {
+        Block::unref(m_block);
+        m_block = nullptr;
+    }
+}
+
+ExtrusionEntityArena::Scope::Scope(ExtrusionEntityArena *arena) : m_previous(s_current_arena)
+{
+    s_current_arena = arena;
+}
+
+ExtrusionEntityArena::Scope::~Scope()
+{
+    s_current_arena = m_previous;
+}
+
+void* ExtrusionEntityArena::allocate(size_t size)
+{
+    const size_t          total = sizeof(ObjectHeader) + align_up(size);
+    ExtrusionEntityArena *arena = s_current_arena;
+    if (arena == nullptr || total > arena_block_size / 4) {
+        auto *header = static_cast<ObjectHeader*>(::operator new(total));
+        header->block = nullptr;
+        return header + 1;
+    }
+    if (arena->m_block == nullptr || arena->m_block->used + total > arena_block_size) {
+        arena->release();
+        arena->m_block = new (::operator new(arena_block_size)) Block();
+        arena->m_block->used = align_up(sizeof(Block));
+        ++ arena->m_num_blocks;
+    }
+    Block *block = arena->m_block;
+    auto *header = reinterpret_cast<ObjectHeader*>(reinterpret_cast<char*>(block) + block->used);
+    header->block = block;
+    block->used += total;
+    // The arena holds a reference to the block, thus the block cannot be released concurrently and a relaxed increment is sufficient.
+    block->refs.fetch_add(1, std::memory_order_relaxed);
+    ++ arena->m_num_allocations;
+    return header + 1;
+}
+
+void ExtrusionEntityArena::deallocate(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    ObjectHeader *header = static_cast<ObjectHeader*>(ptr) - 1;
+    if (Block *block = header->block)
+        Block::unref(block);
+    else
+        ::operator delete(header);
+}
+
+} // namespace Slic3r
@@ -0,0 +1,59 @@
+#ifndef slic3r_ExtrusionEntityArena_hpp_
+#define slic3r_ExtrusionEntityArena_hpp_
+
+#include <cstddef>
+
+namespace Slic3r {
+
+// Monotonic allocator of the ExtrusionEntity objects of a single layer.
+// ExtrusionEntity objects are allocated from the arena bound to the calling thread by ExtrusionEntityArena::Scope,
+// or from the heap if there is none. The arena carves the objects from large blocks. Deleting an object only
+// decrements the count of live objects of its block, a block is released in bulk once all its objects were deleted
+// and the arena moved on to another block. Therefore the objects may outlive their arena, for example if they are
+// moved to another layer.
+// An arena is not thread safe, it shall only be bound to a single thread at a time.
+class ExtrusionEntityArena
+{
+public:
+    ExtrusionEntityArena() = default;
+    ExtrusionEntityArena(const ExtrusionEntityArena &) = delete;
+    ExtrusionEntityArena& operator=(const ExtrusionEntityArena &) = delete;
+    ~ExtrusionEntityArena() { this->release(); }
+
+    // Stop allocating from the current block, so that it is released as soon as all its objects are deleted.
+    void    release();
+
+    // Statistics: number of objects allocated from this arena and number of blocks allocated for them.
+    size_t  num_allocations() const { return m_num_allocations; }
+    size_t  num_blocks() const { return m_num_blocks; }
+
+    // Binds an arena to the current thread for the lifetime of the scope. Scopes may be nested,
+    // a nullptr arena makes the objects allocated from the heap.
+    class Scope
+    {
+    public:
+        explicit Scope(ExtrusionEntityArena *arena);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope& operator=(const Scope &) = delete;
+
+    private:
+        ExtrusionEntityArena *m_previous;
+    };
+
+    // Used by ExtrusionEntity::operator new() / operator delete().
+    static void*    allocate(size_t size);
+    static void     deallocate(void *ptr);
+
+private:
+    struct Block;
+    struct ObjectHeader;
+
+    Block  *m_block { nullptr };
+    size_t  m_num_allocations { 0 };
+    size_t  m_num_blocks { 0 };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ExtrusionEntityArena_hpp_
@@ -10,6 +10,7 @@
 #include "../Print.hpp"
 #include "../PrintConfig.hpp"
 #include "../Surface.hpp"
+#include "../Trace.hpp"
 // for Arachne based infills
 #include "../PerimeterGenerator.hpp"
 
@@ -433,14 +434,17 @@ void Layer::clear_fills()
 {
     for (LayerRegion *layerm : m_regions)
         layerm->m_fills.clear();
+    m_surface_fills_ranges.clear();
     for (LayerSlice &lslice : lslices_ex)
 		for (LayerIsland &island : lslice.islands)
 			island.fills.clear();
 }
 
-void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree, FillLightning::Generator* lightning_generator)
+void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive::Octree* support_fill_octree, FillLightning::Generator* lightning_generator, const std::vector<const Layer*> &fill_sources)
 {
+    SLIC3R_TRACE_ZONE("Layer::make_fills", "layer", this->id());
 	this->clear_fills();
+    ExtrusionEntityArena::Scope arena_scope(&m_extrusion_arena);
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
 //	this->export_region_fill_surfaces_to_svg_debug("10_fill-initial");
@@ -461,6 +465,7 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 	BOOST_LOG_TRIVIAL(trace) << "make_fills: found " << surface_fills.size() << " surfaces to fill for layer " << id();
 
 	size_t first_object_layer_id = this->object()->get_layer(0)->id();
+	m_surface_fills_ranges.assign(surface_fills.size(), LayerExtrusionRange());
     for (SurfaceFill &surface_fill : surface_fills) {
         // Create the filler object.
         std::unique_ptr<Fill> f = std::unique_ptr<Fill>(Fill::new_from_type(surface_fill.params.pattern));
@@ -502,7 +507,37 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
         // Used by the concentric infill pattern to clip the loops to create extrusion paths.
         f->loop_clipping = coord_t(scale_(surface_fill.params.flow.nozzle_diameter()) * LOOP_CLIPPING_LENGTH_OVER_NOZZLE_DIAMETER);
 
-        LayerRegion &layerm = *m_regions[surface_fill.region_id];
+        LayerRegion &layerm             = *m_regions[surface_fill.region_id];
+        auto         surface_fill_id    = size_t(&surface_fill - surface_fills.data());
+        auto         surface_fill_begin = uint32_t(layerm.fills().size());
+
+        // The fill sources were grouped the same way, so their surface fills are indexed the same way as ours.
+        // Copy their infill if it does not depend on Z and if it runs in the same direction.
+        const Layer *fill_source = nullptr;
+        if (! fill_sources.empty() && ! f->depends_on_z()) {
+            const std::pair<float, Point> direction = f->_infill_direction(&surface_fill.surface);
+            for (const Layer *layer : fill_sources) {
+                f->layer_id = layer->id() - first_object_layer_id;
+                if (f->_infill_direction(&surface_fill.surface) == direction) {
+                    fill_source = layer;
+                    break;
+                }
+            }
+            f->layer_id = this->id() - first_object_layer_id;
+        }
+        if (fill_source != nullptr) {
+            assert(fill_source->m_surface_fills_ranges.size() == surface_fills.size());
+            const LayerExtrusionRange &source_range  = fill_source->m_surface_fills_ranges[surface_fill_id];
+            const LayerRegion         &source_layerm = *fill_source->get_region(source_range.region());
+            assert(source_range.empty() || source_range.region() == surface_fill.region_id);
+            for (uint32_t fill_id : source_range) {
+                auto fill_begin = uint32_t(layerm.fills().size());
+                layerm.m_fills.entities.push_back(source_layerm.fills().entities[fill_id]->clone());
+                insert_fills_into_islands(*this, uint32_t(surface_fill.region_id), fill_begin, fill_begin + 1);
+            }
+            m_surface_fills_ranges[surface_fill_id] = { uint32_t(surface_fill.region_id), { surface_fill_begin, uint32_t(layerm.fills().size()) } };
+            continue;
+        }
 
         // apply half spacing using this flow's own spacing and generate infill
         FillParams params;
@@ -574,6 +609,7 @@ void Layer::make_fills(FillAdaptive::Octree* adaptive_fill_octree, FillAdaptive:
 				BOOST_LOG_TRIVIAL(trace) << "make_fills: no infill was generated for layer " << id();
 			}
 		}
+        m_surface_fills_ranges[surface_fill_id] = { uint32_t(surface_fill.region_id), { surface_fill_begin, uint32_t(layerm.fills().size()) } };
     }
 
 	for (LayerSlice &lslice : this->lslices_ex)
@@ -712,6 +748,8 @@ Polylines Layer::generate_sparse_infill_polylines_for_anchoring(FillAdaptive::Oc
 // Create ironing extrusions over top surfaces.
 void Layer::make_ironing()
 {
+    SLIC3R_TRACE_ZONE("Layer::make_ironing", "layer", this->id());
+    ExtrusionEntityArena::Scope arena_scope(&m_extrusion_arena);
 	// LayerRegion::slices contains surfaces marked with SurfaceType.
 	// Here we want to collect top surfaces extruded with the same extruder.
 	// A surface will be ironed with the same extruder to not contaminate the print with another material leaking from the nozzle.
@@ -18,30 +18,32 @@ Credits: David Eccles (gringer).
 
 // Generate an array of points that are in the same direction as the
 // basic printing line (i.e. Y points for columns, X points for rows)
+// for the grid cells [cellBegin, cellEnd) of the line.
 // Note: a negative offset only causes a change in the perpendicular
 // direction
-static std::vector<coordf_t> colinearPoints(const coordf_t offset, const size_t baseLocation, size_t gridLength)
+static std::vector<coordf_t> colinearPoints(const coordf_t offset, const size_t baseLocation, size_t cellBegin, size_t cellEnd)
 {
     const coordf_t offset2 = std::abs(offset / coordf_t(2.));
     std::vector<coordf_t> points;
-    points.push_back(baseLocation - offset2);
-    for (size_t i = 0; i < gridLength; ++i) {
+    points.push_back(baseLocation + cellBegin - offset2);
+    for (size_t i = cellBegin; i < cellEnd; ++i) {
         points.push_back(baseLocation + i + offset2);
         points.push_back(baseLocation + i + 1 - offset2);
     }
-    points.push_back(baseLocation + gridLength + offset2);
+    points.push_back(baseLocation + cellEnd + offset2);
     return points;
 }
 
 // Generate an array of points for the dimension that is perpendicular to
 // the basic printing line (i.e. X points for columns, Y points for rows)
-static std::vector<coordf_t> perpendPoints(const coordf_t offset, const size_t baseLocation, size_t gridLength)
+// for the grid cells [cellBegin, cellEnd) of the line.
+static std::vector<coordf_t> perpendPoints(const coordf_t offset, const size_t baseLocation, size_t cellBegin, size_t cellEnd)
 {
     coordf_t offset2 = offset / coordf_t(2.);
-    coord_t  side    = 2 * (baseLocation & 1) - 1;
+    coord_t  side    = 2 * ((cellBegin + baseLocation) & 1) - 1;
     std::vector<coordf_t> points;
     points.push_back(baseLocation - offset2 * side);
-    for (size_t i = 0; i < gridLength; ++i) {
+    for (size_t i = cellBegin; i < cellEnd; ++i) {
         side = 2*((i+baseLocation) & 1) - 1;
         points.push_back(baseLocation + offset2 * side);
         points.push_back(baseLocation + offset2 * side);
@@ -70,11 +72,38 @@ static inline Pointfs zip(const std::vector<coordf_t> &x, const std::vector<coor
     return out;
 }
 
+// Ranges of grid cells along the grid lines at [0, numLines], which cross the clipping polygons.
+// The polygons are given in units of the grid cells, their X axis runs along the grid lines.
+// The grid lines are offsetted by up to maxOffset in the perpendicular direction.
+static std::vector<std::vector<std::pair<size_t, size_t>>> lineCellRanges(const Polygons &clip, size_t numLines, size_t numCells, coordf_t maxOffset, coordf_t scaleFactor)
+{
+    std::vector<std::pair<double, double>> bands;
+    bands.reserve(numLines + 1);
+    for (size_t i = 0; i <= numLines; ++ i)
+        bands.emplace_back(std::clamp(coordf_t(i) - maxOffset, coordf_t(0.), coordf_t(numLines)) * scaleFactor, std::clamp(coordf_t(i) + maxOffset, coordf_t(0.), coordf_t(numLines)) * scaleFactor);
+    std::vector<Fill::Spans> spans = Fill::band_spans(clip, bands);
+    std::vector<std::vector<std::pair<size_t, size_t>>> out(bands.size());
+    for (size_t i = 0; i < spans.size(); ++ i)
+        for (const std::pair<double, double> &span : spans[i]) {
+            // The line points of a cell may reach half of the offset into the neighbor cells.
+            auto cellBegin = size_t(std::clamp(floor(span.first / scaleFactor - maxOffset), 0., double(numCells)));
+            auto cellEnd   = size_t(std::clamp(ceil(span.second / scaleFactor + maxOffset), 0., double(numCells)));
+            if (cellBegin >= cellEnd)
+                continue;
+            if (! out[i].empty() && cellBegin <= out[i].back().second)
+                out[i].back().second = std::max(out[i].back().second, cellEnd);
+            else
+                out[i].emplace_back(cellBegin, cellEnd);
+        }
+    return out;
+}
+
 // Generate a set of curves (array of array of 2d points) that describe a
 // horizontal slice of a truncated regular octahedron with edge length 1.
 // curveType specifies which lines to print, 1 for vertical lines
 // (columns), 2 for horizontal lines (rows), and 3 for both.
-static std::vector<Pointfs> makeNormalisedGrid(coordf_t z, size_t gridWidth, size_t gridHeight, size_t curveType)
+// Only the parts of the curves crossing the clipping polygons, given relative to the grid origin, are generated.
+static std::vector<Pointfs> makeNormalisedGrid(coordf_t z, size_t gridWidth, size_t gridHeight, size_t curveType, const Polygons &clip, coordf_t scaleFactor)
 {
     // offset required to create a regular octagram
     coordf_t octagramGap = coordf_t(0.5);
@@ -86,29 +115,40 @@ static std::vector<Pointfs> makeNormalisedGrid(coordf_t z, size_t gridWidth, siz
     
     std::vector<Pointfs> points;
     if ((curveType & 1) != 0) {
+        // The columns run along the Y axis.
+        Polygons clip_transposed = clip;
+        for (Polygon &polygon : clip_transposed)
+            for (Point &pt : polygon.points)
+                std::swap(pt.x(), pt.y());
+        std::vector<std::vector<std::pair<size_t, size_t>>> cellRanges = lineCellRanges(clip_transposed, gridWidth, gridHeight, std::abs(offset / 2.), scaleFactor);
         for (size_t x = 0; x <= gridWidth; ++x) {
-            points.push_back(Pointfs());
-            Pointfs &newPoints = points.back();
-            newPoints = zip(
-                perpendPoints(offset, x, gridHeight), 
-                colinearPoints(offset, 0, gridHeight));
-            // trim points to grid edges
-            trim(newPoints, coordf_t(0.), coordf_t(0.), coordf_t(gridWidth), coordf_t(gridHeight));
-            if (x & 1)
-                std::reverse(newPoints.begin(), newPoints.end());
+            for (const std::pair<size_t, size_t> &cells : cellRanges[x]) {
+                points.push_back(Pointfs());
+                Pointfs &newPoints = points.back();
+                newPoints = zip(
+                    perpendPoints(offset, x, cells.first, cells.second), 
+                    colinearPoints(offset, 0, cells.first, cells.second));
+                // trim points to grid edges
+                trim(newPoints, coordf_t(0.), coordf_t(0.), coordf_t(gridWidth), coordf_t(gridHeight));
+                if (x & 1)
+                    std::reverse(newPoints.begin(), newPoints.end());
+            }
         }
     }
     if ((curveType & 2) != 0) {
+        std::vector<std::vector<std::pair<size_t, size_t>>> cellRanges = lineCellRanges(clip, gridHeight, gridWidth, std::abs(offset / 2.), scaleFactor);
         for (size_t y = 0; y <= gridHeight; ++y) {
-            points.push_back(Pointfs());
-            Pointfs &newPoints = points.back();
-            newPoints = zip(
-                colinearPoints(offset, 0, gridWidth),
-                perpendPoints(offset, y, gridWidth));
-            // trim points to grid edges
-            trim(newPoints, coordf_t(0.), coordf_t(0.), coordf_t(gridWidth), coordf_t(gridHeight));
-            if (y & 1)
-                std::reverse(newPoints.begin(), newPoints.end());
+            for (const std::pair<size_t, size_t> &cells : cellRanges[y]) {
+                points.push_back(Pointfs());
+                Pointfs &newPoints = points.back();
+                newPoints = zip(
+                    colinearPoints(offset, 0, cells.first, cells.second),
+                    perpendPoints(offset, y, cells.first, cells.second));
+                // trim points to grid edges
+                trim(newPoints, coordf_t(0.), coordf_t(0.), coordf_t(gridWidth), coordf_t(gridHeight));
+                if (y & 1)
+                    std::reverse(newPoints.begin(), newPoints.end());
+            }
         }
     }
     return points;
@@ -117,11 +157,11 @@ static std::vector<Pointfs> makeNormalisedGrid(coordf_t z, size_t gridWidth, siz
 // Generate a set of curves (array of array of 2d points) that describe a
 // horizontal slice of a truncated regular octahedron with a specified
 // grid square size.
-static Polylines makeGrid(coord_t z, coord_t gridSize, size_t gridWidth, size_t gridHeight, size_t curveType)
+static Polylines makeGrid(coord_t z, coord_t gridSize, size_t gridWidth, size_t gridHeight, size_t curveType, const Polygons &clip)
 {
     coord_t  scaleFactor = gridSize;
     coordf_t normalisedZ = coordf_t(z) / coordf_t(scaleFactor);
-    std::vector<Pointfs> polylines = makeNormalisedGrid(normalisedZ, gridWidth, gridHeight, curveType);
+    std::vector<Pointfs> polylines = makeNormalisedGrid(normalisedZ, gridWidth, gridHeight, curveType, clip, coordf_t(scaleFactor));
     Polylines result;
     result.reserve(polylines.size());
     for (std::vector<Pointfs>::const_iterator it_polylines = polylines.begin(); it_polylines != polylines.end(); ++ it_polylines) {
@@ -150,12 +190,16 @@ void Fill3DHoneycomb::_fill_surface_single(
     bb.merge(align_to_grid(bb.min, Point(2*distance, 2*distance)));
     
     // generate pattern
+    Polygons    clip = to_polygons(expolygon);
+    for (Polygon &polygon : clip)
+        polygon.translate(- bb.min);
     Polylines   polylines = makeGrid(
         scale_(this->z),
         distance,
         ceil(bb.size()(0) / distance) + 1,
         ceil(bb.size()(1) / distance) + 1,
-        ((this->layer_id/thickness_layers) % 2) + 1);
+        ((this->layer_id/thickness_layers) % 2) + 1,
+        clip);
     
     // move pattern in place
 	for (Polyline &pl : polylines)
@@ -18,6 +18,9 @@ public:
 	// require bridge flow since most of this pattern hangs in air
     bool use_bridge_flow() const override { return true; }
 
+    // The octahedrons are sliced at the print Z.
+    bool depends_on_z() const override { return true; }
+
 protected:
 	void _fill_surface_single(
 	    const FillParams                &params, 
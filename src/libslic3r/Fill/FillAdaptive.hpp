@@ -58,6 +58,9 @@ class Filler : public Slic3r::Fill
 public:
     ~Filler() override {}
 
+    // The octree is sliced at the print Z.
+    bool depends_on_z() const override { return true; }
+
 protected:
     Fill* clone() const override { return new Filler(*this); }
 	void _fill_surface_single(
@@ -126,6 +126,60 @@ coord_t Fill::_adjust_solid_spacing(const coord_t width, const coord_t distance)
     return distance_new;
 }
 
+std::vector<Fill::Spans> Fill::band_spans(const Polygons &polygons, const std::vector<std::pair<double, double>> &bands)
+{
+    std::vector<Spans>               spans(bands.size());
+    // Intersections of the band boundaries with the polygon edges. The parts of the band boundaries inside the polygons
+    // are needed for bands crossing a polygon without any polygon vertex inside the band.
+    std::vector<std::vector<double>> crossings_lower(bands.size());
+    std::vector<std::vector<double>> crossings_upper(bands.size());
+    for (const Polygon &polygon : polygons)
+        for (size_t i = 0; i < polygon.points.size(); ++ i) {
+            Vec2d a = polygon.points[i].cast<double>();
+            Vec2d b = polygon.points[i + 1 == polygon.points.size() ? 0 : i + 1].cast<double>();
+            if (a.y() > b.y())
+                std::swap(a, b);
+            auto x_at = [&a, &b](double y) { return a.x() + (b.x() - a.x()) * (y - a.y()) / (b.y() - a.y()); };
+            // The bands are sorted, the first band which may intersect this edge is found by a binary search.
+            for (auto it_band = std::lower_bound(bands.begin(), bands.end(), a.y(), [](const std::pair<double, double> &band, double y) { return band.second < y; });
+                 it_band != bands.end() && it_band->first <= b.y(); ++ it_band) {
+                const size_t band_idx = it_band - bands.begin();
+                if (a.y() == b.y())
+                    spans[band_idx].emplace_back(std::min(a.x(), b.x()), std::max(a.x(), b.x()));
+                else {
+                    double x0 = x_at(std::max(a.y(), it_band->first));
+                    double x1 = x_at(std::min(b.y(), it_band->second));
+                    spans[band_idx].emplace_back(std::min(x0, x1), std::max(x0, x1));
+                    if (a.y() <= it_band->first && it_band->first < b.y())
+                        crossings_lower[band_idx].emplace_back(x_at(it_band->first));
+                    if (a.y() <= it_band->second && it_band->second < b.y())
+                        crossings_upper[band_idx].emplace_back(x_at(it_band->second));
+                }
+            }
+        }
+
+    for (size_t band_idx = 0; band_idx < bands.size(); ++ band_idx) {
+        Spans &this_spans = spans[band_idx];
+        for (std::vector<double> *crossings : { &crossings_lower[band_idx], &crossings_upper[band_idx] }) {
+            std::sort(crossings->begin(), crossings->end());
+            // Even-odd rule, the polygons are closed, thus the number of crossings is even.
+            for (size_t i = 0; i + 1 < crossings->size(); i += 2)
+                this_spans.emplace_back((*crossings)[i], (*crossings)[i + 1]);
+        }
+        // Merge the overlapping spans.
+        std::sort(this_spans.begin(), this_spans.end());
+        size_t j = 0;
+        for (size_t i = 1; i < this_spans.size(); ++ i)
+            if (this_spans[i].first <= this_spans[j].second)
+                this_spans[j].second = std::max(this_spans[j].second, this_spans[i].second);
+            else
+                this_spans[++ j] = this_spans[i];
+        if (! this_spans.empty())
+            this_spans.erase(this_spans.begin() + j + 1, this_spans.end());
+    }
+    return spans;
+}
+
 // Returns orientation of the infill and the reference point of the infill pattern.
 // For a normal print, the reference point is the center of a bounding box of the STL.
 std::pair<float, Point> Fill::_infill_direction(const Surface *surface) const
@@ -111,6 +111,9 @@ public:
     // Do not sort the fill lines to optimize the print head path?
     virtual bool no_sort() const { return false; }
 
+    // Does the pattern change with Z, not just by rotating the infill direction from layer to layer?
+    virtual bool depends_on_z() const { return false; }
+
     // Perform the fill.
     virtual Polylines fill_surface(const Surface *surface, const FillParams &params);
     virtual ThickPolylines fill_surface_arachne(const Surface *surface, const FillParams &params);
@@ -158,6 +161,13 @@ public:
     static void connect_base_support(Polylines &&infill_ordered, const Polygons &boundary_src, const BoundingBox &bbox, Polylines &polylines_out, const double spacing, const FillParams &params);
 
     static coord_t  _adjust_solid_spacing(const coord_t width, const coord_t distance);
+
+    // Sorted disjoint intervals of the X axis.
+    using Spans = std::vector<std::pair<double, double>>;
+    // For each horizontal band given by its Y interval, return the X intervals, at which the band intersects the polygons.
+    // Used by the patterns generated line by line to only generate the lines where they may intersect the infill area.
+    // Both the lower and the upper bounds of the bands have to be non-decreasing.
+    static std::vector<Spans> band_spans(const Polygons &polygons, const std::vector<std::pair<double, double>> &bands);
 };
 
 } // namespace Slic3r
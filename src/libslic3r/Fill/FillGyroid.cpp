@@ -9,44 +9,48 @@
 
 namespace Slic3r {
 
-static inline double f(double x, double z_sin, double z_cos, bool vertical, bool flip)
+// The gyroid wave. Evaluated either for a single abscissa or for an Eigen array of abscissas at once,
+// for which Eigen vectorizes the evaluation.
+template<typename T>
+static inline T f(const T &x, double z_sin, double z_cos, bool vertical, bool flip)
 {
+    using std::asin; using std::cos; using std::sin; using std::sqrt;
     if (vertical) {
         double phase_offset = (z_cos < 0 ? M_PI : 0) + M_PI;
-        double a   = sin(x + phase_offset);
+        T      a   = sin(x + phase_offset);
         double b   = - z_cos;
-        double res = z_sin * cos(x + phase_offset + (flip ? M_PI : 0.));
-        double r   = sqrt(sqr(a) + sqr(b));
-        return asin(a/r) + asin(res/r) + M_PI;
+        T      res = z_sin * cos(x + phase_offset + (flip ? M_PI : 0.));
+        T      r   = sqrt(a * a + sqr(b));
+        return asin(a / r) + asin(res / r) + M_PI;
     }
     else {
         double phase_offset = z_sin < 0 ? M_PI : 0.;
-        double a   = cos(x + phase_offset);
+        T      a   = cos(x + phase_offset);
         double b   = - z_sin;
-        double res = z_cos * sin(x + phase_offset + (flip ? 0 : M_PI));
-        double r   = sqrt(sqr(a) + sqr(b));
-        return (asin(a/r) + asin(res/r) + 0.5 * M_PI);
+        T      res = z_cos * sin(x + phase_offset + (flip ? 0 : M_PI));
+        T      r   = sqrt(a * a + sqr(b));
+        return (asin(a / r) + asin(res / r) + 0.5 * M_PI);
     }
 }
 
+// Wave made of the periods [period_begin, period_end) of one_period, trimmed to width.
 static inline Polyline make_wave(
     const std::vector<Vec2d>& one_period, double width, double height, double offset, double scaleFactor,
-    double z_cos, double z_sin, bool vertical, bool flip)
+    double z_cos, double z_sin, bool vertical, bool flip, size_t period_begin, size_t period_end)
 {
-    std::vector<Vec2d> points = one_period;
-    double period = points.back()(0);
+    std::vector<Vec2d> points;
+    double period = one_period.back()(0);
     if (width != period) // do not extend if already truncated
     {
-        points.reserve(one_period.size() * size_t(floor(width / period)));
-        points.pop_back();
-
-        size_t n = points.size();
-        do {
-            points.emplace_back(points[points.size()-n].x() + period, points[points.size()-n].y());
-        } while (points.back()(0) < width - EPSILON);
-
-        points.emplace_back(Vec2d(width, f(width, z_sin, z_cos, vertical, flip)));
-    }
+        const double x_end = std::min(width, double(period_end) * period);
+        points.reserve((one_period.size() - 1) * (period_end - period_begin) + 2);
+        for (size_t k = period_begin; points.empty() || points.back()(0) < x_end - EPSILON; ++ k)
+            for (size_t i = 0; i + 1 < one_period.size() && (points.empty() || points.back()(0) < x_end - EPSILON); ++ i)
+                points.emplace_back(one_period[i].x() + double(k) * period, one_period[i].y());
+        if (x_end == width)
+            points.emplace_back(Vec2d(width, f(width, z_sin, z_cos, vertical, flip)));
+    } else
+        points = one_period;
 
     // and construct the final polyline to return:
     Polyline polyline;
@@ -70,20 +74,32 @@ static std::vector<Vec2d> make_one_period(double width, double scaleFactor, doub
     points.reserve(coord_t(ceil(limit / tolerance / 3)));
 
     for (double x = 0.; x < limit - EPSILON; x += dx) {
-        points.emplace_back(Vec2d(x, f(x, z_sin, z_cos, vertical, flip)));
+        points.emplace_back(Vec2d(x, 0.));
+    }
+    points.emplace_back(Vec2d(limit, 0.));
+    {
+        Eigen::ArrayXd xs(points.size());
+        for (size_t i = 0; i < points.size(); ++ i)
+            xs[i] = points[i].x();
+        Eigen::ArrayXd ys = f(xs, z_sin, z_cos, vertical, flip);
+        for (size_t i = 0; i < points.size(); ++ i)
+            points[i].y() = ys[i];
     }
-    points.emplace_back(Vec2d(limit, f(limit, z_sin, z_cos, vertical, flip)));
 
     // piecewise increase in resolution up to requested tolerance
+    Eigen::ArrayXd xs;
     for(;;)
     {
+        // Evaluate the wave at the centers of all the segments at once.
         size_t size = points.size();
-        for (unsigned int i = 1;i < size; ++i) {
-            auto& lp = points[i-1]; // left point
-            auto& rp = points[i];   // right point
-            double x = lp(0) + (rp(0) - lp(0)) / 2;
-            double y = f(x, z_sin, z_cos, vertical, flip);
-            Vec2d ip = {x, y};
+        xs.resize(size - 1);
+        for (size_t i = 1; i < size; ++ i)
+            xs[i - 1] = points[i - 1](0) + (points[i](0) - points[i - 1](0)) / 2;
+        Eigen::ArrayXd ys = f(xs, z_sin, z_cos, vertical, flip);
+        for (size_t i = 1; i < size; ++i) {
+            Vec2d lp = points[i-1]; // left point
+            Vec2d rp = points[i];   // right point
+            Vec2d ip = {xs[i - 1], ys[i - 1]};
             if (std::abs(cross2(Vec2d(ip - lp), Vec2d(ip - rp))) > sqr(tolerance)) {
                 points.emplace_back(std::move(ip));
             }
@@ -102,7 +118,9 @@ static std::vector<Vec2d> make_one_period(double width, double scaleFactor, doub
     return points;
 }
 
-static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double line_spacing, double width, double height)
+// Generate the gyroid waves, which may intersect the clipping polygons, given relative to the origin of the waves.
+// Only the periods of the waves crossing the clipping polygons are generated.
+static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double line_spacing, double width, double height, Polygons clip)
 {
     const double scaleFactor = scale_(line_spacing) / density_adjusted;
 
@@ -125,21 +143,62 @@ static Polylines make_gyroid_waves(double gridZ, double density_adjusted, double
         lower_bound = -M_PI;
         upper_bound = width - M_PI_2;
         std::swap(width,height);
+        // Vertical waves run along the Y axis.
+        for (Polygon &polygon : clip)
+            for (Point &pt : polygon.points)
+                std::swap(pt.x(), pt.y());
     }
 
     std::vector<Vec2d> one_period_odd = make_one_period(width, scaleFactor, z_cos, z_sin, vertical, flip, tolerance); // creates one period of the waves, so it doesn't have to be recalculated all the time
     flip = !flip;                                                                   // even polylines are a bit shifted
     std::vector<Vec2d> one_period_even = make_one_period(width, scaleFactor, z_cos, z_sin, vertical, flip, tolerance);
-    Polylines result;
 
-    for (double y0 = lower_bound; y0 < upper_bound + EPSILON; y0 += M_PI) {
-        // creates odd polylines
-        result.emplace_back(make_wave(one_period_odd, width, height, y0, scaleFactor, z_cos, z_sin, vertical, flip));
-        // creates even polylines
-        y0 += M_PI;
-        if (y0 < upper_bound + EPSILON) {
-            result.emplace_back(make_wave(one_period_even, width, height, y0, scaleFactor, z_cos, z_sin, vertical, flip));
+    // Offsets of the odd and even waves.
+    std::vector<double> offsets;
+    for (double y0 = lower_bound; y0 < upper_bound + EPSILON; y0 += M_PI)
+        offsets.emplace_back(y0);
+    // Bands covered by the waves, clamped the same way as in make_wave(), in scaled coordinates.
+    double wave_min = std::numeric_limits<double>::max();
+    double wave_max = std::numeric_limits<double>::lowest();
+    for (const std::vector<Vec2d> *one_period : { &one_period_odd, &one_period_even })
+        for (const Vec2d &pt : *one_period) {
+            wave_min = std::min(wave_min, pt.y());
+            wave_max = std::max(wave_max, pt.y());
+        }
+    // The end points of the waves are not part of the periods, thus leave some margin.
+    wave_min -= 1.;
+    wave_max += 1.;
+    std::vector<std::pair<double, double>> bands;
+    bands.reserve(offsets.size());
+    for (double y0 : offsets)
+        bands.emplace_back(std::clamp(y0 + wave_min, 0., height) * scaleFactor, std::clamp(y0 + wave_max, 0., height) * scaleFactor);
+    std::vector<Fill::Spans> spans = Fill::band_spans(clip, bands);
+
+    const double period      = one_period_odd.back()(0);
+    const auto   num_periods = size_t(ceil(width / period));
+    Polylines result;
+    for (size_t i = 0; i < offsets.size(); ++ i) {
+        // creates odd polylines and even polylines
+        const std::vector<Vec2d> &one_period = (i & 1) ? one_period_even : one_period_odd;
+        // Ranges of periods overlapping the spans.
+        size_t period_begin = 0;
+        size_t period_end   = 0;
+        for (const std::pair<double, double> &span : spans[i]) {
+            auto span_begin = size_t(std::clamp(floor(span.first  / scaleFactor / period), 0., double(num_periods)));
+            auto span_end   = std::min(std::max(size_t(std::clamp(ceil(span.second / scaleFactor / period), 0., double(num_periods))), span_begin + 1), num_periods);
+            if (span_begin >= span_end)
+                continue;
+            if (period_begin < period_end && span_begin <= period_end)
+                period_end = std::max(period_end, span_end);
+            else {
+                if (period_begin < period_end)
+                    result.emplace_back(make_wave(one_period, width, height, offsets[i], scaleFactor, z_cos, z_sin, vertical, flip, period_begin, period_end));
+                period_begin = span_begin;
+                period_end   = span_end;
+            }
         }
+        if (period_begin < period_end)
+            result.emplace_back(make_wave(one_period, width, height, offsets[i], scaleFactor, z_cos, z_sin, vertical, flip, period_begin, period_end));
     }
 
     return result;
@@ -169,12 +228,16 @@ void FillGyroid::_fill_surface_single(
     bb.merge(align_to_grid(bb.min, Point(2*M_PI*distance, 2*M_PI*distance)));
 
     // generate pattern
+    Polygons clip = to_polygons(expolygon);
+    for (Polygon &polygon : clip)
+        polygon.translate(- bb.min);
     Polylines polylines = make_gyroid_waves(
         scale_(this->z),
         density_adjusted,
         this->spacing,
         ceil(bb.size()(0) / distance) + 1.,
-        ceil(bb.size()(1) / distance) + 1.);
+        ceil(bb.size()(1) / distance) + 1.,
+        std::move(clip));
 
 	// shift the polyline to the grid origin
 	for (Polyline &pl : polylines)
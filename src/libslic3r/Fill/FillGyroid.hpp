@@ -16,6 +16,9 @@ public:
     // require bridge flow since most of this pattern hangs in air
     bool use_bridge_flow() const override { return false; }
 
+    // The gyroid is evaluated at the print Z.
+    bool depends_on_z() const override { return true; }
+
     // Correction applied to regular infill angle to maximize printing
     // speed in default configuration (degrees)
     static constexpr float CorrectionAngle = -45.;
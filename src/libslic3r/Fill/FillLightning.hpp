@@ -22,6 +22,8 @@ public:
     ~Filler() override = default;
 
     Generator   *generator { nullptr };
+    // The trees are grown separately for each layer.
+    bool depends_on_z() const override { return true; }
 protected:
     Fill* clone() const override { return new Filler(*this); }
 
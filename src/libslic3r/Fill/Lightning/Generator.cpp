@@ -2,11 +2,17 @@
 //CuraEngine is released under the terms of the AGPLv3 or higher.
 
 #include "Generator.hpp"
+#include "DistanceField.hpp"
 #include "TreeNode.hpp"
 
 #include "../../ClipperUtils.hpp"
 #include "../../Layer.hpp"
 #include "../../Print.hpp"
+#include "../../Trace.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 /* Possible future tasks/optimizations,etc.:
  * - Improve connecting heuristic to favor connecting to shorter trees
@@ -48,33 +54,49 @@ Generator::Generator(const PrintObject &print_object, const coordf_t fill_densit
     m_prune_length                                    = coord_t(layer_thickness * std::tan(lightning_infill_prune_angle));
     m_straightening_max_distance                      = coord_t(layer_thickness * std::tan(lightning_infill_straightening_angle));
 
-    generateInitialInternalOverhangs(print_object, throw_on_cancel_callback);
-    generateTrees(print_object, throw_on_cancel_callback);
+    const std::vector<Polygons> infill_outlines = collectInfillOutlines(print_object, throw_on_cancel_callback);
+    generateInitialInternalOverhangs(infill_outlines, throw_on_cancel_callback);
+    generateTrees(infill_outlines, throw_on_cancel_callback);
 }
 
-void Generator::generateInitialInternalOverhangs(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+std::vector<Polygons> Generator::collectInfillOutlines(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
 {
-    m_overhang_per_layer.resize(print_object.layers().size());
+    SLIC3R_TRACE_ZONE("FillLightning::collectInfillOutlines");
+    std::vector<Polygons> infill_outlines(print_object.layers().size(), Polygons());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, print_object.layers().size()),
+        [&print_object, &infill_outlines, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_id = range.begin(); layer_id < range.end(); ++ layer_id) {
+                throw_on_cancel_callback();
+                Polygons &outlines = infill_outlines[layer_id];
+                for (const LayerRegion *layerm : print_object.get_layer(int(layer_id))->regions())
+                    for (const Surface &surface : layerm->fill_surfaces())
+                        if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
+                            append(outlines, to_polygons(surface.expolygon));
+                outlines = union_(outlines);
+            }
+        });
+    return infill_outlines;
+}
 
-    Polygons infill_area_above;
-    // Iterate from top to bottom, to subtract the overhang areas above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
-    for (int layer_nr = int(print_object.layers().size()) - 1; layer_nr >= 0; --layer_nr) {
-        throw_on_cancel_callback();
-        Polygons infill_area_here;
-        for (const LayerRegion* layerm : print_object.get_layer(layer_nr)->regions())
-            for (const Surface& surface : layerm->fill_surfaces())
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_area_here, to_polygons(surface.expolygon));
-
-        infill_area_here = union_(infill_area_here);
-        // Remove the part of the infill area that is already supported by the walls.
-        Polygons overhang = diff(offset(infill_area_here, -float(m_wall_supporting_radius)), infill_area_above);
-        // Filter out unprintable polygons and near degenerated polygons (three almost collinear points and so).
-        overhang = opening(overhang, float(SCALED_EPSILON), float(SCALED_EPSILON));
-
-        m_overhang_per_layer[layer_nr] = overhang;
-        infill_area_above = std::move(infill_area_here);
-    }
+void Generator::generateInitialInternalOverhangs(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback)
+{
+    SLIC3R_TRACE_ZONE("FillLightning::generateInitialInternalOverhangs");
+    m_overhang_per_layer.resize(infill_outlines.size());
+
+    // Subtract the infill area above from the overhang areas on the layer below, to get only overhang in the top layer where it is overhanging.
+    // Each layer only depends on the infill areas of itself and of the layer above, thus the layers are processed in parallel.
+    const Polygons no_infill_above;
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, infill_outlines.size()),
+        [this, &infill_outlines, &no_infill_above, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_nr = range.begin(); layer_nr < range.end(); ++ layer_nr) {
+                throw_on_cancel_callback();
+                const Polygons &infill_area_above = layer_nr + 1 < infill_outlines.size() ? infill_outlines[layer_nr + 1] : no_infill_above;
+                // Remove the part of the infill area that is already supported by the walls.
+                Polygons overhang = diff(offset(infill_outlines[layer_nr], -float(m_wall_supporting_radius)), infill_area_above);
+                // Filter out unprintable polygons and near degenerated polygons (three almost collinear points and so).
+                m_overhang_per_layer[layer_nr] = opening(overhang, float(SCALED_EPSILON), float(SCALED_EPSILON));
+            }
+        });
 }
 
 const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
@@ -83,39 +105,54 @@ const Layer& Generator::getTreesForLayer(const size_t& layer_id) const
     return m_lightning_layers[layer_id];
 }
 
-void Generator::generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback)
+void Generator::generateTrees(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback)
 {
-    m_lightning_layers.resize(print_object.layers().size());
-
-    std::vector<Polygons> infill_outlines(print_object.layers().size(), Polygons());
-
-    // For-each layer from top to bottom:
-    for (int layer_id = int(print_object.layers().size()) - 1; layer_id >= 0; layer_id--) {
-        throw_on_cancel_callback();
-        for (const LayerRegion *layerm : print_object.get_layer(layer_id)->regions())
-            for (const Surface &surface : layerm->fill_surfaces())
-                if (surface.surface_type == stInternal || surface.surface_type == stInternalVoid)
-                    append(infill_outlines[layer_id], to_polygons(surface.expolygon));
-
-        infill_outlines[layer_id] = union_(infill_outlines[layer_id]);
-    }
+    SLIC3R_TRACE_ZONE("FillLightning::generateTrees");
+    m_lightning_layers.resize(infill_outlines.size());
+    if (infill_outlines.empty())
+        return;
 
     // For various operations its beneficial to quickly locate nearby features on the polygon:
-    const size_t top_layer_id = print_object.layers().size() - 1;
+    const size_t top_layer_id = infill_outlines.size() - 1;
     EdgeGrid::Grid outlines_locator(get_extents(infill_outlines[top_layer_id]).inflated(SCALED_EPSILON));
     outlines_locator.create(infill_outlines[top_layer_id], locator_cell_size);
 
+    // The trees have to be generated from top to bottom, as the trees of a layer are propagated to the layer below.
+    // The distance fields only depend on the outlines and overhangs of their own layer, thus they are built in parallel
+    // for a batch of layers ahead of the tree generation. The batches are limited to bound the memory footprint.
+    const size_t                                batch_size  = 2 * size_t(tbb::this_task_arena::max_concurrency());
+    std::vector<std::unique_ptr<DistanceField>> distance_fields(batch_size);
+    size_t                                      batch_begin = infill_outlines.size();
+
     // For-each layer from top to bottom:
     for (int layer_id = int(top_layer_id); layer_id >= 0; layer_id--) {
         throw_on_cancel_callback();
+        if (size_t(layer_id) < batch_begin) {
+            // Build the distance fields of the next batch of layers below.
+            const size_t batch_end = size_t(layer_id) + 1;
+            batch_begin = batch_end - std::min(batch_size, batch_end);
+            SLIC3R_TRACE_ZONE("FillLightning::generateDistanceFields", "layer", int64_t(layer_id));
+            tbb::parallel_for(tbb::blocked_range<size_t>(batch_begin, batch_end),
+                [this, &infill_outlines, &distance_fields, batch_begin, &throw_on_cancel_callback](const tbb::blocked_range<size_t> &range) {
+                    for (size_t batch_layer_id = range.begin(); batch_layer_id < range.end(); ++ batch_layer_id) {
+                        throw_on_cancel_callback();
+                        const Polygons &outlines = infill_outlines[batch_layer_id];
+                        distance_fields[batch_layer_id - batch_begin] = std::make_unique<DistanceField>(m_supporting_radius, outlines, get_extents(outlines), m_overhang_per_layer[batch_layer_id]);
+                    }
+                });
+        }
+
+        SLIC3R_TRACE_ZONE("FillLightning::generateLayerTrees", "layer", int64_t(layer_id));
         Layer             &current_lightning_layer = m_lightning_layers[layer_id];
         const Polygons    &current_outlines        = infill_outlines[layer_id];
         const BoundingBox &current_outlines_bbox   = get_extents(current_outlines);
+        std::unique_ptr<DistanceField> distance_field = std::move(distance_fields[size_t(layer_id) - batch_begin]);
 
         // register all trees propagated from the previous layer as to-be-reconnected
         std::vector<NodeSPtr> to_be_reconnected_tree_roots = current_lightning_layer.tree_roots;
 
-        current_lightning_layer.generateNewTrees(m_overhang_per_layer[layer_id], current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
+        current_lightning_layer.generateNewTrees(*distance_field, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius, throw_on_cancel_callback);
+        distance_field.reset();
         current_lightning_layer.reconnectRoots(to_be_reconnected_tree_roots, current_outlines, current_outlines_bbox, outlines_locator, m_supporting_radius, m_wall_supporting_radius);
 
         // Initialize trees for next lower layer from the current one.
@@ -133,9 +170,19 @@ void Generator::generateTrees(const PrintObject &print_object, const std::functi
         outlines_locator.set_bbox(below_outlines_bbox);
         outlines_locator.create(below_outlines, locator_cell_size);
 
+        // Each tree is propagated to a copy of its own, thus the trees are propagated in parallel.
+        // The propagated trees are collected per source tree and then concatenated in the order of the source trees
+        // to produce the same result as the sequential propagation.
+        const std::vector<NodeSPtr> &tree_roots = current_lightning_layer.tree_roots;
+        std::vector<std::vector<NodeSPtr>> lower_trees_per_tree(tree_roots.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, tree_roots.size()),
+            [this, &tree_roots, &lower_trees_per_tree, &below_outlines, &outlines_locator](const tbb::blocked_range<size_t> &range) {
+                for (size_t tree_idx = range.begin(); tree_idx < range.end(); ++ tree_idx)
+                    tree_roots[tree_idx]->propagateToNextLayer(lower_trees_per_tree[tree_idx], below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, locator_cell_size / 2);
+            });
         std::vector<NodeSPtr>& lower_trees = m_lightning_layers[layer_id - 1].tree_roots;
-        for (auto& tree : current_lightning_layer.tree_roots)
-            tree->propagateToNextLayer(lower_trees, below_outlines, outlines_locator, m_prune_length, m_straightening_max_distance, locator_cell_size / 2);
+        for (std::vector<NodeSPtr> &trees : lower_trees_per_tree)
+            append(lower_trees, std::move(trees));
     }
 }
 
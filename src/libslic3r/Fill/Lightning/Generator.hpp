@@ -60,6 +60,12 @@ public:
     float infilll_extrusion_width() const { return m_infill_extrusion_width; }
 
 protected:
+    /*!
+     * Collect the infill areas of all layers of the object, one union of the
+     * internal and internal void surfaces of all regions per layer.
+     */
+    static std::vector<Polygons> collectInfillOutlines(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+
     /*!
      * Calculate the overhangs above the infill areas that need to be supported
      * by infill.
@@ -68,12 +74,12 @@ protected:
      * only when support is generated. For this pattern, we also need to
      * generate overhang areas for the inside of the model.
      */
-    void generateInitialInternalOverhangs(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+    void generateInitialInternalOverhangs(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback);
 
     /*!
      * Calculate the tree structure of all layers.
      */
-    void generateTrees(const PrintObject &print_object, const std::function<void()> &throw_on_cancel_callback);
+    void generateTrees(const std::vector<Polygons> &infill_outlines, const std::function<void()> &throw_on_cancel_callback);
 
     float m_infill_extrusion_width;
 
@@ -16,6 +16,7 @@
 namespace Slic3r::FillLightning
 {
 
+class DistanceField;
 class Node;
 using NodeSPtr = std::shared_ptr<Node>;
 using SparseNodeGrid = std::unordered_multimap<Point, std::weak_ptr<Node>, PointHash>;
@@ -37,9 +38,13 @@ class Layer
 public:
     std::vector<NodeSPtr> tree_roots;
 
+    /*!
+     * Support the points of the distance field not supported yet by new trees or by new branches of the existing trees.
+     * \param distance_field The points to support, built from the overhang of this layer. It is consumed by this call.
+     */
     void generateNewTrees
     (
-        const Polygons& current_overhang,
+        DistanceField& distance_field,
         const Polygons& current_outlines,
         const BoundingBox& current_outlines_bbox,
         const EdgeGrid::Grid& outline_locator,
@@ -22,6 +22,7 @@
 #include <boost/bimap.hpp>
 #include <boost/filesystem.hpp>
 
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/spirit/include/karma.hpp>
@@ -34,11 +35,15 @@ namespace pt = boost::property_tree;
 #include <expat.h>
 #include <Eigen/Dense>
 #include "miniz_extension.hpp"
+#include "ParallelZipWriter.hpp"
 
 #include "TextConfiguration.hpp"
 
 #include <fast_float/fast_float.h>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 // Slightly faster than sprintf("%.9g"), but there is an issue with the karma floating point formatter,
 // https://github.com/boostorg/spirit/pull/586
 // where the exported string is one digit shorter than it should be to guarantee lossless round trip.
@@ -296,6 +301,236 @@ bool is_valid_object_type(const std::string& type)
 
 namespace Slic3r {
 
+    // Content of a <vertices> or <triangles> element of the model XML, parsed in parallel ahead of the XML parser.
+    struct MeshBlock
+    {
+        enum class Type { Vertices, Triangles };
+
+        Type   type;
+        // Span of the content of the element in the model XML. The XML parser is not fed with the content once it has been parsed.
+        size_t content_begin;
+        size_t content_end;
+        bool   parsed { false };
+        // Vertices in the units of the model XML.
+        std::vector<Vec3f>       vertices;
+        std::vector<Vec3i>       triangles;
+        std::vector<std::string> custom_supports;
+        std::vector<std::string> custom_seam;
+        std::vector<std::string> mmu_segmentation;
+
+        MeshBlock(Type type, size_t content_begin, size_t content_end) : type(type), content_begin(content_begin), content_end(content_end) {}
+    };
+
+    static inline bool is_xml_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    // Index of the '>' closing a tag, skipping quoted attribute values, which may contain '>'.
+    static size_t find_xml_tag_end(const std::string_view xml, size_t pos)
+    {
+        for (char quote = 0; pos < xml.size(); ++ pos)
+            if (quote != 0) {
+                if (xml[pos] == quote)
+                    quote = 0;
+            } else if (xml[pos] == '"' || xml[pos] == '\'')
+                quote = xml[pos];
+            else if (xml[pos] == '>')
+                return pos;
+        return std::string_view::npos;
+    }
+
+    // Find the <vertices> and <triangles> elements of the model XML in the order the XML parser will report them.
+    // Returns no blocks if the XML contains constructs, which could hide tags from this simple scanner or alter the content
+    // (DOCTYPE with entity declarations, comments or processing instructions inside the mesh elements).
+    static std::vector<MeshBlock> find_mesh_blocks(const std::string_view xml)
+    {
+        std::vector<MeshBlock> blocks;
+        for (size_t pos = xml.find('<'); pos != std::string_view::npos; pos = xml.find('<', pos)) {
+            const std::string_view tag = xml.substr(pos);
+            if (boost::starts_with(tag, "<!--") || boost::starts_with(tag, "<![CDATA[") || boost::starts_with(tag, "<?")) {
+                const char *terminator = tag[1] == '?' ? "?>" : tag[2] == '-' ? "-->" : "]]>";
+                if (pos = xml.find(terminator, pos); pos == std::string_view::npos)
+                    return {};
+                continue;
+            }
+            if (boost::starts_with(tag, "<!"))
+                return {};
+            size_t name_end = pos + 1;
+            for (; name_end < xml.size() && ! is_xml_whitespace(xml[name_end]) && xml[name_end] != '>' && xml[name_end] != '/'; ++ name_end) ;
+            const std::string_view name = xml.substr(pos + 1, name_end - pos - 1);
+            const size_t tag_end = find_xml_tag_end(xml, name_end);
+            if (tag_end == std::string_view::npos)
+                return {};
+            pos = tag_end + 1;
+            if (name != VERTICES_TAG && name != TRIANGLES_TAG)
+                continue;
+            const MeshBlock::Type type = name == VERTICES_TAG ? MeshBlock::Type::Vertices : MeshBlock::Type::Triangles;
+            if (xml[tag_end - 1] == '/') {
+                // Empty element.
+                blocks.emplace_back(type, pos, pos).parsed = true;
+                continue;
+            }
+            // Without comments, CDATA and processing instructions in the content, the first end tag closes the element,
+            // as '<' is not allowed in attribute values.
+            const std::string end_tag = std::string("</") + std::string(name);
+            size_t content_end = pos;
+            for (;; content_end += end_tag.size()) {
+                if (content_end = xml.find(end_tag, content_end); content_end == std::string_view::npos)
+                    return {};
+                const char c = content_end + end_tag.size() < xml.size() ? xml[content_end + end_tag.size()] : 0;
+                if (c == '>' || is_xml_whitespace(c))
+                    break;
+            }
+            const std::string_view content = xml.substr(pos, content_end - pos);
+            if (content.find("<!") != std::string_view::npos || content.find("<?") != std::string_view::npos)
+                return {};
+            blocks.emplace_back(type, pos, content_end);
+            pos = content_end;
+        }
+        return blocks;
+    }
+
+    // Parse the elements of a span of content of a <vertices> or <triangles> element, calling element_fn(attributes) for each
+    // <vertex> or <triangle> element. Returns false if the span contains anything but whitespaces and the expected elements with
+    // attribute values free of entity references and of characters normalized by the XML parser.
+    template<typename ElementFn>
+    static bool parse_mesh_block_elements(const std::string_view content, const std::string_view element, ElementFn element_fn)
+    {
+        std::vector<std::pair<std::string_view, std::string_view>> attributes;
+        for (size_t pos = 0;;) {
+            for (; pos < content.size() && is_xml_whitespace(content[pos]); ++ pos) ;
+            if (pos == content.size())
+                return true;
+            if (content[pos] != '<')
+                return false;
+            const bool end_tag = pos + 1 < content.size() && content[pos + 1] == '/';
+            pos += end_tag ? 2 : 1;
+            if (content.compare(pos, element.size(), element) != 0)
+                return false;
+            pos += element.size();
+            attributes.clear();
+            for (;;) {
+                size_t name_begin = pos;
+                for (; pos < content.size() && is_xml_whitespace(content[pos]); ++ pos) ;
+                if (pos == content.size())
+                    return false;
+                if (content[pos] == '>' || (! end_tag && content.compare(pos, 2, "/>") == 0)) {
+                    pos += content[pos] == '>' ? 1 : 2;
+                    break;
+                }
+                if (end_tag || pos == name_begin)
+                    // Attributes have to be separated by a whitespace, an end tag has no attributes.
+                    return false;
+                name_begin = pos;
+                for (; pos < content.size() && content[pos] != '=' && ! is_xml_whitespace(content[pos]); ++ pos) ;
+                const std::string_view name = content.substr(name_begin, pos - name_begin);
+                for (; pos < content.size() && is_xml_whitespace(content[pos]); ++ pos) ;
+                if (pos == content.size() || content[pos] != '=')
+                    return false;
+                for (++ pos; pos < content.size() && is_xml_whitespace(content[pos]); ++ pos) ;
+                if (pos == content.size() || (content[pos] != '"' && content[pos] != '\''))
+                    return false;
+                const size_t value_end = content.find(content[pos], pos + 1);
+                if (value_end == std::string_view::npos)
+                    return false;
+                const std::string_view value = content.substr(pos + 1, value_end - pos - 1);
+                if (value.find_first_of("&<\t\r\n") != std::string_view::npos)
+                    return false;
+                attributes.emplace_back(name, value);
+                pos = value_end + 1;
+            }
+            if (! end_tag)
+                element_fn(attributes);
+        }
+    }
+
+    static std::string_view mesh_block_attribute(const std::vector<std::pair<std::string_view, std::string_view>> &attributes, const char *name)
+    {
+        for (const auto &attribute : attributes)
+            if (attribute.first == name)
+                return attribute.second;
+        return {};
+    }
+
+    // Parse a span of content of a <vertices> or <triangles> element the same way the XML handlers would.
+    static void parse_mesh_block(const std::string_view xml, MeshBlock &block)
+    {
+        const std::string_view content = xml.substr(block.content_begin, block.content_end - block.content_begin);
+        if (block.type == MeshBlock::Type::Vertices) {
+            block.parsed = parse_mesh_block_elements(content, VERTEX_TAG, [&block](const auto &attributes) {
+                // missing values are set equal to ZERO
+                Vec3f &v = block.vertices.emplace_back(Vec3f::Zero());
+                for (int i = 0; i < 3; ++ i) {
+                    const std::string_view value = mesh_block_attribute(attributes, i == 0 ? X_ATTR : i == 1 ? Y_ATTR : Z_ATTR);
+                    fast_float::from_chars(value.data(), value.data() + value.size(), v[i]);
+                }
+            });
+        } else {
+            block.parsed = parse_mesh_block_elements(content, TRIANGLE_TAG, [&block](const auto &attributes) {
+                // missing values are set equal to ZERO
+                Vec3i &t = block.triangles.emplace_back(Vec3i::Zero());
+                for (int i = 0; i < 3; ++ i) {
+                    const std::string_view value = mesh_block_attribute(attributes, i == 0 ? V1_ATTR : i == 1 ? V2_ATTR : V3_ATTR);
+                    const char *begin = value.data();
+                    boost::spirit::qi::parse(begin, value.data() + value.size(), boost::spirit::qi::int_, t[i]);
+                }
+                block.custom_supports.emplace_back(mesh_block_attribute(attributes, CUSTOM_SUPPORTS_ATTR));
+                block.custom_seam.emplace_back(mesh_block_attribute(attributes, CUSTOM_SEAM_ATTR));
+                block.mmu_segmentation.emplace_back(mesh_block_attribute(attributes, MMU_SEGMENTATION_ATTR));
+            });
+        }
+    }
+
+    // Find and parse the mesh elements of the model XML. Meshes are parsed in parallel, huge meshes are split into chunks at element boundaries.
+    // Blocks, which could not be parsed, are left to the XML parser.
+    static std::vector<MeshBlock> parse_mesh_blocks(const std::string_view xml)
+    {
+        std::vector<MeshBlock> blocks = find_mesh_blocks(xml);
+
+        static constexpr const size_t chunk_size = 1024 * 1024;
+        std::vector<MeshBlock>         chunks;
+        std::vector<size_t>            chunk_to_block;
+        for (size_t block_idx = 0; block_idx < blocks.size(); ++ block_idx) {
+            const MeshBlock &block = blocks[block_idx];
+            for (size_t begin = block.content_begin; begin < block.content_end;) {
+                size_t end = begin + chunk_size >= block.content_end ? block.content_end :
+                    std::min(block.content_end, xml.find('<', begin + chunk_size));
+                chunks.emplace_back(block.type, begin, end);
+                chunk_to_block.emplace_back(block_idx);
+                begin = end;
+            }
+        }
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, chunks.size(), 1), [xml, &chunks](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                parse_mesh_block(xml, chunks[i]);
+        });
+
+        for (MeshBlock &block : blocks)
+            if (block.content_begin < block.content_end)
+                block.parsed = true;
+        for (size_t i = 0; i < chunks.size(); ++ i)
+            blocks[chunk_to_block[i]].parsed &= chunks[i].parsed;
+        // Merge the chunks of the blocks, which were parsed completely.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, blocks.size(), 1), [&blocks, &chunks, &chunk_to_block](const tbb::blocked_range<size_t> &range) {
+            auto append = [](auto &dst, auto &src) {
+                if (dst.empty())
+                    dst = std::move(src);
+                else
+                    dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+            };
+            for (size_t block_idx = range.begin(); block_idx < range.end(); ++ block_idx)
+                if (MeshBlock &block = blocks[block_idx]; block.parsed)
+                    for (auto it = std::lower_bound(chunk_to_block.begin(), chunk_to_block.end(), block_idx); it != chunk_to_block.end() && *it == block_idx; ++ it) {
+                        MeshBlock &chunk = chunks[it - chunk_to_block.begin()];
+                        append(block.vertices,         chunk.vertices);
+                        append(block.triangles,        chunk.triangles);
+                        append(block.custom_supports,  chunk.custom_supports);
+                        append(block.custom_seam,      chunk.custom_seam);
+                        append(block.mmu_segmentation, chunk.mmu_segmentation);
+                    }
+        });
+        return blocks;
+    }
+
     // Base class with error messages management
     class _3MF_Base
     {
@@ -472,6 +707,10 @@ namespace Slic3r {
         Model* m_model;
         float m_unit_factor;
         CurrentObject m_curr_object;
+        // Mesh elements of the model XML parsed ahead of the XML parser, in the order of their appearance.
+        std::vector<MeshBlock> m_mesh_blocks;
+        size_t m_next_vertices_block { 0 };
+        size_t m_next_triangles_block { 0 };
         IdToModelObjectMap m_objects;
         IdToAliasesMap m_objects_aliases;
         InstancesList m_instances;
@@ -544,6 +783,8 @@ namespace Slic3r {
 
         bool _handle_start_vertices(const char** attributes, unsigned int num_attributes);
         bool _handle_end_vertices();
+        // Next mesh block of the given type, nullptr if the model XML was not scanned for mesh blocks.
+        MeshBlock* _next_mesh_block(MeshBlock::Type type);
 
         bool _handle_start_vertex(const char** attributes, unsigned int num_attributes);
         bool _handle_end_vertex();
@@ -940,31 +1181,43 @@ namespace Slic3r {
         XML_SetElementHandler(m_xml_parser, _3MF_Importer::_handle_start_model_xml_element, _3MF_Importer::_handle_end_model_xml_element);
         XML_SetCharacterDataHandler(m_xml_parser, _3MF_Importer::_handle_model_xml_characters);
 
-        struct CallbackData
-        {
-            XML_Parser& parser;
-            _3MF_Importer& importer;
-            const mz_zip_archive_file_stat& stat;
-
-            CallbackData(XML_Parser& parser, _3MF_Importer& importer, const mz_zip_archive_file_stat& stat) : parser(parser), importer(importer), stat(stat) {}
-        };
-
-        CallbackData data(m_xml_parser, *this, stat);
+        // The whole model entry is decompressed into a single string to find and parse the meshes in parallel.
+        // This raises the peak memory by the uncompressed size of the model XML compared to streaming it into expat,
+        // which a model with huge meshes may feel.
+        std::string xml((size_t)stat.m_uncomp_size, 0);
+        if (mz_zip_reader_extract_to_mem(&archive, stat.m_file_index, (void*)xml.data(), xml.size(), 0) == 0) {
+            add_error("Error while extracting model data from ZIP archive");
+            return false;
+        }
 
-        mz_bool res = 0;
+        // The meshes are parsed in parallel first, the XML parser then processes the rest of the model sequentially,
+        // skipping the content of the mesh elements already parsed.
+        m_mesh_blocks = parse_mesh_blocks(xml);
+        m_next_vertices_block  = 0;
+        m_next_triangles_block = 0;
 
         try
         {
-            res = mz_zip_reader_extract_to_callback(&archive, stat.m_file_index, [](void* pOpaque, mz_uint64 file_ofs, const void* pBuf, size_t n)->size_t {
-                CallbackData* data = (CallbackData*)pOpaque;
-                if (!XML_Parse(data->parser, (const char*)pBuf, (int)n, (file_ofs + n == data->stat.m_uncomp_size) ? 1 : 0) || data->importer.parse_error()) {
-                    char error_buf[1024];
-                    ::sprintf(error_buf, "Error (%s) while parsing '%s' at line %d", data->importer.parse_error_message(), data->stat.m_filename, (int)XML_GetCurrentLineNumber(data->parser));
-                    throw Slic3r::FileIOError(error_buf);
+            auto parse = [this, &stat, &xml](size_t begin, size_t end, bool final) {
+                // XML_Parse() accepts an int length.
+                static constexpr const size_t max_length = size_t(1) << 30;
+                do {
+                    size_t length = std::min(end - begin, max_length);
+                    if (!XML_Parse(m_xml_parser, xml.data() + begin, (int)length, (final && begin + length == end) ? 1 : 0) || parse_error()) {
+                        char error_buf[1024];
+                        ::sprintf(error_buf, "Error (%s) while parsing '%s' at line %d", parse_error_message(), stat.m_filename, (int)XML_GetCurrentLineNumber(m_xml_parser));
+                        throw Slic3r::FileIOError(error_buf);
+                    }
+                    begin += length;
+                } while (begin < end);
+            };
+            size_t pos = 0;
+            for (const MeshBlock &block : m_mesh_blocks)
+                if (block.parsed) {
+                    parse(pos, block.content_begin, false);
+                    pos = block.content_end;
                 }
-
-                return n;
-                }, &data, 0);
+            parse(pos, xml.size(), true);
         }
         catch (const version_error& e)
         {
@@ -974,14 +1227,11 @@ namespace Slic3r {
         catch (std::exception& e)
         {
             add_error(e.what());
+            m_mesh_blocks.clear();
             return false;
         }
 
-        if (res == 0) {
-            add_error("Error while extracting model data from ZIP archive");
-            return false;
-        }
-
+        m_mesh_blocks.clear();
         return true;
     }
 
@@ -1717,10 +1967,24 @@ namespace Slic3r {
 
     bool _3MF_Importer::_handle_end_vertices()
     {
-        // do nothing
+        if (MeshBlock *block = _next_mesh_block(MeshBlock::Type::Vertices); block != nullptr && block->parsed) {
+            // the content was not fed to the XML parser
+            m_curr_object.geometry.vertices = std::move(block->vertices);
+            for (Vec3f &v : m_curr_object.geometry.vertices)
+                v *= m_unit_factor;
+        }
         return true;
     }
 
+    MeshBlock* _3MF_Importer::_next_mesh_block(MeshBlock::Type type)
+    {
+        size_t &next = type == MeshBlock::Type::Vertices ? m_next_vertices_block : m_next_triangles_block;
+        for (; next < m_mesh_blocks.size(); ++ next)
+            if (m_mesh_blocks[next].type == type)
+                return &m_mesh_blocks[next ++];
+        return nullptr;
+    }
+
     bool _3MF_Importer::_handle_start_vertex(const char** attributes, unsigned int num_attributes)
     {
         // appends the vertex coordinates
@@ -1747,7 +2011,13 @@ namespace Slic3r {
 
     bool _3MF_Importer::_handle_end_triangles()
     {
-        // do nothing
+        if (MeshBlock *block = _next_mesh_block(MeshBlock::Type::Triangles); block != nullptr && block->parsed) {
+            // the content was not fed to the XML parser
+            m_curr_object.geometry.triangles        = std::move(block->triangles);
+            m_curr_object.geometry.custom_supports  = std::move(block->custom_supports);
+            m_curr_object.geometry.custom_seam      = std::move(block->custom_seam);
+            m_curr_object.geometry.mmu_segmentation = std::move(block->mmu_segmentation);
+        }
         return true;
     }
 
@@ -2366,34 +2636,37 @@ namespace Slic3r {
 
         bool m_fullpath_sources{ true };
         bool m_zip64 { true };
+        // miniz compression level of the archive entries.
+        int  m_compression_level { MZ_DEFAULT_LEVEL };
 
     public:
-        bool save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64);
+        bool save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, ArchiveCompression compression);
         static void add_transformation(std::stringstream &stream, const Transform3d &tr);
     private:
         bool _save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, const ThumbnailData* thumbnail_data);
-        bool _add_content_types_file_to_archive(mz_zip_archive& archive);
-        bool _add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data);
-        bool _add_relationships_file_to_archive(mz_zip_archive& archive);
-        bool _add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, IdToObjectDataMap& objects_data);
-        bool _add_object_to_model_stream(mz_zip_writer_staged_context &context, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
-        bool _add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);        
+        bool _add_content_types_file_to_archive(ParallelZipWriter& writer);
+        bool _add_thumbnail_file_to_archive(ParallelZipWriter& writer, const ThumbnailData& thumbnail_data);
+        bool _add_relationships_file_to_archive(ParallelZipWriter& writer);
+        bool _add_model_file_to_archive(const std::string& filename, ParallelZipWriter& writer, const Model& model, IdToObjectDataMap& objects_data);
+        bool _add_object_to_model_stream(ParallelZipWriter &writer, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets);
+        bool _add_mesh_to_object_stream(ParallelZipWriter &writer, ModelObject& object, VolumeToOffsetsMap& volumes_offsets);        
         bool _add_build_to_model_stream(std::stringstream& stream, const BuildItemsList& build_items);
-        bool _add_cut_information_file_to_archive(mz_zip_archive& archive, Model& model);
-        bool _add_layer_height_profile_file_to_archive(mz_zip_archive& archive, Model& model);
-        bool _add_layer_config_ranges_file_to_archive(mz_zip_archive& archive, Model& model);
-        bool _add_sla_support_points_file_to_archive(mz_zip_archive& archive, Model& model);
-        bool _add_sla_drain_holes_file_to_archive(mz_zip_archive& archive, Model& model);
-        bool _add_print_config_file_to_archive(mz_zip_archive& archive, const DynamicPrintConfig &config);
-        bool _add_model_config_file_to_archive(mz_zip_archive& archive, const Model& model, const IdToObjectDataMap &objects_data);
-        bool _add_custom_gcode_per_print_z_file_to_archive(mz_zip_archive& archive, Model& model, const DynamicPrintConfig* config);
+        bool _add_cut_information_file_to_archive(ParallelZipWriter& writer, Model& model);
+        bool _add_layer_height_profile_file_to_archive(ParallelZipWriter& writer, Model& model);
+        bool _add_layer_config_ranges_file_to_archive(ParallelZipWriter& writer, Model& model);
+        bool _add_sla_support_points_file_to_archive(ParallelZipWriter& writer, Model& model);
+        bool _add_sla_drain_holes_file_to_archive(ParallelZipWriter& writer, Model& model);
+        bool _add_print_config_file_to_archive(ParallelZipWriter& writer, const DynamicPrintConfig &config);
+        bool _add_model_config_file_to_archive(ParallelZipWriter& writer, const Model& model, const IdToObjectDataMap &objects_data);
+        bool _add_custom_gcode_per_print_z_file_to_archive(ParallelZipWriter& writer, Model& model, const DynamicPrintConfig* config);
     };
 
-    bool _3MF_Exporter::save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64)
+    bool _3MF_Exporter::save_model_to_file(const std::string& filename, Model& model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, ArchiveCompression compression)
     {
         clear_errors();
         m_fullpath_sources = fullpath_sources;
         m_zip64 = zip64;
+        m_compression_level = compression == ArchiveCompression::Fast ? MZ_BEST_SPEED : compression == ArchiveCompression::Max ? MZ_BEST_COMPRESSION : MZ_DEFAULT_LEVEL;
         return _save_model_to_file(filename, model, config, thumbnail_data);
     }
 
@@ -2407,9 +2680,12 @@ namespace Slic3r {
             return false;
         }
 
+        // Compresses the entries on worker threads, while the following entries are being generated.
+        ParallelZipWriter writer(archive, m_compression_level);
+
         // Adds content types file ("[Content_Types].xml";).
         // The content of this file is the same for each PrusaSlicer 3mf.
-        if (!_add_content_types_file_to_archive(archive)) {
+        if (!_add_content_types_file_to_archive(writer)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2417,7 +2693,7 @@ namespace Slic3r {
 
         if (thumbnail_data != nullptr && thumbnail_data->is_valid()) {
             // Adds the file Metadata/thumbnail.png.
-            if (!_add_thumbnail_file_to_archive(archive, *thumbnail_data)) {
+            if (!_add_thumbnail_file_to_archive(writer, *thumbnail_data)) {
                 close_zip_writer(&archive);
                 boost::filesystem::remove(filename);
                 return false;
@@ -2427,7 +2703,7 @@ namespace Slic3r {
         // Adds relationships file ("_rels/.rels"). 
         // The content of this file is the same for each PrusaSlicer 3mf.
         // The relationshis file contains a reference to the geometry file "3D/3dmodel.model", the name was chosen to be compatible with CURA.
-        if (!_add_relationships_file_to_archive(archive)) {
+        if (!_add_relationships_file_to_archive(writer)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2436,7 +2712,7 @@ namespace Slic3r {
         // Adds model file ("3D/3dmodel.model").
         // This is the one and only file that contains all the geometry (vertices and triangles) of all ModelVolumes.
         IdToObjectDataMap objects_data;
-        if (!_add_model_file_to_archive(filename, archive, model, objects_data)) {
+        if (!_add_model_file_to_archive(filename, writer, model, objects_data)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2445,7 +2721,7 @@ namespace Slic3r {
         // Adds file with information for object cut ("Metadata/Slic3r_PE_cut_information.txt").
         // All information for object cut of all ModelObjects are stored here, indexed by 1 based index of the ModelObject in Model.
         // The index differes from the index of an object ID of an object instance of a 3MF file!
-        if (!_add_cut_information_file_to_archive(archive, model)) {
+        if (!_add_cut_information_file_to_archive(writer, model)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2454,7 +2730,7 @@ namespace Slic3r {
         // Adds layer height profile file ("Metadata/Slic3r_PE_layer_heights_profile.txt").
         // All layer height profiles of all ModelObjects are stored here, indexed by 1 based index of the ModelObject in Model.
         // The index differes from the index of an object ID of an object instance of a 3MF file!
-        if (!_add_layer_height_profile_file_to_archive(archive, model)) {
+        if (!_add_layer_height_profile_file_to_archive(writer, model)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2463,7 +2739,7 @@ namespace Slic3r {
         // Adds layer config ranges file ("Metadata/Slic3r_PE_layer_config_ranges.txt").
         // All layer height profiles of all ModelObjects are stored here, indexed by 1 based index of the ModelObject in Model.
         // The index differes from the index of an object ID of an object instance of a 3MF file!
-        if (!_add_layer_config_ranges_file_to_archive(archive, model)) {
+        if (!_add_layer_config_ranges_file_to_archive(writer, model)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2472,13 +2748,13 @@ namespace Slic3r {
         // Adds sla support points file ("Metadata/Slic3r_PE_sla_support_points.txt").
         // All  sla support points of all ModelObjects are stored here, indexed by 1 based index of the ModelObject in Model.
         // The index differes from the index of an object ID of an object instance of a 3MF file!
-        if (!_add_sla_support_points_file_to_archive(archive, model)) {
+        if (!_add_sla_support_points_file_to_archive(writer, model)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
         }
         
-        if (!_add_sla_drain_holes_file_to_archive(archive, model)) {
+        if (!_add_sla_drain_holes_file_to_archive(writer, model)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2487,7 +2763,7 @@ namespace Slic3r {
 
         // Adds custom gcode per height file ("Metadata/Prusa_Slicer_custom_gcode_per_print_z.xml").
         // All custom gcode per height of whole Model are stored here
-        if (!_add_custom_gcode_per_print_z_file_to_archive(archive, model, config)) {
+        if (!_add_custom_gcode_per_print_z_file_to_archive(writer, model, config)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
@@ -2496,7 +2772,7 @@ namespace Slic3r {
         // Adds slic3r print config file ("Metadata/Slic3r_PE.config").
         // This file contains the content of FullPrintConfing / SLAFullPrintConfig.
         if (config != nullptr) {
-            if (!_add_print_config_file_to_archive(archive, *config)) {
+            if (!_add_print_config_file_to_archive(writer, *config)) {
                 close_zip_writer(&archive);
                 boost::filesystem::remove(filename);
                 return false;
@@ -2507,12 +2783,28 @@ namespace Slic3r {
         // This file contains all the attributes of all ModelObjects and their ModelVolumes (names, parameter overrides).
         // As there is just a single Indexed Triangle Set data stored per ModelObject, offsets of volumes into their respective Indexed Triangle Set data
         // is stored here as well.
-        if (!_add_model_config_file_to_archive(archive, model, objects_data)) {
+        if (!_add_model_config_file_to_archive(writer, model, objects_data)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
             return false;
         }
 
+        if (!writer.flush()) {
+            close_zip_writer(&archive);
+            boost::filesystem::remove(filename);
+            add_error("Error during writing or compression");
+            return false;
+        }
+
+        if (!m_zip64 && mz_zip_is_zip64(&archive)) {
+            // Maximum expected 3MF file size is 4GB-1. This is a workaround for interoperability with Windows 10 3D model fixing API, see
+            // GH issue #6193.
+            close_zip_writer(&archive);
+            boost::filesystem::remove(filename);
+            add_error("The file is too large to be stored without ZIP64 extensions");
+            return false;
+        }
+
         if (!mz_zip_writer_finalize_archive(&archive)) {
             close_zip_writer(&archive);
             boost::filesystem::remove(filename);
@@ -2525,7 +2817,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_content_types_file_to_archive(mz_zip_archive& archive)
+    bool _3MF_Exporter::_add_content_types_file_to_archive(ParallelZipWriter& writer)
     {
         std::stringstream stream;
         stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
@@ -2537,7 +2829,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, CONTENT_TYPES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!writer.add_entry(CONTENT_TYPES_FILE, std::move(out))) {
             add_error("Unable to add content types file to archive");
             return false;
         }
@@ -2545,14 +2837,14 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_thumbnail_file_to_archive(mz_zip_archive& archive, const ThumbnailData& thumbnail_data)
+    bool _3MF_Exporter::_add_thumbnail_file_to_archive(ParallelZipWriter& writer, const ThumbnailData& thumbnail_data)
     {
         bool res = false;
 
         size_t png_size = 0;
         void* png_data = tdefl_write_image_to_png_file_in_memory_ex((const void*)thumbnail_data.pixels.data(), thumbnail_data.width, thumbnail_data.height, 4, &png_size, MZ_DEFAULT_LEVEL, 1);
         if (png_data != nullptr) {
-            res = mz_zip_writer_add_mem(&archive, THUMBNAIL_FILE.c_str(), (const void*)png_data, png_size, MZ_DEFAULT_COMPRESSION);
+            res = writer.add_entry(THUMBNAIL_FILE, png_data, png_size);
             mz_free(png_data);
         }
 
@@ -2562,7 +2854,7 @@ namespace Slic3r {
         return res;
     }
 
-    bool _3MF_Exporter::_add_relationships_file_to_archive(mz_zip_archive& archive)
+    bool _3MF_Exporter::_add_relationships_file_to_archive(ParallelZipWriter& writer)
     {
         std::stringstream stream;
         stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
@@ -2573,7 +2865,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, RELATIONSHIPS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!writer.add_entry(RELATIONSHIPS_FILE, std::move(out))) {
             add_error("Unable to add relationships file to archive");
             return false;
         }
@@ -2592,18 +2884,10 @@ namespace Slic3r {
         stream << std::setprecision(std::numeric_limits<float>::max_digits10);
     }
 
-    bool _3MF_Exporter::_add_model_file_to_archive(const std::string& filename, mz_zip_archive& archive, const Model& model, IdToObjectDataMap& objects_data)
+    bool _3MF_Exporter::_add_model_file_to_archive(const std::string& filename, ParallelZipWriter& writer, const Model& model, IdToObjectDataMap& objects_data)
     {
-        mz_zip_writer_staged_context context;
-        if (!mz_zip_writer_add_staged_open(&archive, &context, MODEL_FILE.c_str(), 
-            m_zip64 ? 
-                // Maximum expected and allowed 3MF file size is 16GiB.
-                // This switches the ZIP file to a 64bit mode, which adds a tiny bit of overhead to file records.
-                (uint64_t(1) << 30) * 16 : 
-                // Maximum expected 3MF file size is 4GB-1. This is a workaround for interoperability with Windows 10 3D model fixing API, see
-                // GH issue #6193.
-                (uint64_t(1) << 32) - 1,
-            nullptr, nullptr, 0, MZ_DEFAULT_COMPRESSION, nullptr, 0, nullptr, 0)) {
+        // The model file is compressed in blocks on worker threads while it is being generated.
+        if (!writer.open_entry(MODEL_FILE)) {
             add_error("Unable to add model file to archive");
             return false;
         }
@@ -2639,7 +2923,7 @@ namespace Slic3r {
             stream << " <" << METADATA_TAG << " name=\"Application\">" << SLIC3R_APP_KEY << "-" << SLIC3R_VERSION << "</" << METADATA_TAG << ">\n";
             stream << " <" << RESOURCES_TAG << ">\n";
             std::string buf = stream.str();
-            if (! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) {
+            if (! buf.empty() && ! writer.append(buf.data(), buf.size())) {
                 add_error("Unable to add model file to archive");
                 return false;
             }
@@ -2662,9 +2946,9 @@ namespace Slic3r {
             // Store geometry of all ModelVolumes contained in a single ModelObject into a single 3MF indexed triangle set object.
             // object_it->second.volumes_offsets will contain the offsets of the ModelVolumes in that single indexed triangle set.
             // object_id will be increased to point to the 1st instance of the next ModelObject.
-            if (!_add_object_to_model_stream(context, object_id, *obj, build_items, object_it->second.volumes_offsets)) {
+            if (!_add_object_to_model_stream(writer, object_id, *obj, build_items, object_it->second.volumes_offsets)) {
                 add_error("Unable to add object to archive");
-                mz_zip_writer_add_staged_finish(&context);
+                writer.close_entry();
                 return false;
             }
         }
@@ -2677,7 +2961,7 @@ namespace Slic3r {
             // Store the transformations of all the ModelInstances of all ModelObjects, indexed in a linear fashion.
             if (!_add_build_to_model_stream(stream, build_items)) {
                 add_error("Unable to add build to archive");
-                mz_zip_writer_add_staged_finish(&context);
+                writer.close_entry();
                 return false;
             }
 
@@ -2685,8 +2969,8 @@ namespace Slic3r {
            
             std::string buf = stream.str();
 
-            if ((! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) ||
-                ! mz_zip_writer_add_staged_finish(&context)) {
+            if ((! buf.empty() && ! writer.append(buf.data(), buf.size())) ||
+                ! writer.close_entry()) {
                 add_error("Unable to add model file to archive");
                 return false;
             }
@@ -2695,7 +2979,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_object_to_model_stream(mz_zip_writer_staged_context &context, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_object_to_model_stream(ParallelZipWriter &writer, unsigned int& object_id, ModelObject& object, BuildItemsList& build_items, VolumeToOffsetsMap& volumes_offsets)
     {
         std::stringstream stream;
         reset_stream(stream);
@@ -2711,8 +2995,8 @@ namespace Slic3r {
             if (id == 0) {
                 std::string buf = stream.str();
                 reset_stream(stream);
-                if ((! buf.empty() && ! mz_zip_writer_add_staged_data(&context, buf.data(), buf.size())) ||
-                    ! _add_mesh_to_object_stream(context, object, volumes_offsets)) {
+                if ((! buf.empty() && ! writer.append(buf.data(), buf.size())) ||
+                    ! _add_mesh_to_object_stream(writer, object, volumes_offsets)) {
                     add_error("Unable to add mesh to archive");
                     return false;
                 }
@@ -2735,7 +3019,7 @@ namespace Slic3r {
 
         object_id += id;
         std::string buf = stream.str();
-        return buf.empty() || mz_zip_writer_add_staged_data(&context, buf.data(), buf.size());
+        return buf.empty() || writer.append(buf.data(), buf.size());
     }
 
 #if EXPORT_3MF_USE_SPIRIT_KARMA_FP
@@ -2758,7 +3042,7 @@ namespace Slic3r {
     using coordinate_type_scientific = boost::spirit::karma::real_generator<float, coordinate_policy_scientific<float>>;
 #endif // EXPORT_3MF_USE_SPIRIT_KARMA_FP
 
-    bool _3MF_Exporter::_add_mesh_to_object_stream(mz_zip_writer_staged_context &context, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
+    bool _3MF_Exporter::_add_mesh_to_object_stream(ParallelZipWriter &writer, ModelObject& object, VolumeToOffsetsMap& volumes_offsets)
     {
         std::string output_buffer;
         output_buffer += "   <";
@@ -2767,9 +3051,9 @@ namespace Slic3r {
         output_buffer += VERTICES_TAG;
         output_buffer += ">\n";
 
-        auto flush = [this, &output_buffer, &context](bool force = false) {
+        auto flush = [this, &output_buffer, &writer](bool force = false) {
             if ((force && ! output_buffer.empty()) || output_buffer.size() >= 65536 * 16) {
-                if (! mz_zip_writer_add_staged_data(&context, output_buffer.data(), output_buffer.size())) {
+                if (! writer.append(output_buffer.data(), output_buffer.size())) {
                     add_error("Error during writing or compression");
                     return false;
                 }
@@ -2954,7 +3238,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_cut_information_file_to_archive(mz_zip_archive& archive, Model& model)
+    bool _3MF_Exporter::_add_cut_information_file_to_archive(ParallelZipWriter& writer, Model& model)
     {
         std::string out = "";
         pt::ptree tree;
@@ -3008,7 +3292,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, CUT_INFORMATION_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!writer.add_entry(CUT_INFORMATION_FILE, std::move(out))) {
                 add_error("Unable to add cut information file to archive");
                 return false;
             }
@@ -3017,7 +3301,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_layer_height_profile_file_to_archive(mz_zip_archive& archive, Model& model)
+    bool _3MF_Exporter::_add_layer_height_profile_file_to_archive(ParallelZipWriter& writer, Model& model)
     {
         assert(is_decimal_separator_point());
         std::string out = "";
@@ -3042,7 +3326,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_HEIGHTS_PROFILE_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!writer.add_entry(LAYER_HEIGHTS_PROFILE_FILE, std::move(out))) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -3051,7 +3335,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_layer_config_ranges_file_to_archive(mz_zip_archive& archive, Model& model)
+    bool _3MF_Exporter::_add_layer_config_ranges_file_to_archive(ParallelZipWriter& writer, Model& model)
     {
         std::string out = "";
         pt::ptree tree;
@@ -3100,7 +3384,7 @@ namespace Slic3r {
         }
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, LAYER_CONFIG_RANGES_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!writer.add_entry(LAYER_CONFIG_RANGES_FILE, std::move(out))) {
                 add_error("Unable to add layer heights profile file to archive");
                 return false;
             }
@@ -3109,7 +3393,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_sla_support_points_file_to_archive(mz_zip_archive& archive, Model& model)
+    bool _3MF_Exporter::_add_sla_support_points_file_to_archive(ParallelZipWriter& writer, Model& model)
     {
         assert(is_decimal_separator_point());
         std::string out = "";
@@ -3136,7 +3420,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("support_points_format_version=") + std::to_string(support_points_format_version) + std::string("\n") + out;
 
-            if (!mz_zip_writer_add_mem(&archive, SLA_SUPPORT_POINTS_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!writer.add_entry(SLA_SUPPORT_POINTS_FILE, std::move(out))) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3144,7 +3428,7 @@ namespace Slic3r {
         return true;
     }
     
-    bool _3MF_Exporter::_add_sla_drain_holes_file_to_archive(mz_zip_archive& archive, Model& model)
+    bool _3MF_Exporter::_add_sla_drain_holes_file_to_archive(ParallelZipWriter& writer, Model& model)
     {
         assert(is_decimal_separator_point());
         const char *const fmt = "object_id=%d|";
@@ -3187,7 +3471,7 @@ namespace Slic3r {
             // Adds version header at the beginning:
             out = std::string("drain_holes_format_version=") + std::to_string(drain_holes_format_version) + std::string("\n") + out;
             
-            if (!mz_zip_writer_add_mem(&archive, SLA_DRAIN_HOLES_FILE.c_str(), static_cast<const void*>(out.data()), out.length(), mz_uint(MZ_DEFAULT_COMPRESSION))) {
+            if (!writer.add_entry(SLA_DRAIN_HOLES_FILE, std::move(out))) {
                 add_error("Unable to add sla support points file to archive");
                 return false;
             }
@@ -3195,7 +3479,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_print_config_file_to_archive(mz_zip_archive& archive, const DynamicPrintConfig &config)
+    bool _3MF_Exporter::_add_print_config_file_to_archive(ParallelZipWriter& writer, const DynamicPrintConfig &config)
     {
         assert(is_decimal_separator_point());
         char buffer[1024];
@@ -3207,7 +3491,7 @@ namespace Slic3r {
                 out += "; " + key + " = " + config.opt_serialize(key) + "\n";
 
         if (!out.empty()) {
-            if (!mz_zip_writer_add_mem(&archive, PRINT_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+            if (!writer.add_entry(PRINT_CONFIG_FILE, std::move(out))) {
                 add_error("Unable to add print config file to archive");
                 return false;
             }
@@ -3216,7 +3500,7 @@ namespace Slic3r {
         return true;
     }
 
-    bool _3MF_Exporter::_add_model_config_file_to_archive(mz_zip_archive& archive, const Model& model, const IdToObjectDataMap &objects_data)
+    bool _3MF_Exporter::_add_model_config_file_to_archive(ParallelZipWriter& writer, const Model& model, const IdToObjectDataMap &objects_data)
     {
         enum class MetadataType{
             object,
@@ -3339,7 +3623,7 @@ namespace Slic3r {
 
         std::string out = stream.str();
 
-        if (!mz_zip_writer_add_mem(&archive, MODEL_CONFIG_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!writer.add_entry(MODEL_CONFIG_FILE, std::move(out))) {
             add_error("Unable to add model config file to archive");
             return false;
         }
@@ -3347,7 +3631,7 @@ namespace Slic3r {
         return true;
     }
 
-bool _3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive( mz_zip_archive& archive, Model& model, const DynamicPrintConfig* config)
+bool _3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive( ParallelZipWriter& writer, Model& model, const DynamicPrintConfig* config)
 {
     std::string out = "";
 
@@ -3390,7 +3674,7 @@ bool _3MF_Exporter::_add_custom_gcode_per_print_z_file_to_archive( mz_zip_archiv
     } 
 
     if (!out.empty()) {
-        if (!mz_zip_writer_add_mem(&archive, CUSTOM_GCODE_PER_PRINT_Z_FILE.c_str(), (const void*)out.data(), out.length(), MZ_DEFAULT_COMPRESSION)) {
+        if (!writer.add_entry(CUSTOM_GCODE_PER_PRINT_Z_FILE, std::move(out))) {
             add_error("Unable to add custom Gcodes per print_z file to archive");
             return false;
         }
@@ -3474,6 +3758,11 @@ bool load_3mf(const char* path, DynamicPrintConfig& config, ConfigSubstitutionCo
 }
 
 bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64)
+{
+    return store_3mf(path, model, config, fullpath_sources, thumbnail_data, zip64, ArchiveCompression::Default);
+}
+
+bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config, bool fullpath_sources, const ThumbnailData* thumbnail_data, bool zip64, ArchiveCompression compression)
 {
     // All export should use "C" locales for number formatting.
     CNumericLocalesSetter locales_setter;
@@ -3482,7 +3771,7 @@ bool store_3mf(const char* path, Model* model, const DynamicPrintConfig* config,
         return false;
 
     _3MF_Exporter exporter;
-    bool res = exporter.save_model_to_file(path, *model, config, fullpath_sources, thumbnail_data, zip64);
+    bool res = exporter.save_model_to_file(path, *model, config, fullpath_sources, thumbnail_data, zip64, compression);
     if (!res)
         exporter.log_errors();
 
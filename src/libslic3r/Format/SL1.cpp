@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include "libslic3r/Time.hpp"
+#include "libslic3r/Utils.hpp"
 #include "libslic3r/Zipper.hpp"
 #include "libslic3r/SLAPrint.hpp"
 #include "libslic3r/Exception.hpp"
@@ -163,9 +164,25 @@ std::unique_ptr<sla::RasterBase> SL1Archive::create_raster() const
 
 sla::RasterEncoder SL1Archive::get_encoder() const
 {
+    if (m_cfg.sla_archive_fast_png.getBool())
+        return sla::FastPNGRasterEncoder{};
     return sla::PNGRasterEncoder{};
 }
 
+Zipper::e_compression SL1Archive::compression() const
+{
+    switch (m_cfg.sla_archive_compression.value) {
+    case ArchiveCompression::Default: return Zipper::DEFAULT_COMPRESSION;
+    case ArchiveCompression::Max:     return Zipper::TIGHT_COMPRESSION;
+    default:                          return Zipper::FAST_COMPRESSION;
+    }
+}
+
+static std::string layer_image_name(const std::string &project, size_t idx, const sla::EncodedRaster &rst)
+{
+    return project + string_printf("%.5d", int(idx)) + "." + rst.extension();
+}
+
 static void write_thumbnail(Zipper &zipper, const ThumbnailData &data)
 {
     size_t png_size = 0;
@@ -208,13 +225,8 @@ void SL1Archive::export_print(Zipper               &zipper,
         zipper << to_ini(slicerconf);
 
         size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-
-            std::string imgname = project + string_printf("%.5d", i++) + "." +
-                                  rst.extension();
-
-            zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
-        }
+        for (const sla::EncodedRaster &rst : m_layers)
+            zipper.add_entry(layer_image_name(project, i++, rst), rst.data(), rst.size());
 
         for (const ThumbnailData& data : thumbnails)
             if (data.is_valid())
@@ -228,12 +240,69 @@ void SL1Archive::export_print(Zipper               &zipper,
     }
 }
 
+bool SL1Archive::stream_begin(const std::string &fname, const std::string &projectname, size_t /* layer_num */)
+{
+    stream_abort();
+    m_streamed_archive.clear();
+    m_stream_projectname = projectname.empty() ? boost::filesystem::path(fname).stem().string() : projectname;
+    // The layers are written into a temporary file, which is renamed once export_print() completes it.
+    m_stream_zipper = std::make_unique<Zipper>(fname + ".tmp", compression());
+    return true;
+}
+
+void SL1Archive::stream_layer(size_t idx, const sla::EncodedRaster &rst)
+{
+    m_stream_zipper->add_entry(layer_image_name(m_stream_projectname, idx, rst), rst.data(), rst.size());
+}
+
+SL1Archive::~SL1Archive()
+{
+    // The layers were streamed, but the archive was never exported, for example the processing was canceled.
+    stream_abort();
+}
+
+void SL1Archive::stream_abort()
+{
+    if (m_stream_zipper) {
+        std::string tmp_fname = m_stream_zipper->get_filename();
+        m_stream_zipper.reset();
+        boost::system::error_code ec;
+        boost::filesystem::remove(tmp_fname, ec);
+    }
+}
+
 void SL1Archive::export_print(const std::string     fname,
                               const SLAPrint       &print,
                               const ThumbnailsList &thumbnails,
                               const std::string    &prjname)
 {
-    Zipper zipper{fname, Zipper::FAST_COMPRESSION};
+    if (m_layers_streamed) {
+        if (m_stream_zipper) {
+            // The layers were written while being rasterized, add the configs and thumbnails.
+            // The layer image names have to match the project name the layers were written with.
+            std::string tmp_fname = m_stream_zipper->get_filename();
+            // Don't leave the temporary file behind if the archive could not be completed.
+            ScopeGuard remove_tmp([this, &tmp_fname]() {
+                m_stream_zipper.reset();
+                boost::system::error_code ec;
+                boost::filesystem::remove(tmp_fname, ec);
+            });
+            export_print(*m_stream_zipper, print, thumbnails, m_stream_projectname);
+            m_stream_zipper.reset();
+            if (rename_file(tmp_fname, fname))
+                throw ExportError(std::string("Failed to rename the output archive from ") + tmp_fname + " to " + fname);
+            remove_tmp.reset();
+            m_streamed_archive = fname;
+        } else if (fname != m_streamed_archive) {
+            // Exported again, the layers are not available in memory.
+            std::string error_message;
+            if (copy_file(m_streamed_archive, fname, error_message) != SUCCESS)
+                throw ExportError(std::string("Failed to copy the output archive from ") + m_streamed_archive + " to " + fname + ": " + error_message);
+        }
+        return;
+    }
+
+    Zipper zipper{fname, compression()};
 
     export_print(zipper, print, thumbnails, prjname);
 }
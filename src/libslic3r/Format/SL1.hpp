@@ -13,11 +13,24 @@ namespace Slic3r {
 
 class SL1Archive: public SLAArchiveWriter {
     SLAPrinterConfig m_cfg;
+
+    // Archive being written by stream_layer(), completed by export_print().
+    std::unique_ptr<Zipper> m_stream_zipper;
+    std::string             m_stream_projectname;
+    // Archive exported from the streamed layers, copied by further export_print() calls.
+    std::string             m_streamed_archive;
     
 protected:
     std::unique_ptr<sla::RasterBase> create_raster() const override;
     sla::RasterEncoder get_encoder() const override;
 
+    bool stream_begin(const std::string &fname, const std::string &projectname, size_t layer_num) override;
+    void stream_layer(size_t idx, const sla::EncodedRaster &rst) override;
+    void stream_abort() override;
+
+    // Compression of the archive entries.
+    virtual Zipper::e_compression compression() const;
+
     SLAPrinterConfig & cfg() { return m_cfg; }
     const SLAPrinterConfig & cfg() const { return m_cfg; }
 
@@ -31,6 +44,8 @@ public:
     SL1Archive() = default;
     explicit SL1Archive(const SLAPrinterConfig &cfg): m_cfg(cfg) {}
     explicit SL1Archive(SLAPrinterConfig &&cfg): m_cfg(std::move(cfg)) {}
+    // Removes the temporary archive of the streamed layers, if export_print() did not complete it.
+    ~SL1Archive() override;
 
     void export_print(const std::string     fname,
                       const SLAPrint       &print,
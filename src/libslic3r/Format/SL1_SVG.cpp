@@ -230,19 +230,6 @@ sla::RasterEncoder SL1_SVGArchive::get_encoder() const
     return nullptr;
 }
 
-void SL1_SVGArchive::export_print(const std::string     fname,
-                                  const SLAPrint       &print,
-                                  const ThumbnailsList &thumbnails,
-                                  const std::string    &projectname)
-{
-    // Export code is completely identical to SL1, only the compression level
-    // is elevated, as the SL1 has already compressed PNGs with deflate,
-    // but the svg is just text.
-    Zipper zipper{fname, Zipper::TIGHT_COMPRESSION};
-
-    SL1Archive::export_print(zipper, print, thumbnails, projectname);
-}
-
 struct NanoSVGParser {
     NSVGimage *image;
     static constexpr const char *Units = "mm"; // Denotes user coordinate system
@@ -1,8 +1,60 @@
 #include "SLAArchiveWriter.hpp"
 #include "SLAArchiveFormatRegistry.hpp"
 
+#include <tbb/task_arena.h>
+
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
+void SLAArchiveWriter::draw_layers_streaming(size_t                                                 layer_num,
+                                             const std::function<void(sla::RasterBase&, size_t)> &drawfn,
+                                             const std::function<bool()>                          &cancelfn)
+{
+    using EncodedLayer = std::pair<size_t, sla::EncodedRaster>;
+
+    size_t next_layer = 0;
+    const auto select_layer = tbb::make_filter<void, size_t>(slic3r_tbb_filtermode::serial_in_order,
+        [layer_num, &next_layer, &cancelfn](tbb::flow_control &fc) -> size_t {
+            if (next_layer == layer_num || cancelfn()) {
+                fc.stop();
+                return 0;
+            }
+            return next_layer ++;
+        });
+    const auto draw = tbb::make_filter<size_t, EncodedLayer>(slic3r_tbb_filtermode::parallel,
+        [this, &drawfn](size_t idx) -> EncodedLayer {
+            auto rst = create_raster();
+            drawfn(*rst, idx);
+            return { idx, rst->encode(get_encoder()) };
+        });
+    const auto write = tbb::make_filter<EncodedLayer, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this](EncodedLayer layer) { stream_layer(layer.first, layer.second); });
+
+    try {
+        // The number of layers in flight bounds the memory held by the encoded layers waiting to be written.
+        tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), select_layer & draw & write);
+    } catch (...) {
+        stream_abort();
+        throw;
+    }
+    if (next_layer < layer_num || cancelfn())
+        // Canceled.
+        stream_abort();
+    else
+        m_layers_streamed = true;
+}
+
 std::unique_ptr<SLAArchiveWriter>
 SLAArchiveWriter::create(const std::string &archtype, const SLAPrinterConfig &cfg)
 {
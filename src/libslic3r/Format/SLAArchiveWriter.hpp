@@ -1,6 +1,8 @@
 #ifndef SLAARCHIVE_HPP
 #define SLAARCHIVE_HPP
 
+#include <functional>
+#include <string>
 #include <vector>
 
 #include "libslic3r/SLA/RasterBase.hpp"
@@ -15,13 +17,41 @@ class SLAPrinterConfig;
 class SLAArchiveWriter {
 protected:
     std::vector<sla::EncodedRaster> m_layers;
+    // The layers drawn by the last draw_layers() were written by stream_layer() instead of being stored in m_layers.
+    bool m_layers_streamed = false;
 
     virtual std::unique_ptr<sla::RasterBase> create_raster() const = 0;
     virtual sla::RasterEncoder get_encoder() const = 0;
 
+    // Streaming export for archive formats, which do not need all the layers at once, see set_stream_target().
+    // Open the archive for writing the layers. Returns false if streaming is not supported.
+    virtual bool stream_begin(const std::string & /* fname */, const std::string & /* projectname */, size_t /* layer_num */) { return false; }
+    // Write an encoded layer into the archive, called in the order of the layers.
+    virtual void stream_layer(size_t /* idx */, const sla::EncodedRaster & /* rst */) {}
+    // Discard the partially written archive.
+    virtual void stream_abort() {}
+
+private:
+    std::string m_stream_fname;
+    std::string m_stream_projectname;
+
+    // Layers are drawn and encoded in parallel and passed to stream_layer() in order, while only a bounded
+    // number of encoded layers is waiting for its predecessors, thus the memory does not depend on the layer count.
+    void draw_layers_streaming(size_t                                                 layer_num,
+                               const std::function<void(sla::RasterBase&, size_t)> &drawfn,
+                               const std::function<bool()>                          &cancelfn);
+
 public:
     virtual ~SLAArchiveWriter() = default;
 
+    // Let draw_layers() write the layers into an archive at fname as soon as they are encoded,
+    // export_print() then completes the archive. Empty fname collects the layers in memory.
+    void set_stream_target(const std::string &fname, const std::string &projectname = "")
+    {
+        m_stream_fname       = fname;
+        m_stream_projectname = projectname;
+    }
+
     // Fn have to be thread safe: void(sla::RasterBase& raster, size_t lyrid);
     template<class Fn, class CancelFn, class EP = ExecutionTBB>
     void draw_layers(
@@ -30,6 +60,13 @@ public:
         CancelFn cancelfn = []() { return false; },
         const EP & ep       = {})
     {
+        m_layers.clear();
+        m_layers_streamed = false;
+        if (! m_stream_fname.empty() && stream_begin(m_stream_fname, m_stream_projectname, layer_num)) {
+            draw_layers_streaming(layer_num, drawfn, cancelfn);
+            return;
+        }
+
         m_layers.resize(layer_num);
         execution::for_each(
             ep, size_t(0), m_layers.size(),
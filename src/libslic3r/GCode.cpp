@@ -15,6 +15,7 @@
 #include "ShortestPath.hpp"
 #include "Print.hpp"
 #include "Thread.hpp"
+#include "Trace.hpp"
 #include "Utils.hpp"
 #include "ClipperUtils.hpp"
 #include "libslic3r.h"
@@ -22,9 +23,14 @@
 #include "libslic3r/format.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <math.h>
+#include <mutex>
 #include <string>
 #include <string_view>
 
@@ -837,8 +843,11 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
 
     m_processor.initialize(path_tmp);
     m_processor.set_print(print);
-    GCodeOutputStream file(boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor);
-    if (! file.is_open())
+    // With gcode_single_pass, the G-code processor writes the final G-code while processing it,
+    // instead of the G-code being written here first and then rewritten by GCodeProcessor::post_process().
+    const bool single_pass = print->config().gcode_single_pass.value;
+    GCodeOutputStream file(single_pass ? nullptr : boost::nowide::fopen(path_tmp.c_str(), "wb"), m_processor);
+    if (single_pass ? ! m_processor.enable_single_pass_export() : ! file.is_open())
         throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed.\nCannot open the file for writing.\n");
 
     try {
@@ -846,6 +855,7 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         file.flush();
         if (file.is_error()) {
             file.close();
+            m_processor.abort_single_pass_export();
             boost::nowide::remove(path_tmp.c_str());
             throw Slic3r::RuntimeError(std::string("G-code export to ") + path + " failed\nIs the disk full?\n");
         }
@@ -853,12 +863,15 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
         // Rethrow on any exception. std::runtime_exception and CanceledException are expected to be thrown.
         // Close and remove the file.
         file.close();
+        m_processor.abort_single_pass_export();
         boost::nowide::remove(path_tmp.c_str());
         throw;
     }
     file.close();
 
     if (! m_placeholder_parser_integration.failed_templates.empty()) {
+        // Write out the G-code held by the single pass export for the user to inspect.
+        m_processor.abort_single_pass_export();
         // G-code export proceeded, but some of the PlaceholderParser substitutions failed.
         //FIXME localize!
         std::string msg = std::string("G-code export to ") + path + " failed due to invalid custom G-code sections:\n\n";
@@ -876,6 +889,11 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessorResult* resu
     BOOST_LOG_TRIVIAL(debug) << "Start processing gcode, " << log_memory_info();
     // Post-process the G-code to update time stamps.
     m_processor.finalize(true);
+    if (m_processor.single_pass_export_truncated() > 0)
+        // The file is written already, the values can not be written in full without exporting the G-code again.
+        print->active_step_add_warning(PrintStateBase::WarningLevel::NON_CRITICAL,
+            _u8L("Some of the print time estimates or filament statistics did not fit into the space reserved by the single pass G-code export "
+                 "and they were truncated. Disable the single pass export to get the complete values."));
 //    DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     DoExport::update_print_estimated_stats(m_processor, m_writer.extruders(), print->m_print_statistics);
     if (result != nullptr) {
@@ -1525,10 +1543,11 @@ void GCode::process_layers(
     const std::vector<std::pair<coordf_t, ObjectsLayerToPrint>>         &layers_to_print,
     GCodeOutputStream                                                   &output_stream)
 {
+    SLIC3R_TRACE_ZONE("GCode::process_layers");
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerResult {
+    const auto select_layer = tbb::make_filter<void, LayerToProcess>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerToProcess {
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if ((!m_pressure_equalizer && layer_to_print_idx == layers_to_print.size()) || (m_pressure_equalizer && layer_to_print_idx == (layers_to_print.size() + 1))) {
                     fc.stop();
@@ -1537,27 +1556,57 @@ void GCode::process_layers(
                     // Pressure equalizer need insert empty input. Because it returns one layer back.
                     // Insert NOP (no operation) layer;
                     ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
+                    return {};
                 }
-            } else {
-                const std::pair<coordf_t, ObjectsLayerToPrint> &layer = layers_to_print[layer_to_print_idx++];
-                const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
-                if (m_wipe_tower && layer_tools.has_wipe_tower)
-                    m_wipe_tower->next_layer();
+            } else
+                return { layer_to_print_idx ++ };
+        });
+    // Calculate the path planning data, which does not depend on the state of the G-code generator, for multiple layers in parallel.
+    const auto plan_paths = tbb::make_filter<LayerToProcess, LayerToProcess>(slic3r_tbb_filtermode::parallel,
+        [&print, &layers_to_print](LayerToProcess in) -> LayerToProcess {
+            if (! in.is_nop()) {
+                SLIC3R_TRACE_ZONE("GCode::make_layer_path_planning", "layer", in.layer_to_print_idx);
                 print.throw_if_canceled();
-                return this->process_layer(print, layer.second, layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+                in.path_planning = make_layer_path_planning(print, layers_to_print[in.layer_to_print_idx].second);
+            }
+            return in;
+        });
+    const auto process = tbb::make_filter<LayerToProcess, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &print_object_instances_ordering, &layers_to_print](LayerToProcess in) -> LayerResult {
+            if (in.is_nop())
+                return LayerResult::make_nop_layer_result();
+            SLIC3R_TRACE_ZONE("GCode::process_layer", "layer", in.layer_to_print_idx);
+            const std::pair<coordf_t, ObjectsLayerToPrint> &layer = layers_to_print[in.layer_to_print_idx];
+            const LayerTools& layer_tools = tool_ordering.tools_for_layer(layer.first);
+            if (m_wipe_tower && layer_tools.has_wipe_tower)
+                m_wipe_tower->next_layer();
+            print.throw_if_canceled();
+            return this->process_layer(print, layer.second, std::move(in.path_planning), layer_tools, &layer == &layers_to_print.back(), &print_object_instances_ordering, size_t(-1));
+        });
+    const auto generator = select_layer & plan_paths & process;
+    // Tokenize the G-code of multiple layers in parallel for the G-code filters. The pressure equalizer rewrites the G-code
+    // with its own parser, thus the G-code is tokenized after it if it is active.
+    const auto tokenize = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::parallel,
+        [extrusion_axis = get_extrusion_axis(m_config)[0], toolchange_prefix = m_writer.toolchange_prefix()](LayerResult in) -> LayerResult {
+            if (! in.nop_layer_result) {
+                SLIC3R_TRACE_ZONE("GCode::tokenize_layer", "layer", in.layer_id);
+                in.lines.parse(in.gcode, extrusion_axis, toolchange_prefix);
             }
+            return in;
         });
     const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [spiral_vase = this->m_spiral_vase.get()](LayerResult in) -> LayerResult {
             if (in.nop_layer_result)
                 return in;
 
+            SLIC3R_TRACE_ZONE("GCode::spiral_vase", "layer", in.layer_id);
             spiral_vase->enable(in.spiral_vase_enable);
-            return { spiral_vase->process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush};
+            in.gcode = spiral_vase->process_layer(std::move(in.gcode), in.lines);
+            return in;
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
+            SLIC3R_TRACE_ZONE("GCode::pressure_equalizer", "layer", in.layer_id);
             return pressure_equalizer->process_layer(std::move(in));
         });
     const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
@@ -1565,14 +1614,19 @@ void GCode::process_layers(
              if (in.nop_layer_result)
                 return in.gcode;
 
-             return cooling_buffer->process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+             SLIC3R_TRACE_ZONE("GCode::cooling_buffer", "layer", in.layer_id);
+             return cooling_buffer->process_layer(std::move(in.gcode), std::move(in.lines), in.layer_id, in.cooling_buffer_flush);
         });
     const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [find_replace = this->m_find_replace.get()](std::string s) -> std::string {
+            SLIC3R_TRACE_ZONE("GCode::find_replace");
             return find_replace->process_layer(std::move(s));
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) {
+            SLIC3R_TRACE_ZONE("GCode::write_layer");
+            output_stream.write(s);
+        }
     );
 
     // It registers a handler that sets locales to "C" before any TBB thread starts participating in tbb::parallel_pipeline.
@@ -1582,21 +1636,21 @@ void GCode::process_layers(
     // The pipeline elements are joined using const references, thus no copying is performed.
     output_stream.find_replace_supress();
     if (m_spiral_vase && m_find_replace && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_vase & pressure_equalizer & cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator &            spiral_vase & pressure_equalizer & tokenize & cooling & find_replace & output);
     else if (m_spiral_vase && m_find_replace)
-        tbb::parallel_pipeline(12, generator & spiral_vase &                      cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_vase &                                 cooling & find_replace & output);
     else if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_vase & pressure_equalizer & cooling &                output);
+        tbb::parallel_pipeline(12, generator &            spiral_vase & pressure_equalizer & tokenize & cooling &                output);
     else if (m_find_replace && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator &               pressure_equalizer & cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator &                          pressure_equalizer & tokenize & cooling & find_replace & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_vase &                      cooling &                output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_vase &                                 cooling &                output);
     else if (m_find_replace)
-        tbb::parallel_pipeline(12, generator &                                    cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator & tokenize &                                               cooling & find_replace & output);
     else if (m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator &               pressure_equalizer & cooling &                output);
+        tbb::parallel_pipeline(12, generator &                          pressure_equalizer & tokenize & cooling &                output);
     else
-        tbb::parallel_pipeline(12, generator &                                    cooling &                output);
+        tbb::parallel_pipeline(12, generator & tokenize &                                               cooling &                output);
     output_stream.find_replace_enable();
 }
 
@@ -1610,10 +1664,11 @@ void GCode::process_layers(
     const size_t                             single_object_idx,
     GCodeOutputStream                       &output_stream)
 {
+    SLIC3R_TRACE_ZONE("GCode::process_layers");
     // The pipeline is variable: The vase mode filter is optional.
     size_t layer_to_print_idx = 0;
-    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
-        [this, &print, &tool_ordering, &layers_to_print, &layer_to_print_idx, single_object_idx](tbb::flow_control& fc) -> LayerResult {
+    const auto select_layer = tbb::make_filter<void, LayerToProcess>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &layers_to_print, &layer_to_print_idx](tbb::flow_control& fc) -> LayerToProcess {
             if (layer_to_print_idx >= layers_to_print.size()) {
                 if ((!m_pressure_equalizer && layer_to_print_idx == layers_to_print.size()) || (m_pressure_equalizer && layer_to_print_idx == (layers_to_print.size() + 1))) {
                     fc.stop();
@@ -1622,37 +1677,72 @@ void GCode::process_layers(
                     // Pressure equalizer need insert empty input. Because it returns one layer back.
                     // Insert NOP (no operation) layer;
                     ++layer_to_print_idx;
-                    return LayerResult::make_nop_layer_result();
+                    return {};
                 }
-            } else {
-                ObjectLayerToPrint &layer = layers_to_print[layer_to_print_idx ++];
+            } else
+                return { layer_to_print_idx ++ };
+        });
+    // Calculate the path planning data, which does not depend on the state of the G-code generator, for multiple layers in parallel.
+    const auto plan_paths = tbb::make_filter<LayerToProcess, LayerToProcess>(slic3r_tbb_filtermode::parallel,
+        [&print, &layers_to_print](LayerToProcess in) -> LayerToProcess {
+            if (! in.is_nop()) {
+                SLIC3R_TRACE_ZONE("GCode::make_layer_path_planning", "layer", in.layer_to_print_idx);
                 print.throw_if_canceled();
-                return this->process_layer(print, { std::move(layer) }, tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx);
+                in.path_planning = make_layer_path_planning(print, { layers_to_print[in.layer_to_print_idx] });
+            }
+            return in;
+        });
+    const auto process = tbb::make_filter<LayerToProcess, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &layers_to_print, single_object_idx](LayerToProcess in) -> LayerResult {
+            if (in.is_nop())
+                return LayerResult::make_nop_layer_result();
+            SLIC3R_TRACE_ZONE("GCode::process_layer", "layer", in.layer_to_print_idx);
+            const ObjectLayerToPrint &layer = layers_to_print[in.layer_to_print_idx];
+            print.throw_if_canceled();
+            return this->process_layer(print, { layer }, std::move(in.path_planning), tool_ordering.tools_for_layer(layer.print_z()), &layer == &layers_to_print.back(), nullptr, single_object_idx);
+        });
+    const auto generator = select_layer & plan_paths & process;
+    // Tokenize the G-code of multiple layers in parallel for the G-code filters. The pressure equalizer rewrites the G-code
+    // with its own parser, thus the G-code is tokenized after it if it is active.
+    const auto tokenize = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::parallel,
+        [extrusion_axis = get_extrusion_axis(m_config)[0], toolchange_prefix = m_writer.toolchange_prefix()](LayerResult in) -> LayerResult {
+            if (! in.nop_layer_result) {
+                SLIC3R_TRACE_ZONE("GCode::tokenize_layer", "layer", in.layer_id);
+                in.lines.parse(in.gcode, extrusion_axis, toolchange_prefix);
             }
+            return in;
         });
     const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [spiral_vase = this->m_spiral_vase.get()](LayerResult in)->LayerResult {
             if (in.nop_layer_result)
                 return in;
+            SLIC3R_TRACE_ZONE("GCode::spiral_vase", "layer", in.layer_id);
             spiral_vase->enable(in.spiral_vase_enable);
-            return { spiral_vase->process_layer(std::move(in.gcode)), in.layer_id, in.spiral_vase_enable, in.cooling_buffer_flush };
+            in.gcode = spiral_vase->process_layer(std::move(in.gcode), in.lines);
+            return in;
         });
     const auto pressure_equalizer = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
         [pressure_equalizer = this->m_pressure_equalizer.get()](LayerResult in) -> LayerResult {
+            SLIC3R_TRACE_ZONE("GCode::pressure_equalizer", "layer", in.layer_id);
              return pressure_equalizer->process_layer(std::move(in));
         });
     const auto cooling = tbb::make_filter<LayerResult, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [cooling_buffer = this->m_cooling_buffer.get()](LayerResult in)->std::string {
             if (in.nop_layer_result)
                 return in.gcode;
-            return cooling_buffer->process_layer(std::move(in.gcode), in.layer_id, in.cooling_buffer_flush);
+            SLIC3R_TRACE_ZONE("GCode::cooling_buffer", "layer", in.layer_id);
+            return cooling_buffer->process_layer(std::move(in.gcode), std::move(in.lines), in.layer_id, in.cooling_buffer_flush);
         });
     const auto find_replace = tbb::make_filter<std::string, std::string>(slic3r_tbb_filtermode::serial_in_order,
         [find_replace = this->m_find_replace.get()](std::string s) -> std::string {
+            SLIC3R_TRACE_ZONE("GCode::find_replace");
             return find_replace->process_layer(std::move(s));
         });
     const auto output = tbb::make_filter<std::string, void>(slic3r_tbb_filtermode::serial_in_order,
-        [&output_stream](std::string s) { output_stream.write(s); }
+        [&output_stream](std::string s) {
+            SLIC3R_TRACE_ZONE("GCode::write_layer");
+            output_stream.write(s);
+        }
     );
 
     // It registers a handler that sets locales to "C" before any TBB thread starts participating in tbb::parallel_pipeline.
@@ -1662,21 +1752,21 @@ void GCode::process_layers(
     // The pipeline elements are joined using const references, thus no copying is performed.
     output_stream.find_replace_supress();
     if (m_spiral_vase && m_find_replace && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_vase & pressure_equalizer & cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator &            spiral_vase & pressure_equalizer & tokenize & cooling & find_replace & output);
     else if (m_spiral_vase && m_find_replace)
-        tbb::parallel_pipeline(12, generator & spiral_vase &                      cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_vase &                                 cooling & find_replace & output);
     else if (m_spiral_vase && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator & spiral_vase & pressure_equalizer & cooling &                output);
+        tbb::parallel_pipeline(12, generator &            spiral_vase & pressure_equalizer & tokenize & cooling &                output);
     else if (m_find_replace && m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator &               pressure_equalizer & cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator &                          pressure_equalizer & tokenize & cooling & find_replace & output);
     else if (m_spiral_vase)
-        tbb::parallel_pipeline(12, generator & spiral_vase &                      cooling &                output);
+        tbb::parallel_pipeline(12, generator & tokenize & spiral_vase &                                 cooling &                output);
     else if (m_find_replace)
-        tbb::parallel_pipeline(12, generator &                                    cooling & find_replace & output);
+        tbb::parallel_pipeline(12, generator & tokenize &                                               cooling & find_replace & output);
     else if (m_pressure_equalizer)
-        tbb::parallel_pipeline(12, generator &               pressure_equalizer & cooling &                output);
+        tbb::parallel_pipeline(12, generator &                          pressure_equalizer & tokenize & cooling &                output);
     else
-        tbb::parallel_pipeline(12, generator &                                    cooling &                output);
+        tbb::parallel_pipeline(12, generator & tokenize &                                               cooling &                output);
     output_stream.find_replace_enable();
 }
 
@@ -2109,10 +2199,27 @@ namespace Skirt {
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
+GCode::LayerPathPlanning GCode::make_layer_path_planning(const Print &print, const ObjectsLayerToPrint &layers)
+{
+    LayerPathPlanning out;
+    out.extrusion_quality.reserve(layers.size());
+    for (const ObjectLayerToPrint &layer_to_print : layers)
+        out.extrusion_quality.emplace_back(layer_to_print.object_layer ?
+            ExtrusionQualityEstimator::make_layer_data(*layer_to_print.object_layer) : ExtrusionQualityEstimator::LayerData{});
+    if (print.config().avoid_crossing_perimeters) {
+        out.avoid_crossing_perimeters.reserve(layers.size());
+        for (const ObjectLayerToPrint &layer_to_print : layers)
+            out.avoid_crossing_perimeters.emplace_back(AvoidCrossingPerimeters::make_layer_data(*layer_to_print.layer()));
+    }
+    return out;
+}
+
 LayerResult GCode::process_layer(
     const Print                    			&print,
     // Set of object & print layers of the same PrintObject and with the same print_z.
     const ObjectsLayerToPrint           	&layers,
+    // Data of the above layers calculated by make_layer_path_planning().
+    LayerPathPlanning                      &&path_planning,
     const LayerTools        		        &layer_tools,
     const bool                               last_layer,
     // Pairs of PrintObject index and its instance index.
@@ -2257,9 +2364,10 @@ LayerResult GCode::process_layer(
         }
     }
 
-    for (const ObjectLayerToPrint &layer_to_print : layers) {
-        m_extrusion_quality_estimator.prepare_for_new_layer(layer_to_print.object_layer);
-    }
+    assert(path_planning.extrusion_quality.size() == layers.size());
+    for (size_t i = 0; i < layers.size(); ++ i)
+        if (const Layer *object_layer = layers[i].object_layer; object_layer)
+            m_extrusion_quality_estimator.prepare_for_new_layer(object_layer->object(), std::move(path_planning.extrusion_quality[i]));
 
     // Extrude the skirt, brim, support, perimeters, infill ordered by the extruders.
     for (unsigned int extruder_id : layer_tools.extruders)
@@ -2317,7 +2425,7 @@ LayerResult GCode::process_layer(
             for (const InstanceToPrint &instance : instances_to_print)
                 this->process_layer_single_object(
                     gcode, extruder_id, instance,
-                    layers[instance.object_layer_to_print_id], layer_tools,
+                    layers[instance.object_layer_to_print_id], path_planning, layer_tools,
                     is_anything_overridden, true /* print_wipe_extrusions */);
             if (gcode_size_old < gcode.size())
                 gcode+="; PURGING FINISHED\n";
@@ -2326,7 +2434,7 @@ LayerResult GCode::process_layer(
         for (const InstanceToPrint &instance : instances_to_print)
             this->process_layer_single_object(
                 gcode, extruder_id, instance,
-                layers[instance.object_layer_to_print_id], layer_tools,
+                layers[instance.object_layer_to_print_id], path_planning, layer_tools,
                 is_anything_overridden, false /* print_wipe_extrusions */);
     }
 
@@ -2353,6 +2461,8 @@ void GCode::process_layer_single_object(
     const InstanceToPrint    &print_instance,
     // and the object & support layer of the above.
     const ObjectLayerToPrint &layer_to_print, 
+    // Path planning data of all layers of the current print_z, indexed by print_instance.object_layer_to_print_id.
+    const LayerPathPlanning  &path_planning,
     // Container for extruder overrides (when wiping into object or infill).
     const LayerTools         &layer_tools,
     // Is any extrusion possibly marked as wiping extrusion?
@@ -2363,7 +2473,7 @@ void GCode::process_layer_single_object(
     bool     first     = true;
     int      object_id = 0;
     // Delay layer initialization as many layers may not print with all extruders.
-    auto init_layer_delayed = [this, &print_instance, &layer_to_print, &first, &object_id, &gcode]() {
+    auto init_layer_delayed = [this, &print_instance, &layer_to_print, &path_planning, &first, &object_id, &gcode]() {
         if (first) {
             first = false;
             const PrintObject &print_object = print_instance.print_object;
@@ -2371,7 +2481,7 @@ void GCode::process_layer_single_object(
             m_config.apply(print_object.config(), true);
             m_layer = layer_to_print.layer();
             if (print.config().avoid_crossing_perimeters)
-                m_avoid_crossing_perimeters.init_layer(*m_layer);
+                m_avoid_crossing_perimeters.init_layer(path_planning.avoid_crossing_perimeters[print_instance.object_layer_to_print_id]);
             // When starting a new object, use the external motion planner for the first travel move.
             const Point &offset = print_object.instances()[print_instance.instance_id].shift;
             std::pair<const PrintObject*, Point> this_object_copy(&print_object, offset);
@@ -2743,6 +2853,8 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, const std::string_view descr
 
     if (m_wipe.enable) {
         m_wipe.path = paths.front().polyline;
+        // Wiping is planar.
+        m_wipe.path.z.clear();
 
         for (auto it = std::next(paths.begin()); it != paths.end(); ++it) {
             if (it->role().is_bridge())
@@ -2787,11 +2899,10 @@ std::string GCode::extrude_loop(ExtrusionLoop loop, const std::string_view descr
         // Shift by no more than a nozzle diameter.
         //FIXME Hiding the seams will not work nicely for very densely discretized contours!
         Point  pt = ((nd * nd >= l2) ? p2 : (p1 + v * (nd / sqrt(l2)))).cast<coord_t>();
-        pt.nonplanar_z = paths.front().polyline.points.front().nonplanar_z;
         // Rotate pt inside around the seam point.
         pt.rotate(angle_inside / 3., paths.front().polyline.points.front());
         // generate the travel move
-        gcode += m_writer.travel_to_xyz(this->point3_to_gcode(pt), "move inwards before travel");
+        gcode += m_writer.travel_to_xyz(this->point3_to_gcode(pt, paths.front().polyline.first_z()), "move inwards before travel");
     }
 
     return gcode;
@@ -2811,6 +2922,7 @@ std::string GCode::extrude_multi_path(ExtrusionMultiPath multipath, const std::s
     }
     if (m_wipe.enable) {
         m_wipe.path = std::move(multipath.paths.back().polyline);
+        m_wipe.path.z.clear();
         m_wipe.path.reverse();
 
         for (auto it = std::next(multipath.paths.rbegin()); it != multipath.paths.rend(); ++it) {
@@ -2854,6 +2966,7 @@ std::string GCode::extrude_path(ExtrusionPath path, std::string_view description
     std::string gcode = this->_extrude(path, description, speed);
     if (m_wipe.enable) {
         m_wipe.path = std::move(path.polyline);
+        m_wipe.path.z.clear();
         m_wipe.path.reverse();
     }
     // reset acceleration
@@ -2894,32 +3007,181 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
     return gcode;
 }
 
+// Batches of G-code are passed from GCodeOutputStream::write() to a writer thread (disk I/O) and to a processor thread
+// (GCodeProcessor analysis), so that the caller does not wait for either of them. The number of batches in flight is bounded:
+// if the workers fall behind, hand_over() blocks until a batch is consumed by both of them and recycled with its memory.
+struct GCode::GCodeOutputStream::Workers
+{
+    // Hand over a batch once it grew over this size. Batches only end at write() boundaries, thus they hold whole layers.
+    static constexpr size_t buffer_size_threshold = 1024 * 1024;
+    static constexpr size_t num_buffers           = 4;
+
+    struct Buffer {
+        std::string data;
+        // Number of worker threads, which did not consume this buffer yet.
+        int         pending { 0 };
+    };
+
+    // If f is null, the G-code is written by the G-code processor and the writer thread is not started.
+    Workers(FILE *f, GCodeProcessor &processor) : buffers(num_buffers) {
+        for (Buffer &buffer : buffers)
+            free_buffers.emplace_back(&buffer);
+        if (f) {
+            writer = create_thread([this, f]() {
+                this->run(write_queue, [this, f](const std::string &data) {
+                    if (::fwrite(data.data(), 1, data.size(), f) != data.size())
+                        write_failed = true;
+                });
+            });
+            set_thread_name(writer, "slic3r_gcwriter");
+        }
+        processor_thread = create_thread([this, &processor]() {
+            // GCodeProcessor parses numbers, thus it needs "." as a decimal separator.
+            CNumericLocalesSetter locales_setter;
+            this->run(process_queue, [this, &processor](const std::string &data) {
+                if (! process_exception) {
+                    try {
+                        processor.process_buffer(data);
+                    } catch (...) {
+                        std::scoped_lock<std::mutex> lock(mutex);
+                        process_exception = std::current_exception();
+                    }
+                }
+            });
+        });
+        set_thread_name(processor_thread, "slic3r_gcproc");
+    }
+
+    // Consumes all the batches handed over so far, then stops the threads.
+    ~Workers() {
+        {
+            std::scoped_lock<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_all();
+        if (writer.joinable())
+            writer.join();
+        processor_thread.join();
+    }
+
+    // Swap data into a free buffer and queue it to both workers, data receives the memory of an already consumed batch.
+    void hand_over(std::string &data) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this]{ return ! free_buffers.empty(); });
+            Buffer *buffer = free_buffers.back();
+            free_buffers.pop_back();
+            buffer->data.swap(data);
+            buffer->pending = 1;
+            if (writer.joinable()) {
+                ++ buffer->pending;
+                write_queue.emplace_back(buffer);
+            }
+            process_queue.emplace_back(buffer);
+        }
+        cond.notify_all();
+    }
+
+    // Block until all the batches handed over were consumed, rethrow an exception of the G-code processor.
+    void wait_idle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this]{ return free_buffers.size() == buffers.size(); });
+        if (process_exception)
+            std::rethrow_exception(process_exception);
+    }
+
+    template<typename ConsumeFn>
+    void run(std::deque<Buffer*> &queue, ConsumeFn consume) {
+        for (;;) {
+            Buffer *buffer;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cond.wait(lock, [this, &queue]{ return stopping || ! queue.empty(); });
+                if (queue.empty())
+                    // Stopping and all the batches were consumed.
+                    return;
+                buffer = queue.front();
+                queue.pop_front();
+            }
+            consume(buffer->data);
+            {
+                std::scoped_lock<std::mutex> lock(mutex);
+                if (-- buffer->pending == 0) {
+                    // Keep the capacity of the buffer for the next batch.
+                    buffer->data.clear();
+                    free_buffers.emplace_back(buffer);
+                }
+            }
+            cond.notify_all();
+        }
+    }
+
+    std::mutex              mutex;
+    std::condition_variable cond;
+    std::vector<Buffer>     buffers;
+    std::vector<Buffer*>    free_buffers;
+    std::deque<Buffer*>     write_queue;
+    std::deque<Buffer*>     process_queue;
+    bool                    stopping { false };
+    std::atomic<bool>       write_failed { false };
+    std::exception_ptr      process_exception;
+    boost::thread           writer;
+    boost::thread           processor_thread;
+};
+
+GCode::GCodeOutputStream::GCodeOutputStream(FILE *f, GCodeProcessor &processor) : f(f), m_processor(processor)
+{
+    m_buffer.reserve(Workers::buffer_size_threshold * 2);
+}
+
+GCode::GCodeOutputStream::~GCodeOutputStream()
+{
+    this->close();
+}
+
 bool GCode::GCodeOutputStream::is_error() const 
 {
-    return ::ferror(this->f);
+    return (this->f && ::ferror(this->f)) || (m_workers && m_workers->write_failed);
 }
 
 void GCode::GCodeOutputStream::flush()
 { 
-    ::fflush(this->f);
+    if (! m_buffer.empty())
+        this->hand_over_buffer();
+    if (m_workers)
+        m_workers->wait_idle();
+    if (this->f)
+        ::fflush(this->f);
 }
 
 void GCode::GCodeOutputStream::close()
 { 
+    if (! m_buffer.empty())
+        this->hand_over_buffer();
+    // Joins the worker threads after they consumed all the batches.
+    m_workers.reset();
     if (this->f) {
         ::fclose(this->f);
         this->f = nullptr;
     }
 }
 
+void GCode::GCodeOutputStream::hand_over_buffer()
+{
+    if (! m_workers)
+        m_workers = std::make_unique<Workers>(this->f, m_processor);
+    m_workers->hand_over(m_buffer);
+}
+
 void GCode::GCodeOutputStream::write(const char *what)
 {
     if (what != nullptr) {
-        //FIXME don't allocate a string, maybe process a batch of lines?
-        std::string gcode(m_find_replace ? m_find_replace->process_layer(what) : what);
-        // writes string to file
-        fwrite(gcode.c_str(), 1, gcode.size(), this->f);
-        m_processor.process_buffer(gcode);
+        if (m_find_replace)
+            m_buffer += m_find_replace->process_layer(what);
+        else
+            m_buffer += what;
+        if (m_buffer.size() >= Workers::buffer_size_threshold)
+            this->hand_over_buffer();
     }
 }
 
@@ -2972,7 +3234,7 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
         comment += description;
         comment += description_bridge;
         comment += " point";
-        gcode += this->travel_to(path.first_point(), path.role(), comment);
+        gcode += this->travel_to(path.first_point(), path.role(), comment, path.polyline.first_z());
     }
 
     // compensate retraction
@@ -3162,11 +3424,9 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
             comment = description;
             comment += description_bridge;
         }
-        Vec3d prev3 = this->point3_to_gcode_quantized(path.polyline.points.front());
-        auto  it   = path.polyline.points.begin();
-        auto  end  = path.polyline.points.end();
-        for (++ it; it != end; ++ it) {
-            Vec3d p3 = this->point3_to_gcode_quantized(*it);
+        Vec3d prev3 = this->point3_to_gcode_quantized(path.polyline.points.front(), path.polyline.first_z());
+        for (size_t i = 1; i < path.polyline.points.size(); ++ i) {
+            Vec3d p3 = this->point3_to_gcode_quantized(path.polyline.points[i], path.polyline.point_z(i));
             const double line_length = (p3 - prev3).norm();
             path_length += line_length;
             gcode += m_writer.extrude_to_xyz(p3, e_per_mm * line_length, comment);
@@ -3182,10 +3442,10 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
         double last_set_fan_speed = new_points[0].fan_speed;
         gcode += m_writer.set_speed(last_set_speed, "", cooling_marker_setspeed_comments);
         gcode += "\n;_SET_FAN_SPEED" + std::to_string(int(last_set_fan_speed)) + "\n";
-        Vec3d prev3 = this->point3_to_gcode_quantized(new_points[0].p);
+        Vec3d prev3 = this->point3_to_gcode_quantized(new_points[0].p, -1);
         for (size_t i = 1; i < new_points.size(); i++) {
             const ProcessedPoint &processed_point = new_points[i];
-            Vec3d                 p3              = this->point3_to_gcode_quantized(processed_point.p);
+            Vec3d                 p3              = this->point3_to_gcode_quantized(processed_point.p, -1);
             const double          line_length     = (p3 - prev3).norm();
             gcode += m_writer.extrude_to_xyz(p3, e_per_mm * line_length, marked_comment);
             prev3             = p3;
@@ -3205,12 +3465,12 @@ std::string GCode::_extrude(const ExtrusionPath &path, const std::string_view de
     if (m_enable_cooling_markers)
         gcode += path.role().is_bridge() ? ";_BRIDGE_FAN_END\n" : ";_EXTRUDE_END\n";
 
-    this->set_last_pos(path.last_point());
+    this->set_last_pos(path.last_point(), path.polyline.last_z());
     return gcode;
 }
 
 // This method accepts &point in print coordinates.
-std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string comment)
+std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string comment, coord_t z)
 {
     /*  Define the travel move as a line between current position and the taget point.
         This is expressed in print coordinates, so it will need to be translated by
@@ -3228,6 +3488,16 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
         }
     }
 
+    // Only the end points of the travel may be nonplanar.
+    auto assign_travel_z = [this, z](Polyline &travel) {
+        if (m_last_pos_z != -1 || z != -1) {
+            travel.z.assign(travel.size(), -1);
+            travel.z.front() = m_last_pos_z;
+            travel.z.back()  = z;
+        }
+    };
+    assign_travel_z(travel);
+
     // check whether a straight travel move would need retraction
     bool needs_retraction             = this->needs_retraction(travel, role);
     // check whether we need to move to a different z layer
@@ -3243,6 +3513,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
         && m_config.avoid_crossing_perimeters
         && ! m_avoid_crossing_perimeters.disabled_once()) {
         travel = m_avoid_crossing_perimeters.travel_to(*this, point, &could_be_wipe_disabled);
+        assign_travel_z(travel);
         // check again whether the new travel path still needs a retraction
         needs_retraction = this->needs_retraction(travel, role);
         //if (needs_retraction && m_layer_index > 1) exit(0);
@@ -3267,6 +3538,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
             if (used_external_mp_once)
                 m_avoid_crossing_perimeters.use_external_mp_once();
             travel = m_avoid_crossing_perimeters.travel_to(*this, point);
+            assign_travel_z(travel);
             // If state of use_external_mp_once was changed reset it to right value.
             if (used_external_mp_once)
                 m_avoid_crossing_perimeters.reset_once_modifiers();
@@ -3280,8 +3552,8 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
 
         // Move Z up if necessary
         if (needs_zmove) {
-            float move_z = unscale<double>(travel.points[0].nonplanar_z);
-            if(travel.points[0].nonplanar_z == -1)
+            float move_z = unscale<double>(travel.first_z());
+            if(travel.first_z() == -1)
                 move_z = this->layer()->print_z;
             gcode += m_writer.travel_to_z(move_z, "Move up for non planar extrusion");
         }
@@ -3290,7 +3562,7 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
 
         for (size_t i = 1; i < travel.size(); ++ i) {
             if (needs_zmove) {
-                gcode += m_writer.travel_to_xyz(this->point3_to_gcode(travel.points[i]), comment);
+                gcode += m_writer.travel_to_xyz(this->point3_to_gcode(travel.points[i], travel.point_z(i)), comment);
             } else {
                 gcode += m_writer.travel_to_xy(this->point_to_gcode(travel.points[i]), comment);
             }
@@ -3303,14 +3575,14 @@ std::string GCode::travel_to(const Point &point, ExtrusionRole role, std::string
         }
 
         if (needs_zmove) {
-            float move_z = unscale<double>(point.nonplanar_z);
-            if(point.nonplanar_z == -1) {
+            float move_z = unscale<double>(z);
+            if(z == -1) {
                 move_z = this->layer()->print_z;
             }
             gcode += m_writer.travel_to_z(move_z, "Move down for non planar extrusion");
         }
 
-        this->set_last_pos(travel.points.back());
+        this->set_last_pos(travel.points.back(), travel.last_z());
     }
 
 
@@ -3365,9 +3637,9 @@ GCode::needs_zmove(const Polyline &travel)
     }
 
     //check if any point in travel is below the layer z
-    for (Point p : travel.points)
+    for (coord_t z : travel.z)
     {
-        if ((p.nonplanar_z != -1) && (p.nonplanar_z < scale_(this->layer()->print_z)))
+        if ((z != -1) && (z < scale_(this->layer()->print_z)))
             return true;
     }
 
@@ -3509,12 +3781,12 @@ Vec2d GCode::point_to_gcode(const Point &point) const
 }
 
 // convert a model-space scaled point into G-code coordinates
-Vec3d GCode::point3_to_gcode(const Point &point) const
+Vec3d GCode::point3_to_gcode(const Point &point, coord_t z) const
 {
     Vec2d extruder_offset = EXTRUDER_CONFIG(extruder_offset);
     double p_x = unscaled<double>(point.x()) + m_origin.x() - extruder_offset.x();
     double p_y = unscaled<double>(point.y()) + m_origin.y() - extruder_offset.y();
-    double p_z = point.nonplanar_z == -1 ? this->layer()->print_z : unscale<double>(point.nonplanar_z);
+    double p_z = z == -1 ? this->layer()->print_z : unscale<double>(z);
     return { p_x, p_y, p_z };
 }
 
@@ -3524,9 +3796,9 @@ Vec2d GCode::point_to_gcode_quantized(const Point &point) const
     return { GCodeFormatter::quantize_xyzf(p.x()), GCodeFormatter::quantize_xyzf(p.y()) };
 }
 
-Vec3d GCode::point3_to_gcode_quantized(const Point &point) const
+Vec3d GCode::point3_to_gcode_quantized(const Point &point, coord_t z) const
 {
-    Vec3d p = this->point3_to_gcode(point);
+    Vec3d p = this->point3_to_gcode(point, z);
     return { GCodeFormatter::quantize_xyzf(p.x()), GCodeFormatter::quantize_xyzf(p.y()), GCodeFormatter::quantize_xyzf(p.z()) };
 }
 
@@ -13,6 +13,7 @@
 #include "GCode/AvoidCrossingPerimeters.hpp"
 #include "GCode/CoolingBuffer.hpp"
 #include "GCode/FindReplace.hpp"
+#include "GCode/GCodeLayerLines.hpp"
 #include "GCode/RetractWhenCrossingPerimeters.hpp"
 #include "GCode/SpiralVase.hpp"
 #include "GCode/ToolOrdering.hpp"
@@ -125,6 +126,8 @@ struct LayerResult {
     // Is indicating if this LayerResult should be processed, or it is just inserted artificial LayerResult.
     // It is used for the pressure equalizer because it needs to buffer one layer back.
     bool        nop_layer_result { false };
+    // Tokenized gcode, shared by the G-code filters of the export pipeline.
+    GCodeLayerLines lines;
 
     static LayerResult make_nop_layer_result() { return {"", std::numeric_limits<coord_t>::max(), false, false, true}; }
 };
@@ -166,10 +169,11 @@ public:
     const Point&    last_pos() const { return m_last_pos; }
     // Convert coordinates of the active object to G-code coordinates, possibly adjusted for extruder offset.
     Vec2d           point_to_gcode(const Point &point) const;
-    Vec3d           point3_to_gcode(const Point &point) const;
+    // z is the Z coordinate of a nonplanar point, -1 for the Z of the active layer.
+    Vec3d           point3_to_gcode(const Point &point, coord_t z) const;
     // Convert coordinates of the active object to G-code coordinates, possibly adjusted for extruder offset and quantized to G-code resolution.
     Vec2d           point_to_gcode_quantized(const Point &point) const;
-    Vec3d           point3_to_gcode_quantized(const Point &point) const;
+    Vec3d           point3_to_gcode_quantized(const Point &point, coord_t z) const;
     Point           gcode_to_point(const Vec2d &point) const;
     const FullPrintConfig &config() const { return m_config; }
     const Layer*    layer() const { return m_layer; }
@@ -206,8 +210,9 @@ public:
 private:
     class GCodeOutputStream {
     public:
-        GCodeOutputStream(FILE *f, GCodeProcessor &processor) : f(f), m_processor(processor) {}
-        ~GCodeOutputStream() { this->close(); }
+        // f is null if the processor writes the G-code, see GCodeProcessor::enable_single_pass_export().
+        GCodeOutputStream(FILE *f, GCodeProcessor &processor);
+        ~GCodeOutputStream();
 
         // Set a find-replace post-processor to modify the G-code before GCodePostProcessor.
         // It is being set to null inside process_layers(), because the find-replace process
@@ -217,9 +222,13 @@ private:
         void find_replace_supress() { m_find_replace = nullptr; }
 
         bool is_open() const { return f; }
+        // Only valid after flush(), which waits for the writer thread to write all the buffered G-code.
         bool is_error() const;
         
+        // Hand over the buffered G-code to the writer and processor threads, wait until they consumed it
+        // and flush the file. Rethrows an exception thrown by the GCodeProcessor.
         void flush();
+        // Write out the buffered G-code, stop the writer and processor threads and close the file.
         void close();
 
         // Write a string into a file.
@@ -235,22 +244,56 @@ private:
         void write_format(const char* format, ...);
 
     private:
+        // Writer and processor threads with a bounded pool of recycled buffers, see GCode.cpp.
+        struct Workers;
+        // Pass m_buffer to the writer and processor threads, start the threads on the first call.
+        void hand_over_buffer();
+
         FILE             *f { nullptr };
         // Find-replace post-processor to be called before GCodePostProcessor.
         GCodeFindReplace *m_find_replace { nullptr };
         // If suppressed, the backoup holds m_find_replace.
         GCodeFindReplace *m_find_replace_backup { nullptr };
         GCodeProcessor   &m_processor;
+        // G-code accumulated by write() until it is handed over to the worker threads.
+        // Its memory is recycled by swapping it with an already consumed buffer.
+        std::string       m_buffer;
+        std::unique_ptr<Workers> m_workers;
     };
     void            _do_export(Print &print, GCodeOutputStream &file, ThumbnailsGeneratorCallback thumbnail_cb);
 
     static ObjectsLayerToPrint         		                     collect_layers_to_print(const PrintObject &object);
     static std::vector<std::pair<coordf_t, ObjectsLayerToPrint>> collect_layers_to_print(const Print &print);
 
+    // Path planning data of the layers of a single print_z: The overhang distancers of ExtrusionQualityEstimator
+    // and the AvoidCrossingPerimeters boundaries. They do not depend on the state of the G-code generator,
+    // thus process_layers() calculates them for multiple layers in parallel ahead of process_layer().
+    // process_layer() itself stays serial, as the emitted G-code depends on the GCodeWriter position,
+    // the active tool, the retraction / wipe state and the wipe tower.
+    struct LayerPathPlanning
+    {
+        // One item for each ObjectLayerToPrint, empty for an ObjectLayerToPrint without an object layer.
+        std::vector<ExtrusionQualityEstimator::LayerData>                      extrusion_quality;
+        // One item for each ObjectLayerToPrint, empty if avoid_crossing_perimeters is disabled.
+        std::vector<std::shared_ptr<const AvoidCrossingPerimeters::LayerData>> avoid_crossing_perimeters;
+    };
+    static LayerPathPlanning make_layer_path_planning(const Print &print, const ObjectsLayerToPrint &layers);
+    // Item passed through the pipeline of process_layers() from the layer selection to process_layer().
+    struct LayerToProcess
+    {
+        // Index into the layers to print, size_t(-1) for a NOP layer inserted for the pressure equalizer.
+        size_t            layer_to_print_idx { size_t(-1) };
+        LayerPathPlanning path_planning;
+
+        bool              is_nop() const { return layer_to_print_idx == size_t(-1); }
+    };
+
     LayerResult process_layer(
         const Print                     &print,
         // Set of object & print layers of the same PrintObject and with the same print_z.
         const ObjectsLayerToPrint       &layers,
+        // Data of the above layers calculated by make_layer_path_planning().
+        LayerPathPlanning              &&path_planning,
         const LayerTools  				&layer_tools,
         const bool                       last_layer,
 		// Pairs of PrintObject index and its instance index.
@@ -277,7 +320,7 @@ private:
         const size_t                             single_object_idx,
         GCodeOutputStream                       &output_stream);
 
-    void            set_last_pos(const Point &pos) { m_last_pos = pos; m_last_pos_defined = true; }
+    void            set_last_pos(const Point &pos, coord_t z = -1) { m_last_pos = pos; m_last_pos_z = z; m_last_pos_defined = true; }
     bool            last_pos_defined() const { return m_last_pos_defined; }
     void            set_extruders(const std::vector<unsigned int> &extruder_ids);
     std::string     preamble();
@@ -317,6 +360,8 @@ private:
         const InstanceToPrint    &print_instance,
         // and the object & support layer of the above.
         const ObjectLayerToPrint &layer_to_print, 
+        // Path planning data of all layers of the current print_z, indexed by print_instance.object_layer_to_print_id.
+        const LayerPathPlanning  &path_planning,
         // Container for extruder overrides (when wiping into object or infill).
         const LayerTools         &layer_tools,
         // Is any extrusion possibly marked as wiping extrusion?
@@ -326,7 +371,7 @@ private:
 
     std::string     extrude_support(const ExtrusionEntityCollection &support_fills);
 
-    std::string     travel_to(const Point &point, ExtrusionRole role, std::string comment);
+    std::string     travel_to(const Point &point, ExtrusionRole role, std::string comment, coord_t z = -1);
     bool            needs_retraction(const Polyline &travel, ExtrusionRole role = ExtrusionRole::None);
     bool            needs_zmove(const Polyline &travel);
     std::string     retract(bool toolchange = false);
@@ -415,6 +460,8 @@ private:
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
 
     Point                               m_last_pos;
+    // Z of m_last_pos if it is a point of a nonplanar extrusion, otherwise -1.
+    coord_t                             m_last_pos_z { -1 };
     bool                                m_last_pos_defined;
 
     std::unique_ptr<CoolingBuffer>      m_cooling_buffer;
@@ -1183,7 +1183,8 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
     Vec2d endf   = end  .cast<double>();
 
     bool is_support_layer = dynamic_cast<const SupportLayer *>(gcodegen.layer()) != nullptr;
-    if (!use_external && (is_support_layer || (!m_lslices_offset.empty() && !any_expolygon_contains(m_lslices_offset, m_lslices_offset_bboxes, m_grid_lslices_offset, travel)))) {
+    const LayerData &layer_data = *m_layer_data;
+    if (!use_external && (is_support_layer || (!layer_data.lslices_offset.empty() && !any_expolygon_contains(layer_data.lslices_offset, layer_data.lslices_offset_bboxes, layer_data.grid_lslices_offset, travel)))) {
         // Initialize m_internal only when it is necessary.
         if (m_internal.boundaries.empty())
             init_boundary(&m_internal, to_polygons(get_boundary(*gcodegen.layer())));
@@ -1233,32 +1234,39 @@ Polyline AvoidCrossingPerimeters::travel_to(const GCode &gcodegen, const Point &
     } else if (max_detour_length_exceeded) {
         *could_be_wipe_disabled = false;
     } else
-        *could_be_wipe_disabled = !need_wipe(gcodegen, m_lslices_offset, m_lslices_offset_bboxes, m_grid_lslices_offset, travel, result_pl, travel_intersection_count);
+        *could_be_wipe_disabled = !need_wipe(gcodegen, layer_data.lslices_offset, layer_data.lslices_offset_bboxes, layer_data.grid_lslices_offset, travel, result_pl, travel_intersection_count);
 
     return result_pl;
 }
 
 // ************************************* AvoidCrossingPerimeters::init_layer() *****************************************
 
-void AvoidCrossingPerimeters::init_layer(const Layer &layer)
+std::shared_ptr<const AvoidCrossingPerimeters::LayerData> AvoidCrossingPerimeters::make_layer_data(const Layer &layer)
 {
-    m_internal.clear();
-    m_external.clear();
-    m_lslices_offset.clear();
-    m_lslices_offset_bboxes.clear();
+    // The grid references the contours of lslices_offset, thus the data is constructed in place.
+    auto out = std::make_shared<LayerData>();
 
     float perimeter_offset = -get_external_perimeter_width(layer) / float(2.);
-    m_lslices_offset        = offset_ex(layer.lslices, perimeter_offset);
+    out->lslices_offset    = offset_ex(layer.lslices, perimeter_offset);
 
-    m_lslices_offset_bboxes.reserve(m_lslices_offset.size());
-    for (const ExPolygon &ex_poly : m_lslices_offset)
-        m_lslices_offset_bboxes.emplace_back(get_extents(ex_poly));
+    out->lslices_offset_bboxes.reserve(out->lslices_offset.size());
+    for (const ExPolygon &ex_poly : out->lslices_offset)
+        out->lslices_offset_bboxes.emplace_back(get_extents(ex_poly));
 
     BoundingBox bbox_slice(get_extents(layer.lslices));
     bbox_slice.offset(SCALED_EPSILON);
 
-    m_grid_lslices_offset.set_bbox(bbox_slice);
-    m_grid_lslices_offset.create(m_lslices_offset, coord_t(scale_(1.)));
+    out->grid_lslices_offset.set_bbox(bbox_slice);
+    out->grid_lslices_offset.create(out->lslices_offset, coord_t(scale_(1.)));
+    return out;
+}
+
+void AvoidCrossingPerimeters::init_layer(std::shared_ptr<const LayerData> layer_data)
+{
+    assert(layer_data);
+    m_internal.clear();
+    m_external.clear();
+    m_layer_data = std::move(layer_data);
 }
 
 #if 0
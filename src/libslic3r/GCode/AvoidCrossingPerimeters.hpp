@@ -5,6 +5,8 @@
 #include "../ExPolygon.hpp"
 #include "../EdgeGrid.hpp"
 
+#include <memory>
+
 namespace Slic3r {
 
 // Forward declarations.
@@ -23,7 +25,20 @@ public:
     bool        disabled_once() const   { return m_disabled_once; }
     void        reset_once_modifiers()  { m_use_external_mp_once = false; m_disabled_once = false; }
 
-    void        init_layer(const Layer &layer);
+    // Data of a single layer, which does not depend on the state of the motion planner.
+    // It may thus be calculated for multiple layers in parallel ahead of init_layer().
+    struct LayerData {
+        // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
+        ExPolygons               lslices_offset;
+        std::vector<BoundingBox> lslices_offset_bboxes;
+        // Used for detection of line or polyline is inside of any polygon.
+        EdgeGrid::Grid           grid_lslices_offset;
+    };
+    static std::shared_ptr<const LayerData> make_layer_data(const Layer &layer);
+
+    void        init_layer(const Layer &layer) { this->init_layer(make_layer_data(layer)); }
+    // Layer data may be shared by multiple instances of the same object.
+    void        init_layer(std::shared_ptr<const LayerData> layer_data);
 
     Polyline    travel_to(const GCode& gcodegen, const Point& point)
     {
@@ -58,11 +73,8 @@ private:
     // we enable it by default for the first travel move in print
     bool           m_disabled_once { true };
 
-    // Lslices offseted by half an external perimeter width. Used for detection if line or polyline is inside of any polygon.
-    ExPolygons               m_lslices_offset;
-    std::vector<BoundingBox> m_lslices_offset_bboxes;
-    // Used for detection of line or polyline is inside of any polygon.
-    EdgeGrid::Grid           m_grid_lslices_offset;
+    // Data of the active layer, never null.
+    std::shared_ptr<const LayerData> m_layer_data { std::make_shared<const LayerData>() };
     // Store all needed data for travels inside object
     Boundary m_internal;
     // Store all needed data for travels outside object
@@ -15,13 +15,12 @@
 
 #include <assert.h>
 
-#include <fast_float/fast_float.h>
-
 namespace Slic3r {
 
 CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_config(gcodegen.config()), m_toolchange_prefix(gcodegen.writer().toolchange_prefix()), m_current_extruder(0)
 {
     this->reset(gcodegen.writer().get_position());
+    m_extrusion_axis = get_extrusion_axis(m_config)[0];
 
     const std::vector<Extruder> &extruders = gcodegen.writer().extruders();
     m_extruder_ids.reserve(extruders.size());
@@ -302,30 +301,38 @@ finished:
 	return new_feedrate;
 }
 
-std::string CoolingBuffer::process_layer(std::string &&gcode, size_t layer_id, bool flush)
+std::string CoolingBuffer::process_layer(std::string &&gcode, GCodeLayerLines &&lines, size_t layer_id, bool flush)
 {
+    if (! lines.valid_for(gcode))
+        lines.parse(gcode, m_extrusion_axis, m_toolchange_prefix);
+
     // Cache the input G-code.
-    if (m_gcode.empty())
+    if (m_gcode.empty()) {
         m_gcode = std::move(gcode);
-    else
+        m_lines = std::move(lines);
+    } else {
         m_gcode += gcode;
+        m_lines.append(lines);
+    }
 
     std::string out;
     if (flush) {
         // This is either an object layer or the very last print layer. Calculate cool down over the collected support layers
         // and one object layer.
-        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_current_pos);
+        std::vector<PerExtruderAdjustments> per_extruder_adjustments = this->parse_layer_gcode(m_gcode, m_lines, m_current_pos);
         float layer_time_stretched = this->calculate_layer_slowdown(per_extruder_adjustments);
         out = this->apply_layer_cooldown(m_gcode, layer_id, layer_time_stretched, per_extruder_adjustments);
         m_gcode.clear();
+        m_lines.clear();
     }
     return out;
 }
 
-// Parse the layer G-code for the moves, which could be adjusted.
+// Collect the moves, which could be adjusted, from the tokenized layer G-code.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, const GCodeLayerLines &lines, std::vector<float> &current_pos) const
 {
+    assert(lines.valid_for(gcode));
     std::vector<PerExtruderAdjustments> per_extruder_adjustments(m_extruder_ids.size());
     std::vector<size_t>                 map_extruder_to_per_extruder_adjustment(m_num_extruders, 0);
     for (size_t i = 0; i < m_extruder_ids.size(); ++ i) {
@@ -340,64 +347,36 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
 
     unsigned int      current_extruder  = m_current_extruder;
     PerExtruderAdjustments *adjustment  = &per_extruder_adjustments[map_extruder_to_per_extruder_adjustment[current_extruder]];
-    const char       *line_start = gcode.c_str();
-    const char       *line_end   = line_start;
-    const char        extrusion_axis = get_extrusion_axis(m_config)[0];
     // Index of an existing CoolingLine of the current adjustment, which holds the feedrate setting command
     // for a sequence of extrusion moves.
     size_t            active_speed_modifier = size_t(-1);
 
     std::vector<float> new_pos;
-    for (; *line_start != 0; line_start = line_end) 
+    for (const GCodeLayerLine &gline : lines)
     {
-        while (*line_end != '\n' && *line_end != 0)
-            ++ line_end;
-        // sline will not contain the trailing '\n'.
-        std::string_view sline(line_start, line_end - line_start);
         // CoolingLine will contain the trailing '\n'.
-        if (*line_end == '\n')
-            ++ line_end;
-        CoolingLine line(0, line_start - gcode.c_str(), line_end - gcode.c_str());
-        if (boost::starts_with(sline, "G0 "))
-            line.type = CoolingLine::TYPE_G0;
-        else if (boost::starts_with(sline, "G1 "))
-            line.type = CoolingLine::TYPE_G1;
-        else if (boost::starts_with(sline, "G92 "))
-            line.type = CoolingLine::TYPE_G92;
-        if (line.type) {
-            // G0, G1 or G92
-            // Parse the G-code line.
+        CoolingLine line(0, gline.begin, gline.end);
+        if (gline.type == GCodeLayerLine::TYPE_G0 || gline.type == GCodeLayerLine::TYPE_G1 || gline.type == GCodeLayerLine::TYPE_G92) {
+            line.type = gline.type == GCodeLayerLine::TYPE_G0 ? CoolingLine::TYPE_G0 :
+                        gline.type == GCodeLayerLine::TYPE_G1 ? CoolingLine::TYPE_G1 : CoolingLine::TYPE_G92;
             new_pos = current_pos;
-            for (auto c = sline.begin() + 3;;) {
-                // Skip whitespaces.
-                for (; c != sline.end() && (*c == ' ' || *c == '\t'); ++ c);
-                if (c == sline.end() || *c == ';')
-                    break;
-
-                // Parse the axis.
-                size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
-                              (*c == extrusion_axis) ? 3 : (*c == 'F') ? 4 : size_t(-1);
-                if (axis != size_t(-1)) {
-                    //auto [pend, ec] = 
-                        fast_float::from_chars(&*(++ c), sline.data() + sline.size(), new_pos[axis]);
-                    if (axis == 4) {
-                        // Convert mm/min to mm/sec.
-                        new_pos[4] /= 60.f;
-                        if ((line.type & CoolingLine::TYPE_G92) == 0)
-                            // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
-                            line.type |= CoolingLine::TYPE_HAS_F;
-                    }
-                }
-                // Skip this word.
-                for (; c != sline.end() && *c != ' ' && *c != '\t'; ++ c);
+            for (size_t axis = 0; axis < 5; ++ axis)
+                if (gline.has(GCodeLayerLine::Axis(axis)))
+                    new_pos[axis] = gline.value(GCodeLayerLine::Axis(axis));
+            if (gline.has_tag(GCodeLayerLine::TAG_F_WORD)) {
+                // Convert mm/min to mm/sec.
+                new_pos[4] /= 60.f;
+                if ((line.type & CoolingLine::TYPE_G92) == 0)
+                    // This is G0 or G1 line and it sets the feedrate. This mark is used for reducing the duplicate F calls.
+                    line.type |= CoolingLine::TYPE_HAS_F;
             }
-            bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
-            bool wipe               = boost::contains(sline, ";_WIPE");
+            bool external_perimeter = gline.has_tag(GCodeLayerLine::TAG_EXTERNAL_PERIMETER);
+            bool wipe               = gline.has_tag(GCodeLayerLine::TAG_WIPE);
             if (external_perimeter)
                 line.type |= CoolingLine::TYPE_EXTERNAL_PERIMETER;
             if (wipe)
                 line.type |= CoolingLine::TYPE_WIPE;
-            if (boost::contains(sline, ";_EXTRUDE_SET_SPEED") && ! wipe) {
+            if (gline.has_tag(GCodeLayerLine::TAG_EXTRUDE_SET_SPEED) && ! wipe) {
                 line.type |= CoolingLine::TYPE_ADJUSTABLE;
                 active_speed_modifier = adjustment->lines.size();
             }
@@ -448,7 +427,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 }
             }
             current_pos = std::move(new_pos);
-        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+        } else if (gline.type == GCodeLayerLine::TYPE_EXTRUDE_END) {
             // Closing a block of non-zero length extrusion moves.
             line.type = CoolingLine::TYPE_EXTRUDE_END;
             if (active_speed_modifier != size_t(-1)) {
@@ -467,10 +446,9 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 }
             }
             active_speed_modifier = size_t(-1);
-        } else if (boost::starts_with(sline, m_toolchange_prefix)) {
-            unsigned int new_extruder = 0;
-            auto res = std::from_chars(sline.data() + m_toolchange_prefix.size(), sline.data() + sline.size(), new_extruder);
-            if (res.ec != std::errc::invalid_argument) {
+        } else if (gline.type == GCodeLayerLine::TYPE_TOOLCHANGE) {
+            if (gline.param != GCodeLayerLine::INVALID_TOOL) {
+                unsigned int new_extruder = gline.param;
                 // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes - those shall be ignored.
                 if (new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
                     if (new_extruder != current_extruder) {
@@ -483,37 +461,22 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                 else {
                     // Only log the error in case of MM printer. Single extruder printers likely ignore any T anyway.
                     if (map_extruder_to_per_extruder_adjustment.size() > 1)
-                        BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: " << sline;
+                        BOOST_LOG_TRIVIAL(error) << "CoolingBuffer encountered an invalid toolchange, maybe from a custom gcode: "
+                                                 << std::string_view(gcode.data() + gline.begin, gline.end - gline.begin - (gcode[gline.end - 1] == '\n'));
                 }
             }
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_START")) {
+        } else if (gline.type == GCodeLayerLine::TYPE_BRIDGE_FAN_START) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_START;
-        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_END")) {
+        } else if (gline.type == GCodeLayerLine::TYPE_BRIDGE_FAN_END) {
             line.type = CoolingLine::TYPE_BRIDGE_FAN_END;
-        } else if (boost::starts_with(sline, "G4 ")) {
-            // Parse the wait time.
-            line.type = CoolingLine::TYPE_G4;
-            size_t pos_S = sline.find('S', 3);
-            size_t pos_P = sline.find('P', 3);
-            bool   has_S = pos_S > 0;
-            bool   has_P = pos_P > 0;
-            if (has_S || has_P) {
-                //auto [pend, ec] = 
-                    fast_float::from_chars(sline.data() + (has_S ? pos_S : pos_P) + 1, sline.data() + sline.size(), line.time);
-                if (has_P)
-                    line.time *= 0.001f;
-            } else
-                line.time = 0;
+        } else if (gline.type == GCodeLayerLine::TYPE_G4) {
+            line.type     = CoolingLine::TYPE_G4;
+            line.time     = gline.time;
             line.time_max = line.time;
-        } else if (boost::contains(sline, ";_SET_FAN_SPEED")) {
-            auto speed_start = sline.find_last_of('D');
-            int  speed       = 0;
-            for (char num : sline.substr(speed_start + 1)) {
-                speed = speed * 10 + (num - '0');
-            }
-            line.type = CoolingLine::TYPE_SET_FAN_SPEED;
-            line.fan_speed = speed;
-        } else if (boost::contains(sline, ";_RESET_FAN_SPEED")) {
+        } else if (gline.type == GCodeLayerLine::TYPE_SET_FAN_SPEED) {
+            line.type      = CoolingLine::TYPE_SET_FAN_SPEED;
+            line.fan_speed = int(gline.param);
+        } else if (gline.type == GCodeLayerLine::TYPE_RESET_FAN_SPEED) {
             line.type = CoolingLine::TYPE_RESET_FAN_SPEED;
         }
 
@@ -2,6 +2,7 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include "GCodeLayerLines.hpp"
 #include <map>
 #include <string>
 
@@ -25,13 +26,16 @@ public:
     CoolingBuffer(GCode &gcodegen);
     void        reset(const Vec3d &position);
     void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
-    std::string process_layer(std::string &&gcode, size_t layer_id, bool flush);
+    // The lines are the tokenized gcode. If they do not match the gcode, the gcode is tokenized here.
+    std::string process_layer(std::string &&gcode, GCodeLayerLines &&lines, size_t layer_id, bool flush);
+    std::string process_layer(std::string &&gcode, size_t layer_id, bool flush)
+        { return this->process_layer(std::move(gcode), GCodeLayerLines(), layer_id, flush); }
     std::string process_layer(const std::string &gcode, size_t layer_id, bool flush)
         { return this->process_layer(std::string(gcode), layer_id, flush); }
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, const GCodeLayerLines &lines, std::vector<float> &current_pos) const;
     float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
@@ -39,6 +43,8 @@ private:
 
     // G-code snippet cached for the support layers preceding an object layer.
     std::string                 m_gcode;
+    // Tokenized m_gcode.
+    GCodeLayerLines             m_lines;
     // Internal data.
     // X,Y,Z,E,F
     std::vector<char>           m_axis;
@@ -51,6 +57,8 @@ private:
     // Highest of m_extruder_ids plus 1.
     unsigned int                m_num_extruders { 0 };
     const std::string           m_toolchange_prefix;
+    // Extrusion axis, zero for gcfNoExtrusion.
+    char                        m_extrusion_axis { 0 };
     // Referencs GCode::m_config, which is FullPrintConfig. While the PrintObjectConfig slice of FullPrintConfig is being modified,
     // the PrintConfig slice of FullPrintConfig is constant, thus no thread synchronization is required.
     const PrintConfig          &m_config;
@@ -227,17 +227,34 @@ class ExtrusionQualityEstimator
     const PrintObject                                                            *current_object;
 
 public:
+    // Data of a single layer, which does not depend on the state of the estimator.
+    // It may thus be calculated for multiple layers in parallel ahead of prepare_for_new_layer().
+    struct LayerData
+    {
+        AABBTreeLines::LinesDistancer<Linef>      boundaries;
+        AABBTreeLines::LinesDistancer<CurledLine> curled_extrusions;
+    };
+
+    static LayerData make_layer_data(const Layer &layer)
+    {
+        return { AABBTreeLines::LinesDistancer<Linef>{ to_unscaled_linesf(layer.lslices) },
+                 AABBTreeLines::LinesDistancer<CurledLine>{ layer.curled_lines } };
+    }
+
     void set_current_object(const PrintObject *object) { current_object = object; }
 
     void prepare_for_new_layer(const Layer *layer)
     {
-        if (layer == nullptr)
-            return;
-        const PrintObject *object      = layer->object();
-        prev_layer_boundaries[object]  = next_layer_boundaries[object];
-        next_layer_boundaries[object]  = AABBTreeLines::LinesDistancer<Linef>{to_unscaled_linesf(layer->lslices)};
-        prev_curled_extrusions[object] = next_curled_extrusions[object];
-        next_curled_extrusions[object] = AABBTreeLines::LinesDistancer<CurledLine>{layer->curled_lines};
+        if (layer != nullptr)
+            this->prepare_for_new_layer(layer->object(), make_layer_data(*layer));
+    }
+
+    void prepare_for_new_layer(const PrintObject *object, LayerData &&layer_data)
+    {
+        prev_layer_boundaries[object]  = std::move(next_layer_boundaries[object]);
+        next_layer_boundaries[object]  = std::move(layer_data.boundaries);
+        prev_curled_extrusions[object] = std::move(next_curled_extrusions[object]);
+        next_curled_extrusions[object] = std::move(layer_data.curled_extrusions);
     }
 
     std::vector<ProcessedPoint> estimate_speed_from_extrusion_quality(
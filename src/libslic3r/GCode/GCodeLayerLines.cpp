@@ -0,0 +1,133 @@
+#include "GCodeLayerLines.hpp"
+
+#include <charconv>
+#include <string_view>
+
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <fast_float/fast_float.h>
+
+namespace Slic3r {
+
+// Parse the axes of a G0 / G1 / G92 line.
+static void parse_move(std::string_view sline, char extrusion_axis, GCodeLayerLine &line)
+{
+    const char *end = sline.data() + sline.size();
+    for (const char *c = sline.data() + 3;;) {
+        // Skip whitespaces.
+        for (; c != end && (*c == ' ' || *c == '\t'); ++ c);
+        if (c == end || *c == ';')
+            break;
+
+        // Parse the axis.
+        size_t axis = (*c >= 'X' && *c <= 'Z') ? size_t(*c - 'X') :
+                      (*c == extrusion_axis) ? size_t(GCodeLayerLine::E) : (*c == 'F') ? size_t(GCodeLayerLine::F) : size_t(-1);
+        ++ c;
+        if (axis != size_t(-1)) {
+            if (axis == GCodeLayerLine::F)
+                line.tags |= GCodeLayerLine::TAG_F_WORD;
+            float v;
+            if (fast_float::from_chars(c, end, v).ec == std::errc())
+                line.set(GCodeLayerLine::Axis(axis), v);
+        }
+        // Skip this word.
+        for (; c != end && *c != ' ' && *c != '\t'; ++ c);
+    }
+    if (boost::contains(sline, ";_EXTERNAL_PERIMETER"))
+        line.tags |= GCodeLayerLine::TAG_EXTERNAL_PERIMETER;
+    if (boost::contains(sline, ";_WIPE"))
+        line.tags |= GCodeLayerLine::TAG_WIPE;
+    if (boost::contains(sline, ";_EXTRUDE_SET_SPEED"))
+        line.tags |= GCodeLayerLine::TAG_EXTRUDE_SET_SPEED;
+}
+
+void GCodeLayerLines::parse(const std::string &gcode, char extrusion_axis, const std::string &toolchange_prefix)
+{
+    m_lines.clear();
+    m_text_length = gcode.size();
+    m_parsed      = true;
+
+    const char *line_start = gcode.c_str();
+    const char *line_end   = line_start;
+    for (; *line_start != 0; line_start = line_end) {
+        while (*line_end != '\n' && *line_end != 0)
+            ++ line_end;
+        // sline will not contain the trailing '\n'.
+        std::string_view sline(line_start, line_end - line_start);
+        // The line span will contain the trailing '\n'.
+        if (*line_end == '\n')
+            ++ line_end;
+        GCodeLayerLine &line = m_lines.emplace_back();
+        line.begin = line_start - gcode.c_str();
+        line.end   = line_end - gcode.c_str();
+
+        if (boost::starts_with(sline, "G0 ")) {
+            line.type = GCodeLayerLine::TYPE_G0;
+            parse_move(sline, extrusion_axis, line);
+        } else if (boost::starts_with(sline, "G1 ")) {
+            line.type = GCodeLayerLine::TYPE_G1;
+            parse_move(sline, extrusion_axis, line);
+        } else if (boost::starts_with(sline, "G92 ")) {
+            line.type = GCodeLayerLine::TYPE_G92;
+            parse_move(sline, extrusion_axis, line);
+        } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
+            line.type = GCodeLayerLine::TYPE_EXTRUDE_END;
+        } else if (! toolchange_prefix.empty() && boost::starts_with(sline, toolchange_prefix)) {
+            line.type = GCodeLayerLine::TYPE_TOOLCHANGE;
+            unsigned int tool = 0;
+            auto res = std::from_chars(sline.data() + toolchange_prefix.size(), sline.data() + sline.size(), tool);
+            line.param = res.ec == std::errc::invalid_argument ? GCodeLayerLine::INVALID_TOOL : uint32_t(tool);
+        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_START")) {
+            line.type = GCodeLayerLine::TYPE_BRIDGE_FAN_START;
+        } else if (boost::starts_with(sline, ";_BRIDGE_FAN_END")) {
+            line.type = GCodeLayerLine::TYPE_BRIDGE_FAN_END;
+        } else if (boost::starts_with(sline, "G4 ")) {
+            // Parse the wait time.
+            line.type = GCodeLayerLine::TYPE_G4;
+            size_t pos_S = sline.find('S', 3);
+            size_t pos_P = sline.find('P', 3);
+            bool   has_S = pos_S != std::string_view::npos;
+            bool   has_P = pos_P != std::string_view::npos;
+            if (has_S || has_P) {
+                fast_float::from_chars(sline.data() + (has_S ? pos_S : pos_P) + 1, sline.data() + sline.size(), line.time);
+                if (! has_S)
+                    // P is in milliseconds.
+                    line.time *= 0.001f;
+            } else
+                line.time = 0;
+        } else if (boost::contains(sline, ";_SET_FAN_SPEED")) {
+            line.type = GCodeLayerLine::TYPE_SET_FAN_SPEED;
+            auto speed_start = sline.find_last_of('D');
+            int  speed       = 0;
+            for (char num : sline.substr(speed_start + 1))
+                speed = speed * 10 + (num - '0');
+            line.param = uint32_t(speed);
+        } else if (boost::contains(sline, ";_RESET_FAN_SPEED")) {
+            line.type = GCodeLayerLine::TYPE_RESET_FAN_SPEED;
+        }
+    }
+}
+
+void GCodeLayerLines::append(const GCodeLayerLines &rhs)
+{
+    assert(rhs.m_parsed);
+    m_lines.reserve(m_lines.size() + rhs.m_lines.size());
+    for (GCodeLayerLine line : rhs.m_lines) {
+        line.begin += m_text_length;
+        line.end   += m_text_length;
+        m_lines.emplace_back(line);
+    }
+    m_text_length += rhs.m_text_length;
+    m_parsed       = true;
+}
+
+void GCodeLayerLines::append(GCodeLayerLine line, size_t length)
+{
+    line.begin = m_text_length;
+    line.end   = m_text_length + length;
+    m_lines.emplace_back(line);
+    m_text_length += length;
+    m_parsed       = true;
+}
+
+} // namespace Slic3r
@@ -0,0 +1,100 @@
+#ifndef slic3r_GCodeLayerLines_hpp_
+#define slic3r_GCodeLayerLines_hpp_
+
+#include "../libslic3r.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Slic3r {
+
+// A single tokenized line of the G-code of a layer. The text of the line is not stored,
+// the line only references its span in the G-code it was parsed from.
+struct GCodeLayerLine
+{
+    enum Type : uint8_t {
+        TYPE_OTHER,
+        TYPE_G0,
+        TYPE_G1,
+        TYPE_G4,
+        TYPE_G92,
+        TYPE_TOOLCHANGE,
+        TYPE_EXTRUDE_END,
+        TYPE_BRIDGE_FAN_START,
+        TYPE_BRIDGE_FAN_END,
+        TYPE_SET_FAN_SPEED,
+        TYPE_RESET_FAN_SPEED,
+    };
+
+    // Markers emitted by GCode into the comments of G0 / G1 / G92 lines for the G-code filters.
+    enum Tag : uint8_t {
+        TAG_EXTRUDE_SET_SPEED  = 1 << 0,
+        TAG_EXTERNAL_PERIMETER = 1 << 1,
+        TAG_WIPE               = 1 << 2,
+        // The F word is present, even if its value could not be parsed.
+        TAG_F_WORD             = 1 << 3,
+    };
+
+    enum Axis : uint8_t { X, Y, Z, E, F, NUM_AXES };
+
+    // Value of TYPE_TOOLCHANGE param if the tool index could not be parsed.
+    static constexpr uint32_t INVALID_TOOL = uint32_t(-1);
+
+    bool  is_move()              const { return type == TYPE_G0 || type == TYPE_G1; }
+    bool  has(Axis axis)         const { return (axes & (1 << axis)) != 0; }
+    bool  has_tag(Tag tag)       const { return (tags & tag) != 0; }
+    float value(Axis axis)       const { return values[axis]; }
+    void  set(Axis axis, float v)      { values[axis] = v; axes |= uint8_t(1 << axis); }
+
+    // Span of this line in the G-code, end includes the trailing '\n' if there is one.
+    size_t   begin  { 0 };
+    size_t   end    { 0 };
+    Type     type   { TYPE_OTHER };
+    uint8_t  tags   { 0 };
+    // Bit mask of the axes parsed from a G0 / G1 / G92 line.
+    uint8_t  axes   { 0 };
+    // X, Y, Z, E as written, F in mm/min.
+    float    values[NUM_AXES];
+    // TYPE_G4: wait time in seconds.
+    float    time   { 0.f };
+    // TYPE_TOOLCHANGE: tool index or INVALID_TOOL, TYPE_SET_FAN_SPEED: fan speed.
+    uint32_t param  { 0 };
+};
+
+// Tokenized G-code of a layer, produced once in the G-code export pipeline right after a layer is generated
+// and shared by the filters that follow (vase mode, cooling buffer), so that they do not need to tokenize
+// the text again. A filter that rewrites the G-code is responsible for updating the lines as well.
+class GCodeLayerLines
+{
+public:
+    using const_iterator = std::vector<GCodeLayerLine>::const_iterator;
+
+    // Tokenize the G-code. extrusion_axis is zero if there is no extrusion axis (gcfNoExtrusion),
+    // toolchange_prefix may be empty if the tool changes are of no interest.
+    void parse(const std::string &gcode, char extrusion_axis, const std::string &toolchange_prefix);
+    // Append lines of G-code appended to the G-code these lines were parsed from.
+    void append(const GCodeLayerLines &rhs);
+    // Append a line for a span of text of the given length, which was appended to the G-code.
+    void append(GCodeLayerLine line, size_t length);
+    void clear() { m_lines.clear(); m_text_length = 0; m_parsed = false; }
+
+    // Do the lines correspond to this G-code? Filters, which were not given the lines, parse the G-code themselves.
+    bool valid_for(const std::string &gcode) const { return m_parsed && m_text_length == gcode.size(); }
+
+    bool                  empty()                const { return m_lines.empty(); }
+    size_t                size()                 const { return m_lines.size(); }
+    const GCodeLayerLine& operator[](size_t idx) const { return m_lines[idx]; }
+    const_iterator        begin()                const { return m_lines.begin(); }
+    const_iterator        end()                  const { return m_lines.end(); }
+
+private:
+    std::vector<GCodeLayerLine> m_lines;
+    // Length of the G-code indexed by m_lines.
+    size_t                      m_text_length { 0 };
+    bool                        m_parsed      { false };
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_GCodeLayerLines_hpp_
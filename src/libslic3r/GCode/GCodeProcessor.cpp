@@ -5,6 +5,7 @@
 #include "libslic3r/format.hpp"
 #include "libslic3r/I18N.hpp"
 #include "libslic3r/GCodeWriter.hpp"
+#include "libslic3r/Trace.hpp"
 #include "libslic3r/I18N.hpp"
 #include "GCodeProcessor.hpp"
 
@@ -540,6 +541,442 @@ bool GCodeProcessor::contains_reserved_tags(const std::string& gcode, unsigned i
     return ret;
 }
 
+static int time_in_minutes(float time_in_seconds)
+{
+    assert(time_in_seconds >= 0.f);
+    return int((time_in_seconds + 0.5f) / 60.0f);
+}
+
+static float time_in_last_minute(float time_in_seconds)
+{
+    assert(time_in_seconds <= 60.0f);
+    return time_in_seconds / 60.0f;
+}
+
+static std::string format_line_M73_main(const std::string& mask, int percent, int time)
+{
+    char line_M73[64];
+    sprintf(line_M73, mask.c_str(),
+        std::to_string(percent).c_str(),
+        std::to_string(time).c_str());
+    return std::string(line_M73);
+}
+
+static std::string format_line_M73_stop_int(const std::string& mask, int time)
+{
+    char line_M73[64];
+    sprintf(line_M73, mask.c_str(), std::to_string(time).c_str());
+    return std::string(line_M73);
+}
+
+static std::string format_time_float(float time)
+{
+    return Slic3r::float_to_string_decimal_point(time, 2);
+}
+
+static std::string format_line_M73_stop_float(const std::string& mask, float time)
+{
+    char line_M73[64];
+    sprintf(line_M73, mask.c_str(), format_time_float(time).c_str());
+    return std::string(line_M73);
+}
+
+// Filament usage per extruder, to replace the values written into the G-code footer by GCode.
+struct UsedFilamentStats
+{
+    std::vector<double> mm;
+    std::vector<double> cm3;
+    std::vector<double> g;
+    std::vector<double> cost;
+    double              total_g    { 0.0 };
+    double              total_cost { 0.0 };
+
+    explicit UsedFilamentStats(const GCodeProcessorResult& result) :
+        mm(result.extruders_count, 0.0), cm3(result.extruders_count, 0.0), g(result.extruders_count, 0.0), cost(result.extruders_count, 0.0)
+    {
+        for (const auto& [id, volume] : result.print_statistics.volumes_per_extruder) {
+            mm[id]   = volume / (static_cast<double>(M_PI) * sqr(0.5 * result.filament_diameters[id]));
+            cm3[id]  = volume * 0.001;
+            g[id]    = cm3[id] * double(result.filament_densities[id]);
+            cost[id] = g[id] * double(result.filament_cost[id]) * 0.001;
+            total_g    += g[id];
+            total_cost += cost[id];
+        }
+    }
+
+    // Tags of the footer lines with the filament usage, in the order of values().
+    static constexpr std::array<std::string_view, 6> tags = {
+        "; filament used [mm] =", "; filament used [g] =", "; total filament used [g] =",
+        "; filament used [cm3] =", "; filament cost =", "; total filament cost ="
+    };
+    // Index into tags of the footer line gcode_line, or -1.
+    static int find_tag(const std::string_view gcode_line) {
+        // Prefilter for parsing speed.
+        if (gcode_line.size() < 8 || gcode_line[0] != ';' || gcode_line[1] != ' ')
+            return -1;
+        if (const char c = gcode_line[2]; c != 'f' && c != 't')
+            return -1;
+        for (size_t i = 0; i < tags.size(); ++i)
+            if (boost::algorithm::starts_with(gcode_line, tags[i]))
+                return int(i);
+        return -1;
+    }
+    std::vector<double> values(int tag_idx) const {
+        switch (tag_idx) {
+        case 0:  return mm;
+        case 1:  return g;
+        case 2:  return { total_g };
+        case 3:  return cm3;
+        case 4:  return cost;
+        default: return { total_cost };
+        }
+    }
+    // Footer line with the tag tags[tag_idx] and its values, including the trailing '\n'.
+    std::string format_line(int tag_idx) const {
+        std::string gcode_line(tags[tag_idx]);
+        const std::vector<double> vals = this->values(tag_idx);
+        char buf[1024];
+        for (size_t i = 0; i < vals.size(); ++i) {
+            sprintf(buf, i == vals.size() - 1 ? " %.2lf\n" : " %.2lf,", vals[i]);
+            gcode_line += buf;
+        }
+        return gcode_line;
+    }
+};
+
+// Helper class to modify and export gcode to file
+class GCodeProcessor::ExportLines
+{
+public:
+    struct Backtrace
+    {
+        float time{ 60.0f };
+        unsigned int steps{ 10 };
+        float time_step() const { return time / float(steps); }
+    };
+
+    enum class EWriteType
+    {
+        BySize,
+        ByTime
+    };
+
+private:
+    struct LineData
+    {
+        std::string line;
+        float time;
+        // Index of the slot reserved by this line, see append_slot().
+        size_t slot{ size_t(-1) };
+    };
+
+#ifndef NDEBUG
+    class Statistics
+    {
+        ExportLines& m_parent;
+        size_t m_max_size{ 0 };
+        size_t m_lines_count{ 0 };
+        size_t m_max_lines_count{ 0 };
+
+    public:
+        explicit Statistics(ExportLines& parent)
+        : m_parent(parent)
+        {}
+
+        void add_line(size_t line_size) {
+            ++m_lines_count;
+            m_max_size = std::max(m_max_size, m_parent.get_size() + line_size);
+            m_max_lines_count = std::max(m_max_lines_count, m_lines_count);
+        }
+
+        void remove_line() { --m_lines_count; }
+        void remove_all_lines() { m_lines_count = 0; }
+    };
+
+    Statistics m_statistics;
+#endif // NDEBUG
+
+    EWriteType m_write_type{ EWriteType::BySize };
+    // Time machine containing g1 times cache
+    TimeMachine& m_machine;
+    // Current time
+    float m_time{ 0.0f };
+    // Current size in bytes
+    size_t m_size{ 0 };
+
+    // gcode lines cache
+    std::deque<LineData> m_lines;
+    size_t m_added_lines_counter{ 0 };
+    // map of gcode line ids from original to final 
+    // used to update m_result.moves[].gcode_id
+    std::vector<std::pair<size_t, size_t>> m_gcode_lines_map;
+
+    size_t m_curr_g1_id{ 0 };
+    size_t m_out_file_pos{ 0 };
+    // file positions of the slots reserved by append_slot()
+    std::vector<size_t> m_slots_file_pos;
+
+public:
+    ExportLines(EWriteType type, TimeMachine& machine)
+#ifndef NDEBUG
+    : m_statistics(*this), m_write_type(type), m_machine(machine) {}
+#else
+    : m_write_type(type), m_machine(machine) {}
+#endif // NDEBUG
+
+    void update(size_t lines_counter, size_t g1_lines_counter) {
+        m_gcode_lines_map.push_back({ lines_counter, 0 });
+
+        if (g1_lines_counter == 0)
+            return;
+
+        auto init_it = m_machine.g1_times_cache.begin() + m_curr_g1_id;
+        auto it = init_it;
+        while (it != m_machine.g1_times_cache.end() && it->id < g1_lines_counter + 1) {
+            ++it;
+            ++m_curr_g1_id;
+        }
+
+        if ((it != m_machine.g1_times_cache.end() && it != init_it) || m_curr_g1_id == 0)
+            m_time = it->elapsed_time;
+    }
+
+    // add the given gcode line to the cache
+    void append_line(const std::string& line) {
+        m_lines.push_back({ line, m_time });
+#ifndef NDEBUG
+        m_statistics.add_line(line.length());
+#endif // NDEBUG
+        m_size += line.length();
+        ++m_added_lines_counter;
+        assert(!m_gcode_lines_map.empty());
+        m_gcode_lines_map.back().second = m_added_lines_counter;
+    }
+
+    // add a line of the given width (not counting the trailing '\n') to the cache, to be overwritten in the file once
+    // its content is known, returns the index of the slot
+    size_t append_slot(size_t width) {
+        append_line(std::string(width, ' ') + "\n");
+        m_lines.back().slot = m_slots_file_pos.size();
+        m_slots_file_pos.emplace_back(0);
+        return m_lines.back().slot;
+    }
+
+    // file position of the slot, valid once the line reserving the slot was written
+    size_t get_slot_file_pos(size_t slot) const { return m_slots_file_pos[slot]; }
+
+    // Insert the gcode lines required by the command cmd by backtracing into the cache
+    void insert_lines(const Backtrace& backtrace, const std::string& cmd, std::function<std::string(unsigned int, float, float)> line_inserter,
+        std::function<std::string(const std::string&)> line_replacer) {
+        assert(!m_lines.empty());
+        const float time_step = backtrace.time_step();
+        size_t rev_it_dist = 0; // distance from the end of the cache of the starting point of the backtrace
+        float last_time_insertion = 0.0f; // used to avoid inserting two lines at the same time
+        for (unsigned int i = 0; i < backtrace.steps; ++i) {
+            const float backtrace_time_i = (i + 1) * time_step;
+            const float time_threshold_i = m_time - backtrace_time_i;
+            auto rev_it = m_lines.rbegin() + rev_it_dist;
+            auto start_rev_it = rev_it;
+
+            std::string curr_cmd = GCodeReader::GCodeLine::extract_cmd(rev_it->line);
+            // backtrace into the cache to find the place where to insert the line
+            while (rev_it != m_lines.rend() && rev_it->time > time_threshold_i && curr_cmd != cmd && curr_cmd != "G28" && curr_cmd != "G29") {
+                rev_it->line = line_replacer(rev_it->line);
+                ++rev_it;
+                curr_cmd = GCodeReader::GCodeLine::extract_cmd(rev_it->line);
+            }
+
+            // we met the previous evenience of cmd, or a G28/G29 command. stop inserting lines
+            if (rev_it != m_lines.rend() && (curr_cmd == cmd || curr_cmd == "G28" || curr_cmd == "G29"))
+                break;
+
+            // insert the line for the current step
+            if (rev_it != m_lines.rend() && rev_it != start_rev_it && rev_it->time != last_time_insertion) {
+                last_time_insertion = rev_it->time;
+                const std::string out_line = line_inserter(i + 1, last_time_insertion, m_time - last_time_insertion);
+                rev_it_dist = std::distance(m_lines.rbegin(), rev_it) + 1;
+                m_lines.insert(rev_it.base(), { out_line, rev_it->time });
+#ifndef NDEBUG
+                m_statistics.add_line(out_line.length());
+#endif // NDEBUG
+                m_size += out_line.length();
+                // synchronize gcode lines map
+                for (auto map_it = m_gcode_lines_map.rbegin(); map_it != m_gcode_lines_map.rbegin() + rev_it_dist - 1; ++map_it) {
+                    ++map_it->second;
+                }
+
+                ++m_added_lines_counter;
+            }
+        }
+    }
+
+    // Insert the M104 lines preheating the tool selected by the T line gcode_line by backtracing into the cache
+    void insert_lines_T(GCodeProcessor& processor, const std::string& gcode_line, const Backtrace& backtrace);
+
+    // write to file:
+    // m_write_type == EWriteType::ByTime - all lines older than m_time - backtrace_time
+    // m_write_type == EWriteType::BySize - all lines if current size is greater than 65535 bytes
+    void write(FilePtr& out, float backtrace_time, GCodeProcessorResult& result, const std::string& out_path) {
+        if (m_lines.empty())
+            return;
+
+        // collect lines to write into a single string
+        std::string out_string;
+        if (!m_lines.empty()) {
+            if (m_write_type == EWriteType::ByTime) {
+                while (m_lines.front().time < m_time - backtrace_time) {
+                    const LineData& data = m_lines.front();
+                    record_slot(data, out_string);
+                    out_string += data.line;
+                    m_size -= data.line.length();
+                    m_lines.pop_front();
+#ifndef NDEBUG
+                    m_statistics.remove_line();
+#endif // NDEBUG
+                }
+            }
+            else {
+                if (m_size > 65535) {
+                    while (!m_lines.empty()) {
+                        record_slot(m_lines.front(), out_string);
+                        out_string += m_lines.front().line;
+                        m_lines.pop_front();
+                    }
+                    m_size = 0;
+#ifndef NDEBUG
+                    m_statistics.remove_all_lines();
+#endif // NDEBUG
+                }
+            }
+        }
+
+        write_to_file(out, out_string, result, out_path);
+    }
+
+    // flush the current content of the cache to file
+    void flush(FilePtr& out, GCodeProcessorResult& result, const std::string& out_path) {
+        // collect lines to flush into a single string
+        std::string out_string;
+        while (!m_lines.empty()) {
+            record_slot(m_lines.front(), out_string);
+            out_string += m_lines.front().line;
+            m_lines.pop_front();
+        }
+        m_size = 0;
+#ifndef NDEBUG
+        m_statistics.remove_all_lines();
+#endif // NDEBUG
+
+        write_to_file(out, out_string, result, out_path);
+    }
+
+    void synchronize_moves(GCodeProcessorResult& result) const {
+        auto it = m_gcode_lines_map.begin();
+        for (GCodeProcessorResult::MoveVertex& move : result.moves) {
+            while (it != m_gcode_lines_map.end() && it->first < move.gcode_id) {
+                ++it;
+            }
+            if (it != m_gcode_lines_map.end() && it->first == move.gcode_id)
+                move.gcode_id = it->second;
+        }
+    }
+
+    size_t get_size() const { return m_size; }
+
+private:
+    // the line data is going to be appended to out_string, which will be written at m_out_file_pos
+    void record_slot(const LineData& data, const std::string& out_string) {
+        if (data.slot != size_t(-1))
+            m_slots_file_pos[data.slot] = m_out_file_pos + out_string.size();
+    }
+
+    void write_to_file(FilePtr& out, const std::string& out_string, GCodeProcessorResult& result, const std::string& out_path) {
+        if (!out_string.empty()) {
+            fwrite((const void*)out_string.c_str(), 1, out_string.length(), out.f);
+            if (ferror(out.f)) {
+                out.close();
+                boost::nowide::remove(out_path.c_str());
+                throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nIs the disk full?\n"));
+            }
+            for (size_t i = 0; i < out_string.size(); ++i) {
+                if (out_string[i] == '\n')
+                    result.lines_ends.emplace_back(m_out_file_pos + i + 1);
+            }
+            m_out_file_pos += out_string.size();
+        }
+    }
+};
+
+// Exports the final G-code while it is being processed, thus the G-code is written once and it is not rewritten by post_process().
+// A line is exported as soon as the time machines calculated the time of the moves up to that line, so that only a short tail
+// of the G-code is held in memory. The values known only at the end of the print (progress and remaining times, print time
+// and used filament statistics) are written into slots of a reserved width, which are overwritten in place by finish().
+// Unlike post_process(), which emits an M73 line whenever the exported values change, the M73 lines are reserved
+// every M73_Interval seconds of the print time.
+class GCodeProcessor::SinglePassExport
+{
+public:
+    // Print time between two reserved M73 lines, in seconds.
+    static constexpr float M73_Interval = 30.0f;
+
+    explicit SinglePassExport(GCodeProcessor& processor) :
+        m_processor(processor), m_out{ boost::nowide::fopen(processor.m_result.filename.c_str(), "wb") } {}
+
+    bool is_open() const { return m_out.f != nullptr; }
+
+    // Split the buffer into lines and export those lines, for which the times are known already.
+    void process_buffer(const std::string& buffer);
+    // Export the remaining lines, fill in the slots and close the file. To be called after the time machines finished.
+    void finish();
+    // Write the remaining lines as they are and close the file, after the G-code export failed.
+    void abort();
+
+private:
+    struct PendingLine
+    {
+        std::string line;
+        // Number of G1 lines preceding this line.
+        size_t g1_lines_counter;
+        bool is_G1;
+    };
+
+    struct Slot
+    {
+        size_t id;
+        size_t width;
+        // Produces the content of the slot once the G-code was processed.
+        std::function<std::string()> content;
+    };
+
+    void start();
+    bool times_known(size_t g1_lines_counter) const;
+    void export_pending_lines(bool all);
+    void export_line(const std::string& gcode_line, size_t g1_lines_counter, bool is_G1);
+    bool process_placeholders(const std::string& gcode_line);
+    void process_line_G1(size_t g1_lines_counter);
+    void append_slot(size_t width, std::function<std::string()> content);
+    void fill_slots();
+    [[noreturn]] void throw_error(const std::string& error);
+
+    GCodeProcessor&              m_processor;
+    FilePtr                      m_out;
+    // Created by the first process_buffer(), when the processor is already configured.
+    std::unique_ptr<ExportLines> m_export_lines;
+    // Incomplete line at the end of the last buffer.
+    std::string                  m_line;
+    // Lines waiting for the time machines to calculate their times.
+    std::deque<PendingLine>      m_pending;
+    size_t                       m_g1_lines_counter{ 0 };
+    size_t                       m_line_id{ 0 };
+    // In case there are multiple sources of backtracing, keeps track of the longest backtrack time needed
+    // to flush the backtrace cache accordingly.
+    float                        m_max_backtrace_time{ 120.0f };
+    // Index of the g1_times_cache item recently processed by process_line_G1() and the print time of the next M73 slot, per time machine.
+    std::array<size_t, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)> m_g1_times_cache_idx;
+    std::array<float, static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count)>  m_next_M73_time;
+    std::vector<Slot>            m_slots;
+};
+
 GCodeProcessor::GCodeProcessor()
 : m_options_z_corrector(m_result)
 {
@@ -550,6 +987,8 @@ GCodeProcessor::GCodeProcessor()
     m_time_processor.machines[static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Stealth)].line_m73_stop_mask = "M73 D%s\n";
 }
 
+GCodeProcessor::~GCodeProcessor() = default;
+
 void GCodeProcessor::apply_config(const PrintConfig& config)
 {
     m_parser.apply_config(config);
@@ -1024,6 +1463,7 @@ static inline const char* remove_eols(const char *begin, const char *end) {
 // throws CanceledException through print->throw_if_canceled() (sent by the caller as callback).
 void GCodeProcessor::process_file(const std::string& filename, std::function<void()> cancel_callback)
 {
+    SLIC3R_TRACE_ZONE("GCodeProcessor::process_file");
     CNumericLocalesSetter locales_setter;
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
@@ -1076,7 +1516,8 @@ void GCodeProcessor::process_file(const std::string& filename, std::function<voi
     m_result.id = ++s_result_id;
     initialize_result_moves();
     size_t parse_line_callback_cntr = 10000;
-    m_parser.parse_file(filename, [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
+    // The file is tokenized in parallel, the lines are processed sequentially in their order.
+    m_parser.parse_file_parallel(filename, [this, cancel_callback, &parse_line_callback_cntr](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (-- parse_line_callback_cntr == 0) {
             // Don't call the cancel_callback() too often, do it every at every 10000'th line.
             parse_line_callback_cntr = 10000;
@@ -1101,6 +1542,26 @@ void GCodeProcessor::initialize(const std::string& filename)
     // process gcode
     m_result.filename = filename;
     m_result.id = ++s_result_id;
+    m_single_pass_export.reset();
+}
+
+bool GCodeProcessor::enable_single_pass_export()
+{
+    m_single_pass_export_truncated = 0;
+    m_single_pass_export = std::make_unique<SinglePassExport>(*this);
+    if (!m_single_pass_export->is_open()) {
+        m_single_pass_export.reset();
+        return false;
+    }
+    return true;
+}
+
+void GCodeProcessor::abort_single_pass_export()
+{
+    if (m_single_pass_export) {
+        m_single_pass_export->abort();
+        m_single_pass_export.reset();
+    }
 }
 
 void GCodeProcessor::process_buffer(const std::string &buffer)
@@ -1109,10 +1570,13 @@ void GCodeProcessor::process_buffer(const std::string &buffer)
     m_parser.parse_buffer(buffer, [this](GCodeReader&, const GCodeReader::GCodeLine& line) { 
         this->process_gcode_line(line, false);
     });
+    if (m_single_pass_export)
+        m_single_pass_export->process_buffer(buffer);
 }
 
 void GCodeProcessor::finalize(bool perform_post_process)
 {
+    SLIC3R_TRACE_ZONE("GCodeProcessor::finalize");
     // update width/height of wipe moves
     for (GCodeProcessorResult::MoveVertex& move : m_result.moves) {
         if (move.type == EMoveType::Wipe) {
@@ -1141,7 +1605,12 @@ void GCodeProcessor::finalize(bool perform_post_process)
     m_width_compare.output();
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
 
-    if (perform_post_process)
+    if (m_single_pass_export) {
+        // The G-code was written while being processed, fill in the final values.
+        m_single_pass_export->finish();
+        m_single_pass_export.reset();
+    }
+    else if (perform_post_process)
         post_process();
 #if ENABLE_GCODE_VIEWER_STATISTICS
     m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_start_time).count();
@@ -3426,6 +3895,53 @@ void GCodeProcessor::process_T(const std::string_view command)
     }
 }
 
+// add lines XXX to exported gcode
+void GCodeProcessor::ExportLines::insert_lines_T(GCodeProcessor& processor, const std::string& gcode_line, const Backtrace& backtrace)
+{
+    const std::string cmd = GCodeReader::GCodeLine::extract_cmd(gcode_line);
+    if (cmd.size() >= 2) {
+        std::stringstream ss(cmd.substr(1));
+        int tool_number = -1;
+        ss >> tool_number;
+        if (tool_number != -1) {
+            if (tool_number < 0 || (int)processor.m_extruder_temps_config.size() <= tool_number) {
+                // found an invalid value, clamp it to a valid one
+                tool_number = std::clamp<int>(0, processor.m_extruder_temps_config.size() - 1, tool_number);
+                // emit warning
+                std::string warning = _u8L("GCode Post-Processor encountered an invalid toolchange, maybe from a custom gcode:");
+                warning += "\n> ";
+                warning += gcode_line;
+                warning += _u8L("Generated M104 lines may be incorrect.");
+                BOOST_LOG_TRIVIAL(error) << warning;
+                if (processor.m_print != nullptr)
+                    processor.m_print->active_step_add_warning(PrintStateBase::WarningLevel::CRITICAL, warning);
+            }
+        }
+        insert_lines(backtrace, cmd,
+            // line inserter
+            [tool_number, &processor](unsigned int id, float time, float time_diff) {
+                int temperature = int( processor.m_layer_id != 1 ? processor.m_extruder_temps_config[tool_number] : processor.m_extruder_temps_first_layer_config[tool_number]);
+                const std::string out = "M104 T" + std::to_string(tool_number) + " P" + std::to_string(int(std::round(time_diff))) + " S" + std::to_string(temperature) + "\n";
+                return out;
+            },
+            // line replacer
+            [&processor, tool_number](const std::string& line) {
+                if (GCodeReader::GCodeLine::cmd_is(line, "M104")) {
+                    GCodeReader::GCodeLine gline;
+                    GCodeReader reader;
+                    reader.parse_line(line, [&gline](GCodeReader& reader, const GCodeReader::GCodeLine& l) { gline = l; });
+
+                    float val;
+                    if (gline.has_value('T', val) && gline.raw().find("cooldown") != std::string::npos && processor.m_is_XL_printer) {
+                        if (static_cast<int>(val) == tool_number)
+                            return std::string("; removed M104\n");
+                    }
+                }
+                return line;
+            });
+    }
+}
+
 void GCodeProcessor::post_process()
 {
     FilePtr in{ boost::nowide::fopen(m_result.filename.c_str(), "rb") };
@@ -3439,40 +3955,6 @@ void GCodeProcessor::post_process()
         throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nCannot open file for writing.\n"));
     }
 
-    auto time_in_minutes = [](float time_in_seconds) {
-        assert(time_in_seconds >= 0.f);
-        return int((time_in_seconds + 0.5f) / 60.0f);
-    };
-
-    auto time_in_last_minute = [](float time_in_seconds) {
-        assert(time_in_seconds <= 60.0f);
-        return time_in_seconds / 60.0f;
-    };
-
-    auto format_line_M73_main = [](const std::string& mask, int percent, int time) {
-        char line_M73[64];
-        sprintf(line_M73, mask.c_str(),
-            std::to_string(percent).c_str(),
-            std::to_string(time).c_str());
-        return std::string(line_M73);
-    };
-
-    auto format_line_M73_stop_int = [](const std::string& mask, int time) {
-        char line_M73[64];
-        sprintf(line_M73, mask.c_str(), std::to_string(time).c_str());
-        return std::string(line_M73);
-    };
-
-    auto format_time_float = [](float time) {
-        return Slic3r::float_to_string_decimal_point(time, 2);
-    };
-
-    auto format_line_M73_stop_float = [format_time_float](const std::string& mask, float time) {
-        char line_M73[64];
-        sprintf(line_M73, mask.c_str(), format_time_float(time).c_str());
-        return std::string(line_M73);
-    };
-
     std::string gcode_line;
     size_t g1_lines_counter = 0;
     // keeps track of last exported pair <percent, remaining time>
@@ -3487,241 +3969,6 @@ void GCodeProcessor::post_process()
         last_exported_stop[i] = time_in_minutes(m_time_processor.machines[i].time);
     }
 
-    // Helper class to modify and export gcode to file
-    class ExportLines
-    {
-    public:
-        struct Backtrace
-        {
-            float time{ 60.0f };
-            unsigned int steps{ 10 };
-            float time_step() const { return time / float(steps); }
-        };
-
-        enum class EWriteType
-        {
-            BySize,
-            ByTime
-        };
-
-    private:
-        struct LineData
-        {
-            std::string line;
-            float time;
-        };
-
-#ifndef NDEBUG
-        class Statistics
-        {
-            ExportLines& m_parent;
-            size_t m_max_size{ 0 };
-            size_t m_lines_count{ 0 };
-            size_t m_max_lines_count{ 0 };
-
-        public:
-            explicit Statistics(ExportLines& parent)
-            : m_parent(parent)
-            {}
-
-            void add_line(size_t line_size) {
-                ++m_lines_count;
-                m_max_size = std::max(m_max_size, m_parent.get_size() + line_size);
-                m_max_lines_count = std::max(m_max_lines_count, m_lines_count);
-            }
-
-            void remove_line() { --m_lines_count; }
-            void remove_all_lines() { m_lines_count = 0; }
-        };
-
-        Statistics m_statistics;
-#endif // NDEBUG
-
-        EWriteType m_write_type{ EWriteType::BySize };
-        // Time machine containing g1 times cache
-        TimeMachine& m_machine;
-        // Current time
-        float m_time{ 0.0f };
-        // Current size in bytes
-        size_t m_size{ 0 };
-
-        // gcode lines cache
-        std::deque<LineData> m_lines;
-        size_t m_added_lines_counter{ 0 };
-        // map of gcode line ids from original to final 
-        // used to update m_result.moves[].gcode_id
-        std::vector<std::pair<size_t, size_t>> m_gcode_lines_map;
-
-        size_t m_curr_g1_id{ 0 };
-        size_t m_out_file_pos{ 0 };
-
-    public:
-        ExportLines(EWriteType type, TimeMachine& machine)
-#ifndef NDEBUG
-        : m_statistics(*this), m_write_type(type), m_machine(machine) {}
-#else
-        : m_write_type(type), m_machine(machine) {}
-#endif // NDEBUG
-
-        void update(size_t lines_counter, size_t g1_lines_counter) {
-            m_gcode_lines_map.push_back({ lines_counter, 0 });
-
-            if (g1_lines_counter == 0)
-                return;
-
-            auto init_it = m_machine.g1_times_cache.begin() + m_curr_g1_id;
-            auto it = init_it;
-            while (it != m_machine.g1_times_cache.end() && it->id < g1_lines_counter + 1) {
-                ++it;
-                ++m_curr_g1_id;
-            }
-
-            if ((it != m_machine.g1_times_cache.end() && it != init_it) || m_curr_g1_id == 0)
-                m_time = it->elapsed_time;
-        }
-
-        // add the given gcode line to the cache
-        void append_line(const std::string& line) {
-            m_lines.push_back({ line, m_time });
-#ifndef NDEBUG
-            m_statistics.add_line(line.length());
-#endif // NDEBUG
-            m_size += line.length();
-            ++m_added_lines_counter;
-            assert(!m_gcode_lines_map.empty());
-            m_gcode_lines_map.back().second = m_added_lines_counter;
-        }
-
-        // Insert the gcode lines required by the command cmd by backtracing into the cache
-        void insert_lines(const Backtrace& backtrace, const std::string& cmd, std::function<std::string(unsigned int, float, float)> line_inserter,
-            std::function<std::string(const std::string&)> line_replacer) {
-            assert(!m_lines.empty());
-            const float time_step = backtrace.time_step();
-            size_t rev_it_dist = 0; // distance from the end of the cache of the starting point of the backtrace
-            float last_time_insertion = 0.0f; // used to avoid inserting two lines at the same time
-            for (unsigned int i = 0; i < backtrace.steps; ++i) {
-                const float backtrace_time_i = (i + 1) * time_step;
-                const float time_threshold_i = m_time - backtrace_time_i;
-                auto rev_it = m_lines.rbegin() + rev_it_dist;
-                auto start_rev_it = rev_it;
-
-                std::string curr_cmd = GCodeReader::GCodeLine::extract_cmd(rev_it->line);
-                // backtrace into the cache to find the place where to insert the line
-                while (rev_it != m_lines.rend() && rev_it->time > time_threshold_i && curr_cmd != cmd && curr_cmd != "G28" && curr_cmd != "G29") {
-                    rev_it->line = line_replacer(rev_it->line);
-                    ++rev_it;
-                    curr_cmd = GCodeReader::GCodeLine::extract_cmd(rev_it->line);
-                }
-
-                // we met the previous evenience of cmd, or a G28/G29 command. stop inserting lines
-                if (rev_it != m_lines.rend() && (curr_cmd == cmd || curr_cmd == "G28" || curr_cmd == "G29"))
-                    break;
-
-                // insert the line for the current step
-                if (rev_it != m_lines.rend() && rev_it != start_rev_it && rev_it->time != last_time_insertion) {
-                    last_time_insertion = rev_it->time;
-                    const std::string out_line = line_inserter(i + 1, last_time_insertion, m_time - last_time_insertion);
-                    rev_it_dist = std::distance(m_lines.rbegin(), rev_it) + 1;
-                    m_lines.insert(rev_it.base(), { out_line, rev_it->time });
-#ifndef NDEBUG
-                    m_statistics.add_line(out_line.length());
-#endif // NDEBUG
-                    m_size += out_line.length();
-                    // synchronize gcode lines map
-                    for (auto map_it = m_gcode_lines_map.rbegin(); map_it != m_gcode_lines_map.rbegin() + rev_it_dist - 1; ++map_it) {
-                        ++map_it->second;
-                    }
-
-                    ++m_added_lines_counter;
-                }
-            }
-        }
-
-        // write to file:
-        // m_write_type == EWriteType::ByTime - all lines older than m_time - backtrace_time
-        // m_write_type == EWriteType::BySize - all lines if current size is greater than 65535 bytes
-        void write(FilePtr& out, float backtrace_time, GCodeProcessorResult& result, const std::string& out_path) {
-            if (m_lines.empty())
-                return;
-
-            // collect lines to write into a single string
-            std::string out_string;
-            if (!m_lines.empty()) {
-                if (m_write_type == EWriteType::ByTime) {
-                    while (m_lines.front().time < m_time - backtrace_time) {
-                        const LineData& data = m_lines.front();
-                        out_string += data.line;
-                        m_size -= data.line.length();
-                        m_lines.pop_front();
-#ifndef NDEBUG
-                        m_statistics.remove_line();
-#endif // NDEBUG
-                    }
-                }
-                else {
-                    if (m_size > 65535) {
-                        while (!m_lines.empty()) {
-                            out_string += m_lines.front().line;
-                            m_lines.pop_front();
-                        }
-                        m_size = 0;
-#ifndef NDEBUG
-                        m_statistics.remove_all_lines();
-#endif // NDEBUG
-                    }
-                }
-            }
-
-            write_to_file(out, out_string, result, out_path);
-        }
-
-        // flush the current content of the cache to file
-        void flush(FilePtr& out, GCodeProcessorResult& result, const std::string& out_path) {
-            // collect lines to flush into a single string
-            std::string out_string;
-            while (!m_lines.empty()) {
-                out_string += m_lines.front().line;
-                m_lines.pop_front();
-            }
-            m_size = 0;
-#ifndef NDEBUG
-            m_statistics.remove_all_lines();
-#endif // NDEBUG
-
-            write_to_file(out, out_string, result, out_path);
-        }
-
-        void synchronize_moves(GCodeProcessorResult& result) const {
-            auto it = m_gcode_lines_map.begin();
-            for (GCodeProcessorResult::MoveVertex& move : result.moves) {
-                while (it != m_gcode_lines_map.end() && it->first < move.gcode_id) {
-                    ++it;
-                }
-                if (it != m_gcode_lines_map.end() && it->first == move.gcode_id)
-                    move.gcode_id = it->second;
-            }
-        }
-
-        size_t get_size() const { return m_size; }
-
-    private:
-        void write_to_file(FilePtr& out, const std::string& out_string, GCodeProcessorResult& result, const std::string& out_path) {
-            if (!out_string.empty()) {
-                fwrite((const void*)out_string.c_str(), 1, out_string.length(), out.f);
-                if (ferror(out.f)) {
-                    out.close();
-                    boost::nowide::remove(out_path.c_str());
-                    throw Slic3r::RuntimeError(std::string("GCode processor post process export failed.\nIs the disk full?\n"));
-                }
-                for (size_t i = 0; i < out_string.size(); ++i) {
-                    if (out_string[i] == '\n')
-                        result.lines_ends.emplace_back(m_out_file_pos + i + 1);
-                }
-                m_out_file_pos += out_string.size();
-            }
-        }
-    };
-
     ExportLines export_lines(m_result.backtrace_enabled ? ExportLines::EWriteType::ByTime : ExportLines::EWriteType::BySize, m_time_processor.machines[0]);
 
     // replace placeholder lines with the proper final value
@@ -3785,50 +4032,14 @@ void GCodeProcessor::post_process()
         return processed;
     };
 
-    std::vector<double> filament_mm(m_result.extruders_count, 0.0);
-    std::vector<double> filament_cm3(m_result.extruders_count, 0.0);
-    std::vector<double> filament_g(m_result.extruders_count, 0.0);
-    std::vector<double> filament_cost(m_result.extruders_count, 0.0);
+    const UsedFilamentStats used_filament_stats(m_result);
 
-    double filament_total_g    = 0.0;
-    double filament_total_cost = 0.0;
-
-    for (const auto& [id, volume] : m_result.print_statistics.volumes_per_extruder) {
-        filament_mm[id]   = volume / (static_cast<double>(M_PI) * sqr(0.5 * m_result.filament_diameters[id]));
-        filament_cm3[id]  = volume * 0.001;
-        filament_g[id]    = filament_cm3[id] * double(m_result.filament_densities[id]);
-        filament_cost[id] = filament_g[id] * double(m_result.filament_cost[id]) * 0.001;
-        filament_total_g    += filament_g[id];
-        filament_total_cost += filament_cost[id];
-    }
-
-    auto process_used_filament = [&](std::string& gcode_line) {
-        // Prefilter for parsing speed.
-        if (gcode_line.size() < 8 || gcode_line[0] != ';' || gcode_line[1] != ' ')
-            return false;
-        if (const char c = gcode_line[2]; c != 'f' && c != 't')
-            return false;
-        auto process_tag = [](std::string& gcode_line, const std::string_view tag, const std::vector<double>& values) {
-            if (boost::algorithm::starts_with(gcode_line, tag)) {
-                gcode_line = tag;
-                char buf[1024];
-                for (size_t i = 0; i < values.size(); ++i) {
-                    sprintf(buf, i == values.size() - 1 ? " %.2lf\n" : " %.2lf,", values[i]);
-                    gcode_line += buf;
-                }
-                return true;
-            }
+    auto process_used_filament = [&used_filament_stats](std::string& gcode_line) {
+        const int tag_idx = UsedFilamentStats::find_tag(gcode_line);
+        if (tag_idx == -1)
             return false;
-        };
-
-        bool ret = false;
-        ret |= process_tag(gcode_line, "; filament used [mm] =", filament_mm);
-        ret |= process_tag(gcode_line, "; filament used [g] =", filament_g);
-        ret |= process_tag(gcode_line, "; total filament used [g] =", { filament_total_g });
-        ret |= process_tag(gcode_line, "; filament used [cm3] =", filament_cm3);
-        ret |= process_tag(gcode_line, "; filament cost =", filament_cost);
-        ret |= process_tag(gcode_line, "; total filament cost =", { filament_total_cost });
-        return ret;
+        gcode_line = used_filament_stats.format_line(tag_idx);
+        return true;
     };
 
     // check for temporary lines
@@ -3852,8 +4063,6 @@ void GCodeProcessor::post_process()
 
     // add lines M73 to exported gcode
     auto process_line_G1 = [this,
-        // Lambdas, mostly for string formatting, all with an empty capture block.
-        time_in_minutes, format_time_float, format_line_M73_main, format_line_M73_stop_int, format_line_M73_stop_float, time_in_last_minute,
         // Caches, to be modified
         &g1_times_cache_it, &last_exported_main, &last_exported_stop,
         &export_lines]
@@ -3919,52 +4128,6 @@ void GCodeProcessor::post_process()
         }
     };
 
-    // add lines XXX to exported gcode
-    auto process_line_T = [this, &export_lines](const std::string& gcode_line, const size_t g1_lines_counter, const ExportLines::Backtrace& backtrace) {
-        const std::string cmd = GCodeReader::GCodeLine::extract_cmd(gcode_line);
-        if (cmd.size() >= 2) {
-            std::stringstream ss(cmd.substr(1));
-            int tool_number = -1;
-            ss >> tool_number;
-            if (tool_number != -1) {
-                if (tool_number < 0 || (int)m_extruder_temps_config.size() <= tool_number) {
-                    // found an invalid value, clamp it to a valid one
-                    tool_number = std::clamp<int>(0, m_extruder_temps_config.size() - 1, tool_number);
-                    // emit warning
-                    std::string warning = _u8L("GCode Post-Processor encountered an invalid toolchange, maybe from a custom gcode:");
-                    warning += "\n> ";
-                    warning += gcode_line;
-                    warning += _u8L("Generated M104 lines may be incorrect.");
-                    BOOST_LOG_TRIVIAL(error) << warning;
-                    if (m_print != nullptr)
-                        m_print->active_step_add_warning(PrintStateBase::WarningLevel::CRITICAL, warning);
-                }
-            }
-            export_lines.insert_lines(backtrace, cmd,
-                // line inserter
-                [tool_number, this](unsigned int id, float time, float time_diff) {
-                    int temperature = int( m_layer_id != 1 ? m_extruder_temps_config[tool_number] : m_extruder_temps_first_layer_config[tool_number]);
-                    const std::string out = "M104 T" + std::to_string(tool_number) + " P" + std::to_string(int(std::round(time_diff))) + " S" + std::to_string(temperature) + "\n";
-                    return out;
-                },
-                // line replacer
-                [this, tool_number](const std::string& line) {
-                    if (GCodeReader::GCodeLine::cmd_is(line, "M104")) {
-                        GCodeReader::GCodeLine gline;
-                        GCodeReader reader;
-                        reader.parse_line(line, [&gline](GCodeReader& reader, const GCodeReader::GCodeLine& l) { gline = l; });
-
-                        float val;
-                        if (gline.has_value('T', val) && gline.raw().find("cooldown") != std::string::npos && m_is_XL_printer) {
-                            if (static_cast<int>(val) == tool_number)
-                                return std::string("; removed M104\n");
-                        }
-                    }
-                    return line;
-                });
-        }
-    };
-
     m_result.lines_ends.clear();
 
     unsigned int line_id = 0;
@@ -4011,7 +4174,7 @@ void GCodeProcessor::post_process()
                             process_line_G1(g1_lines_counter++);
                         else if (m_result.backtrace_enabled && GCodeReader::GCodeLine::cmd_starts_with(gcode_line, "T")) {
                             // add lines XXX where needed
-                            process_line_T(gcode_line, g1_lines_counter, backtrace_T);
+                            export_lines.insert_lines_T(*this, gcode_line, backtrace_T);
                             max_backtrace_time = std::max(max_backtrace_time, backtrace_T.time);
                         }
                     }
@@ -4045,6 +4208,269 @@ void GCodeProcessor::post_process()
             "Is " + out_path + " locked?" + '\n');
 }
 
+static int fseek_to(FILE* f, size_t pos)
+{
+#ifdef _WIN32
+    return ::_fseeki64(f, int64_t(pos), SEEK_SET);
+#else
+    return ::fseeko(f, off_t(pos), SEEK_SET);
+#endif
+}
+
+void GCodeProcessor::SinglePassExport::start()
+{
+    m_export_lines = std::make_unique<ExportLines>(m_processor.m_result.backtrace_enabled ? ExportLines::EWriteType::ByTime : ExportLines::EWriteType::BySize,
+        m_processor.m_time_processor.machines[0]);
+    m_processor.m_result.lines_ends.clear();
+    m_g1_times_cache_idx.fill(0);
+    m_next_M73_time.fill(M73_Interval);
+}
+
+void GCodeProcessor::SinglePassExport::process_buffer(const std::string& buffer)
+{
+    if (m_export_lines == nullptr)
+        this->start();
+
+    // Extract lines the same way post_process() does, a line may continue in the next buffer.
+    auto it = buffer.begin();
+    auto it_bufend = buffer.end();
+    while (it != it_bufend) {
+        // Find end of line.
+        bool eol = false;
+        auto it_end = it;
+        for (; it_end != it_bufend && !(eol = *it_end == '\r' || *it_end == '\n'); ++it_end);
+        m_line.insert(m_line.end(), it, it_end);
+        if (eol) {
+            m_line += "\n";
+            const bool is_G1 = GCodeReader::GCodeLine::cmd_is(m_line, "G1");
+            m_pending.push_back({ std::move(m_line), m_g1_lines_counter, is_G1 });
+            if (is_G1)
+                ++m_g1_lines_counter;
+            m_line.clear();
+        }
+        // Skip EOL.
+        it = it_end;
+        if (it != it_bufend && *it == '\r')
+            ++it;
+        if (it != it_bufend && *it == '\n')
+            ++it;
+    }
+
+    this->export_pending_lines(false);
+}
+
+void GCodeProcessor::SinglePassExport::finish()
+{
+    if (m_export_lines == nullptr)
+        this->start();
+    if (!m_line.empty())
+        this->process_buffer("\n");
+
+    this->export_pending_lines(true);
+    GCodeProcessorResult& result = m_processor.m_result;
+    m_export_lines->flush(m_out, result, result.filename);
+    this->fill_slots();
+    if (::fflush(m_out.f) != 0)
+        this->throw_error("Is the disk full?");
+    m_out.close();
+
+    m_export_lines->synchronize_moves(result);
+}
+
+void GCodeProcessor::SinglePassExport::abort()
+{
+    if (m_out.f == nullptr)
+        return;
+    if (m_export_lines != nullptr) {
+        std::string out_string;
+        for (const PendingLine& pending : m_pending)
+            out_string += pending.line;
+        out_string += m_line;
+        try {
+            m_export_lines->flush(m_out, m_processor.m_result, m_processor.m_result.filename);
+            ::fwrite(out_string.data(), 1, out_string.size(), m_out.f);
+        } catch (...) {
+        }
+    }
+    m_out.close();
+}
+
+// The times of a line are known once the time machines processed a move following the line.
+bool GCodeProcessor::SinglePassExport::times_known(size_t g1_lines_counter) const
+{
+    for (const TimeMachine& machine : m_processor.m_time_processor.machines)
+        if (machine.enabled && (machine.g1_times_cache.empty() || machine.g1_times_cache.back().id <= g1_lines_counter))
+            return false;
+    return true;
+}
+
+void GCodeProcessor::SinglePassExport::export_pending_lines(bool all)
+{
+    while (!m_pending.empty() && (all || this->times_known(m_pending.front().g1_lines_counter))) {
+        const PendingLine& pending = m_pending.front();
+        this->export_line(pending.line, pending.g1_lines_counter, pending.is_G1);
+        m_pending.pop_front();
+    }
+}
+
+void GCodeProcessor::SinglePassExport::export_line(const std::string& gcode_line, size_t g1_lines_counter, bool is_G1)
+{
+    // Backtrace data for Tx gcode lines
+    static const ExportLines::Backtrace backtrace_T = { 120.0f, 10 };
+
+    ExportLines& export_lines = *m_export_lines;
+    export_lines.update(++m_line_id, g1_lines_counter);
+
+    if (!this->process_placeholders(gcode_line)) {
+        if (const int tag_idx = UsedFilamentStats::find_tag(gcode_line); tag_idx != -1) {
+            // All the tool changes were processed before the statistics at the end of the G-code.
+            const size_t num_values = (tag_idx == 2 || tag_idx == 5) ? 1 : std::max<size_t>(m_processor.m_result.extruders_count, 1);
+            this->append_slot(UsedFilamentStats::tags[tag_idx].size() + 16 * num_values, [this, tag_idx]() {
+                return UsedFilamentStats(m_processor.m_result).format_line(tag_idx);
+            });
+        }
+        else {
+            if (is_G1)
+                // reserve lines M73
+                this->process_line_G1(g1_lines_counter);
+            else if (m_processor.m_result.backtrace_enabled && GCodeReader::GCodeLine::cmd_starts_with(gcode_line, "T")) {
+                // add lines XXX where needed
+                export_lines.insert_lines_T(m_processor, gcode_line, backtrace_T);
+                m_max_backtrace_time = std::max(m_max_backtrace_time, backtrace_T.time);
+            }
+            export_lines.append_line(gcode_line);
+        }
+    }
+
+    export_lines.write(m_out, 1.1f * m_max_backtrace_time, m_processor.m_result, m_processor.m_result.filename);
+}
+
+// Counterpart of post_process() process_placeholders(), reserving slots for the values not known yet.
+bool GCodeProcessor::SinglePassExport::process_placeholders(const std::string& gcode_line)
+{
+    const TimeProcessor& time_processor = m_processor.m_time_processor;
+    // remove trailing '\n'
+    auto line = std::string_view(gcode_line).substr(0, gcode_line.length() - 1);
+    if (line.length() <= 1)
+        return false;
+    line = line.substr(1);
+
+    bool processed = false;
+    if (time_processor.export_remaining_time_enabled && line == reserved_tag(ETags::First_Line_M73_Placeholder)) {
+        for (const TimeMachine& machine : time_processor.machines) {
+            if (machine.enabled) {
+                // export pair <percent, remaining time>
+                this->append_slot(format_line_M73_main(machine.line_m73_main_mask, 100, 999999).size() - 1, [&machine]() {
+                    return format_line_M73_main(machine.line_m73_main_mask, 0, time_in_minutes(machine.time));
+                });
+                // export remaining time to next printer stop
+                this->append_slot(format_line_M73_stop_int(machine.line_m73_stop_mask, 999999).size() - 1, [&machine]() {
+                    return machine.stop_times.empty() ? std::string(";") :
+                        format_line_M73_stop_int(machine.line_m73_stop_mask, time_in_minutes(machine.stop_times.front().elapsed_time));
+                });
+                processed = true;
+            }
+        }
+    }
+    else if (time_processor.export_remaining_time_enabled && line == reserved_tag(ETags::Last_Line_M73_Placeholder)) {
+        for (const TimeMachine& machine : time_processor.machines) {
+            if (machine.enabled) {
+                m_export_lines->append_line(format_line_M73_main(machine.line_m73_main_mask, 100, 0));
+                processed = true;
+            }
+        }
+    }
+    else if (line == reserved_tag(ETags::Estimated_Printing_Time_Placeholder)) {
+        for (const bool first_layer : { false, true }) {
+            for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+                const TimeMachine& machine = time_processor.machines[i];
+                PrintEstimatedStatistics::ETimeMode mode = static_cast<PrintEstimatedStatistics::ETimeMode>(i);
+                if (mode == PrintEstimatedStatistics::ETimeMode::Normal || machine.enabled) {
+                    char buf[128];
+                    sprintf(buf, first_layer ? "; estimated first layer printing time (%s mode) = " : "; estimated printing time (%s mode) = ",
+                        (mode == PrintEstimatedStatistics::ETimeMode::Normal) ? "normal" : "silent");
+                    std::string prefix = buf;
+                    this->append_slot(prefix.size() + 24, [prefix, &machine, first_layer]() {
+                        return prefix + get_time_dhms(first_layer ? (machine.layers_time.empty() ? 0.f : machine.layers_time.front()) : machine.time);
+                    });
+                    processed = true;
+                }
+            }
+        }
+    }
+    return processed;
+}
+
+// Counterpart of post_process() process_line_G1(), reserving lines M73 every M73_Interval of the print time.
+void GCodeProcessor::SinglePassExport::process_line_G1(size_t g1_lines_counter)
+{
+    const TimeProcessor& time_processor = m_processor.m_time_processor;
+    if (!time_processor.export_remaining_time_enabled)
+        return;
+
+    for (size_t i = 0; i < static_cast<size_t>(PrintEstimatedStatistics::ETimeMode::Count); ++i) {
+        const TimeMachine& machine = time_processor.machines[i];
+        if (!machine.enabled)
+            continue;
+        // Skip all machine.g1_times_cache below g1_lines_counter.
+        size_t& idx = m_g1_times_cache_idx[i];
+        while (idx < machine.g1_times_cache.size() && machine.g1_times_cache[idx].id < g1_lines_counter)
+            ++idx;
+        if (idx == machine.g1_times_cache.size() || machine.g1_times_cache[idx].id != g1_lines_counter ||
+            machine.g1_times_cache[idx].elapsed_time < m_next_M73_time[i])
+            continue;
+
+        const float elapsed_time = machine.g1_times_cache[idx].elapsed_time;
+        m_next_M73_time[i] = elapsed_time + M73_Interval;
+        // export pair <percent, remaining time>
+        this->append_slot(format_line_M73_main(machine.line_m73_main_mask, 100, 999999).size() - 1, [&machine, elapsed_time]() {
+            return format_line_M73_main(machine.line_m73_main_mask, int(100.0f * elapsed_time / machine.time), time_in_minutes(machine.time - elapsed_time));
+        });
+        // export remaining time to next printer stop
+        this->append_slot(format_line_M73_stop_int(machine.line_m73_stop_mask, 999999).size() - 1, [&machine, elapsed_time]() {
+            auto it_stop = std::upper_bound(machine.stop_times.begin(), machine.stop_times.end(), elapsed_time,
+                [](float value, const TimeMachine::StopTime& t) { return value < t.elapsed_time; });
+            if (it_stop == machine.stop_times.end())
+                return std::string(";");
+            const int to_export_stop = time_in_minutes(it_stop->elapsed_time - elapsed_time);
+            return to_export_stop > 0 ? format_line_M73_stop_int(machine.line_m73_stop_mask, to_export_stop) :
+                format_line_M73_stop_float(machine.line_m73_stop_mask, time_in_last_minute(it_stop->elapsed_time - elapsed_time));
+        });
+    }
+}
+
+void GCodeProcessor::SinglePassExport::append_slot(size_t width, std::function<std::string()> content)
+{
+    m_slots.push_back({ m_export_lines->append_slot(width), width, std::move(content) });
+}
+
+void GCodeProcessor::SinglePassExport::fill_slots()
+{
+    std::string line;
+    for (const Slot& slot : m_slots) {
+        line = slot.content();
+        if (!line.empty() && line.back() == '\n')
+            line.pop_back();
+        if (line.size() > slot.width) {
+            BOOST_LOG_TRIVIAL(error) << "GCode processor single pass export: \"" << line << "\" does not fit into its slot";
+            line.resize(slot.width);
+            ++ m_processor.m_single_pass_export_truncated;
+        }
+        else
+            // Pad with spaces up to the end of line.
+            line.append(slot.width - line.size(), ' ');
+        if (fseek_to(m_out.f, m_export_lines->get_slot_file_pos(slot.id)) != 0 || ::fwrite(line.data(), 1, line.size(), m_out.f) != line.size())
+            this->throw_error("Is the disk full?");
+    }
+}
+
+void GCodeProcessor::SinglePassExport::throw_error(const std::string& error)
+{
+    m_out.close();
+    boost::nowide::remove(m_processor.m_result.filename.c_str());
+    throw Slic3r::RuntimeError(std::string("GCode processor single pass export failed.\n") + error + "\n");
+}
+
 void GCodeProcessor::store_move_vertex(EMoveType type, bool internal_only)
 {
     m_last_line_id = (type == EMoveType::Color_change || type == EMoveType::Pause_Print || type == EMoveType::Custom_GCode) ?
@@ -13,6 +13,7 @@
 #include <string>
 #include <string_view>
 #include <optional>
+#include <memory>
 
 namespace Slic3r {
 
@@ -137,7 +138,8 @@ namespace Slic3r {
         std::string filename;
         unsigned int id;
         std::vector<MoveVertex> moves;
-        // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code.
+        // Positions of ends of lines of the final G-code this->filename after TimeProcessor::post_process() finalizes the G-code
+        // or after the single pass export finished, see GCodeProcessor::enable_single_pass_export().
         std::vector<size_t> lines_ends;
         Pointfs bed_shape;
         float max_print_height;
@@ -617,8 +619,17 @@ namespace Slic3r {
         DataChecker m_width_compare{ "width", 0.01f };
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
 
+        // Helper class to modify and export gcode to file, see GCodeProcessor.cpp
+        class ExportLines;
+        // Writer of the final G-code in the single pass export mode, see GCodeProcessor.cpp
+        class SinglePassExport;
+        std::unique_ptr<SinglePassExport> m_single_pass_export;
+        // Number of values, which did not fit into the slots reserved by the last single pass export and which were truncated.
+        size_t m_single_pass_export_truncated{ 0 };
+
     public:
         GCodeProcessor();
+        ~GCodeProcessor();
 
         void apply_config(const PrintConfig& config);
         void set_print(Print* print) { m_print = print; }
@@ -639,6 +650,14 @@ namespace Slic3r {
 
         // Streaming interface, for processing G-codes just generated by PrusaSlicer in a pipelined fashion.
         void initialize(const std::string& filename);
+        // Let the processor write the G-code passed to process_buffer() into the file passed to initialize(). finalize() then
+        // fills in the remaining times and statistics in place instead of post_process() rewriting the whole file.
+        // Returns false if the file could not be opened for writing.
+        bool enable_single_pass_export();
+        // Close the file of the single pass export after the G-code export failed.
+        void abort_single_pass_export();
+        // Number of values truncated by the single pass export finished by the last finalize().
+        size_t single_pass_export_truncated() const { return m_single_pass_export_truncated; }
         void initialize_result_moves() {
             // 1st move must be a dummy move
             assert(m_result.moves.empty());
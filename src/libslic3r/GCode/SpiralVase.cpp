@@ -1,10 +1,64 @@
 #include "SpiralVase.hpp"
 #include "GCode.hpp"
+#include <cmath>
+#include <iomanip>
 #include <sstream>
+#include <string_view>
+
+#include <fast_float/fast_float.h>
 
 namespace Slic3r {
 
-std::string SpiralVase::process_layer(const std::string &gcode)
+// Update the position the same way GCodeReader does after a G-code line was read.
+static inline void update_position(float *pos, const GCodeLayerLine &line)
+{
+    if (line.is_move() || line.type == GCodeLayerLine::TYPE_G92)
+        for (int axis = 0; axis < GCodeLayerLine::NUM_AXES; ++ axis)
+            if (line.has(GCodeLayerLine::Axis(axis)))
+                pos[axis] = line.value(GCodeLayerLine::Axis(axis));
+}
+
+static inline float dist_XY(const float *pos, const GCodeLayerLine &line)
+{
+    float x = line.has(GCodeLayerLine::X) ? (line.value(GCodeLayerLine::X) - pos[GCodeLayerLine::X]) : 0;
+    float y = line.has(GCodeLayerLine::Y) ? (line.value(GCodeLayerLine::Y) - pos[GCodeLayerLine::Y]) : 0;
+    return sqrt(x*x + y*y);
+}
+
+static inline bool extruding(const float *pos, const GCodeLayerLine &line, bool relative_e)
+{
+    // With relative extruder distances, GCodeReader zeroes the extruder position before a line with the E word is processed.
+    return line.type == GCodeLayerLine::TYPE_G1 && line.has(GCodeLayerLine::E) && 
+        line.value(GCodeLayerLine::E) - (relative_e ? 0.f : pos[GCodeLayerLine::E]) > 0;
+}
+
+// Set an axis of a G-code line the same way GCodeReader::GCodeLine::set() does.
+// Returns the value as written into the line.
+static float set_axis(std::string &raw, char axis_char, bool has_axis, float new_value)
+{
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3) << new_value;
+    const std::string value = ss.str();
+
+    const char match[3] = { ' ', axis_char, 0 };
+    if (has_axis) {
+        size_t pos = raw.find(match) + 2;
+        size_t end = raw.find(' ', pos + 1);
+        raw.replace(pos, end - pos, value);
+    } else {
+        size_t pos = raw.find(' ');
+        if (pos == std::string::npos)
+            raw += std::string(match) + value;
+        else
+            raw.replace(pos, 0, std::string(match) + value);
+    }
+
+    float written = new_value;
+    fast_float::from_chars(value.data(), value.data() + value.size(), written);
+    return written;
+}
+
+std::string SpiralVase::process_layer(std::string &&gcode, GCodeLayerLines &lines)
 {
     /*  This post-processor relies on several assumptions:
         - all layers are processed through it, including those that are not supposed
@@ -13,84 +67,119 @@ std::string SpiralVase::process_layer(const std::string &gcode)
           at the beginning
         - each layer is composed by suitable geometry (i.e. a single complete loop)
         - loops were not clipped before calling this method  */
-    
-    // If we're not going to modify G-code, just feed it to the reader
-    // in order to update positions.
+
+    // Lines tokenized here do not recognize tool changes, thus they are not handed over to the filters that follow.
+    const bool own_lines = ! lines.valid_for(gcode);
+    if (own_lines)
+        lines.parse(gcode, m_reader.extrusion_axis(), std::string());
+
+    float position[GCodeLayerLine::NUM_AXES] = { m_reader.x(), m_reader.y(), m_reader.z(), m_reader.e(), m_reader.f() };
+    auto  store_position = [this, &position]() {
+        m_reader.x() = position[GCodeLayerLine::X];
+        m_reader.y() = position[GCodeLayerLine::Y];
+        m_reader.z() = position[GCodeLayerLine::Z];
+        m_reader.e() = position[GCodeLayerLine::E];
+        m_reader.f() = position[GCodeLayerLine::F];
+    };
+
+    // If we're not going to modify G-code, just update the positions.
     if (! m_enabled) {
-        m_reader.parse_buffer(gcode);
-        return gcode;
+        for (const GCodeLayerLine &line : lines)
+            update_position(position, line);
+        store_position();
+        if (own_lines)
+            lines.clear();
+        return std::move(gcode);
     }
-    
+
+    const bool relative_e = m_config.use_relative_e_distances.value;
+
     // Get total XY length for this layer by summing all extrusion moves.
     float total_layer_length = 0;
     float layer_height = 0;
     float z = 0.f;
-    
+
     {
-        //FIXME Performance warning: This copies the GCodeConfig of the reader.
-        GCodeReader r = m_reader;  // clone
+        float pos[GCodeLayerLine::NUM_AXES];
+        std::copy(std::begin(position), std::end(position), std::begin(pos));
         bool set_z = false;
-        r.parse_buffer(gcode, [&total_layer_length, &layer_height, &z, &set_z]
-            (GCodeReader &reader, const GCodeReader::GCodeLine &line) {
-            if (line.cmd_is("G1")) {
-                if (line.extruding(reader)) {
-                    total_layer_length += line.dist_XY(reader);
-                } else if (line.has(Z)) {
-                    layer_height += line.dist_Z(reader);
+        for (const GCodeLayerLine &line : lines) {
+            if (line.type == GCodeLayerLine::TYPE_G1) {
+                if (extruding(pos, line, relative_e)) {
+                    total_layer_length += dist_XY(pos, line);
+                } else if (line.has(GCodeLayerLine::Z)) {
+                    layer_height += line.value(GCodeLayerLine::Z) - pos[GCodeLayerLine::Z];
                     if (!set_z) {
-                        z = line.new_Z(reader);
+                        z = line.value(GCodeLayerLine::Z);
                         set_z = true;
                     }
                 }
             }
-        });
+            update_position(pos, line);
+        }
     }
-    
-    // Remove layer height from initial Z.
+
+    // Remove layer height from initial Z.
     z -= layer_height;
-    
-    std::string new_gcode;
+
+    std::string     new_gcode;
+    GCodeLayerLines new_lines;
+    new_gcode.reserve(gcode.size());
     //FIXME Tapering of the transition layer only works reliably with relative extruder distances.
     // For absolute extruder distances it will be switched off.
     // Tapering the absolute extruder distances requires to process every extrusion value after the first transition
     // layer.
-    bool  transition = m_transition_layer && m_config.use_relative_e_distances.value;
+    bool  transition = m_transition_layer && relative_e;
     float layer_height_factor = layer_height / total_layer_length;
     float len = 0.f;
-    m_reader.parse_buffer(gcode, [&new_gcode, &z, total_layer_length, layer_height_factor, transition, &len]
-        (GCodeReader &reader, GCodeReader::GCodeLine line) {
-        if (line.cmd_is("G1")) {
-            if (line.has_z()) {
+    std::string raw;
+    for (const GCodeLayerLine &line : lines) {
+        // The line without the trailing end of line.
+        std::string_view src(gcode.data() + line.begin, line.end - line.begin);
+        if (! src.empty() && src.back() == '\n')
+            src.remove_suffix(1);
+        GCodeLayerLine new_line = line;
+        bool           emit     = true;
+        raw.assign(src.data(), src.size());
+        if (line.type == GCodeLayerLine::TYPE_G1) {
+            if (line.has(GCodeLayerLine::Z)) {
                 // If this is the initial Z move of the layer, replace it with a
                 // (redundant) move to the last Z of previous layer.
-                line.set(reader, Z, z);
-                new_gcode += line.raw() + '\n';
-                return;
+                new_line.set(GCodeLayerLine::Z, set_axis(raw, 'Z', true, z));
             } else {
-                float dist_XY = line.dist_XY(reader);
-                if (dist_XY > 0) {
+                float dist = dist_XY(position, line);
+                if (dist > 0) {
                     // horizontal move
-                    if (line.extruding(reader)) {
-                        len += dist_XY;
-                        line.set(reader, Z, z + len * layer_height_factor);
-                        if (transition && line.has(E))
+                    if (extruding(position, line, relative_e)) {
+                        len += dist;
+                        new_line.set(GCodeLayerLine::Z, set_axis(raw, 'Z', false, z + len * layer_height_factor));
+                        if (transition && line.has(GCodeLayerLine::E))
                             // Transition layer, modulate the amount of extrusion from zero to the final value.
-                            line.set(reader, E, line.value(E) * len / total_layer_length);
-                        new_gcode += line.raw() + '\n';
-                    }
-                    return;
-                
-                    /*  Skip travel moves: the move to first perimeter point will
-                        cause a visible seam when loops are not aligned in XY; by skipping
-                        it we blend the first loop move in the XY plane (although the smoothness
-                        of such blend depend on how long the first segment is; maybe we should
-                        enforce some minimum length?).  */
+                            new_line.set(GCodeLayerLine::E, set_axis(raw, m_reader.extrusion_axis(), true, line.value(GCodeLayerLine::E) * len / total_layer_length));
+                    } else
+                        /*  Skip travel moves: the move to first perimeter point will
+                            cause a visible seam when loops are not aligned in XY; by skipping
+                            it we blend the first loop move in the XY plane (although the smoothness
+                            of such blend depend on how long the first segment is; maybe we should
+                            enforce some minimum length?).  */
+                        emit = false;
                 }
             }
         }
-        new_gcode += line.raw() + '\n';
-    });
-    
+        if (emit) {
+            new_gcode += raw;
+            new_gcode += '\n';
+            new_lines.append(new_line, raw.size() + 1);
+        }
+        // The position follows the source G-code, not the modified one.
+        update_position(position, line);
+    }
+    store_position();
+
+    if (own_lines)
+        lines.clear();
+    else
+        lines = std::move(new_lines);
     return new_gcode;
 }
 
@@ -3,6 +3,7 @@
 
 #include "../libslic3r.h"
 #include "../GCodeReader.hpp"
+#include "GCodeLayerLines.hpp"
 
 namespace Slic3r {
 
@@ -19,7 +20,11 @@ public:
     	m_enabled 		   = en;
     }
 
-    std::string process_layer(const std::string &gcode);
+    // Process the G-code of a layer together with its tokenized lines, which are updated to match the returned G-code.
+    // If the lines do not match the G-code, the G-code is tokenized here.
+    std::string process_layer(std::string &&gcode, GCodeLayerLines &lines);
+    std::string process_layer(const std::string &gcode)
+        { GCodeLayerLines lines; return this->process_layer(std::string(gcode), lines); }
     
 private:
     const PrintConfig  &m_config;
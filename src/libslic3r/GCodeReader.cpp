@@ -3,15 +3,32 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/nowide/fstream.hpp>
 #include <boost/nowide/cstdio.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
 #include "Utils.hpp"
 
 #include "LocalesUtils.hpp"
 
 #include <fast_float/fast_float.h>
 
+#include <tbb/task_arena.h>
+
+// Intel redesigned some TBB interface considerably when merging TBB with their oneAPI set of libraries, see GH #7332.
+#if ! defined(TBB_VERSION_MAJOR)
+    #include <tbb/version.h>
+#endif
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
+
 namespace Slic3r {
 
 static inline char get_extrusion_axis_char(const GCodeConfig &config)
@@ -37,7 +54,31 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
 const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command)
 {
     assert(is_decimal_separator_point());
-    
+
+    const char *c = this->tokenize_line(ptr, end, gline.m_axis, gline.m_mask, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    // Copy the raw string including the comment, without the trailing newlines.
+    if (c > ptr)
+        gline.m_raw.assign(ptr, c);
+
+    // Skip the trailing newlines.
+	if (*c == '\r')
+		++ c;
+	if (*c == '\n')
+		++ c;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return c;
+}
+
+const char* GCodeReader::tokenize_line(const char *ptr, const char *end, float *axes, uint32_t &mask, std::pair<const char*, const char*> &command) const
+{
+    // Locale independent, may be called from worker threads, which do not share the numeric locale of the calling thread.
     // command and args
     const char *c = ptr;
     {
@@ -75,8 +116,8 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 if (pend != c && is_end_of_word(*pend)) {
                     // The axis value has been parsed correctly.
                     if (axis != UNKNOWN_AXIS)
-	                    gline.m_axis[int(axis)] = float(v);
-                    gline.m_mask |= 1 << int(axis);
+	                    axes[int(axis)] = float(v);
+                    mask |= 1 << int(axis);
                     c = pend;
                 } else
                     // Skip the rest of the word.
@@ -86,26 +127,9 @@ const char* GCodeReader::parse_line_internal(const char *ptr, const char *end, G
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
-
-    // Copy the raw string including the comment, without the trailing newlines.
-    if (c > ptr)
-        gline.m_raw.assign(ptr, c);
-
-    // Skip the trailing newlines.
-	if (*c == '\r')
-		++ c;
-	if (*c == '\n')
-		++ c;
-
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
@@ -208,6 +232,124 @@ bool GCodeReader::parse_file_raw(const std::string &filename, raw_line_callback_
         [](size_t){});
 }
 
+bool GCodeReader::parse_file_parallel(const std::string &filename, callback_t callback, std::vector<size_t> &lines_ends)
+{
+    assert(is_decimal_separator_point());
+
+    lines_ends.clear();
+    m_parsing = true;
+
+    const boost::filesystem::path path(filename);
+    boost::system::error_code     ec;
+    const boost::uintmax_t        file_size = boost::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+    if (file_size == 0)
+        // Empty files cannot be memory mapped.
+        return true;
+
+    boost::iostreams::mapped_file_source file;
+    try {
+        file.open(path);
+    } catch (const std::exception &) {
+        return false;
+    }
+    if (! file.is_open())
+        return false;
+
+    const char *data     = file.data();
+    const char *data_end = data + file.size();
+    // The tokenizer stops at the end of line, which is not there if the file does not end with a newline.
+    // Such last line is parsed from a null terminated copy once the rest of the file has been processed.
+    const char *last_line = data_end;
+    if (data_end[-1] != '\r' && data_end[-1] != '\n')
+        for (; last_line != data && last_line[-1] != '\r' && last_line[-1] != '\n'; -- last_line) ;
+
+    // Block of lines tokenized by a single worker. The lines reference the memory mapped file.
+    struct Block {
+        struct Line {
+            const char                          *begin;
+            // End of the raw line, excluding the trailing newlines.
+            const char                          *end;
+            std::pair<const char*, const char*>  command;
+            float                                axes[NUM_AXES];
+            uint32_t                             mask;
+        };
+        const char          *begin { nullptr };
+        const char          *end   { nullptr };
+        std::vector<Line>    lines;
+        std::vector<size_t>  lines_ends;
+    };
+    using BlockPtr = std::shared_ptr<Block>;
+    // Size of a block is a trade-off between the scheduling overhead and the memory held by the blocks in flight.
+    static constexpr const size_t block_size = 1024 * 1024;
+
+    const char *next_block = data;
+    const auto split = tbb::make_filter<void, BlockPtr>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &next_block, last_line](tbb::flow_control &fc) -> BlockPtr {
+            if (next_block == last_line || ! m_parsing) {
+                fc.stop();
+                return {};
+            }
+            auto block = std::make_shared<Block>();
+            block->begin = next_block;
+            // Split just after '\n', thus "\r\n" is never split. A file with '\r' line endings only is processed as a single block.
+            const char *it = std::find(next_block + std::min(block_size, size_t(last_line - next_block)), last_line, '\n');
+            block->end = next_block = (it == last_line) ? last_line : it + 1;
+            return block;
+        });
+    const auto tokenize = tbb::make_filter<BlockPtr, BlockPtr>(slic3r_tbb_filtermode::parallel,
+        [this, data](BlockPtr block) -> BlockPtr {
+            // Lines are split the same way as parse_file_raw_internal() splits them.
+            for (const char *it = block->begin; it != block->end;) {
+                const char *line_end = it;
+                for (; *line_end != '\r' && *line_end != '\n'; ++ line_end) ;
+                Block::Line &line = block->lines.emplace_back();
+                line.begin = it;
+                line.mask  = 0;
+                memset(line.axes, 0, sizeof(line.axes));
+                line.end   = this->tokenize_line(it, line_end, line.axes, line.mask, line.command);
+                it = line_end;
+                if (*it == '\r')
+                    ++ it;
+                if (it != block->end && *it == '\n')
+                    block->lines_ends.emplace_back(size_t(++ it - data));
+            }
+            return block;
+        });
+    GCodeLine gline;
+    const auto process = tbb::make_filter<BlockPtr, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &lines_ends, &gline](BlockPtr block) {
+            if (! m_parsing)
+                return;
+            lines_ends.insert(lines_ends.end(), block->lines_ends.begin(), block->lines_ends.end());
+            for (const Block::Line &line : block->lines) {
+                gline.m_raw.assign(line.begin, line.end);
+                memcpy(gline.m_axis, line.axes, sizeof(gline.m_axis));
+                gline.m_mask = line.mask;
+                if (gline.has(E) && m_config.use_relative_e_distances)
+                    m_position[E] = 0;
+                if (m_verbose)
+                    std::cout << gline.m_raw << std::endl;
+                callback(*this, gline);
+                std::pair<const char*, const char*> command = line.command;
+                update_coordinates(gline, command);
+                if (! m_parsing)
+                    // The callback wishes to exit.
+                    return;
+            }
+        });
+    // The number of blocks in flight bounds the memory held by the tokenized lines.
+    tbb::parallel_pipeline(2 * size_t(tbb::this_task_arena::max_concurrency()), split & tokenize & process);
+
+    if (m_parsing && last_line != data_end) {
+        const std::string line(last_line, data_end);
+        gline.reset();
+        this->parse_line(line.c_str(), line.c_str() + line.size(), gline, callback);
+    }
+    return true;
+}
+
 const char* GCodeReader::axis_pos(const char *raw_str, char axis)
 {
     const char *c = raw_str;
@@ -7,6 +7,7 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "PrintConfig.hpp"
 
 namespace Slic3r {
@@ -134,6 +135,10 @@ public:
     bool parse_file(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
     // Just read the G-code file line by line, calls callback (const char *begin, const char *end). Returns false if reading the file failed.
     bool parse_file_raw(const std::string &file, raw_line_callback_t callback);
+    // Same as parse_file() with lines_ends, intended for large files: the file is memory mapped, split into blocks at line boundaries
+    // and the blocks are tokenized in parallel. The callback is called sequentially in the order of the lines, from the calling thread
+    // or from a TBB worker, therefore it must not rely on thread local state. Exceptions thrown by the callback are propagated.
+    bool parse_file_parallel(const std::string &file, callback_t callback, std::vector<size_t> &lines_ends);
 
     // To be called by the callback to stop parsing.
     void quit_parsing() { m_parsing = false; }
@@ -162,6 +167,9 @@ private:
     bool        parse_file_internal(const std::string &filename, ParseLineCallback parse_line_callback, LineEndCallback line_end_callback);
 
     const char* parse_line_internal(const char *ptr, const char *end, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Parse the command and the axes of a line up to its end or to the end of the buffer, does not touch the state of the reader.
+    // Returns pointer to the end of line, excluding the trailing newlines.
+    const char* tokenize_line(const char *ptr, const char *end, float *axes, uint32_t &mask, std::pair<const char*, const char*> &command) const;
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
@@ -6,10 +6,12 @@
 #include "Print.hpp"
 #include "Fill/Fill.hpp"
 #include "ShortestPath.hpp"
+#include "Trace.hpp"
 #include "SVG.hpp"
 #include "BoundingBox.hpp"
 #include "clipper/clipper.hpp"
 
+#include <boost/functional/hash.hpp>
 #include <boost/log/trivial.hpp>
 
 namespace Slic3r {
@@ -615,7 +617,12 @@ ExPolygons Layer::merged(float offset_scaled) const
 // The resulting fill surface is split back among the originating regions.
 void Layer::make_perimeters()
 {
+    SLIC3R_TRACE_ZONE("Layer::make_perimeters", "layer", this->id());
     BOOST_LOG_TRIVIAL(trace) << "Generating perimeters for layer " << this->id();
+    m_perimeters_source = nullptr;
+    // Start a new block, so that the blocks of the extrusions being replaced are released as soon as the old extrusions are deleted.
+    m_extrusion_arena.release();
+    ExtrusionEntityArena::Scope arena_scope(&m_extrusion_arena);
     
     // keep track of regions whose perimeters we have already generated
     std::vector<unsigned char>                              done(m_regions.size(), false);
@@ -1045,6 +1052,139 @@ void Layer::sort_perimeters_into_islands(
     }
 }
 
+static inline void hash_expolygon(size_t &seed, const ExPolygon &expolygon)
+{
+    auto hash_polygon = [&seed](const Polygon &polygon) {
+        boost::hash_combine(seed, polygon.points.size());
+        for (const Point &pt : polygon.points) {
+            boost::hash_combine(seed, pt.x());
+            boost::hash_combine(seed, pt.y());
+        }
+    };
+    hash_polygon(expolygon.contour);
+    for (const Polygon &hole : expolygon.holes)
+        hash_polygon(hole);
+}
+
+static inline void hash_surfaces(size_t &seed, const Surfaces &surfaces)
+{
+    boost::hash_combine(seed, surfaces.size());
+    for (const Surface &surface : surfaces) {
+        boost::hash_combine(seed, int(surface.surface_type));
+        boost::hash_combine(seed, surface.thickness);
+        boost::hash_combine(seed, surface.thickness_layers);
+        boost::hash_combine(seed, surface.bridge_angle);
+        boost::hash_combine(seed, surface.extra_perimeters);
+        hash_expolygon(seed, surface.expolygon);
+    }
+}
+
+static inline bool surfaces_equal(const Surfaces &lhs, const Surfaces &rhs)
+{
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Surface &l, const Surface &r) {
+        return l.surface_type == r.surface_type && l.thickness == r.thickness && l.thickness_layers == r.thickness_layers &&
+               l.bridge_angle == r.bridge_angle && l.extra_perimeters == r.extra_perimeters && l.distance_to_top == r.distance_to_top &&
+               l.expolygon == r.expolygon;
+    });
+}
+
+// Perimeters of the first object layer and of the raft interface differ from the layers above,
+// fuzzy skin is randomized, spiral vase and nonplanar layers depend on the layers around.
+bool Layer::perimeters_shareable() const
+{
+    const PrintObjectConfig &object_config = this->object()->config();
+    if (this->lower_layer == nullptr || this->id() <= size_t(object_config.raft_layers.value) ||
+        object_config.use_nonplanar_layers || this->object()->print()->config().spiral_vase)
+        return false;
+    for (const LayerRegion *layerm : m_regions)
+        if (layerm->region().config().fuzzy_skin != FuzzySkinType::None)
+            return false;
+    return true;
+}
+
+size_t Layer::perimeters_fingerprint() const
+{
+    if (! this->perimeters_shareable())
+        return 0;
+    size_t seed = 0;
+    boost::hash_combine(seed, this->height);
+    boost::hash_combine(seed, m_regions.size());
+    for (const LayerRegion *layerm : m_regions) {
+        boost::hash_combine(seed, &layerm->region());
+        hash_surfaces(seed, layerm->slices().surfaces);
+    }
+    for (const ExPolygon &expolygon : this->lower_layer->lslices)
+        hash_expolygon(seed, expolygon);
+    // Zero is reserved for layers, which shall not share their perimeters.
+    return std::max<size_t>(seed, 1);
+}
+
+bool Layer::has_same_perimeter_inputs(const Layer &other) const
+{
+    if (! this->perimeters_shareable() || ! other.perimeters_shareable() ||
+        this->height != other.height || m_regions.size() != other.m_regions.size() || this->lslices != other.lslices)
+        return false;
+    for (size_t region_id = 0; region_id < m_regions.size(); ++ region_id) {
+        const LayerRegion &layerm       = *m_regions[region_id];
+        const LayerRegion &other_layerm = *other.m_regions[region_id];
+        if (&layerm.region() != &other_layerm.region() || ! surfaces_equal(layerm.slices().surfaces, other_layerm.slices().surfaces))
+            return false;
+    }
+    return this->lower_layer->lslices == other.lower_layer->lslices;
+}
+
+void Layer::copy_perimeters(const Layer &source)
+{
+    assert(m_regions.size() == source.m_regions.size());
+    assert(this->lslices_ex.size() == source.lslices_ex.size());
+    m_extrusion_arena.release();
+    ExtrusionEntityArena::Scope arena_scope(&m_extrusion_arena);
+    for (size_t region_id = 0; region_id < m_regions.size(); ++ region_id) {
+        LayerRegion       &layerm        = *m_regions[region_id];
+        const LayerRegion &source_layerm = *source.m_regions[region_id];
+        layerm.m_perimeters                       = source_layerm.m_perimeters;
+        layerm.m_thin_fills                       = source_layerm.m_thin_fills;
+        layerm.m_fills.clear();
+        layerm.m_fill_expolygons                  = source_layerm.m_fill_expolygons;
+        layerm.m_fill_expolygons_bboxes           = source_layerm.m_fill_expolygons_bboxes;
+        layerm.m_fill_expolygons_composite        = source_layerm.m_fill_expolygons_composite;
+        layerm.m_fill_expolygons_composite_bboxes = source_layerm.m_fill_expolygons_composite_bboxes;
+    }
+    // The islands only reference the extrusions and fill expolygons of the layer regions by their indices.
+    for (size_t lslice_id = 0; lslice_id < this->lslices_ex.size(); ++ lslice_id) {
+        LayerIslands &islands = this->lslices_ex[lslice_id].islands;
+        islands = source.lslices_ex[lslice_id].islands;
+        for (LayerIsland &island : islands)
+            island.fills.clear();
+    }
+    m_perimeters_source = &source.perimeters_source();
+}
+
+// Infill of the first layer is not bridging, nonplanar infill is projected onto the surface above.
+size_t Layer::fills_fingerprint() const
+{
+    if (this->id() == 0 || this->object()->config().use_nonplanar_layers)
+        return 0;
+    size_t seed = 0;
+    boost::hash_combine(seed, &this->perimeters_source());
+    boost::hash_combine(seed, this->height);
+    for (const LayerRegion *layerm : m_regions)
+        hash_surfaces(seed, layerm->fill_surfaces().surfaces);
+    return std::max<size_t>(seed, 1);
+}
+
+bool Layer::has_same_fill_inputs(const Layer &other) const
+{
+    // Sharing the perimeters implies sharing the regions, the islands, the fill expolygons and the gap fills.
+    if (this->id() == 0 || other.id() == 0 || this->object()->config().use_nonplanar_layers ||
+        &this->perimeters_source() != &other.perimeters_source() || this->height != other.height)
+        return false;
+    for (size_t region_id = 0; region_id < m_regions.size(); ++ region_id)
+        if (! surfaces_equal(m_regions[region_id]->fill_surfaces().surfaces, other.m_regions[region_id]->fill_surfaces().surfaces))
+            return false;
+    return true;
+}
+
 void Layer::export_region_slices_to_svg(const char *path) const
 {
     BoundingBox bbox;
@@ -172,7 +172,7 @@ public:
     bool    has_extrusions() const { return ! this->perimeters().empty() || ! this->fills().empty(); }
 
     //append a new nonplanar surface to the list skip if already in list
-    void append_nonplanar_surface(NonplanarSurface& surface);
+    void append_nonplanar_surface(const NonplanarSurfacePtr &surface);
     // Projects the paths of a collection regarding the structure of a stl mesh
     void project_nonplanar_extrusion(ExtrusionEntityCollection* collection);
     /// Projects nonplanar surfaces downwards regarding the structure of the stl mesh.
@@ -387,11 +387,24 @@ public:
         return false;
     }
     void                    make_perimeters();
+    // Hash of the inputs of make_perimeters(), zero if the perimeters of this layer shall not be shared with another layer.
+    size_t                  perimeters_fingerprint() const;
+    // Would make_perimeters() produce the same extrusions for both layers?
+    bool                    has_same_perimeter_inputs(const Layer &other) const;
+    // Layer, at which the perimeters of this layer were generated.
+    const Layer&            perimeters_source() const { return m_perimeters_source ? *m_perimeters_source : *this; }
+    // Hash of the inputs of make_fills(), zero if the infill of this layer shall not be shared with another layer.
+    size_t                  fills_fingerprint() const;
+    // Would make_fills() produce the same extrusions for both layers, up to the infill direction and Z dependent infill patterns?
+    bool                    has_same_fill_inputs(const Layer &other) const;
     // Phony version of make_fills() without parameters for Perl integration only.
     void                    make_fills() { this->make_fills(nullptr, nullptr, nullptr); }
     void                    make_fills(FillAdaptive::Octree     *adaptive_fill_octree,
                                        FillAdaptive::Octree     *support_fill_octree,
-                                       FillLightning::Generator *lightning_generator);
+                                       FillLightning::Generator *lightning_generator,
+                                       // Already filled layers with the same fill inputs, see has_same_fill_inputs().
+                                       // Infill, which does not depend on Z and which runs in the same direction as at this layer, is copied from these layers.
+                                       const std::vector<const Layer*> &fill_sources = {});
     Polylines               generate_sparse_infill_polylines_for_anchoring(FillAdaptive::Octree *adaptive_fill_octree,
                                                                            FillAdaptive::Octree *support_fill_octree,
                                                                            FillLightning::Generator* lightning_generator) const;
@@ -407,6 +420,9 @@ public:
 
     // Is there any valid extrusion assigned to this LayerRegion?
     virtual bool            has_extrusions() const { for (auto layerm : m_regions) if (layerm->has_extrusions()) return true; return false; }
+    // Allocator of the extrusion entities of this layer, bound to the current thread by the steps generating the extrusions.
+    ExtrusionEntityArena&       extrusion_arena()       { return m_extrusion_arena; }
+    const ExtrusionEntityArena& extrusion_arena() const { return m_extrusion_arena; }
 //    virtual bool            has_extrusions() const { for (const LayerSlice &lslice : lslices_ex) if (lslice.has_extrusions()) return true; return false; }
 
 protected:
@@ -422,6 +438,8 @@ protected:
     virtual ~Layer();
     // Clear fill extrusions, remove them from layer islands.
     void clear_fills();
+    // Copy perimeters, gap fills, fill expolygons and layer islands from a layer with the same perimeter inputs.
+    void copy_perimeters(const Layer &source);
 
 private:
     void sort_perimeters_into_islands(
@@ -439,11 +457,18 @@ private:
         const std::vector<ExPolygonRange>                               &fill_expolygons_ranges,
         // If the current layer consists of multiple regions, then the fill_expolygons above are split by the source LayerRegion surfaces.
         const std::vector<uint32_t>                                     &layer_region_ids);
+    bool perimeters_shareable() const;
 
     // Sequential index of layer, 0-based, offsetted by number of raft layers.
     size_t              m_id;
     PrintObject        *m_object;
     LayerRegionPtrs     m_regions;
+    // Layer, from which the perimeters were copied by copy_perimeters(), nullptr if they were generated for this layer.
+    const Layer        *m_perimeters_source { nullptr };
+    // Ranges of LayerRegion::fills() produced by make_fills() for each group of fill surfaces.
+    // Used to copy the infill to layers with the same fill inputs.
+    LayerExtrusionRanges m_surface_fills_ranges;
+    ExtrusionEntityArena m_extrusion_arena;
 };
 
 class SupportLayer : public Layer 
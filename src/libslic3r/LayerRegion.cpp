@@ -915,13 +915,11 @@ void LayerRegion::export_region_fill_surfaces_to_svg_debug(const char *name) con
 }
 
 void
-LayerRegion::append_nonplanar_surface(NonplanarSurface& surface)
+LayerRegion::append_nonplanar_surface(const NonplanarSurfacePtr &surface)
 {
-    for(auto & s : m_nonplanar_surfaces){
-        if (s == surface){
-            return;
-        }    
-    }
+    // surfaces are shared between the layers, compare by identity
+    if (std::find(m_nonplanar_surfaces.begin(), m_nonplanar_surfaces.end(), surface) != m_nonplanar_surfaces.end())
+        return;
     m_nonplanar_surfaces.push_back(surface);
 }
 
@@ -1031,34 +1029,32 @@ smallerY(const Vec3d &a, const Vec3d &b)
 void
 LayerRegion::project_nonplanar_path(ExtrusionPath *path)
 {
-    //First check all points and project them regarding the triangle mesh
-    for (Point& point : path->polyline.points) {
-        for (auto& surface : m_nonplanar_surfaces) {
-            float distance_to_top = surface.stats.max.z - this->layer()->print_z;
-            for(auto& facet : surface.mesh) {
-                // skip if point is outside of the bounding box of the triangle
-                if (unscale(point).x() < std::min({facet.second.vertex[0].x, facet.second.vertex[1].x, facet.second.vertex[2].x}) ||
-                    unscale(point).x() > std::max({facet.second.vertex[0].x, facet.second.vertex[1].x, facet.second.vertex[2].x}) ||
-                    unscale(point).y() < std::min({facet.second.vertex[0].y, facet.second.vertex[1].y, facet.second.vertex[2].y}) ||
-                    unscale(point).y() > std::max({facet.second.vertex[0].y, facet.second.vertex[1].y, facet.second.vertex[2].y}))
-                {
-                    continue;
-                }
+    std::vector<coord_t> &path_z = path->polyline.z;
+    path_z.assign(path->polyline.points.size(), -1);
 
+    //First check all points and project them regarding the triangle mesh
+    for (size_t idx_point = 0; idx_point < path->polyline.points.size(); ++ idx_point) {
+        const Point &point = path->polyline.points[idx_point];
+        const Vec2f  pt    = unscale(point).cast<float>();
+        for (const NonplanarSurfacePtr& surface : m_nonplanar_surfaces) {
+            const NonplanarMesh &mesh = *surface->mesh;
+            float distance_to_top = surface->stats.max.z - this->layer()->print_z;
+            // only the facets, whose bounding box contains the point
+            for (int facet_id : surface->facets_at(pt)) {
+                const Vec3f  v0     = mesh.vertex(facet_id, 0);
+                const Vec3f &normal = mesh.normal(facet_id);
                 //check if point is inside of Triangle
                 if (Slic3r::Geometry::Point_in_triangle(
-                    Vec2f(unscale(point).x(), unscale(point).y()),
-                    Vec2f(facet.second.vertex[0].x, facet.second.vertex[0].y),
-                    Vec2f(facet.second.vertex[1].x, facet.second.vertex[1].y),
-                    Vec2f(facet.second.vertex[2].x, facet.second.vertex[2].y))
-                    && (facet.second.normal.z != 0))
+                    pt,
+                    v0.head<2>().eval(),
+                    mesh.vertex(facet_id, 1).head<2>().eval(),
+                    mesh.vertex(facet_id, 2).head<2>().eval())
+                    && (normal.z() != 0))
                 {
-                    coord_t z = Slic3r::Geometry::Project_point_on_plane(Vec3f(facet.second.vertex[0].x,facet.second.vertex[0].y,facet.second.vertex[0].z),
-                                                             Vec3f(facet.second.normal.x,facet.second.normal.y,facet.second.normal.z),
-                                                             point);
+                    coord_t z = Slic3r::Geometry::Project_point_on_plane(v0, normal, point);
 
                     //Shift down when on lower layer
-                    point.nonplanar_z = z - scale_(distance_to_top);
+                    path_z[idx_point] = z - scale_(distance_to_top);
                     //break;
                 }
             }
@@ -1070,15 +1066,20 @@ LayerRegion::project_nonplanar_path(ExtrusionPath *path)
     for (std::vector<Vec3crd>::size_type i = 0; i < size-1; ++i)
     {
         Pointf3s intersections;
-        // check against every facet if lines intersect
-        for (auto& surface : m_nonplanar_surfaces) {
-            float distance_to_top = surface.stats.max.z - this->layer()->print_z;
-            for(auto& facet : surface.mesh) {
+        // only facets whose bounding box overlaps the bounding box of the segment may intersect it
+        const Vec2d a = unscale(path->polyline.points[i]);
+        const Vec2d b = unscale(path->polyline.points[i+1]);
+        const Vec2f segment_min = a.cwiseMin(b).cast<float>();
+        const Vec2f segment_max = a.cwiseMax(b).cast<float>();
+        // check against the candidate facets if lines intersect
+        for (const NonplanarSurfacePtr& surface : m_nonplanar_surfaces) {
+            const NonplanarMesh &mesh = *surface->mesh;
+            float distance_to_top = surface->stats.max.z - this->layer()->print_z;
+            for (int facet_id : surface->facets_in_box(segment_min, segment_max)) {
                 for(int j= 0; j < 3; j++) {
-                    // TODO precheck for faster computation
-                    Vec3d p1 = Vec3d(scale_(facet.second.vertex[j].x), scale_(facet.second.vertex[j].y), scale_(facet.second.vertex[j].z));
-                    Vec3d p2 = Vec3d(scale_(facet.second.vertex[(j+1) % 3].x), scale_(facet.second.vertex[(j+1) % 3].y), scale_(facet.second.vertex[(j+1) % 3].z));
-                    Vec3d* p = Slic3r::Geometry::Line_intersection(p1, p2, path->polyline.points[i], path->polyline.points[i+1]);
+                    Vec3d p1 = mesh.vertex(facet_id, j).cast<double>() / SCALING_FACTOR;
+                    Vec3d p2 = mesh.vertex(facet_id, (j+1) % 3).cast<double>() / SCALING_FACTOR;
+                    std::unique_ptr<Vec3d> p(Slic3r::Geometry::Line_intersection(p1, p2, path->polyline.points[i], path->polyline.points[i+1]));
 
                     if (p) {
                         // add distance to top for every added point
@@ -1132,9 +1133,8 @@ LayerRegion::project_nonplanar_path(ExtrusionPath *path)
         //insert new points into array
         for (Vec3d p : intersections)
         {
-            Point *pt = new Point(p.x(), p.y());
-            pt->nonplanar_z = p.z();
-            path->polyline.points.insert(path->polyline.points.begin()+i+1, *pt);
+            path->polyline.points.insert(path->polyline.points.begin()+i+1, Point(p.x(), p.y()));
+            path_z.insert(path_z.begin()+i+1, coord_t(p.z()));
         }
 
         //modifiy array boundary
@@ -1146,9 +1146,9 @@ LayerRegion::project_nonplanar_path(ExtrusionPath *path)
 void
 LayerRegion::correct_z_on_path(ExtrusionPath *path)
 {
-    for (Point& point : path->polyline.points) {
-        if(point.nonplanar_z == -1) {
-            point.nonplanar_z = scale_(this->layer()->print_z);
+    for (coord_t &z : path->polyline.z) {
+        if(z == -1) {
+            z = scale_(this->layer()->print_z);
         }
     }
 }
@@ -1,22 +1,25 @@
 #include "NonplanarSurface.hpp"
 #include <boost/log/trivial.hpp>
 
+#include <tbb/parallel_for.h>
+
 namespace Slic3r {
 
-NonplanarSurface::NonplanarSurface(std::map<int, NonplanarFacet> &_mesh)
+NonplanarMesh::NonplanarMesh(std::shared_ptr<const TriangleMesh> mesh, float z_offset) :
+    m_mesh(std::move(mesh)), m_z_offset(z_offset), m_neighbors(its_face_neighbors_par(m_mesh->its))
 {
-    this->mesh = _mesh;
-    this->calculate_stats();
+    m_normals.reserve(m_mesh->its.indices.size());
+    for (size_t facet_id = 0; facet_id < m_mesh->its.indices.size(); ++ facet_id)
+        m_normals.emplace_back(its_unnormalized_normal(m_mesh->its, facet_id).cast<double>().normalized().cast<float>());
 }
 
-bool 
-NonplanarSurface::operator==(const NonplanarSurface& other) const {
-   return (stats.min.x == other.stats.min.x &&
-           stats.min.y == other.stats.min.y &&
-           stats.min.z == other.stats.min.z &&
-           stats.max.x == other.stats.max.x &&
-           stats.max.y == other.stats.max.y &&
-           stats.max.z == other.stats.max.z);
+NonplanarSurface::NonplanarSurface(NonplanarMeshPtr _mesh, std::vector<int> _facets) :
+    mesh(std::move(_mesh)), facets(std::move(_facets))
+{
+    assert(std::is_sorted(this->facets.begin(), this->facets.end()));
+    this->calculate_stats();
+    this->build_facets_tree();
+    m_horizontal_projection = this->calculate_horizontal_projection();
 }
 
 void
@@ -29,164 +32,105 @@ NonplanarSurface::calculate_stats()
     this->stats.max.x = -10000000;
     this->stats.max.y = -10000000;
     this->stats.max.z = -10000000;
-    for(auto& facet : this->mesh) {
-        this->stats.min.x = std::min(this->stats.min.x, facet.second.stats.min.x);
-        this->stats.min.y = std::min(this->stats.min.y, facet.second.stats.min.y);
-        this->stats.min.z = std::min(this->stats.min.z, facet.second.stats.min.z);
-        this->stats.max.x = std::max(this->stats.max.x, facet.second.stats.max.x);
-        this->stats.max.y = std::max(this->stats.max.y, facet.second.stats.max.y);
-        this->stats.max.z = std::max(this->stats.max.z, facet.second.stats.max.z);
-    }
-}
-
-void
-NonplanarSurface::translate(float x, float y, float z)
-{
-    //translate all facets
-    for(auto& facet : this->mesh) {
-        facet.second.translate(x, y, z);
-    }
-
-    //translate min and max values
-    this->stats.min.x += x;
-    this->stats.min.y += y;
-    this->stats.min.z += z;
-    this->stats.max.x += x;
-    this->stats.max.y += y;
-    this->stats.max.z += z;
-}
-
-void
-NonplanarSurface::scale(float factor)
-{
-    float versor[3];
-    versor[0] = factor;
-    versor[1] = factor;
-    versor[2] = factor;
-    this->scale(versor);
-}
-
-void
-NonplanarSurface::scale(float versor[3])
-{
-    //scale all facets
-    for(auto& facet : this->mesh) {
-        facet.second.scale(versor);
-    }
-
-    //scale min and max values
-    this->stats.min.x *= versor[0];
-    this->stats.min.y *= versor[1];
-    this->stats.min.z *= versor[2];
-    this->stats.max.x *= versor[0];
-    this->stats.max.y *= versor[1];
-    this->stats.max.z *= versor[2];
-}
-
-void
-NonplanarSurface::rotate_z(float angle) {
-  double radian_angle = (angle / 180.0) * 3.1415927;
-  double c = cos(radian_angle);
-  double s = sin(radian_angle);
-
-  for(auto& facet : this->mesh) {
-    for(int j = 0; j < 3; j++) {
-        double xold = facet.second.vertex[j].x;
-        double yold = facet.second.vertex[j].y;
-        facet.second.vertex[j].x = c * xold - s * yold;
-        facet.second.vertex[j].y = s * xold + c * yold;
+    for (int facet_id : this->facets) {
+        for (int j = 0; j < 3; ++ j) {
+            const Vec3f v = this->mesh->vertex(facet_id, j);
+            this->stats.min.x = std::min(this->stats.min.x, v.x());
+            this->stats.min.y = std::min(this->stats.min.y, v.y());
+            this->stats.min.z = std::min(this->stats.min.z, v.z());
+            this->stats.max.x = std::max(this->stats.max.x, v.x());
+            this->stats.max.y = std::max(this->stats.max.y, v.y());
+            this->stats.max.z = std::max(this->stats.max.z, v.z());
+        }
     }
-    facet.second.calculate_stats();
-  }
-
-  this->calculate_stats();
 }
 
 void
-NonplanarSurface::debug_output()
+NonplanarSurface::debug_output() const
 {
-    std::cout << "Facets(" << this->mesh.size() << "): (min:X:" << this->stats.min.x << " Y:" << this->stats.min.y << " Z:" << this->stats.min.z <<
+    std::cout << "Facets(" << this->facets.size() << "): (min:X:" << this->stats.min.x << " Y:" << this->stats.min.y << " Z:" << this->stats.min.z <<
                            " max:X:" << this->stats.max.x << " Y:" << this->stats.max.y << " Z:" << this->stats.max.z << ")" << 
                            "Height " << this->stats.max.z - this->stats.min.z << std::endl;
-    for(auto& facet : this->mesh) {
-        std::cout << "triangle: (" << facet.first << ")(" << facet.second.marked << ") ";
-        std::cout << " (" << (180*std::acos(facet.second.normal.z))/3.14159265 << "°)";
-
-        std::cout << " | V0:";
-        std::cout << " X:"<< facet.second.vertex[0].x;
-        std::cout << " Y:"<< facet.second.vertex[0].y;
-        std::cout << " Z:"<< facet.second.vertex[0].z;
-
-        std::cout << " | V1:";
-        std::cout << " X:"<< facet.second.vertex[1].x;
-        std::cout << " Y:"<< facet.second.vertex[1].y;
-        std::cout << " Z:"<< facet.second.vertex[1].z;
-
-        std::cout << " | V2:";
-        std::cout << " X:"<< facet.second.vertex[2].x;
-        std::cout << " Y:"<< facet.second.vertex[2].y;
-        std::cout << " Z:"<< facet.second.vertex[2].z;
+    for (int facet_id : this->facets) {
+        const Vec3f &normal    = this->mesh->normal(facet_id);
+        const Vec3i &neighbors = this->mesh->neighbors(facet_id);
+        std::cout << "triangle: (" << facet_id << ") ";
+        std::cout << " (" << (180*std::acos(normal.z()))/3.14159265 << "°)";
+
+        for (int j = 0; j < 3; ++ j) {
+            const Vec3f v = this->mesh->vertex(facet_id, j);
+            std::cout << " | V" << j << ":";
+            std::cout << " X:"<< v.x();
+            std::cout << " Y:"<< v.y();
+            std::cout << " Z:"<< v.z();
+        }
 
         std::cout << " | Normal:";
-        std::cout << " X:"<< facet.second.normal.x;
-        std::cout << " Y:"<< facet.second.normal.y;
-        std::cout << " Z:"<< facet.second.normal.z;
+        std::cout << " X:"<< normal.x();
+        std::cout << " Y:"<< normal.y();
+        std::cout << " Z:"<< normal.z();
 
-        //TODO check if neighbors exist
-        // stl_neighbors* neighbors = mesh.stl.neighbors_start + facet.first;
         std::cout << " | Neighbors:";
-        std::cout << " 0:"<< facet.second.neighbor[0];
-        std::cout << " 1:"<< facet.second.neighbor[1];
-        std::cout << " 2:"<< facet.second.neighbor[2];
+        std::cout << " 0:"<< neighbors(0);
+        std::cout << " 1:"<< neighbors(1);
+        std::cout << " 2:"<< neighbors(2);
         std::cout << std::endl;
     }
 }
 
 NonplanarSurfaces
-NonplanarSurface::group_surfaces()
+NonplanarSurface::group_surfaces(const NonplanarMeshPtr &mesh, const std::vector<int> &facets)
 {
-    std::pair<int, NonplanarFacet> begin = *this->mesh.begin();
-    this->mark_neighbor_surfaces(begin.first);
-    NonplanarSurface newSurface;
-    for (std::map<int, NonplanarFacet>::iterator it=this->mesh.begin(); it!=this->mesh.end();) {
-        if((*it).second.marked == false) {
-            newSurface.mesh[(*it).first] = (*it).second;
-            it = this->mesh.erase(it);
-        }
-        else {
-            ++it;
+    assert(std::is_sorted(facets.begin(), facets.end()));
+
+    // Index of a mesh facet in facets, -1 if the facet is not part of any surface.
+    std::vector<int> facet_idx(mesh->facets_count(), -1);
+    for (size_t i = 0; i < facets.size(); ++ i)
+        facet_idx[facets[i]] = int(i);
+
+    // Flood fill the edge connected facets, starting with the lowest facet ID not yet assigned to a surface.
+    // Iterative, so that large connected surfaces do not overflow the stack.
+    std::vector<std::vector<int>> groups;
+    std::vector<char> visited(facets.size(), false);
+    std::vector<int>  queue;
+    for (size_t seed = 0; seed < facets.size(); ++ seed) {
+        if (visited[seed])
+            continue;
+        std::vector<int> surface_facets;
+        visited[seed] = true;
+        queue.emplace_back(facets[seed]);
+        while (! queue.empty()) {
+            int facet_id = queue.back();
+            queue.pop_back();
+            surface_facets.emplace_back(facet_id);
+            const Vec3i &neighbors = mesh->neighbors(facet_id);
+            for (int j = 0; j < 3; ++ j) {
+                if (neighbors(j) < 0)
+                    continue;
+                int idx = facet_idx[neighbors(j)];
+                if (idx >= 0 && ! visited[idx]) {
+                    visited[idx] = true;
+                    queue.emplace_back(facets[idx]);
+                }
+            }
         }
+        std::sort(surface_facets.begin(), surface_facets.end());
+        groups.emplace_back(std::move(surface_facets));
     }
-    this->calculate_stats();
-    if (newSurface.mesh.size() == 0) {
-        //return only this
-        NonplanarSurfaces nonplanar_surfaces;
-        nonplanar_surfaces.push_back(*this);
-        return nonplanar_surfaces;
-    } 
-    else {
-        //return union of this and recursion
-        NonplanarSurfaces nonplanar_surfaces = newSurface.group_surfaces();
-        nonplanar_surfaces.push_back(*this);
-        return nonplanar_surfaces;
-    }
-}
 
-void
-NonplanarSurface::mark_neighbor_surfaces(int id)
-{
-    //if already marked return
-    if(this->mesh.find(id) == this->mesh.end() || this->mesh[id].marked == true) return;
-    //mark this facet
-    this->mesh[id].marked = true;
-    //mark all neighbors
-    for(int j = 0; j < 3; j++) {
-        this->mark_neighbor_surfaces(this->mesh[id].neighbor[j]);
-    }
+    // Build the facet trees and projections of the surfaces in parallel.
+    // The surface containing the lowest facet ID goes last.
+    NonplanarSurfaces nonplanar_surfaces(groups.size());
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, groups.size()),
+        [&mesh, &groups, &nonplanar_surfaces](const tbb::blocked_range<size_t> &range) {
+            for (size_t i = range.begin(); i < range.end(); ++ i)
+                nonplanar_surfaces[groups.size() - i - 1] = std::make_shared<const NonplanarSurface>(mesh, std::move(groups[i]));
+        });
+    return nonplanar_surfaces;
 }
 
 bool
-NonplanarSurface::check_max_printing_height(float height) 
+NonplanarSurface::check_max_printing_height(float height) const
 {
     if ((this->stats.max.z - this->stats.min.z) > height ) {
         BOOST_LOG_TRIVIAL(trace) << "Surface removed: printheight too heigh (" << (this->stats.max.z - this->stats.min.z) << " mm)";
@@ -197,12 +141,18 @@ NonplanarSurface::check_max_printing_height(float height)
 }
 
 bool
-NonplanarSurface::check_surface_area()
+NonplanarSurface::check_surface_area() const
 {
     //calculate surface area of nonplanar surface.
     float area = 0.0f;
-    for(auto& facet : this->mesh) {
-        area += facet.second.calculate_surface_area();
+    for (int facet_id : this->facets) {
+        const Vec3f v0 = this->mesh->vertex(facet_id, 0);
+        const Vec3f v1 = this->mesh->vertex(facet_id, 1);
+        const Vec3f v2 = this->mesh->vertex(facet_id, 2);
+        area += Slic3r::Geometry::triangle_surface(
+            Point(double(v0.x()), double(v0.y())),
+            Point(double(v1.x()), double(v1.y())),
+            Point(double(v2.x()), double(v2.y())));
     }
     if (area < 20.0f) {
         BOOST_LOG_TRIVIAL(trace) << "Surface removed: area too small (" << area << " mm²)";
@@ -213,23 +163,24 @@ NonplanarSurface::check_surface_area()
 }
 
 void
-NonplanarSurface::check_printable_surfaces(float max_angle)
+NonplanarSurface::check_printable_surfaces(float max_angle) const
 {
     //TODO do something
 }
 
 /* this will return scaled ExPolygons */
 ExPolygons
-NonplanarSurface::horizontal_projection() const
+NonplanarSurface::calculate_horizontal_projection() const
 {
     Polygons pp;
-    pp.reserve(this->mesh.size());
-    for(auto& facet : this->mesh) {
+    pp.reserve(this->facets.size());
+    for (int facet_id : this->facets) {
         Polygon p;
         p.points.resize(3);
-        p.points[0] = Point(scale_(facet.second.vertex[0].x), scale_(facet.second.vertex[0].y));
-        p.points[1] = Point(scale_(facet.second.vertex[1].x), scale_(facet.second.vertex[1].y));
-        p.points[2] = Point(scale_(facet.second.vertex[2].x), scale_(facet.second.vertex[2].y));
+        for (int j = 0; j < 3; ++ j) {
+            const Vec3f v = this->mesh->vertex(facet_id, j);
+            p.points[j] = Point(scale_(v.x()), scale_(v.y()));
+        }
         p.make_counter_clockwise();  // do this after scaling, as winding order might change while doing that
         pp.push_back(p);
     }
@@ -238,4 +189,66 @@ NonplanarSurface::horizontal_projection() const
     return union_ex(offset(pp, scale_(0.01)));
 }
 
-}
\ No newline at end of file
+void
+NonplanarSurface::build_facets_tree()
+{
+    using BoundingBox = AABBTreeIndirect::Tree2f::BoundingBox;
+    using VectorType  = AABBTreeIndirect::Tree2f::VectorType;
+
+    struct InputType {
+        size_t              idx()       const { return m_idx; }
+        const BoundingBox&  bbox()      const { return m_bbox; }
+        const VectorType&   centroid()  const { return m_centroid; }
+
+        size_t      m_idx;
+        BoundingBox m_bbox;
+        VectorType  m_centroid;
+    };
+
+    // Inflate the bounding boxes a bit to account for numerical issues.
+    const Vec2f eps = Vec2f::Constant(float(EPSILON));
+    std::vector<InputType> input;
+    input.reserve(this->facets.size());
+    for (size_t i = 0; i < this->facets.size(); ++ i) {
+        const Vec3f v0 = this->mesh->vertex(this->facets[i], 0);
+        const Vec3f v1 = this->mesh->vertex(this->facets[i], 1);
+        const Vec3f v2 = this->mesh->vertex(this->facets[i], 2);
+        InputType n;
+        n.m_idx      = i;
+        n.m_bbox     = BoundingBox(v0.head<2>().cwiseMin(v1.head<2>()).cwiseMin(v2.head<2>()) - eps,
+                                   v0.head<2>().cwiseMax(v1.head<2>()).cwiseMax(v2.head<2>()) + eps);
+        n.m_centroid = n.m_bbox.center();
+        input.emplace_back(n);
+    }
+    m_facets_tree.build(std::move(input));
+}
+
+std::vector<int>
+NonplanarSurface::facets_at(const Vec2f &pt) const
+{
+    std::vector<size_t> candidates;
+    AABBTreeIndirect::get_candidate_idxs(m_facets_tree, pt, candidates);
+    std::vector<int> out;
+    out.reserve(candidates.size());
+    for (size_t idx : candidates)
+        out.emplace_back(this->facets[idx]);
+    // Keep the order of the facets stable, the projection gives priority to the facet with the highest ID.
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+std::vector<int>
+NonplanarSurface::facets_in_box(const Vec2f &min, const Vec2f &max) const
+{
+    std::vector<int> out;
+    AABBTreeIndirect::traverse(m_facets_tree, AABBTreeIndirect::intersecting(AABBTreeIndirect::Tree2f::BoundingBox(min, max)),
+        [this, &out](const AABBTreeIndirect::Tree2f::Node &node) {
+            out.emplace_back(this->facets[node.idx]);
+            // Continue traversal.
+            return true;
+        });
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+}
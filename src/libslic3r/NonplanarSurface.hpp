@@ -2,12 +2,15 @@
 #define slic3r_NonplanarSurface_hpp_
 
 #include "libslic3r.h"
-#include "NonplanarFacet.hpp"
 #include "Point.hpp"
 #include "Polygon.hpp"
 #include "ExPolygon.hpp"
 #include "Geometry.hpp"
 #include "ClipperUtils.hpp"
+#include "AABBTreeIndirect.hpp"
+#include "TriangleMesh.hpp"
+
+#include <memory>
 
 namespace Slic3r {
 
@@ -22,33 +25,74 @@ typedef struct {
   mesh_vertex    min;
 } mesh_stats;
 
+// Triangle mesh of a model volume, shared by all the nonplanar surfaces found on that volume.
+// The vertex and face buffers are referenced from the source mesh, only the per face normals
+// and neighbors are stored here. Vertices are returned shifted by z_offset, so that the bottom
+// of the object is at z = 0.
+class NonplanarMesh
+{
+public:
+    NonplanarMesh(std::shared_ptr<const TriangleMesh> mesh, float z_offset);
+
+    size_t       facets_count()                      const { return m_mesh->its.indices.size(); }
+    Vec3f        vertex(int facet_id, int idx)       const { return m_mesh->its.vertices[m_mesh->its.indices[facet_id](idx)] + Vec3f(0.f, 0.f, m_z_offset); }
+    const Vec3f& normal(int facet_id)                const { return m_normals[facet_id]; }
+    // Neighbor facet IDs, -1 if there is no neighbor at the respective edge.
+    const Vec3i& neighbors(int facet_id)             const { return m_neighbors[facet_id]; }
+    float        z_offset()                          const { return m_z_offset; }
+
+private:
+    std::shared_ptr<const TriangleMesh> m_mesh;
+    float                               m_z_offset;
+    std::vector<Vec3f>                  m_normals;
+    std::vector<Vec3i>                  m_neighbors;
+};
+
+using NonplanarMeshPtr = std::shared_ptr<const NonplanarMesh>;
+
 class NonplanarSurface;
 
-typedef std::vector<NonplanarSurface> NonplanarSurfaces;
+// Nonplanar surfaces are immutable once found, they are shared by the PrintObject and all the LayerRegions they are homed in.
+using NonplanarSurfacePtr = std::shared_ptr<const NonplanarSurface>;
+using NonplanarSurfaces   = std::vector<NonplanarSurfacePtr>;
 
 class NonplanarSurface
 {
     public:
-    std::map<int, NonplanarFacet> mesh;
+    // Source mesh of the facets.
+    NonplanarMeshPtr mesh;
+    // IDs of the facets of the mesh forming this surface, sorted in ascending order.
+    std::vector<int> facets;
     mesh_stats stats;
-    NonplanarSurface() {};
-    ~NonplanarSurface() {};
-    NonplanarSurface(std::map<int, NonplanarFacet> &_mesh);
-    bool operator==(const NonplanarSurface& other) const;
+
+    NonplanarSurface(NonplanarMeshPtr mesh, std::vector<int> facets);
+
+    // Split the facets into surfaces of edge connected facets.
+    // The surface containing the lowest facet ID is returned last.
+    static NonplanarSurfaces group_surfaces(const NonplanarMeshPtr &mesh, const std::vector<int> &facets);
+
+    void debug_output() const;
+    bool check_max_printing_height(float height) const;
+    void check_printable_surfaces(float max_angle) const;
+    bool check_surface_area() const;
+    // Union of the horizontal projections of the facets (scaled), calculated once when the surface is created.
+    const ExPolygons& horizontal_projection() const { return m_horizontal_projection; }
+
+    // IDs of facets, whose horizontal bounding box contains the point (unscaled), sorted in ascending order.
+    std::vector<int> facets_at(const Vec2f &pt) const;
+    // IDs of facets, whose horizontal bounding box intersects the box (unscaled), sorted in ascending order.
+    std::vector<int> facets_in_box(const Vec2f &min, const Vec2f &max) const;
+
+private:
     void calculate_stats();
-    void translate(float x, float y, float z);
-    void scale(float factor);
-    void scale(float versor[3]);
-    void rotate_z(float angle);
-    void debug_output();
-    NonplanarSurfaces group_surfaces();
-    void mark_neighbor_surfaces(int id);
-    bool check_max_printing_height(float height);
-    void check_printable_surfaces(float max_angle);
-    bool check_surface_area();
-    ExPolygons horizontal_projection() const;
+    // Build an AABB tree over the horizontal projections of the facets.
+    void build_facets_tree();
+    ExPolygons calculate_horizontal_projection() const;
 
+    // AABB tree over the horizontal projections of the facets, leaves reference this->facets.
+    AABBTreeIndirect::Tree2f m_facets_tree;
+    ExPolygons               m_horizontal_projection;
 };
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,290 @@
+#include "ParallelZipWriter.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <vector>
+
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+namespace Slic3r {
+
+namespace {
+
+struct Block
+{
+    // Uncompressed data, released once compressed.
+    std::string          data;
+    // Raw deflate stream of the data, flushed to a byte boundary, so that the blocks of an entry may be concatenated.
+    std::vector<uint8_t> compressed;
+    size_t               size   { 0 };
+    mz_uint32            crc    { MZ_CRC32_INIT };
+    // The last block of an entry finishes the deflate stream.
+    bool                 last   { false };
+    bool                 failed { false };
+    std::atomic<bool>    done   { false };
+};
+
+struct Entry
+{
+    explicit Entry(const std::string &name) : name(name) {}
+
+    std::string                         name;
+    std::vector<std::unique_ptr<Block>> blocks;
+    // All the blocks of the entry were added.
+    bool                                closed { false };
+};
+
+// Deflate a block independently of the other blocks of an entry, to be run on a worker thread.
+void compress_block(Block &block, int level)
+{
+    block.crc = mz_uint32(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(block.data.data()), block.data.size()));
+    try {
+        auto compressor = std::make_unique<tdefl_compressor>();
+        tdefl_put_buf_func_ptr put_buf = [](const void *buf, int len, void *user) -> mz_bool {
+            try {
+                auto &out = *static_cast<std::vector<uint8_t>*>(user);
+                out.insert(out.end(), static_cast<const uint8_t*>(buf), static_cast<const uint8_t*>(buf) + len);
+                return MZ_TRUE;
+            } catch (...) {
+                return MZ_FALSE;
+            }
+        };
+        tdefl_status status = tdefl_init(compressor.get(), put_buf, &block.compressed,
+            tdefl_create_comp_flags_from_zip_params(level, -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+        if (status == TDEFL_STATUS_OKAY)
+            // A sync flush ends the block on a byte boundary without marking it as the final one.
+            status = tdefl_compress_buffer(compressor.get(), block.data.data(), block.data.size(), block.last ? TDEFL_FINISH : TDEFL_SYNC_FLUSH);
+        block.failed = status != (block.last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY);
+    } catch (...) {
+        block.failed = true;
+    }
+    std::string().swap(block.data);
+}
+
+uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    for (; vec != 0; vec >>= 1, ++ mat)
+        if (vec & 1)
+            sum ^= *mat;
+    return sum;
+}
+
+void gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+    for (int n = 0; n < 32; ++ n)
+        square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+// CRC32 of a concatenation of two buffers from their CRC32s and the length of the second buffer, see crc32_combine() of zlib.
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    if (len2 == 0)
+        return crc1;
+
+    // Operator for a single zero bit.
+    uint32_t odd[32];
+    odd[0] = 0xedb88320u;
+    for (uint32_t n = 1, row = 1; n < 32; ++ n, row <<= 1)
+        odd[n] = row;
+    // Operators for two and four zero bits.
+    uint32_t even[32];
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // Apply len2 zero bytes to crc1, the first square puts the operator for one zero byte into even.
+    for (;;) {
+        gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(even, crc1);
+        if ((len2 >>= 1) == 0)
+            break;
+        gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(odd, crc1);
+        if ((len2 >>= 1) == 0)
+            break;
+    }
+    return crc1 ^ crc2;
+}
+
+} // namespace
+
+class ParallelZipWriter::Impl
+{
+public:
+    Impl(mz_zip_archive &archive, int level) :
+        archive(archive), level(level < 0 ? MZ_DEFAULT_LEVEL : std::min(level, int(MZ_UBER_COMPRESSION))) {}
+    ~Impl() { tasks.wait(); }
+
+    void add_block(std::string &&data, bool last);
+    bool write_ready();
+
+    mz_zip_archive          &archive;
+    const int                level;
+    tbb::task_group          tasks;
+    // Blocks being compressed.
+    std::atomic<size_t>      num_running { 0 };
+    // Entries not written into the archive yet, the last one may be open.
+    std::deque<Entry>        entries;
+    // Data appended to an open entry, not filling a block yet.
+    std::string              buffer;
+    bool                     open   { false };
+    bool                     failed { false };
+
+private:
+    bool write_entry(Entry &entry);
+};
+
+void ParallelZipWriter::Impl::add_block(std::string &&data, bool last)
+{
+    assert(! entries.empty() && ! entries.back().closed);
+    // Limit the amount of uncompressed data held in memory.
+    if (num_running >= 2 * size_t(tbb::this_task_arena::max_concurrency()))
+        tasks.wait();
+
+    Block &block = *entries.back().blocks.emplace_back(std::make_unique<Block>());
+    block.size = data.size();
+    block.data = std::move(data);
+    block.last = last;
+    if (level == MZ_NO_COMPRESSION) {
+        // Stored by miniz when the entry is written.
+        block.done = true;
+        return;
+    }
+    ++ num_running;
+    tasks.run([this, &block]() {
+        compress_block(block, level);
+        block.done.store(true, std::memory_order_release);
+        -- num_running;
+    });
+}
+
+bool ParallelZipWriter::Impl::write_ready()
+{
+    while (! entries.empty()) {
+        Entry &entry = entries.front();
+        if (! entry.closed || ! std::all_of(entry.blocks.begin(), entry.blocks.end(),
+                [](const std::unique_ptr<Block> &block) { return block->done.load(std::memory_order_acquire); }))
+            break;
+        // Once writing an entry failed, the following entries are dropped.
+        if (! failed && ! write_entry(entry))
+            failed = true;
+        entries.pop_front();
+    }
+    return ! failed;
+}
+
+bool ParallelZipWriter::Impl::write_entry(Entry &entry)
+{
+    size_t    size = 0;
+    mz_uint32 crc  = MZ_CRC32_INIT;
+    for (const std::unique_ptr<Block> &block : entry.blocks) {
+        if (block->failed) {
+            archive.m_last_error = MZ_ZIP_COMPRESSION_FAILED;
+            return false;
+        }
+        crc   = crc32_combine(crc, block->crc, block->size);
+        size += block->size;
+    }
+
+    auto concatenate = [&entry](auto member) {
+        auto out = std::move(entry.blocks.front().get()->*member);
+        for (size_t i = 1; i < entry.blocks.size(); ++ i) {
+            auto &data = entry.blocks[i].get()->*member;
+            out.insert(out.end(), data.begin(), data.end());
+            decltype(out)().swap(data);
+        }
+        return out;
+    };
+
+    if (level == MZ_NO_COMPRESSION || size == 0) {
+        // Let miniz store the data and handle the empty entries.
+        std::string data = concatenate(&Block::data);
+        return mz_zip_writer_add_mem(&archive, entry.name.c_str(), data.data(), data.size(), mz_uint(level));
+    }
+
+    std::vector<uint8_t> compressed = concatenate(&Block::compressed);
+    return mz_zip_writer_add_mem_ex_v2(&archive, entry.name.c_str(), compressed.data(), compressed.size(), nullptr, 0,
+        mz_uint(level) | MZ_ZIP_FLAG_COMPRESSED_DATA, size, crc, nullptr, nullptr, 0, nullptr, 0);
+}
+
+ParallelZipWriter::ParallelZipWriter(mz_zip_archive &archive, int level) : m_impl(std::make_unique<Impl>(archive, level)) {}
+
+ParallelZipWriter::~ParallelZipWriter() = default;
+
+bool ParallelZipWriter::add_entry(const std::string &name, const void *data, size_t size)
+{
+    assert(! m_impl->open);
+    m_impl->entries.emplace_back(name);
+    const char *src = static_cast<const char*>(data);
+    size_t      offset = 0;
+    do {
+        size_t n = std::min(size - offset, BlockSize);
+        m_impl->add_block(std::string(src + offset, n), offset + n == size);
+        offset += n;
+    } while (offset < size);
+    m_impl->entries.back().closed = true;
+    return m_impl->write_ready();
+}
+
+bool ParallelZipWriter::add_entry(const std::string &name, std::string &&data)
+{
+    if (data.size() > BlockSize)
+        return this->add_entry(name, data.data(), data.size());
+    assert(! m_impl->open);
+    m_impl->entries.emplace_back(name);
+    m_impl->add_block(std::move(data), true);
+    m_impl->entries.back().closed = true;
+    return m_impl->write_ready();
+}
+
+bool ParallelZipWriter::open_entry(const std::string &name)
+{
+    assert(! m_impl->open);
+    m_impl->entries.emplace_back(name);
+    m_impl->open = true;
+    m_impl->buffer.clear();
+    m_impl->buffer.reserve(BlockSize);
+    return ! m_impl->failed;
+}
+
+bool ParallelZipWriter::append(const void *data, size_t size)
+{
+    assert(m_impl->open);
+    const char *src = static_cast<const char*>(data);
+    while (size > 0) {
+        size_t n = std::min(size, BlockSize - m_impl->buffer.size());
+        m_impl->buffer.append(src, n);
+        src  += n;
+        size -= n;
+        if (m_impl->buffer.size() == BlockSize) {
+            m_impl->add_block(std::move(m_impl->buffer), false);
+            m_impl->buffer = std::string();
+            m_impl->buffer.reserve(BlockSize);
+        }
+    }
+    return m_impl->write_ready();
+}
+
+bool ParallelZipWriter::close_entry()
+{
+    assert(m_impl->open);
+    m_impl->add_block(std::move(m_impl->buffer), true);
+    m_impl->buffer = std::string();
+    m_impl->entries.back().closed = true;
+    m_impl->open = false;
+    return m_impl->write_ready();
+}
+
+bool ParallelZipWriter::flush()
+{
+    assert(! m_impl->open);
+    m_impl->tasks.wait();
+    return m_impl->write_ready();
+}
+
+} // namespace Slic3r
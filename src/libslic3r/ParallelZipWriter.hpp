@@ -0,0 +1,51 @@
+#ifndef slic3r_ParallelZipWriter_hpp_
+#define slic3r_ParallelZipWriter_hpp_
+
+#include <memory>
+#include <string>
+
+#include <miniz.h>
+
+namespace Slic3r {
+
+// Writes entries into a zip archive opened for writing, deflating them on worker threads.
+// The entries are appended to the archive in the order they were added. The data of an entry is split into blocks
+// of BlockSize bytes, which are deflated independently and concatenated into a single deflate stream,
+// thus a single large entry is compressed in parallel as well. The archive itself is only accessed from the thread
+// calling the methods of this class.
+class ParallelZipWriter
+{
+public:
+    static constexpr size_t BlockSize = 1024 * 1024;
+
+    // level is a miniz compression level (MZ_NO_COMPRESSION to MZ_UBER_COMPRESSION, or MZ_DEFAULT_COMPRESSION).
+    ParallelZipWriter(mz_zip_archive &archive, int level);
+    // Waits for the running compression tasks. The entries not written by flush() yet are dropped.
+    ~ParallelZipWriter();
+
+    ParallelZipWriter(const ParallelZipWriter&) = delete;
+    ParallelZipWriter& operator=(const ParallelZipWriter&) = delete;
+
+    // Adds an entry with the given data, which is copied or moved. The entry is written into the archive
+    // once it is compressed and all the entries added before it are written.
+    // Returns false if writing of an entry failed, the miniz error is stored in the archive.
+    bool add_entry(const std::string &name, const void *data, size_t size);
+    bool add_entry(const std::string &name, std::string &&data);
+
+    // Adds an entry, the data of which is supplied piecewise by append() until close_entry() is called.
+    bool open_entry(const std::string &name);
+    bool append(const void *data, size_t size);
+    bool close_entry();
+
+    // Waits for all the entries to be compressed and writes them into the archive.
+    // To be called before the archive is finalized.
+    bool flush();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_ParallelZipWriter_hpp_
@@ -7,6 +7,8 @@
 #include <iomanip>
 #include <sstream>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 #ifdef _MSC_VER
     #include <stdlib.h>  // provides **_environ
 #else
@@ -792,6 +794,9 @@ namespace client
         // If false, the macro_processor will evaluate a full macro.
         // If true, the macro processor will evaluate just a boolean condition using the full expressive power of the macro processor.
         bool                     just_boolean_expression = false;
+        // If set, the source of a compiled PlaceholderParser::Program, parts of which are being parsed.
+        // Errors are reported relative to the complete source.
+        const std::string       *source                 = nullptr;
         std::string              error_message;
 
         // Table to translate symbol tag to a human readable error message.
@@ -1562,8 +1567,12 @@ namespace client
             boost::throw_exception(qi::expectation_failure(it_range.begin(), it_range.end(), spirit::info(std::string("*") + msg)));
         }
 
-        static void process_error_message(const MyContext *context, const boost::spirit::info &info, const Iterator &it_begin, const Iterator &it_end, const Iterator &it_error)
+        static void process_error_message(const MyContext *context, const boost::spirit::info &info, Iterator it_begin, Iterator it_end, const Iterator &it_error)
         {
+            if (context->source != nullptr) {
+                it_begin = context->source->begin();
+                it_end   = context->source->end();
+            }
             std::string &msg = const_cast<MyContext*>(context)->error_message;
             std::string  first(it_begin, it_error);
             std::string  last(it_error, it_end);
@@ -2341,7 +2350,335 @@ static std::string process_macro(const std::string &templ, client::MyContext &co
     return output;
 }
 
+// Template split into a sequence of top level operations. Free-form text and references to variables are evaluated
+// without running the Spirit grammar, the code blocks and the {if}...{endif} constructs spanning multiple blocks are
+// parsed by the grammar as if they were stand-alone templates.
+class PlaceholderParser::Program
+{
+public:
+    enum class OpType {
+        // Free-form text, copied to the output.
+        Text,
+        // [key]
+        LegacyVariable,
+        // [key[index_key]]
+        LegacyVectorVariable,
+        // {key} or {key[index]}
+        Variable,
+        // Anything else, evaluated by the grammar.
+        Code,
+    };
+
+    struct Op {
+        OpType                  type;
+        // Range of the source covered by this operation.
+        client::IteratorRange   range;
+        client::IteratorRange   key;
+        client::IteratorRange   index_key;
+        // Constant index of a vector variable, -1 if not indexed.
+        int                     index { -1 };
+    };
+
+    explicit Program(const std::string &templ) : source(templ) {}
+    // The operations point into the source.
+    Program(const Program &) = delete;
+    Program& operator=(const Program &) = delete;
+
+    const std::string       source;
+    std::vector<Op>         ops;
+};
+
+namespace client {
+    static bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    static bool is_identifier_start(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+    static bool is_identifier_char(char c) { return is_identifier_start(c) || (c >= '0' && c <= '9'); }
+
+    static Iterator skip_whitespaces(Iterator it, Iterator end)
+    {
+        while (it != end && is_whitespace(*it))
+            ++ it;
+        return it;
+    }
+
+    // Skip a single UTF-8 character the same way utf8_char_parser does. Returns false on an invalid UTF-8 sequence.
+    static bool skip_utf8_char(Iterator &it, Iterator end)
+    {
+        unsigned char c = static_cast<unsigned char>(*it ++);
+        if ((c & 0xC0) == 0x80)
+            return false;
+        unsigned int cnt = 0;
+        for (unsigned char mask = 0x80u; c & mask; mask >>= 1)
+            ++ cnt;
+        cnt = (cnt == 0) ? 1 : std::min(cnt, 4u);
+        for (-- cnt; cnt > 0; -- cnt) {
+            if (it == end)
+                return false;
+            c = static_cast<unsigned char>(*it ++);
+            if (cnt > 1 && (c & 0xC0) != 0x80)
+                return false;
+        }
+        return true;
+    }
+
+    // Parse an identifier, which is not a keyword of the macro language.
+    static bool parse_identifier(Iterator &it, Iterator end, IteratorRange &out)
+    {
+        if (it == end || ! is_identifier_start(*it))
+            return false;
+        Iterator begin = it;
+        while (it != end && is_identifier_char(*it))
+            ++ it;
+        out = IteratorRange(begin, it);
+        return g_macro_processor_instance.keywords.find(std::string(begin, it)) == nullptr;
+    }
+
+    // Parse the body of a legacy variable expansion [key] or [key[index_key]], "it" pointing after the opening bracket.
+    // Mirrors the legacy_variable_expansion rule.
+    static bool parse_legacy_variable(Iterator &it, Iterator end, PlaceholderParser::Program::Op &op)
+    {
+        it = skip_whitespaces(it, end);
+        if (! parse_identifier(it, end, op.key))
+            return false;
+        it = skip_whitespaces(it, end);
+        op.type = PlaceholderParser::Program::OpType::LegacyVariable;
+        if (it != end && *it == '[') {
+            it = skip_whitespaces(++ it, end);
+            if (! parse_identifier(it, end, op.index_key))
+                return false;
+            it = skip_whitespaces(it, end);
+            if (it == end || *it != ']')
+                return false;
+            it = skip_whitespaces(++ it, end);
+            op.type = PlaceholderParser::Program::OpType::LegacyVectorVariable;
+        }
+        if (it == end || *it != ']')
+            return false;
+        ++ it;
+        return true;
+    }
+
+    // Find the closing brace of a code block, "it" pointing after the opening brace. String literals and regular expressions
+    // are skipped. Returns the number of "if" keywords minus the number of "endif" keywords and the first keyword or identifier
+    // of the block. Returns false if the block is not terminated.
+    static bool scan_code_block(Iterator &it, Iterator end, int &if_depth, IteratorRange &first_word)
+    {
+        bool first = true;
+        // Last non-whitespace character, to distinguish a regular expression from a division.
+        char last  = 0;
+        while (it != end) {
+            char c = *it;
+            if (c == '}') {
+                ++ it;
+                return true;
+            } else if (c == '"' || (c == '/' && (last == '~' || last == ','))) {
+                // String literal or regular expression, backslash escapes the next character.
+                for (++ it; it != end && *it != c; ++ it)
+                    if (*it == '\\' && ++ it == end)
+                        return false;
+                if (it == end)
+                    return false;
+                ++ it;
+            } else if (is_identifier_start(c)) {
+                Iterator begin = it;
+                while (it != end && is_identifier_char(*it))
+                    ++ it;
+                IteratorRange word(begin, it);
+                if (boost::equals(word, "if"))
+                    ++ if_depth;
+                else if (boost::equals(word, "endif"))
+                    -- if_depth;
+                if (first)
+                    first_word = word;
+            } else if (c >= '0' && c <= '9') {
+                // Numeric literal including an exponent.
+                while (it != end && (is_identifier_char(*it) || *it == '.'))
+                    ++ it;
+            } else
+                ++ it;
+            if (! is_whitespace(c)) {
+                last  = c;
+                first = false;
+            }
+        }
+        return false;
+    }
+
+    // Is the code block a reference to a scalar variable {key} or to an element of a vector variable {key[index]}?
+    // Mirrors the statement -> unary_expression -> variable_reference path of the grammar.
+    static bool parse_variable_reference(Iterator it, Iterator end, PlaceholderParser::Program::Op &op)
+    {
+        it = skip_whitespaces(it, end);
+        if (! parse_identifier(it, end, op.key))
+            return false;
+        it = skip_whitespaces(it, end);
+        if (it != end && *it == '[') {
+            it = skip_whitespaces(++ it, end);
+            Iterator begin = it;
+            while (it != end && *it >= '0' && *it <= '9')
+                ++ it;
+            // Leave the negative indices and indices overflowing int to the grammar.
+            if (it == begin || it - begin > 9)
+                return false;
+            op.index = std::stoi(std::string(begin, it));
+            it = skip_whitespaces(it, end);
+            if (it == end || *it != ']')
+                return false;
+            it = skip_whitespaces(++ it, end);
+        }
+        if (it == end || *it != '}' || it + 1 != end)
+            return false;
+        op.type = PlaceholderParser::Program::OpType::Variable;
+        return true;
+    }
+
+    // Split the source into the top level operations. Returns false if the source is not understood, then it shall be
+    // evaluated by the grammar as a whole to report the error the usual way.
+    static bool compile_program(const std::string &source, std::vector<PlaceholderParser::Program::Op> &ops)
+    {
+        using Op     = PlaceholderParser::Program::Op;
+        using OpType = PlaceholderParser::Program::OpType;
+        const Iterator end = source.end();
+        // The grammar drops the leading white spaces with the skipper, which rejects non-ASCII7 characters.
+        Iterator it = skip_whitespaces(source.begin(), end);
+        if (it != end && static_cast<unsigned char>(*it) >= 0x80)
+            return false;
+        while (it != end) {
+            Op       op;
+            Iterator begin = it;
+            if (*it == '[') {
+                if (! parse_legacy_variable(++ it, end, op))
+                    return false;
+            } else if (*it == '{') {
+                int           if_depth = 0;
+                IteratorRange first_word;
+                if (! scan_code_block(++ it, end, if_depth, first_word) || boost::equals(first_word, "else") || 
+                    boost::equals(first_word, "elsif") || boost::equals(first_word, "endif") || if_depth < 0)
+                    return false;
+                // Extend the operation over the blocks and the text up to the matching {endif}.
+                while (if_depth > 0) {
+                    while (it != end && *it != '{')
+                        ++ it;
+                    if (it == end || ! scan_code_block(++ it, end, if_depth, first_word) || if_depth < 0)
+                        return false;
+                }
+                op.type = OpType::Code;
+                parse_variable_reference(begin + 1, it, op);
+            } else {
+                // Free-form text up to the first brace.
+                while (it != end && *it != '[' && *it != '{')
+                    if (! skip_utf8_char(it, end))
+                        return false;
+                op.type = OpType::Text;
+            }
+            op.range = IteratorRange(begin, it);
+            ops.emplace_back(op);
+        }
+        return true;
+    }
+}
+
+PlaceholderParser::ProgramPtr PlaceholderParser::compile(const std::string &templ)
+{
+    auto program = std::make_shared<Program>(templ);
+    if (! client::compile_program(program->source, program->ops)) {
+        program->ops.clear();
+        Program::Op op { Program::OpType::Code, client::IteratorRange(program->source.begin(), program->source.end()) };
+        program->ops.emplace_back(op);
+    }
+    return program;
+}
+
+// Compiled programs shared by all PlaceholderParser instances, the programs do not depend on the configuration.
+static std::mutex                                                       g_program_cache_mutex;
+static std::unordered_map<std::string, PlaceholderParser::ProgramPtr>   g_program_cache;
+// The templates are taken from the configuration, thus only a handful of them are being evaluated repeatedly.
+// Limit the cache size in case the templates are edited or generated.
+static constexpr size_t                                                 g_program_cache_max_size = 256;
+
+PlaceholderParser::ProgramPtr PlaceholderParser::compile_cached(const std::string &templ)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_program_cache_mutex);
+        if (auto it = g_program_cache.find(templ); it != g_program_cache.end())
+            return it->second;
+    }
+    ProgramPtr program = compile(templ);
+    std::lock_guard<std::mutex> lock(g_program_cache_mutex);
+    if (g_program_cache.size() >= g_program_cache_max_size)
+        g_program_cache.clear();
+    g_program_cache.emplace(templ, program);
+    return program;
+}
+
+std::string PlaceholderParser::process(const Program &program, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context_data) const
+{
+    client::MyContext context;
+    context.external_config 	= this->external_config();
+    context.config              = &this->config();
+    context.config_override     = config_override;
+    context.config_outputs      = config_outputs;
+    context.current_extruder_id = current_extruder_id;
+    context.context_data        = context_data;
+    context.source              = &program.source;
+
+    std::string output;
+    std::string value;
+    try {
+        for (auto it_op = program.ops.begin(); it_op != program.ops.end() && context.error_message.empty(); ++ it_op) {
+            const Program::Op &op = *it_op;
+            // The key ranges are passed by a non-const reference to the grammar actions.
+            client::IteratorRange key       = op.key;
+            client::IteratorRange index_key = op.index_key;
+            value.clear();
+            switch (op.type) {
+            case Program::OpType::Text:
+                output.append(op.range.begin(), op.range.end());
+                continue;
+            case Program::OpType::LegacyVariable:
+                client::MyContext::legacy_variable_expansion(&context, key, value);
+                break;
+            case Program::OpType::LegacyVectorVariable:
+                client::MyContext::legacy_variable_expansion2(&context, key, index_key, value);
+                break;
+            case Program::OpType::Variable:
+            {
+                client::OptWithPos opt;
+                client::MyContext::resolve_variable(&context, key, opt);
+                if (op.index >= 0) {
+                    client::OptWithPos opt_indexed;
+                    client::MyContext::store_variable_index(&context, opt, op.index, op.range.end(), opt_indexed);
+                    opt = opt_indexed;
+                }
+                client::expr expr;
+                client::MyContext::variable_value(&context, opt, expr);
+                client::expr::to_string2(expr, value);
+                break;
+            }
+            case Program::OpType::Code:
+                // Parse errors are reported through context.error_message.
+                phrase_parse(op.range.begin(), op.range.end(), g_macro_processor_instance(&context), client::skipper{}, value);
+                break;
+            }
+            output += value;
+        }
+    } catch (qi::expectation_failure<client::Iterator> const &err) {
+        // Thrown by the grammar actions evaluating the variables, report it the same way the grammar does.
+        client::MyContext::process_error_message(&context, err.what_, program.source.begin(), program.source.end(), err.first);
+    }
+	if (! context.error_message.empty()) {
+        if (context.error_message.back() != '\n' && context.error_message.back() != '\r')
+            context.error_message += '\n';
+        throw Slic3r::PlaceholderParserError(context.error_message);
+    }
+    return output;
+}
+
 std::string PlaceholderParser::process(const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context_data) const
+{
+    return this->process(*compile_cached(templ), current_extruder_id, config_override, config_outputs, context_data);
+}
+
+std::string PlaceholderParser::interpret(const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context_data) const
 {
     client::MyContext context;
     context.external_config 	= this->external_config();
@@ -3,6 +3,7 @@
 
 #include "libslic3r.h"
 #include <map>
+#include <memory>
 #include <random>
 #include <string>
 #include <string_view>
@@ -56,11 +57,24 @@ public:
     // External config is not owned by PlaceholderParser. It has a lowest priority when looking up an option.
 	const DynamicConfig*	external_config() const  			{ return m_external_config; }
 
+    // Template split into text, variable references and code blocks, so that it may be evaluated repeatedly
+    // without parsing the text and the variable references again.
+    class Program;
+    using ProgramPtr = std::shared_ptr<const Program>;
+    // Syntax errors are not reported by compile(), but when the program is evaluated.
+    static ProgramPtr compile(const std::string &templ);
+    // Returns a program compiled from templ by an earlier call or compiles a new one.
+    static ProgramPtr compile_cached(const std::string &templ);
+
     // Fill in the template using a macro processing language.
+    // The template is compiled once and cached for the subsequent invocations with the same template.
     // Throws Slic3r::PlaceholderParserError on syntax or runtime error.
     std::string process(const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context) const;
     std::string process(const std::string &templ, unsigned int current_extruder_id = 0, const DynamicConfig *config_override = nullptr, ContextData *context = nullptr) const
         { return this->process(templ, current_extruder_id, config_override, nullptr /* config_outputs */, context); }
+    std::string process(const Program &program, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context) const;
+    // Fill in the template by parsing it as a whole, without compiling it. Produces the same result as process().
+    std::string interpret(const std::string &templ, unsigned int current_extruder_id, const DynamicConfig *config_override, DynamicConfig *config_outputs, ContextData *context) const;
 
     // Evaluate a boolean expression using the full expressive power of the PlaceholderParser boolean expression syntax.
     // Throws Slic3r::PlaceholderParserError on syntax or runtime error.
@@ -5,6 +5,7 @@
 #include "Line.hpp"
 #include "Polygon.hpp"
 #include "SVG.hpp"
+#include <functional>
 #include <iostream>
 #include <utility>
 
@@ -46,14 +47,18 @@ void Polyline::clip_end(double distance)
     while (distance > 0) {
         Vec2d  last_point = this->last_point().cast<double>();
         this->points.pop_back();
+        coord_t last_z = this->last_z();
+        if (this->has_z())
+            this->z.pop_back();
         if (this->points.empty())
             break;
         Vec2d  v    = this->last_point().cast<double>() - last_point;
         double lsqr = v.squaredNorm();
         if (lsqr > distance * distance) {
-            Point p((last_point + v * (distance / sqrt(lsqr))).cast<coord_t>());
-            p.nonplanar_z = this->last_point().nonplanar_z;
-            this->points.emplace_back(p);
+            double t = distance / sqrt(lsqr);
+            this->points.emplace_back((last_point + v * t).cast<coord_t>());
+            if (this->has_z())
+                this->z.emplace_back(last_z == -1 || this->z.back() == -1 ? this->z.back() : coord_t(last_z + (this->z.back() - last_z) * t));
             return;
         }
         distance -= sqrt(lsqr);
@@ -104,18 +109,65 @@ Points Polyline::equally_spaced_points(double distance) const
             continue;
         }
         double take = segment_length - (len - distance);  // how much we take of this segment
-        Point p((p1 + v * (take / v.norm())).cast<coord_t>());
-        p.nonplanar_z = (*it).nonplanar_z;
-        points.emplace_back(p);
+        points.emplace_back((p1 + v * (take / v.norm())).cast<coord_t>());
         -- it;
         len = - take;
     }
     return points;
 }
 
+bool Polyline::remove_duplicate_points()
+{
+    if (! this->has_z())
+        return MultiPoint::remove_duplicate_points();
+    assert(this->z.size() == this->points.size());
+    size_t j = 0;
+    for (size_t i = 1; i < this->points.size(); ++ i) {
+        if (this->points[j] == this->points[i] && this->z[j] == this->z[i]) {
+            // Just increase index i.
+        } else {
+            ++ j;
+            if (j < i) {
+                this->points[j] = this->points[i];
+                this->z[j]      = this->z[i];
+            }
+        }
+    }
+    if (++ j < this->points.size()) {
+        this->points.erase(this->points.begin() + j, this->points.end());
+        this->z.erase(this->z.begin() + j, this->z.end());
+        return true;
+    }
+    return false;
+}
+
 void Polyline::simplify(double tolerance)
 {
-    this->points = MultiPoint::douglas_peucker(this->points, tolerance);
+    if (this->has_z()) {
+        // Only simplify a nonplanar polyline if all its points above the Z of the layer (z != -1) share a single Z.
+        coord_t z_plane = -1;
+        for (coord_t z : this->z)
+            if (z != -1) {
+                if (z_plane == -1)
+                    z_plane = z;
+                else if (z != z_plane)
+                    return;
+            }
+        Points simplified = MultiPoint::douglas_peucker(this->points, tolerance);
+        // The simplified points are a subsequence of the source points, the retained points keep their Z.
+        std::vector<coord_t> simplified_z;
+        simplified_z.reserve(simplified.size());
+        size_t idx = 0;
+        for (const Point &pt : simplified) {
+            while (this->points[idx] != pt)
+                ++ idx;
+            assert(idx < this->points.size());
+            simplified_z.emplace_back(this->z[idx ++]);
+        }
+        this->points = std::move(simplified);
+        this->z      = std::move(simplified_z);
+    } else
+        this->points = MultiPoint::douglas_peucker(this->points, tolerance);
 }
 
 #if 0
@@ -147,6 +199,7 @@ void Polyline::split_at(const Point &point, Polyline* p1, Polyline* p2) const
     if (this->size() < 2) {
         *p1 = *this;
         p2->clear();
+        p2->z.clear();
         return;
     }
 
@@ -175,6 +228,26 @@ void Polyline::split_at(const Point &point, Polyline* p1, Polyline* p2) const
     if (*min_point_it == point)
         ++ min_point_it;
     p2->points.insert(p2->points.end(), min_point_it, this->points.cend());
+
+    if (this->has_z()) {
+        // Interpolate Z of the split point along the segment it has been projected to.
+        size_t   idx   = p1->points.size() - 1;
+        coord_t  z_pt  = this->z[std::min(idx, this->z.size() - 1)];
+        if (idx > 0 && idx < this->points.size() && this->z[idx - 1] != -1 && this->z[idx] != -1) {
+            const Vec2d  a  = this->points[idx - 1].cast<double>();
+            const Vec2d  v  = this->points[idx].cast<double>() - a;
+            const double l2 = v.squaredNorm();
+            const double t  = l2 > 0. ? std::clamp((point.cast<double>() - a).dot(v) / l2, 0., 1.) : 0.;
+            z_pt = coord_t(this->z[idx - 1] + (this->z[idx] - this->z[idx - 1]) * t);
+        }
+        p1->z.assign(this->z.cbegin(), this->z.cbegin() + idx);
+        p1->z.emplace_back(z_pt);
+        p2->z = { z_pt };
+        p2->z.insert(p2->z.end(), this->z.cend() - (p2->points.size() - 1), this->z.cend());
+    } else {
+        p1->z.clear();
+        p2->z.clear();
+    }
 }
 
 bool Polyline::is_straight() const
@@ -251,7 +324,6 @@ std::pair<int, Point> foot_pt(const Points &polyline, const Point &pt)
         if (double d2 = line_alg::distance_to_squared(Line(prev, *it), pt, &foot_pt); d2 < d2_min) {
             d2_min      = d2;
             foot_pt_min = foot_pt;
-            foot_pt_min.nonplanar_z = (*it).nonplanar_z;
             it_proj     = it;
         }
         prev = *it;
@@ -277,7 +349,6 @@ void ThickPolyline::clip_end(double distance)
         assert(this->width.size() == (this->points.size() - 1) * 2);
         while (distance > 0) {
             Vec2d last_point = this->last_point().cast<double>();
-            coord_t last_z = this->last_point().nonplanar_z;
             this->points.pop_back();
             if (this->points.empty()) {
                 assert(this->width.empty());
@@ -291,9 +362,7 @@ void ThickPolyline::clip_end(double distance)
             double   vec_length_sqr = vec.squaredNorm();
             if (vec_length_sqr > distance * distance) {
                 double t = (distance / std::sqrt(vec_length_sqr));
-                Point p((last_point + vec * t).cast<coord_t>());
-                p.nonplanar_z = last_z;
-                this->points.emplace_back(p);
+                this->points.emplace_back((last_point + vec * t).cast<coord_t>());
                 this->width.emplace_back(last_width + width_diff * t);
                 assert(this->width.size() == (this->points.size() - 1) * 2);
                 return;
@@ -16,15 +16,19 @@ typedef std::vector<ThickPolyline> ThickPolylines;
 
 class Polyline : public MultiPoint {
 public:
+    // Z coordinates of the points of a nonplanar extrusion, -1 for a point at the Z of its layer.
+    // Empty for a planar polyline, otherwise of the same size as points.
+    std::vector<coord_t> z;
+
     Polyline() = default;
-    Polyline(const Polyline &other) : MultiPoint(other.points) {}
-    Polyline(Polyline &&other) : MultiPoint(std::move(other.points)) {}
+    Polyline(const Polyline &other) : MultiPoint(other.points), z(other.z) {}
+    Polyline(Polyline &&other) : MultiPoint(std::move(other.points)), z(std::move(other.z)) {}
     Polyline(std::initializer_list<Point> list) : MultiPoint(list) {}
     explicit Polyline(const Point &p1, const Point &p2) { points.reserve(2); points.emplace_back(p1); points.emplace_back(p2); }
     explicit Polyline(const Points &points) : MultiPoint(points) {}
     explicit Polyline(Points &&points) : MultiPoint(std::move(points)) {}
-    Polyline& operator=(const Polyline &other) { points = other.points; return *this; }
-    Polyline& operator=(Polyline &&other) { points = std::move(other.points); return *this; }
+    Polyline& operator=(const Polyline &other) { points = other.points; z = other.z; return *this; }
+    Polyline& operator=(Polyline &&other) { points = std::move(other.points); z = std::move(other.z); return *this; }
 	static Polyline new_scale(const std::vector<Vec2d> &points) {
 		Polyline pl;
 		pl.points.reserve(points.size());
@@ -33,20 +37,25 @@ public:
 		return pl;
     }
     
-    void append(const Point &point) { this->points.push_back(point); }
+    // Points appended to a nonplanar polyline are placed at the Z of the layer.
+    void append(const Point &point) { this->points.push_back(point); if (! this->z.empty()) this->z.push_back(-1); }
     void append(const Points &src) { this->append(src.begin(), src.end()); }
-    void append(const Points::const_iterator &begin, const Points::const_iterator &end) { this->points.insert(this->points.end(), begin, end); }
+    void append(const Points::const_iterator &begin, const Points::const_iterator &end) { this->points.insert(this->points.end(), begin, end); if (! this->z.empty()) this->z.resize(this->points.size(), -1); }
     void append(Points &&src)
     {
         if (this->points.empty()) {
             this->points = std::move(src);
+            this->z.clear();
         } else {
             this->points.insert(this->points.end(), src.begin(), src.end());
             src.clear();
+            if (! this->z.empty())
+                this->z.resize(this->points.size(), -1);
         }
     }
     void append(const Polyline &src) 
     { 
+        this->append_z(src);
         points.insert(points.end(), src.points.begin(), src.points.end());
     }
 
@@ -54,15 +63,28 @@ public:
     {
         if (this->points.empty()) {
             this->points = std::move(src.points);
+            this->z      = std::move(src.z);
         } else {
+            this->append_z(src);
             this->points.insert(this->points.end(), src.points.begin(), src.points.end());
             src.points.clear();
+            src.z.clear();
         }
     }
   
     Point& operator[](Points::size_type idx) { return this->points[idx]; }
     const Point& operator[](Points::size_type idx) const { return this->points[idx]; }
 
+    bool    has_z() const { return ! this->z.empty(); }
+    coord_t point_z(size_t idx) const { assert(this->z.empty() || this->z.size() == this->points.size()); return this->z.empty() ? -1 : this->z[idx]; }
+    coord_t first_z() const { return this->z.empty() ? -1 : this->z.front(); }
+    coord_t last_z() const { return this->z.empty() ? -1 : this->z.back(); }
+
+    void reverse() { MultiPoint::reverse(); std::reverse(this->z.begin(), this->z.end()); }
+    void clear() { MultiPoint::clear(); this->z.clear(); }
+    // Points sharing XY with their predecessor, but not its Z, are kept as they form a vertical move.
+    bool remove_duplicate_points();
+
     double length() const;
     const Point& last_point() const { return this->points.back(); }
     const Point& leftmost_point() const;
@@ -78,6 +100,18 @@ public:
     void split_at(const Point &point, Polyline* p1, Polyline* p2) const;
     bool is_straight() const;
     bool is_closed() const { return this->points.front() == this->points.back(); }
+
+private:
+    // Extend z before the points of src are appended, if either of the polylines is nonplanar.
+    void append_z(const Polyline &src) {
+        if (this->z.empty() && src.z.empty())
+            return;
+        this->z.resize(this->points.size(), -1);
+        if (src.z.empty())
+            this->z.insert(this->z.end(), src.points.size(), -1);
+        else
+            this->z.insert(this->z.end(), src.z.begin(), src.z.end());
+    }
 };
 
 inline bool operator==(const Polyline &lhs, const Polyline &rhs) { return lhs.points == rhs.points; }
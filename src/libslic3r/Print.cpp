@@ -9,6 +9,7 @@
 #include "I18N.hpp"
 #include "ShortestPath.hpp"
 #include "Thread.hpp"
+#include "Trace.hpp"
 #include "GCode.hpp"
 #include "GCode/WipeTower.hpp"
 #include "GCode/ConflictChecker.hpp"
@@ -27,6 +28,9 @@
 #include <boost/log/trivial.hpp>
 #include <boost/regex.hpp>
 
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
 namespace Slic3r {
 
 template class PrintState<PrintStep, psCount>;
@@ -47,13 +51,8 @@ void Print::clear()
     m_model.clear_objects();
 }
 
-// Called by Print::apply().
-// This method only accepts PrintConfig option keys.
-bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+bool Print::steps_invalidated_by_config_option(const t_config_option_key &opt_key, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps)
 {
-    if (opt_keys.empty())
-        return false;
-
     // Cache the plenty of parameters, which influence the G-code generator only,
     // or they are only notes not influencing the generated G-code.
     static std::unordered_set<std::string> steps_gcode = {
@@ -101,6 +100,7 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
         "first_layer_speed_over_raft",
         "gcode_comments",
         "gcode_label_objects",
+        "gcode_single_pass",
         "infill_acceleration",
         "layer_gcode",
         "min_fan_speed",
@@ -149,101 +149,112 @@ bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* n
 
     static std::unordered_set<std::string> steps_ignore;
 
+    if (steps_gcode.find(opt_key) != steps_gcode.end()) {
+        // These options only affect G-code export or they are just notes without influence on the generated G-code,
+        // so there is nothing to invalidate.
+        steps.emplace_back(psGCodeExport);
+    } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
+        // These steps have no influence on the G-code whatsoever. Just ignore them.
+    } else if (
+           opt_key == "skirts"
+        || opt_key == "skirt_height"
+        || opt_key == "draft_shield"
+        || opt_key == "skirt_distance"
+        || opt_key == "min_skirt_length"
+        || opt_key == "ooze_prevention"
+        || opt_key == "wipe_tower_x"
+        || opt_key == "wipe_tower_y"
+        || opt_key == "wipe_tower_rotation_angle") {
+        steps.emplace_back(psSkirtBrim);
+    } else if (
+           opt_key == "first_layer_height"
+        || opt_key == "nozzle_diameter"
+        || opt_key == "resolution"
+        // Spiral Vase forces different kind of slicing than the normal model:
+        // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
+        // Therefore toggling the Spiral Vase on / off requires complete reslicing.
+        || opt_key == "spiral_vase") {
+        osteps.emplace_back(posSlice);
+    } else if (
+           opt_key == "complete_objects"
+        || opt_key == "filament_type"
+        || opt_key == "first_layer_temperature"
+        || opt_key == "filament_loading_speed"
+        || opt_key == "filament_loading_speed_start"
+        || opt_key == "filament_unloading_speed"
+        || opt_key == "filament_unloading_speed_start"
+        || opt_key == "filament_toolchange_delay"
+        || opt_key == "filament_cooling_moves"
+        || opt_key == "filament_minimal_purge_on_wipe_tower"
+        || opt_key == "filament_cooling_initial_speed"
+        || opt_key == "filament_cooling_final_speed"
+        || opt_key == "filament_ramming_parameters"
+        || opt_key == "filament_max_volumetric_speed"
+        || opt_key == "gcode_flavor"
+        || opt_key == "high_current_on_filament_swap"
+        || opt_key == "infill_first"
+        || opt_key == "single_extruder_multi_material"
+        || opt_key == "temperature"
+        || opt_key == "idle_temperature"
+        || opt_key == "wipe_tower"
+        || opt_key == "wipe_tower_width"
+        || opt_key == "wipe_tower_brim_width"
+        || opt_key == "wipe_tower_cone_angle"
+        || opt_key == "wipe_tower_bridging"
+        || opt_key == "wipe_tower_extra_spacing"
+        || opt_key == "wipe_tower_no_sparse_layers"
+        || opt_key == "wipe_tower_extruder"
+        || opt_key == "wiping_volumes_matrix"
+        || opt_key == "parking_pos_retraction"
+        || opt_key == "cooling_tube_retraction"
+        || opt_key == "cooling_tube_length"
+        || opt_key == "extra_loading_move"
+        || opt_key == "travel_speed"
+        || opt_key == "travel_speed_z"
+        || opt_key == "first_layer_speed"
+        || opt_key == "z_offset") {
+        steps.emplace_back(psWipeTower);
+        steps.emplace_back(psSkirtBrim);
+    } else if (opt_key == "filament_soluble") {
+        steps.emplace_back(psWipeTower);
+        // Soluble support interface / non-soluble base interface produces non-soluble interface layers below soluble interface layers.
+        // Thus switching between soluble / non-soluble interface layer material may require recalculation of supports.
+        //FIXME Killing supports on any change of "filament_soluble" is rough. We should check for each object whether that is necessary.
+        osteps.emplace_back(posSupportMaterial);
+    } else if (
+           opt_key == "first_layer_extrusion_width" 
+        || opt_key == "min_layer_height"
+        || opt_key == "max_layer_height"
+        || opt_key == "gcode_resolution") {
+        osteps.emplace_back(posPerimeters);
+        osteps.emplace_back(posInfill);
+        osteps.emplace_back(posSupportMaterial);
+        steps.emplace_back(psSkirtBrim);
+    } else if (opt_key == "avoid_crossing_curled_overhangs") {
+        osteps.emplace_back(posEstimateCurledExtrusions);
+    } else
+        return false;
+    return true;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintConfig option keys.
+bool Print::invalidate_state_by_config_options(const ConfigOptionResolver & /* new_config */, const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
     std::vector<PrintStep> steps;
     std::vector<PrintObjectStep> osteps;
     bool invalidated = false;
 
-    for (const t_config_option_key &opt_key : opt_keys) {
-        if (steps_gcode.find(opt_key) != steps_gcode.end()) {
-            // These options only affect G-code export or they are just notes without influence on the generated G-code,
-            // so there is nothing to invalidate.
-            steps.emplace_back(psGCodeExport);
-        } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
-            // These steps have no influence on the G-code whatsoever. Just ignore them.
-        } else if (
-               opt_key == "skirts"
-            || opt_key == "skirt_height"
-            || opt_key == "draft_shield"
-            || opt_key == "skirt_distance"
-            || opt_key == "min_skirt_length"
-            || opt_key == "ooze_prevention"
-            || opt_key == "wipe_tower_x"
-            || opt_key == "wipe_tower_y"
-            || opt_key == "wipe_tower_rotation_angle") {
-            steps.emplace_back(psSkirtBrim);
-        } else if (
-               opt_key == "first_layer_height"
-            || opt_key == "nozzle_diameter"
-            || opt_key == "resolution"
-            // Spiral Vase forces different kind of slicing than the normal model:
-            // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
-            // Therefore toggling the Spiral Vase on / off requires complete reslicing.
-            || opt_key == "spiral_vase") {
-            osteps.emplace_back(posSlice);
-        } else if (
-               opt_key == "complete_objects"
-            || opt_key == "filament_type"
-            || opt_key == "first_layer_temperature"
-            || opt_key == "filament_loading_speed"
-            || opt_key == "filament_loading_speed_start"
-            || opt_key == "filament_unloading_speed"
-            || opt_key == "filament_unloading_speed_start"
-            || opt_key == "filament_toolchange_delay"
-            || opt_key == "filament_cooling_moves"
-            || opt_key == "filament_minimal_purge_on_wipe_tower"
-            || opt_key == "filament_cooling_initial_speed"
-            || opt_key == "filament_cooling_final_speed"
-            || opt_key == "filament_ramming_parameters"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "gcode_flavor"
-            || opt_key == "high_current_on_filament_swap"
-            || opt_key == "infill_first"
-            || opt_key == "single_extruder_multi_material"
-            || opt_key == "temperature"
-            || opt_key == "idle_temperature"
-            || opt_key == "wipe_tower"
-            || opt_key == "wipe_tower_width"
-            || opt_key == "wipe_tower_brim_width"
-            || opt_key == "wipe_tower_cone_angle"
-            || opt_key == "wipe_tower_bridging"
-            || opt_key == "wipe_tower_extra_spacing"
-            || opt_key == "wipe_tower_no_sparse_layers"
-            || opt_key == "wipe_tower_extruder"
-            || opt_key == "wiping_volumes_matrix"
-            || opt_key == "parking_pos_retraction"
-            || opt_key == "cooling_tube_retraction"
-            || opt_key == "cooling_tube_length"
-            || opt_key == "extra_loading_move"
-            || opt_key == "travel_speed"
-            || opt_key == "travel_speed_z"
-            || opt_key == "first_layer_speed"
-            || opt_key == "z_offset") {
-            steps.emplace_back(psWipeTower);
-            steps.emplace_back(psSkirtBrim);
-        } else if (opt_key == "filament_soluble") {
-            steps.emplace_back(psWipeTower);
-            // Soluble support interface / non-soluble base interface produces non-soluble interface layers below soluble interface layers.
-            // Thus switching between soluble / non-soluble interface layer material may require recalculation of supports.
-            //FIXME Killing supports on any change of "filament_soluble" is rough. We should check for each object whether that is necessary.
-            osteps.emplace_back(posSupportMaterial);
-        } else if (
-               opt_key == "first_layer_extrusion_width" 
-            || opt_key == "min_layer_height"
-            || opt_key == "max_layer_height"
-            || opt_key == "gcode_resolution") {
-            osteps.emplace_back(posPerimeters);
-            osteps.emplace_back(posInfill);
-            osteps.emplace_back(posSupportMaterial);
-            steps.emplace_back(psSkirtBrim);
-        } else if (opt_key == "avoid_crossing_curled_overhangs") {
-            osteps.emplace_back(posEstimateCurledExtrusions);
-        } else {
+    for (const t_config_option_key &opt_key : opt_keys)
+        if (! steps_invalidated_by_config_option(opt_key, steps, osteps)) {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
             invalidated |= this->invalidate_all_steps();
             // Continue with the other opt_keys to possibly invalidate any object specific steps.
         }
-    }
 
     sort_remove_duplicates(steps);
     for (PrintStep step : steps)
@@ -899,22 +910,24 @@ void Print::process()
 {
     name_tbb_thread_pool_threads_set_locale();
 
+    SLIC3R_TRACE_ZONE("Print::process");
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
-    for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_spots();
+    this->process_objects_concurrently([](PrintObject &obj) {
+        obj.restore_from_cache();
+        obj.make_perimeters();
+        obj.infill();
+        obj.ironing();
+        obj.generate_support_spots();
+    });
     // check data from previous step, format the error message(s) and send alert to ui
     alert_when_supports_needed();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
-    for (PrintObject *obj : m_objects)
-        obj->estimate_curled_extrusions();
+    this->process_objects_concurrently([](PrintObject &obj) {
+        obj.generate_support_material();
+        obj.estimate_curled_extrusions();
+        obj.store_in_cache(posEstimateCurledExtrusions);
+    });
     if (this->set_started(psWipeTower)) {
+        SLIC3R_TRACE_ZONE("Print::make_wipe_tower");
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
         if (this->has_wipe_tower()) {
@@ -929,6 +942,7 @@ void Print::process()
         this->set_done(psWipeTower);
     }
     if (this->set_started(psSkirtBrim)) {
+        SLIC3R_TRACE_ZONE("Print::make_skirt_brim");
         this->set_status(88, _u8L("Generating skirt and brim"));
 
         m_skirt.clear();
@@ -968,7 +982,11 @@ void Print::process()
         m_fake_wipe_tower.set_pos_and_rotation({ m_config.wipe_tower_x, m_config.wipe_tower_y }, m_config.wipe_tower_rotation_angle);
         wipe_tower_opt = std::make_optional<const FakeWipeTower*>(&m_fake_wipe_tower);
     }
-    auto conflictRes = ConflictChecker::find_inter_of_lines_in_diff_objs(m_objects, wipe_tower_opt);
+    ConflictResultOpt conflictRes;
+    {
+        SLIC3R_TRACE_ZONE("Print::check_conflicts");
+        conflictRes = ConflictChecker::find_inter_of_lines_in_diff_objs(m_objects, wipe_tower_opt);
+    }
 
     m_conflict_result = conflictRes;
     if (conflictRes.has_value())
@@ -977,6 +995,33 @@ void Print::process()
     BOOST_LOG_TRIVIAL(info) << "Slicing process finished." << log_memory_info();
 }
 
+// Run the steps of independent PrintObjects concurrently. The steps of a single PrintObject parallelize over its layers,
+// which does not saturate the CPU cores for a plate of many small objects.
+// PrintObjects of the same ModelObject share PrintObjectRegions including the data of their shared steps
+// (see is_shared_print_object_step_valid_unguarded()), thus they are processed sequentially by a single task.
+void Print::process_objects_concurrently(const std::function<void(PrintObject&)> &process)
+{
+    std::vector<std::vector<PrintObject*>> groups;
+    for (PrintObject *obj : m_objects) {
+        auto it = std::find_if(groups.begin(), groups.end(), [obj](const std::vector<PrintObject*> &group)
+            { return group.front()->shared_regions() == obj->shared_regions(); });
+        if (it == groups.end())
+            groups.push_back({ obj });
+        else
+            it->emplace_back(obj);
+    }
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, groups.size(), 1),
+        [&groups, &process](const tbb::blocked_range<size_t> &range) {
+            for (size_t group_idx = range.begin(); group_idx < range.end(); ++ group_idx)
+                // Isolate the nested per layer parallelism, so that a thread waiting for the layers of one object
+                // does not pick up another object, which could lead to a deadlock on mutexes held by the waiting step.
+                tbb::this_task_arena::isolate([&groups, &process, group_idx]() {
+                    for (PrintObject *obj : groups[group_idx])
+                        process(*obj);
+                });
+        });
+}
+
 // G-code export process, running at a background thread.
 // The export_gcode may die for various reasons (fails to process output_filename_format,
 // write error into the G-code, cannot execute post-processing scripts).
@@ -996,6 +1041,7 @@ std::string Print::export_gcode(const std::string& path_template, GCodeProcessor
         message = _u8L("Generating G-code");
     this->set_status(90, message);
 
+    SLIC3R_TRACE_ZONE("Print::export_gcode");
     // Create GCode on heap, it has quite a lot of data.
     std::unique_ptr<GCode> gcode(new GCode);
     gcode->do_export(this, path.c_str(), result, thumbnail_cb);
@@ -18,7 +18,6 @@
 #include "GCode/GCodeProcessor.hpp"
 #include "MultiMaterialSegmentation.hpp"
 #include "NonplanarSurface.hpp"
-#include "NonplanarFacet.hpp"
 
 #include "libslic3r.h"
 
@@ -36,6 +35,7 @@ class Layer;
 class ModelObject;
 class Print;
 class PrintObject;
+class PrintObjectCache;
 class SupportLayer;
 
 namespace FillAdaptive {
@@ -269,7 +269,7 @@ public:
     // Centering offset of the sliced mesh from the scaled and rotated mesh of the model.
     const Point& 			     center_offset() const  { return m_center_offset; }
     // 
-    NonplanarSurfaces            nonplanar_surfaces()   { return m_nonplanar_surfaces; }
+    const NonplanarSurfaces&     nonplanar_surfaces() const { return m_nonplanar_surfaces; }
 
     bool                         has_brim() const       {
         return this->config().brim_type != btNoBrim
@@ -365,6 +365,19 @@ private:
     // It may be called for both the PrintObjectConfig and PrintRegionConfig.
     bool                    invalidate_state_by_config_options(
         const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+    // Collect the steps invalidated by a change of a single PrintObjectConfig or PrintRegionConfig option from old_config to new_config.
+    // Returns false for an unknown option, which invalidates all steps.
+    bool                    steps_invalidated_by_config_option(const ConfigOptionResolver &old_config, const ConfigOptionResolver &new_config,
+        const t_config_option_key &opt_key, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const
+        { return this->collect_steps_of_config_option(&old_config, &new_config, opt_key, steps, print_steps); }
+    // Collect all the steps a change of a single PrintObjectConfig or PrintRegionConfig option may invalidate, whatever its values.
+    // Returns false for an unknown option, which may invalidate all steps.
+    bool                    steps_influenced_by_config_option(
+        const t_config_option_key &opt_key, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const
+        { return this->collect_steps_of_config_option(nullptr, nullptr, opt_key, steps, print_steps); }
+    // Implements the two above, old_config and new_config are null if all the steps the option may influence are to be collected.
+    bool                    collect_steps_of_config_option(const ConfigOptionResolver *old_config, const ConfigOptionResolver *new_config,
+        const t_config_option_key &opt_key, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const;
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -373,6 +386,15 @@ private:
 
     static PrintObjectConfig object_config_from_model_object(const PrintObjectConfig &default_object_config, const ModelObject &object, size_t num_extruders);
 
+    // Caching of the results of the steps in Print::object_cache(), implemented in PrintObjectCache.cpp.
+    // Hash of all the inputs of the steps up to last_step, empty if the results of this object cannot be cached.
+    std::string             cache_key(PrintObjectStep last_step) const;
+    // Replace the layers with the layers produced by the steps up to last_step, returns false on a cache miss.
+    bool                    load_from_cache(PrintObjectStep last_step);
+    void                    store_in_cache(PrintObjectStep last_step) const;
+    // Restore the results of all the cached steps of an object, which was not sliced yet, and mark the steps as done.
+    void                    restore_from_cache();
+
 private:
     void make_perimeters();
     void prepare_infill();
@@ -390,7 +412,7 @@ private:
     void detect_surfaces_type();
     void merge_nonplanar_surfaces();
     void debug_svg_print();
-    bool check_nonplanar_collisions(NonplanarSurface &surface);
+    bool check_nonplanar_collisions(const NonplanarSurface &surface);
     void project_nonplanar_surfaces();
     void find_nonplanar_surfaces();
     void detect_nonplanar_surfaces();
@@ -662,17 +684,25 @@ public:
     const Polygons& get_sequential_print_clearance_contours() const { return m_sequential_print_clearance_contours; }
     static bool sequential_print_horizontal_clearance_valid(const Print& print, Polygons* polygons = nullptr);
 
+    // Persistent cache of the results of the PrintObject steps, shared by multiple Prints. Not used if null.
+    void                        set_object_cache(std::shared_ptr<PrintObjectCache> cache) { m_object_cache = std::move(cache); }
+    PrintObjectCache*           object_cache() const { return m_object_cache.get(); }
+
 protected:
     // Invalidates the step, and its depending steps in Print.
     bool                invalidate_step(PrintStep step);
 
 private:
     bool                invalidate_state_by_config_options(const ConfigOptionResolver &new_config, const std::vector<t_config_option_key> &opt_keys);
+    // Collect the steps invalidated by a change of a single PrintConfig option, returns false for an unknown option.
+    static bool         steps_invalidated_by_config_option(const t_config_option_key &opt_key, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps);
 
     void                _make_skirt();
     void                _make_wipe_tower();
     void                finalize_first_layer_convex_hull();
     void                alert_when_supports_needed();
+    // Run process on all PrintObjects, PrintObjects of different ModelObjects concurrently.
+    void                process_objects_concurrently(const std::function<void(PrintObject&)> &process);
 
     // Islands of objects and their supports extruded at the 1st layer.
     Polygons            first_layer_islands() const;
@@ -712,6 +742,8 @@ private:
     // Cache to store sequential print clearance contours
     Polygons m_sequential_print_clearance_contours;
 
+    std::shared_ptr<PrintObjectCache>       m_object_cache;
+
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
     // To allow GCodeProcessor to emit warnings.
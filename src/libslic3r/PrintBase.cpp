@@ -99,9 +99,10 @@ std::string PrintBase::output_filepath(const std::string &path, const std::strin
 
 void PrintBase::status_update_warnings(int step, PrintStateBase::WarningLevel /* warning_level */, const std::string &message, const PrintObjectBase* print_object)
 {
-    if (m_status_callback) {
+    status_callback_type status_callback = this->status_callback();
+    if (status_callback) {
         auto status = print_object ? SlicingStatus(*print_object, step) : SlicingStatus(*this, step);
-        m_status_callback(status);
+        status_callback(status);
     }
     else if (! message.empty())
         printf("%s warning: %s\n",  print_object ? "print_object" : "print", message.c_str());
@@ -483,14 +483,17 @@ public:
     };
     typedef std::function<void(const SlicingStatus&)>  status_callback_type;
     // Default status console print out in the form of percent => message.
-    void                    set_status_default() { m_status_callback = nullptr; }
+    void                    set_status_default() { std::scoped_lock<std::mutex> lock(m_status_mutex); m_status_callback = nullptr; }
     // No status output or callback whatsoever, useful mostly for automatic tests.
-    void                    set_status_silent() { m_status_callback = [](const SlicingStatus&){}; }
+    void                    set_status_silent() { std::scoped_lock<std::mutex> lock(m_status_mutex); m_status_callback = [](const SlicingStatus&){}; }
     // Register a custom status callback.
-    void                    set_status_callback(status_callback_type cb) { m_status_callback = cb; }
+    void                    set_status_callback(status_callback_type cb) { std::scoped_lock<std::mutex> lock(m_status_mutex); m_status_callback = cb; }
     // Calls a registered callback to update the status, or print out the default message.
     void                    set_status(int percent, const std::string &message, unsigned int flags = SlicingStatus::DEFAULT) {
-		if (m_status_callback) m_status_callback(SlicingStatus(percent, message, flags));
+        // Print::process() processes multiple PrintObjects concurrently, thus the callback may be called from multiple threads.
+        // It is called outside of the lock, so that it may call back into set_status().
+        status_callback_type status_callback = this->status_callback();
+		if (status_callback) status_callback(SlicingStatus(percent, message, flags));
         else printf("%d => %s\n", percent, message.c_str());
     }
 
@@ -533,6 +536,8 @@ protected:
 
     std::mutex&            state_mutex() const { return m_state_mutex; }
     std::function<void()>  cancel_callback() { return m_cancel_callback; }
+    // Copy of the status callback, to be invoked without holding m_status_mutex.
+    status_callback_type   status_callback() { std::scoped_lock<std::mutex> lock(m_status_mutex); return m_status_callback; }
 	void				   call_cancel_callback() { m_cancel_callback(); }
 	// Notify UI about a new warning of a milestone "step" on this PrintBase.
 	// The UI will be notified by calling a status callback.
@@ -567,6 +572,8 @@ private:
     // The mutex will be used to guard the worker thread against entering a stage
     // while the data influencing the stage is modified.
     mutable std::mutex                      m_state_mutex;
+    // Guards m_status_callback against being replaced while it is being copied for an invocation.
+    std::mutex                              m_status_mutex;
 
     friend PrintTryCancel;
 };
@@ -206,6 +206,19 @@ static const t_config_enum_values s_keys_map_GCodeThumbnailsFormat = {
 };
 CONFIG_OPTION_ENUM_DEFINE_STATIC_MAPS(GCodeThumbnailsFormat)
 
+static const t_config_enum_values s_keys_map_ArchiveCompression = {
+    { "fast",    int(ArchiveCompression::Fast) },
+    { "default", int(ArchiveCompression::Default) },
+    { "max",     int(ArchiveCompression::Max) }
+};
+CONFIG_OPTION_ENUM_DEFINE_STATIC_MAPS(ArchiveCompression)
+
+ArchiveCompression archive_compression_from_string(const std::string &value)
+{
+    auto it = s_keys_map_ArchiveCompression.find(value);
+    return it == s_keys_map_ArchiveCompression.end() ? ArchiveCompression::Default : ArchiveCompression(it->second);
+}
+
 static const t_config_enum_values s_keys_map_ForwardCompatibilitySubstitutionRule = {
     { "disable",        ForwardCompatibilitySubstitutionRule::Disable },
     { "enable",         ForwardCompatibilitySubstitutionRule::Enable },
@@ -1452,6 +1465,15 @@ void PrintConfigDef::init_fff_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionBool(0));
 
+    def = this->add("gcode_single_pass", coBool);
+    def->label = L("Write G-code in a single pass");
+    def->tooltip = L("If enabled, the remaining time (M73) lines and the print statistics are filled in while the G-code is being written, "
+                   "thus the G-code is written to disk just once instead of being rewritten after the export. "
+                   "The remaining times are then updated every 30 seconds of print time, not whenever the printed percentage "
+                   "or the remaining minutes change. Recommended for very large G-codes.");
+    def->mode = comExpert;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("gcode_substitutions", coStrings);
     def->label = L("G-code substitutions");
     def->tooltip = L("Find / replace patterns in G-code lines and substitute them.");
@@ -4192,6 +4214,25 @@ void PrintConfigDef::init_sla_params()
     def->mode = comAdvanced;
     def->set_default_value(new ConfigOptionString("SL1"));
 
+    def = this->add("sla_archive_compression", coEnum);
+    def->label = L("Compression of the output SLA archive");
+    def->tooltip = L("Compression level of the output SLA archive. Fast compression produces slightly larger archives, "
+                     "maximum compression produces the smallest archives, but takes considerably longer.");
+    def->set_enum<ArchiveCompression>({
+        { "fast",    L("Fast") },
+        { "default", L("Default") },
+        { "max",     L("Maximum") }
+    });
+    def->mode = comExpert;
+    def->set_default_value(new ConfigOptionEnum<ArchiveCompression>(ArchiveCompression::Fast));
+
+    def = this->add("sla_archive_fast_png", coBool);
+    def->label = L("Fast PNG encoding of layers");
+    def->tooltip = L("Encode the layer images of the SL1 archive with a faster PNG encoder. "
+                     "Exporting is faster, but the layer images are larger.");
+    def->mode = comExpert;
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("sla_output_precision", coFloat);
     def->label = L("SLA output precision");
     def->tooltip = L("Minimum resolution in nanometers");
@@ -4911,6 +4952,44 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = L("The file where the output will be written (if not specified, it will be based on the input file).");
     def->cli = "output|o";
 
+    def = this->add("batch", coString);
+    def->label = L("Batch manifest");
+    def->tooltip = L("Slice the models listed in the given file with the configuration composed from --load files and the command line, "
+                     "which is parsed and validated once for all of them. Each line of the file contains an input model file, "
+                     "optionally followed by a tab and the output file. Empty lines and lines starting with # are ignored. "
+                     "Project configurations stored in the input files are ignored. To be used together with --export-gcode or --export-sla.");
+
+    def = this->add("batch_jobs", coInt);
+    def->label = L("Batch jobs");
+    def->tooltip = L("Number of models of the --batch manifest sliced concurrently. The jobs share a single thread pool. "
+                     "If set to zero, a quarter of the available CPU threads is used.");
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(0));
+
+    def = this->add("batch_summary", coString);
+    def->label = L("Batch summary");
+    def->tooltip = L("Write a JSON summary of the --batch jobs with their outcome and timing into the given file, together with "
+                     "the peak memory usage of the whole process when each job finished. "
+                     "If not set, the summary is written to the standard output.");
+
+    def = this->add("cache_dir", coString);
+    def->label = L("Cache directory");
+    def->tooltip = L("Store the results of slicing the objects in the given directory and restore them when the same object is sliced "
+                     "again with the same settings influencing its layers, perimeters, infill and supports. "
+                     "The directory may be shared by multiple runs. Only used with the FFF technology.");
+
+    def = this->add("cache_size", coInt);
+    def->label = L("Cache size");
+    def->tooltip = L("Maximum size of the --cache-dir. The least recently used entries are removed once the cache grows larger.");
+    def->sidetext = L("MB");
+    def->min = 0;
+    def->set_default_value(new ConfigOptionInt(1024));
+
+    def = this->add("trace", coString);
+    def->label = L("Trace");
+    def->tooltip = L("Record the time spent in the individual slicing and G-code export steps on each thread and write it into the given file "
+                     "in the Chrome trace format, to be opened by chrome://tracing or https://ui.perfetto.dev");
+
     def = this->add("single_instance", coBool);
     def->label = L("Single instance mode");
     def->tooltip = L("If enabled, the command line arguments are sent to an existing instance of GUI PrusaSlicer, "
@@ -138,6 +138,11 @@ enum class GCodeThumbnailsFormat {
     PNG, JPG, QOI
 };
 
+// Compression level of the zip archives written: 3MF projects and SLA output archives.
+enum class ArchiveCompression {
+    Fast, Default, Max
+};
+
 #define CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(NAME) \
     template<> const t_config_enum_names& ConfigOptionEnum<NAME>::get_enum_names(); \
     template<> const t_config_enum_values& ConfigOptionEnum<NAME>::get_enum_values();
@@ -161,12 +166,17 @@ CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(SLASupportTreeType)
 CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(BrimType)
 CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(DraftShield)
 CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(GCodeThumbnailsFormat)
+CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(ArchiveCompression)
 CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(ForwardCompatibilitySubstitutionRule)
 CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS(PerimeterGeneratorType)
 
 
 #undef CONFIG_OPTION_ENUM_DECLARE_STATIC_MAPS
 
+// Archive compression stored as a string, for example the "archive_compression" of AppConfig.
+// An empty or unknown value is mapped to ArchiveCompression::Default.
+ArchiveCompression archive_compression_from_string(const std::string &value);
+
 // Defines each and every confiuration option of Slic3r, including the properties of the GUI dialogs.
 // Does not store the actual values, but defines default values.
 class PrintConfigDef : public ConfigDef
@@ -696,6 +706,7 @@ PRINT_CONFIG_CLASS_DEFINE(
     ((ConfigOptionBool,                gcode_comments))
     ((ConfigOptionEnum<GCodeFlavor>,   gcode_flavor))
     ((ConfigOptionBool,                gcode_label_objects))
+    ((ConfigOptionBool,                gcode_single_pass))
     // Triples of strings: "search pattern", "replace with pattern", "attribs"
     // where "attribs" are one of:
     //      r - regular expression
@@ -1107,6 +1118,8 @@ PRINT_CONFIG_CLASS_DEFINE(
     ((ConfigOptionFloat,                      min_initial_exposure_time))
     ((ConfigOptionFloat,                      max_initial_exposure_time))
     ((ConfigOptionString,                     sla_archive_format))
+    ((ConfigOptionEnum<ArchiveCompression>,   sla_archive_compression))
+    ((ConfigOptionBool,                       sla_archive_fast_png))
     ((ConfigOptionFloat,                      sla_output_precision))
 )
 
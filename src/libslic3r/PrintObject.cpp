@@ -23,6 +23,7 @@
 #include "Slicing.hpp"
 #include "SurfaceCollection.hpp"
 #include "Tesselate.hpp"
+#include "Trace.hpp"
 #include "TriangleMeshSlicer.hpp"
 #include "Utils.hpp"
 #include "Fill/FillAdaptive.hpp"
@@ -43,6 +44,7 @@
 #include <functional>
 #include <limits>
 #include <map>
+#include <numeric>
 #include <oneapi/tbb/blocked_range.h>
 #include <oneapi/tbb/concurrent_vector.h>
 #include <oneapi/tbb/parallel_for.h>
@@ -157,6 +159,39 @@ std::vector<std::reference_wrapper<const PrintRegion>> PrintObject::all_regions(
     return out;
 }
 
+// Split layers into runs of consecutive layers with identical inputs of a processing step, as they are common on prismatic objects.
+// Returns for each layer the index of the first layer of its run. Neighbor layers are compared exactly only if their fingerprints match,
+// zero fingerprint marks a layer, which shall not be shared.
+template<typename FingerprintFn, typename SameInputsFn, typename ThrowOnCancel>
+static std::vector<size_t> layer_runs_with_same_inputs(const LayerPtrs &layers, FingerprintFn fingerprint, SameInputsFn same_inputs, ThrowOnCancel throw_on_cancel)
+{
+    std::vector<size_t> run_begin(layers.size());
+    if (layers.size() < 2) {
+        std::iota(run_begin.begin(), run_begin.end(), 0);
+        return run_begin;
+    }
+    std::vector<size_t> fingerprints(layers.size(), 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, layers.size()),
+        [&layers, &fingerprints, &fingerprint, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                throw_on_cancel();
+                fingerprints[layer_idx] = fingerprint(*layers[layer_idx]);
+            }
+        });
+    std::vector<unsigned char> same_as_below(layers.size(), false);
+    tbb::parallel_for(tbb::blocked_range<size_t>(1, layers.size()),
+        [&layers, &fingerprints, &same_inputs, &same_as_below, &throw_on_cancel](const tbb::blocked_range<size_t> &range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                throw_on_cancel();
+                same_as_below[layer_idx] = fingerprints[layer_idx] != 0 && fingerprints[layer_idx] == fingerprints[layer_idx - 1] &&
+                    same_inputs(*layers[layer_idx], *layers[layer_idx - 1]);
+            }
+        });
+    for (size_t layer_idx = 0; layer_idx < layers.size(); ++ layer_idx)
+        run_begin[layer_idx] = same_as_below[layer_idx] ? run_begin[layer_idx - 1] : layer_idx;
+    return run_begin;
+}
+
 // 1) Merges typed region slices into stInternal type.
 // 2) Increases an "extra perimeters" counter at region slices where needed.
 // 3) Generates perimeters, gap fills and fill regions (fill regions of type stInternal).
@@ -167,6 +202,7 @@ void PrintObject::make_perimeters()
 
     if (! this->set_started(posPerimeters))
         return;
+    SLIC3R_TRACE_ZONE("PrintObject::make_perimeters");
 
     m_print->set_status(20, _u8L("Generating perimeters"));
     BOOST_LOG_TRIVIAL(info) << "Generating perimeters..." << log_memory_info();
@@ -255,19 +291,41 @@ void PrintObject::make_perimeters()
         BOOST_LOG_TRIVIAL(debug) << "Generating extra perimeters for region " << region_id << " in parallel - end";
     }
 
+    // Layers with the same region slices and the same layer below as the layer below them share its perimeters.
+    const std::vector<size_t> perimeter_runs = layer_runs_with_same_inputs(m_layers,
+        [](const Layer &layer) { return layer.perimeters_fingerprint(); },
+        [](const Layer &layer, const Layer &other) { return layer.has_same_perimeter_inputs(other); },
+        [this]() { m_print->throw_if_canceled(); });
+
     BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
     tbb::parallel_for(
         tbb::blocked_range<size_t>(0, m_layers.size()),
-        [this](const tbb::blocked_range<size_t>& range) {
+        [this, &perimeter_runs](const tbb::blocked_range<size_t>& range) {
             PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
-            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-                m_print->throw_if_canceled();
-                m_layers[layer_idx]->make_perimeters();
-            }
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                if (perimeter_runs[layer_idx] == layer_idx) {
+                    m_print->throw_if_canceled();
+                    m_layers[layer_idx]->make_perimeters();
+                }
         }
     );
     m_print->throw_if_canceled();
-    BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end";
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, m_layers.size()),
+        [this, &perimeter_runs](const tbb::blocked_range<size_t>& range) {
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                if (size_t source_idx = perimeter_runs[layer_idx]; source_idx != layer_idx) {
+                    m_print->throw_if_canceled();
+                    m_layers[layer_idx]->copy_perimeters(*m_layers[source_idx]);
+                }
+        }
+    );
+    m_print->throw_if_canceled();
+    size_t num_copied = 0;
+    for (size_t layer_idx = 0; layer_idx < m_layers.size(); ++ layer_idx)
+        if (perimeter_runs[layer_idx] != layer_idx)
+            ++ num_copied;
+    BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - end, perimeters of " << num_copied << " of " << m_layers.size() << " layers copied";
 
     this->set_done(posPerimeters);
 }
@@ -276,6 +334,7 @@ void PrintObject::prepare_infill()
 {
     if (! this->set_started(posPrepareInfill))
         return;
+    SLIC3R_TRACE_ZONE("PrintObject::prepare_infill");
 
     m_print->set_status(30, _u8L("Preparing infill"));
 
@@ -423,22 +482,38 @@ void PrintObject::infill()
     this->prepare_infill();
 
     if (this->set_started(posInfill)) {
+        SLIC3R_TRACE_ZONE("PrintObject::infill");
         // TRN Status for the Print calculation 
         m_print->set_status(45, _u8L("Making infill"));
         const auto& adaptive_fill_octree = this->m_adaptive_fill_octrees.first;
         const auto& support_fill_octree = this->m_adaptive_fill_octrees.second;
 
+        // Layers of a run with the same fill inputs copy the infill from one of the first three layers of the run,
+        // which are filled first. These cover the alternating layer angles with a period of up to three layers.
+        // Patterns depending on Z and patterns rotated differently are generated for each layer.
+        static constexpr const size_t num_fill_sources = 3;
+        const std::vector<size_t> fill_runs = layer_runs_with_same_inputs(m_layers,
+            [](const Layer &layer) { return layer.fills_fingerprint(); },
+            [](const Layer &layer, const Layer &other) { return layer.has_same_fill_inputs(other); },
+            [this]() { m_print->throw_if_canceled(); });
+
         BOOST_LOG_TRIVIAL(debug) << "Filling layers in parallel - start";
-        tbb::parallel_for(
-            tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree](const tbb::blocked_range<size_t>& range) {
-                PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
-                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
-                    m_print->throw_if_canceled();
-                    m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get());
+        for (size_t run_offset = 0; run_offset <= num_fill_sources; ++ run_offset)
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, m_layers.size()),
+                [this, &adaptive_fill_octree = adaptive_fill_octree, &support_fill_octree = support_fill_octree, &fill_runs, run_offset](const tbb::blocked_range<size_t>& range) {
+                    PRINT_OBJECT_TIME_LIMIT_MILLIS(PRINT_OBJECT_TIME_LIMIT_DEFAULT);
+                    std::vector<const Layer*> fill_sources;
+                    for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx)
+                        if (size_t run_begin = fill_runs[layer_idx]; std::min(layer_idx - run_begin, num_fill_sources) == run_offset) {
+                            m_print->throw_if_canceled();
+                            fill_sources.clear();
+                            for (size_t source_idx = run_begin; source_idx < run_begin + run_offset; ++ source_idx)
+                                fill_sources.emplace_back(m_layers[source_idx]);
+                            m_layers[layer_idx]->make_fills(adaptive_fill_octree.get(), support_fill_octree.get(), this->m_lightning_generator.get(), fill_sources);
+                        }
                 }
-            }
-        );
+            );
 
         this->project_nonplanar_surfaces();
 
@@ -454,6 +529,7 @@ void PrintObject::infill()
 void PrintObject::ironing()
 {
     if (this->set_started(posIroning)) {
+        SLIC3R_TRACE_ZONE("PrintObject::ironing");
         BOOST_LOG_TRIVIAL(debug) << "Ironing in parallel - start";
         tbb::parallel_for(
             // Ironing starting with layer 0 to support ironing all surfaces.
@@ -475,6 +551,7 @@ void PrintObject::ironing()
 void PrintObject::generate_support_spots()
 {
     if (this->set_started(posSupportSpotsSearch)) {
+        SLIC3R_TRACE_ZONE("PrintObject::generate_support_spots");
         BOOST_LOG_TRIVIAL(debug) << "Searching support spots - start";
         m_print->set_status(65, _u8L("Searching support spots"));
         if (!this->shared_regions()->generated_support_points.has_value()) {
@@ -499,6 +576,7 @@ void PrintObject::generate_support_spots()
 void PrintObject::generate_support_material()
 {
     if (this->set_started(posSupportMaterial)) {
+        SLIC3R_TRACE_ZONE("PrintObject::generate_support_material");
         this->clear_support_layers();
         if ((this->has_support() && m_layers.size() > 1) || (this->has_raft() && ! m_layers.empty())) {
             m_print->set_status(70, _u8L("Generating support material"));    
@@ -520,6 +598,7 @@ void PrintObject::generate_support_material()
 void PrintObject::estimate_curled_extrusions()
 {
     if (this->set_started(posEstimateCurledExtrusions)) {
+        SLIC3R_TRACE_ZONE("PrintObject::estimate_curled_extrusions");
         if (this->print()->config().avoid_crossing_curled_overhangs ||
             std::any_of(this->print()->m_print_regions.begin(), this->print()->m_print_regions.end(),
                         [](const PrintRegion *region) { return region->config().enable_dynamic_overhang_speeds.getBool(); })) {
@@ -544,6 +623,7 @@ void PrintObject::estimate_curled_extrusions()
 std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare_adaptive_infill_data(
     const std::vector<std::pair<const Surface *, float>> &surfaces_w_bottom_z) const
 {
+    SLIC3R_TRACE_ZONE("PrintObject::prepare_adaptive_infill_data");
     using namespace FillAdaptive;
 
     auto [adaptive_line_spacing, support_line_spacing] = adaptive_fill_line_spacing(*this);
@@ -581,6 +661,7 @@ std::pair<FillAdaptive::OctreePtr, FillAdaptive::OctreePtr> PrintObject::prepare
 
 FillLightning::GeneratorPtr PrintObject::prepare_lightning_infill_data()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::prepare_lightning_infill_data");
     bool     has_lightning_infill = false;
     coordf_t lightning_density    = 0.;
     size_t   lightning_cnt        = 0;
@@ -637,222 +718,242 @@ bool PrintObject::invalidate_state_by_config_options(
         return false;
 
     std::vector<PrintObjectStep> steps;
+    std::vector<PrintStep>       print_steps;
     bool invalidated = false;
-    for (const t_config_option_key &opt_key : opt_keys) {
-        if (   opt_key == "brim_width"
-            || opt_key == "brim_separation"
-            || opt_key == "brim_type") {
-            steps.emplace_back(posSupportSpotsSearch);
-            // Brim is printed below supports, support invalidates brim and skirt.
-            steps.emplace_back(posSupportMaterial);
-        } else if (
-               opt_key == "perimeters"
-            || opt_key == "extra_perimeters"
-            || opt_key == "extra_perimeters_on_overhangs"
-            || opt_key == "first_layer_extrusion_width"
-            || opt_key == "perimeter_extrusion_width"
-            || opt_key == "infill_overlap"
-            || opt_key == "external_perimeters_first") {
-            steps.emplace_back(posPerimeters);
-        } else if (
-               opt_key == "gap_fill_enabled"
-            || opt_key == "gap_fill_speed") {
-            // Return true if gap-fill speed has changed from zero value to non-zero or from non-zero value to zero.
-            auto is_gap_fill_changed_state_due_to_speed = [&opt_key, &old_config, &new_config]() -> bool {
-                if (opt_key == "gap_fill_speed") {
-                    const auto *old_gap_fill_speed = old_config.option<ConfigOptionFloat>(opt_key);
-                    const auto *new_gap_fill_speed = new_config.option<ConfigOptionFloat>(opt_key);
-                    assert(old_gap_fill_speed && new_gap_fill_speed);
-                    return (old_gap_fill_speed->value > 0.f && new_gap_fill_speed->value == 0.f) ||
-                           (old_gap_fill_speed->value == 0.f && new_gap_fill_speed->value > 0.f);
-                }
-                return false;
-            };
-
-            // Filtering of unprintable regions in multi-material segmentation depends on if gap-fill is enabled or not.
-            // So step posSlice is invalidated when gap-fill was enabled/disabled by option "gap_fill_enabled" or by
-            // changing "gap_fill_speed" to force recomputation of the multi-material segmentation.
-            if (this->is_mm_painted() && (opt_key == "gap_fill_enabled" || (opt_key == "gap_fill_speed" && is_gap_fill_changed_state_due_to_speed())))
-                steps.emplace_back(posSlice);
-            steps.emplace_back(posPerimeters);
-        } else if (
-               opt_key == "layer_height"
-            || opt_key == "mmu_segmented_region_max_width"
-            || opt_key == "raft_layers"
-            || opt_key == "raft_contact_distance"
-            || opt_key == "slice_closing_radius"
-            || opt_key == "slicing_mode") {
-            steps.emplace_back(posSlice);
-		} else if (
-               opt_key == "elefant_foot_compensation"
-            || opt_key == "support_material_contact_distance" 
-            || opt_key == "xy_size_compensation") {
-            steps.emplace_back(posSlice);
-        } else if (opt_key == "support_material") {
-            steps.emplace_back(posSupportMaterial);
-            if (m_config.support_material_contact_distance == 0.) {
-            	// Enabling / disabling supports while soluble support interface is enabled.
-            	// This changes the bridging logic (bridging enabled without supports, disabled with supports).
-            	// Reset everything.
-            	// See GH #1482 for details.
-	            steps.emplace_back(posSlice);
-	        }
-        } else if (
-        	   opt_key == "support_material_auto"
-            || opt_key == "support_material_angle"
-            || opt_key == "support_material_buildplate_only"
-            || opt_key == "support_material_enforce_layers"
-            || opt_key == "support_material_extruder"
-            || opt_key == "support_material_extrusion_width"
-            || opt_key == "support_material_bottom_contact_distance"
-            || opt_key == "support_material_interface_layers"
-            || opt_key == "support_material_bottom_interface_layers"
-            || opt_key == "support_material_interface_pattern"
-            || opt_key == "support_material_interface_contact_loops"
-            || opt_key == "support_material_interface_extruder"
-            || opt_key == "support_material_interface_spacing"
-            || opt_key == "support_material_pattern"
-            || opt_key == "support_material_style"
-            || opt_key == "support_material_xy_spacing"
-            || opt_key == "support_material_spacing"
-            || opt_key == "support_material_closing_radius"
-            || opt_key == "support_material_synchronize_layers"
-            || opt_key == "support_material_threshold"
-            || opt_key == "support_material_with_sheath"
-            || opt_key == "support_tree_angle"
-            || opt_key == "support_tree_angle_slow"
-            || opt_key == "support_tree_branch_diameter"
-            || opt_key == "support_tree_branch_diameter_angle"
-            || opt_key == "support_tree_branch_diameter_double_wall"
-            || opt_key == "support_tree_top_rate"
-            || opt_key == "support_tree_branch_distance"
-            || opt_key == "support_tree_tip_diameter"
-            || opt_key == "raft_expansion"
-            || opt_key == "raft_first_layer_density"
-            || opt_key == "raft_first_layer_expansion"
-            || opt_key == "dont_support_bridges"
-            || opt_key == "first_layer_extrusion_width") {
-            steps.emplace_back(posSupportMaterial);
-        } else if (opt_key == "bottom_solid_layers") {
-            steps.emplace_back(posPrepareInfill);
-            if (m_print->config().spiral_vase) {
-                // Changing the number of bottom layers when a spiral vase is enabled requires re-slicing the object again.
-                // Otherwise, holes in the bottom layers could be filled, as is reported in GH #5528.
-                steps.emplace_back(posSlice);
-            }
-        } else if (
-               opt_key == "interface_shells"
-            || opt_key == "infill_only_where_needed"
-            || opt_key == "infill_every_layers"
-            || opt_key == "solid_infill_every_layers"
-            || opt_key == "bottom_solid_min_thickness"
-            || opt_key == "top_solid_layers"
-            || opt_key == "top_solid_min_thickness"
-            || opt_key == "solid_infill_below_area"
-            || opt_key == "infill_extruder"
-            || opt_key == "solid_infill_extruder"
-            || opt_key == "infill_extrusion_width"
-            || opt_key == "bridge_angle") {
-            steps.emplace_back(posPrepareInfill);
-        } else if (
-               opt_key == "top_fill_pattern"
-            || opt_key == "bottom_fill_pattern"
-            || opt_key == "external_fill_link_max_length"
-            || opt_key == "fill_angle"
-            || opt_key == "infill_anchor"
-            || opt_key == "infill_anchor_max"
-            || opt_key == "top_infill_extrusion_width"
-            || opt_key == "first_layer_extrusion_width") {
-            steps.emplace_back(posInfill);
-        } else if (opt_key == "fill_pattern") {
-            steps.emplace_back(posPrepareInfill);
-        } else if (opt_key == "fill_density") {
-            // One likely wants to reslice only when switching between zero infill to simulate boolean difference (subtracting volumes),
-            // normal infill and 100% (solid) infill.
-            const auto *old_density = old_config.option<ConfigOptionPercent>(opt_key);
-            const auto *new_density = new_config.option<ConfigOptionPercent>(opt_key);
-            assert(old_density && new_density);
-            //FIXME Vojtech is not quite sure about the 100% here, maybe it is not needed.
-            if (is_approx(old_density->value, 0.) || is_approx(old_density->value, 100.) ||
-                is_approx(new_density->value, 0.) || is_approx(new_density->value, 100.))
-                steps.emplace_back(posPerimeters);
-            steps.emplace_back(posPrepareInfill);
-        } else if (opt_key == "solid_infill_extrusion_width") {
-            // This value is used for calculating perimeter - infill overlap, thus perimeters need to be recalculated.
-            steps.emplace_back(posPerimeters);
-            steps.emplace_back(posPrepareInfill);
-        } else if (
-               opt_key == "external_perimeter_extrusion_width"
-            || opt_key == "perimeter_extruder"
-            || opt_key == "fuzzy_skin"
-            || opt_key == "fuzzy_skin_thickness"
-            || opt_key == "fuzzy_skin_point_dist"
-            || opt_key == "overhangs"
-            || opt_key == "thin_walls"
-            || opt_key == "thick_bridges") {
-            steps.emplace_back(posPerimeters);
-            steps.emplace_back(posSupportMaterial);
-        } else if (opt_key == "bridge_flow_ratio") {
-            if (m_config.support_material_contact_distance > 0.) {
-            	// Only invalidate due to bridging if bridging is enabled.
-            	// If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
-            	steps.emplace_back(posPerimeters);
-            	steps.emplace_back(posInfill);
-	            steps.emplace_back(posSupportMaterial);
-	        }
-        } else if (
-               opt_key == "use_nonplanar_layers"
-            || opt_key == "nonplanar_layers_angle"
-            || opt_key == "nonplanar_layers_height") {
-            // steps.emplace_back(posPerimeters);
-            // steps.emplace_back(posInfill);
-            steps.emplace_back(posSlice);
-        } else if (
-            opt_key == "perimeter_generator"
-            || opt_key == "wall_transition_length"
-            || opt_key == "wall_transition_filter_deviation"
-            || opt_key == "wall_transition_angle"
-            || opt_key == "wall_distribution_count"
-            || opt_key == "min_feature_size"
-            || opt_key == "min_bead_width") {
-            steps.emplace_back(posSlice);
-        } else if (
-               opt_key == "seam_position"
-            || opt_key == "seam_preferred_direction"
-            || opt_key == "seam_preferred_direction_jitter"
-            || opt_key == "support_material_speed"
-            || opt_key == "support_material_interface_speed"
-            || opt_key == "bridge_speed"
-            || opt_key == "enable_dynamic_overhang_speeds"
-            || opt_key == "overhang_speed_0"
-            || opt_key == "overhang_speed_1"
-            || opt_key == "overhang_speed_2"
-            || opt_key == "overhang_speed_3"
-            || opt_key == "external_perimeter_speed"
-            || opt_key == "infill_speed"
-            || opt_key == "perimeter_speed"
-            || opt_key == "small_perimeter_speed"
-            || opt_key == "solid_infill_speed"
-            || opt_key == "top_solid_infill_speed") {
-            invalidated |= m_print->invalidate_step(psGCodeExport);
-        } else if (
-               opt_key == "wipe_into_infill"
-            || opt_key == "wipe_into_objects") {
-            invalidated |= m_print->invalidate_step(psWipeTower);
-            invalidated |= m_print->invalidate_step(psGCodeExport);
-        } else {
+    for (const t_config_option_key &opt_key : opt_keys)
+        if (! this->steps_invalidated_by_config_option(old_config, new_config, opt_key, steps, print_steps)) {
             // for legacy, if we can't handle this option let's invalidate all steps
             this->invalidate_all_steps();
             invalidated = true;
         }
-    }
 
+    sort_remove_duplicates(print_steps);
+    for (PrintStep step : print_steps)
+        invalidated |= m_print->invalidate_step(step);
     sort_remove_duplicates(steps);
     for (PrintObjectStep step : steps)
         invalidated |= this->invalidate_step(step);
     return invalidated;
 }
 
+bool PrintObject::collect_steps_of_config_option(const ConfigOptionResolver *old_config, const ConfigOptionResolver *new_config,
+    const t_config_option_key &opt_key, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const
+{
+    if (   opt_key == "brim_width"
+        || opt_key == "brim_separation"
+        || opt_key == "brim_type") {
+        steps.emplace_back(posSupportSpotsSearch);
+        // Brim is printed below supports, support invalidates brim and skirt.
+        steps.emplace_back(posSupportMaterial);
+    } else if (
+           opt_key == "perimeters"
+        || opt_key == "extra_perimeters"
+        || opt_key == "extra_perimeters_on_overhangs"
+        || opt_key == "first_layer_extrusion_width"
+        || opt_key == "perimeter_extrusion_width"
+        || opt_key == "infill_overlap"
+        || opt_key == "external_perimeters_first") {
+        steps.emplace_back(posPerimeters);
+    } else if (
+           opt_key == "gap_fill_enabled"
+        || opt_key == "gap_fill_speed") {
+        // Return true if gap-fill speed has changed from zero value to non-zero or from non-zero value to zero.
+        auto is_gap_fill_changed_state_due_to_speed = [&opt_key, old_config, new_config]() -> bool {
+            if (old_config == nullptr)
+                // Collecting all the steps the option may influence.
+                return true;
+            if (opt_key == "gap_fill_speed") {
+                const auto *old_gap_fill_speed = old_config->option<ConfigOptionFloat>(opt_key);
+                const auto *new_gap_fill_speed = new_config->option<ConfigOptionFloat>(opt_key);
+                assert(old_gap_fill_speed && new_gap_fill_speed);
+                return (old_gap_fill_speed->value > 0.f && new_gap_fill_speed->value == 0.f) ||
+                       (old_gap_fill_speed->value == 0.f && new_gap_fill_speed->value > 0.f);
+            }
+            return false;
+        };
+
+        // Filtering of unprintable regions in multi-material segmentation depends on if gap-fill is enabled or not.
+        // So step posSlice is invalidated when gap-fill was enabled/disabled by option "gap_fill_enabled" or by
+        // changing "gap_fill_speed" to force recomputation of the multi-material segmentation.
+        if (this->is_mm_painted() && (opt_key == "gap_fill_enabled" || (opt_key == "gap_fill_speed" && is_gap_fill_changed_state_due_to_speed())))
+            steps.emplace_back(posSlice);
+        steps.emplace_back(posPerimeters);
+    } else if (
+           opt_key == "layer_height"
+        || opt_key == "mmu_segmented_region_max_width"
+        || opt_key == "raft_layers"
+        || opt_key == "raft_contact_distance"
+        || opt_key == "slice_closing_radius"
+        || opt_key == "slicing_mode") {
+        steps.emplace_back(posSlice);
+    } else if (
+           opt_key == "elefant_foot_compensation"
+        || opt_key == "support_material_contact_distance" 
+        || opt_key == "xy_size_compensation") {
+        steps.emplace_back(posSlice);
+    } else if (opt_key == "support_material") {
+        steps.emplace_back(posSupportMaterial);
+        if (m_config.support_material_contact_distance == 0.) {
+            // Enabling / disabling supports while soluble support interface is enabled.
+            // This changes the bridging logic (bridging enabled without supports, disabled with supports).
+            // Reset everything.
+            // See GH #1482 for details.
+            steps.emplace_back(posSlice);
+        }
+    } else if (
+           opt_key == "support_material_auto"
+        || opt_key == "support_material_angle"
+        || opt_key == "support_material_buildplate_only"
+        || opt_key == "support_material_enforce_layers"
+        || opt_key == "support_material_extruder"
+        || opt_key == "support_material_extrusion_width"
+        || opt_key == "support_material_bottom_contact_distance"
+        || opt_key == "support_material_interface_layers"
+        || opt_key == "support_material_bottom_interface_layers"
+        || opt_key == "support_material_interface_pattern"
+        || opt_key == "support_material_interface_contact_loops"
+        || opt_key == "support_material_interface_extruder"
+        || opt_key == "support_material_interface_spacing"
+        || opt_key == "support_material_pattern"
+        || opt_key == "support_material_style"
+        || opt_key == "support_material_xy_spacing"
+        || opt_key == "support_material_spacing"
+        || opt_key == "support_material_closing_radius"
+        || opt_key == "support_material_synchronize_layers"
+        || opt_key == "support_material_threshold"
+        || opt_key == "support_material_with_sheath"
+        || opt_key == "support_tree_angle"
+        || opt_key == "support_tree_angle_slow"
+        || opt_key == "support_tree_branch_diameter"
+        || opt_key == "support_tree_branch_diameter_angle"
+        || opt_key == "support_tree_branch_diameter_double_wall"
+        || opt_key == "support_tree_top_rate"
+        || opt_key == "support_tree_branch_distance"
+        || opt_key == "support_tree_tip_diameter"
+        || opt_key == "raft_expansion"
+        || opt_key == "raft_first_layer_density"
+        || opt_key == "raft_first_layer_expansion"
+        || opt_key == "dont_support_bridges"
+        || opt_key == "first_layer_extrusion_width") {
+        steps.emplace_back(posSupportMaterial);
+    } else if (opt_key == "bottom_solid_layers") {
+        steps.emplace_back(posPrepareInfill);
+        if (m_print->config().spiral_vase) {
+            // Changing the number of bottom layers when a spiral vase is enabled requires re-slicing the object again.
+            // Otherwise, holes in the bottom layers could be filled, as is reported in GH #5528.
+            steps.emplace_back(posSlice);
+        }
+    } else if (
+           opt_key == "interface_shells"
+        || opt_key == "infill_only_where_needed"
+        || opt_key == "infill_every_layers"
+        || opt_key == "solid_infill_every_layers"
+        || opt_key == "bottom_solid_min_thickness"
+        || opt_key == "top_solid_layers"
+        || opt_key == "top_solid_min_thickness"
+        || opt_key == "solid_infill_below_area"
+        || opt_key == "infill_extruder"
+        || opt_key == "solid_infill_extruder"
+        || opt_key == "infill_extrusion_width"
+        || opt_key == "bridge_angle") {
+        steps.emplace_back(posPrepareInfill);
+    } else if (
+           opt_key == "top_fill_pattern"
+        || opt_key == "bottom_fill_pattern"
+        || opt_key == "external_fill_link_max_length"
+        || opt_key == "fill_angle"
+        || opt_key == "infill_anchor"
+        || opt_key == "infill_anchor_max"
+        || opt_key == "top_infill_extrusion_width"
+        || opt_key == "first_layer_extrusion_width") {
+        steps.emplace_back(posInfill);
+    } else if (opt_key == "fill_pattern") {
+        steps.emplace_back(posPrepareInfill);
+    } else if (opt_key == "fill_density") {
+        // One likely wants to reslice only when switching between zero infill to simulate boolean difference (subtracting volumes),
+        // normal infill and 100% (solid) infill.
+        auto is_density_changed_to_or_from_limit = [&opt_key, old_config, new_config]() -> bool {
+            if (old_config == nullptr)
+                // Collecting all the steps the option may influence.
+                return true;
+            const auto *old_density = old_config->option<ConfigOptionPercent>(opt_key);
+            const auto *new_density = new_config->option<ConfigOptionPercent>(opt_key);
+            assert(old_density && new_density);
+            //FIXME Vojtech is not quite sure about the 100% here, maybe it is not needed.
+            return is_approx(old_density->value, 0.) || is_approx(old_density->value, 100.) ||
+                   is_approx(new_density->value, 0.) || is_approx(new_density->value, 100.);
+        };
+        if (is_density_changed_to_or_from_limit())
+            steps.emplace_back(posPerimeters);
+        steps.emplace_back(posPrepareInfill);
+    } else if (opt_key == "solid_infill_extrusion_width") {
+        // This value is used for calculating perimeter - infill overlap, thus perimeters need to be recalculated.
+        steps.emplace_back(posPerimeters);
+        steps.emplace_back(posPrepareInfill);
+    } else if (
+           opt_key == "external_perimeter_extrusion_width"
+        || opt_key == "perimeter_extruder"
+        || opt_key == "fuzzy_skin"
+        || opt_key == "fuzzy_skin_thickness"
+        || opt_key == "fuzzy_skin_point_dist"
+        || opt_key == "overhangs"
+        || opt_key == "thin_walls"
+        || opt_key == "thick_bridges") {
+        steps.emplace_back(posPerimeters);
+        steps.emplace_back(posSupportMaterial);
+    } else if (opt_key == "bridge_flow_ratio") {
+        if (m_config.support_material_contact_distance > 0.) {
+            // Only invalidate due to bridging if bridging is enabled.
+            // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
+            steps.emplace_back(posPerimeters);
+            steps.emplace_back(posInfill);
+            steps.emplace_back(posSupportMaterial);
+        }
+    } else if (
+           opt_key == "use_nonplanar_layers"
+        || opt_key == "nonplanar_layers_angle"
+        || opt_key == "nonplanar_layers_height") {
+        // steps.emplace_back(posPerimeters);
+        // steps.emplace_back(posInfill);
+        steps.emplace_back(posSlice);
+    } else if (
+        opt_key == "perimeter_generator"
+        || opt_key == "wall_transition_length"
+        || opt_key == "wall_transition_filter_deviation"
+        || opt_key == "wall_transition_angle"
+        || opt_key == "wall_distribution_count"
+        || opt_key == "min_feature_size"
+        || opt_key == "min_bead_width") {
+        steps.emplace_back(posSlice);
+    } else if (
+           opt_key == "seam_position"
+        || opt_key == "seam_preferred_direction"
+        || opt_key == "seam_preferred_direction_jitter"
+        || opt_key == "support_material_speed"
+        || opt_key == "support_material_interface_speed"
+        || opt_key == "bridge_speed"
+        || opt_key == "enable_dynamic_overhang_speeds"
+        || opt_key == "overhang_speed_0"
+        || opt_key == "overhang_speed_1"
+        || opt_key == "overhang_speed_2"
+        || opt_key == "overhang_speed_3"
+        || opt_key == "external_perimeter_speed"
+        || opt_key == "infill_speed"
+        || opt_key == "perimeter_speed"
+        || opt_key == "small_perimeter_speed"
+        || opt_key == "solid_infill_speed"
+        || opt_key == "top_solid_infill_speed") {
+        print_steps.emplace_back(psGCodeExport);
+    } else if (
+           opt_key == "wipe_into_infill"
+        || opt_key == "wipe_into_objects") {
+        print_steps.emplace_back(psWipeTower);
+        print_steps.emplace_back(psGCodeExport);
+    } else
+        return false;
+    return true;
+}
+
 bool PrintObject::invalidate_step(PrintObjectStep step)
 {
 	bool invalidated = Inherited::invalidate_step(step);
@@ -919,6 +1020,7 @@ void PrintObject::cleanup()
 // If a part of a region is of stBottom and stTop, the stBottom wins.
 void PrintObject::detect_surfaces_type()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::detect_surfaces_type");
     BOOST_LOG_TRIVIAL(info) << "Detecting solid surfaces..." << log_memory_info();
 
     // Interface shells: the intersecting parts are treated as self standing objects supporting each other.
@@ -971,7 +1073,8 @@ void PrintObject::detect_surfaces_type()
 
                     //Find mark nonplanar surfaces
                     Surfaces nonplanar_surfaces;
-                    for(auto& surface : layerm->nonplanar_surfaces()) {
+                    for(const NonplanarSurfacePtr& surface_ptr : layerm->nonplanar_surfaces()) {
+                        const NonplanarSurface &surface = *surface_ptr;
                         surfaces_append(
                             nonplanar_surfaces,
                             intersection_ex(surface.horizontal_projection(), union_ex(layerm->slices().surfaces)),
@@ -1143,7 +1246,7 @@ void PrintObject::detect_surfaces_type()
 }
 
 bool
-PrintObject::check_nonplanar_collisions(NonplanarSurface &surface)
+PrintObject::check_nonplanar_collisions(const NonplanarSurface &surface)
 {
     Polygons nonplanar_polygon = to_polygons(surface.horizontal_projection());
 	for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
@@ -1237,7 +1340,12 @@ PrintObject::detect_nonplanar_surfaces()
     //skip if not active
     if(!m_config.use_nonplanar_layers.value) return;
 
+    BOOST_LOG_TRIVIAL(debug) << "Detecting nonplanar surfaces - start";
+
     bool moved_surfaces = false;
+    double max_layer_height = 0.;
+    for (const Layer *layer : m_layers)
+        max_layer_height = std::max(max_layer_height, layer->height);
 
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
         m_print->throw_if_canceled();
@@ -1245,102 +1353,146 @@ PrintObject::detect_nonplanar_surfaces()
         const PrintRegion &region = this->printing_region(region_id);
 
         //repeat detection for every nonplanar_surface
-        for (auto& nonplanar_surface: this->nonplanar_surfaces()) {
-            float distance_to_top = 0.0f;            
+        for (const NonplanarSurfacePtr& nonplanar_surface_ptr : this->nonplanar_surfaces()) {
+            const NonplanarSurface &nonplanar_surface = *nonplanar_surface_ptr;
+            const ExPolygons       &projection        = nonplanar_surface.horizontal_projection();
+            float distance_to_top = 0.0f;
             for (int shell_thickness = 0; region.config().top_solid_layers > shell_thickness; ++shell_thickness){
-                //search home layer where the area is projected to
-                for (LayerPtrs::reverse_iterator home_layer_it = this->m_layers.rbegin(); home_layer_it != this->m_layers.rend(); ++home_layer_it){
-                    Layer* home_layer        = *home_layer_it;
-                    LayerRegion &home_layerm = *home_layer->m_regions[region_id];
-                    //continue if home layer is not maximum height of nonplanar_surface - the desired distance to the top of the surface for more than one top solid layer
-                    if (home_layer->slice_z > nonplanar_surface.stats.max.z - distance_to_top) continue;
-
-                    //process layers
-                    for (LayerPtrs::iterator layer_it = this->m_layers.begin(); layer_it != this->m_layers.end(); ++layer_it){
-                        Layer* layer        = *layer_it;
-                        LayerRegion &layerm = *layer->m_regions[region_id];
-
-                        //skip if below minimum nonplanar surface and below the last possible surface layer
-                        if (nonplanar_surface.stats.min.z-layer->height-distance_to_top > layer->slice_z) continue;
-                        //break if above home layer
-                        if (home_layer->slice_z < layer->slice_z) break;
-                        //skip if bottom layer because we dont want to project the bottom layers up
-                        if (layer->lower_layer == NULL) continue;
-
-                        BOOST_LOG_TRIVIAL(trace) << "detect_nonplanar_surfaces for region " << region_id << " and layer " << layer->print_z;
-
-                        Surfaces layerm_slices_surfaces = layerm.slices().surfaces;
-                        SurfaceCollection topNonplanar;
-                        if (layer->upper_layer != NULL) {
-                            //append layers where nothing is above
-                            Layer* upper_layer = layer->upper_layer;
-                            LayerRegion &upper_layerm = *upper_layer->m_regions[region_id];
-                            Surfaces upper_surfaces = upper_layerm.slices().surfaces;
-                            topNonplanar.append(
-                                intersection_ex(
-                                    nonplanar_surface.horizontal_projection(),
-                                    union_ex(
-                                        diff_ex(
-                                            layerm_slices_surfaces, 
-                                            upper_surfaces, 
-                                            ApplySafetyOffset::No)), 
-                                    ApplySafetyOffset::No),
-                                (shell_thickness == 0 ? stTopNonplanar : stInternalSolidNonplanar),
-                                distance_to_top
-                            );
+                const SurfaceType surface_type = shell_thickness == 0 ? stTopNonplanar : stInternalSolidNonplanar;
+
+                //search home layer where the area is projected to: the topmost layer not above the maximum height of nonplanar_surface
+                //minus the desired distance to the top of the surface for more than one top solid layer
+                auto it_home = std::upper_bound(m_layers.begin(), m_layers.end(), nonplanar_surface.stats.max.z - distance_to_top,
+                    [](float z, const Layer *layer) { return z < layer->slice_z; });
+                if (it_home == m_layers.begin())
+                    // no home layer for this shell, neither for the following ones
+                    break;
+                const size_t idx_home    = it_home - m_layers.begin() - 1;
+                Layer       *home_layer  = m_layers[idx_home];
+                LayerRegion &home_layerm = *home_layer->m_regions[region_id];
+
+                //skip layers below minimum nonplanar surface and below the last possible surface layer
+                auto below_surface = [&nonplanar_surface, distance_to_top](const Layer *layer) {
+                    return nonplanar_surface.stats.min.z - layer->height - distance_to_top > layer->slice_z;
+                };
+                //slice_z + height = print_z + height / 2 is not monotonous with variable layer height, print_z is.
+                //No layer with print_z below the minimum surface height minus half of the maximum layer height touches the surface,
+                //the first layer touching the surface is searched linearly from there.
+                auto it_begin = std::lower_bound(m_layers.begin(), it_home, nonplanar_surface.stats.min.z - distance_to_top - 0.5 * max_layer_height,
+                    [](const Layer *layer, double z) { return layer->print_z < z; });
+                while (it_begin != it_home && below_surface(*it_begin))
+                    ++ it_begin;
+                //skip the bottom layer because we dont want to project the bottom layers up
+                const size_t idx_begin = std::max<size_t>(1, it_begin - m_layers.begin());
+
+                auto classify_layer = [this, region_id, distance_to_top, surface_type, &projection, &below_surface](size_t idx_layer) {
+                    Layer         *layer  = m_layers[idx_layer];
+                    SurfaceCollection topNonplanar;
+                    //a thin layer above a more than three times thicker layer may still be below the surface
+                    if (below_surface(layer))
+                        return topNonplanar;
+                    const Surfaces &layerm_slices_surfaces = layer->m_regions[region_id]->slices().surfaces;
+                    if (layer->upper_layer != NULL) {
+                        //append layers where nothing is above
+                        const Surfaces &upper_surfaces = layer->upper_layer->m_regions[region_id]->slices().surfaces;
+                        topNonplanar.append(
+                            intersection_ex(
+                                projection,
+                                union_ex(
+                                    diff_ex(
+                                        layerm_slices_surfaces, 
+                                        upper_surfaces, 
+                                        ApplySafetyOffset::No)), 
+                                ApplySafetyOffset::No),
+                            surface_type,
+                            distance_to_top
+                        );
 
-                            // append layers where nonplanar areas with a lower distance_to_top are above
-                            SurfaceCollection upper_nonplanar;
-                            for (auto& s : upper_surfaces){
-                                if (s.is_nonplanar() && s.distance_to_top < distance_to_top) {
-                                    upper_nonplanar.surfaces.push_back(s);
-                                }
+                        // append layers where nonplanar areas with a lower distance_to_top are above
+                        SurfaceCollection upper_nonplanar;
+                        for (auto& s : upper_surfaces){
+                            if (s.is_nonplanar() && s.distance_to_top < distance_to_top) {
+                                upper_nonplanar.surfaces.push_back(s);
                             }
-                            if (upper_nonplanar.size() > 0)
-                                topNonplanar.append(
-                                    intersection_ex(
-                                        nonplanar_surface.horizontal_projection(),
-                                        to_expolygons(upper_nonplanar.surfaces),
-                                        ApplySafetyOffset::No),
-                                    (shell_thickness == 0 ? stTopNonplanar : stInternalSolidNonplanar),
-                                    distance_to_top
-                                );
                         }
-                        else {
+                        if (upper_nonplanar.size() > 0)
                             topNonplanar.append(
                                 intersection_ex(
-                                    nonplanar_surface.horizontal_projection(),
-                                    union_ex(to_expolygons(layerm_slices_surfaces)),
+                                    projection,
+                                    to_expolygons(upper_nonplanar.surfaces),
                                     ApplySafetyOffset::No),
-                                (shell_thickness == 0 ? stTopNonplanar : stInternalSolidNonplanar),
+                                surface_type,
                                 distance_to_top
                             );
-                        }
-
+                    }
+                    else {
+                        topNonplanar.append(
+                            intersection_ex(
+                                projection,
+                                union_ex(to_expolygons(layerm_slices_surfaces)),
+                                ApplySafetyOffset::No),
+                            surface_type,
+                            distance_to_top
+                        );
+                    }
+                    return topNonplanar;
+                };
+
+                auto remove_from_layer = [this, region_id](size_t idx_layer, const SurfaceCollection &topNonplanar) {
+                    BOOST_LOG_TRIVIAL(trace) << "Removing " << topNonplanar.size() << " nonplanar surfaces from layer " << m_layers[idx_layer]->print_z;
+                    m_layers[idx_layer]->m_regions[region_id]->remove_nonplanar_slices(topNonplanar);
+                };
+
+                auto move_to_home_layer = [&](SurfaceCollection &&topNonplanar) {
+                    BOOST_LOG_TRIVIAL(trace) << "Adding " << topNonplanar.size() << " nonplanar surfaces to layer " << home_layer->print_z;
+                    // move nonplanar surfaces to home layer
+                    home_layerm.append_top_nonplanar_slices(std::move(topNonplanar));
+                    //save nonplanar_surface to home_layers nonplanar_surface list
+                    home_layerm.append_nonplanar_surface(nonplanar_surface_ptr);
+                    moved_surfaces = true;
+                };
+
+                if (idx_begin <= idx_home) {
+                    // A layer reads its own slices and the slices of the layer above. Up to two layers below the home layer,
+                    // these are not modified before the layer is processed, thus these layers are classified in parallel.
+                    // The two topmost layers read the home layer, which receives the surfaces of the layers below,
+                    // therefore they are processed afterwards in order.
+                    const size_t idx_serial = std::max(idx_begin, idx_home - 1);
+                    std::vector<SurfaceCollection> top_nonplanar(idx_serial - idx_begin);
+                    tbb::parallel_for(
+                        tbb::blocked_range<size_t>(idx_begin, idx_serial),
+                        [this, idx_begin, &top_nonplanar, &classify_layer](const tbb::blocked_range<size_t>& range) {
+                            for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
+                                m_print->throw_if_canceled();
+                                top_nonplanar[idx_layer - idx_begin] = classify_layer(idx_layer);
+                            }
+                        });
+                    tbb::parallel_for(
+                        tbb::blocked_range<size_t>(idx_begin, idx_serial),
+                        [this, idx_begin, &top_nonplanar, &remove_from_layer](const tbb::blocked_range<size_t>& range) {
+                            for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++ idx_layer) {
+                                m_print->throw_if_canceled();
+                                if (top_nonplanar[idx_layer - idx_begin].size() > 0)
+                                    remove_from_layer(idx_layer, top_nonplanar[idx_layer - idx_begin]);
+                            }
+                        });
+                    // keep the order, in which the surfaces are added to the home layer
+                    for (SurfaceCollection &topNonplanar : top_nonplanar)
+                        if (topNonplanar.size() > 0)
+                            move_to_home_layer(std::move(topNonplanar));
+
+                    for (size_t idx_layer = idx_serial; idx_layer <= idx_home; ++ idx_layer) {
+                        BOOST_LOG_TRIVIAL(trace) << "detect_nonplanar_surfaces for region " << region_id << " and layer " << m_layers[idx_layer]->print_z;
+                        SurfaceCollection topNonplanar = classify_layer(idx_layer);
                         if (topNonplanar.size() > 0) {
-                            // layerm.export_region_slices_to_svg_debug("home_layer_append-layerm");
-                            // home_layerm.export_region_slices_to_svg_debug("home_layer_append-home_layerm");
-
-                            BOOST_LOG_TRIVIAL(trace) << "Removing " << topNonplanar.size() << " nonplanar surfaces from layer " << layer->print_z;
-
-                            layerm.remove_nonplanar_slices(topNonplanar);
-
-                            BOOST_LOG_TRIVIAL(trace) << "Adding " << topNonplanar.size() << " nonplanar surfaces to layer " << home_layer->print_z;
-
-                            // move nonplanar surfaces to home layer
-                            home_layerm.append_top_nonplanar_slices(topNonplanar);
-
-                            //save nonplanar_surface to home_layers nonplanar_surface list
-                            home_layerm.append_nonplanar_surface(nonplanar_surface);
-
-                            moved_surfaces = true;
+                            remove_from_layer(idx_layer, topNonplanar);
+                            move_to_home_layer(std::move(topNonplanar));
                         }
                     }
-
-                    //increase distance to the top layer
-                    distance_to_top += home_layer->height;
-                    break;
                 }
+
+                //increase distance to the top layer
+                distance_to_top += home_layer->height;
             }
         }
     }
@@ -1362,6 +1514,8 @@ PrintObject::detect_nonplanar_surfaces()
     } // for each region
 #endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
 
+    BOOST_LOG_TRIVIAL(debug) << "Detecting nonplanar surfaces - end";
+
     //set typed_slices to true to force merge
     m_typed_slices = true;
 }
@@ -1403,6 +1557,7 @@ PrintObject::project_nonplanar_surfaces()
 
 void PrintObject::process_external_surfaces()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::process_external_surfaces");
     BOOST_LOG_TRIVIAL(info) << "Processing external surfaces..." << log_memory_info();
 
     // Cached surfaces covered by some extrusion, defining regions, over which the from the surfaces one layer higher are allowed to expand.
@@ -1496,6 +1651,7 @@ void PrintObject::process_external_surfaces()
 
 void PrintObject::discover_vertical_shells()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::discover_vertical_shells");
     BOOST_LOG_TRIVIAL(info) << "Discovering vertical shells..." << log_memory_info();
 
     struct DiscoverVerticalShellsCacheEntry
@@ -1947,6 +2103,7 @@ template<typename T> void debug_draw(std::string name, const T& a, const T& b, c
 // This method applies bridge flow to the first internal solid layer above sparse infill.
 void PrintObject::bridge_over_infill()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::bridge_over_infill");
     BOOST_LOG_TRIVIAL(info) << "Bridge over infill - Start" << log_memory_info();
 
     struct CandidateSurface
@@ -3041,6 +3198,7 @@ bool PrintObject::update_layer_height_profile(const ModelObject &model_object, c
 
 void PrintObject::discover_horizontal_shells()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::discover_horizontal_shells");
     BOOST_LOG_TRIVIAL(trace) << "discover_horizontal_shells()";
 
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++region_id) {
@@ -3078,6 +3236,7 @@ void PrintObject::discover_horizontal_shells()
 // fill_surfaces but we only turn them into VOID surfaces, thus preserving the boundaries.
 void PrintObject::combine_infill()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::combine_infill");
     // Work on each region separately.
     for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id) {
         const PrintRegion &region = this->printing_region(region_id);
@@ -0,0 +1,756 @@
+#include "PrintObjectCache.hpp"
+
+#include "Exception.hpp"
+#include "ExtrusionEntity.hpp"
+#include "ExtrusionEntityCollection.hpp"
+#include "Layer.hpp"
+#include "Model.hpp"
+#include "Print.hpp"
+#include "libslic3r_version.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+#include <typeinfo>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+//FIXME replace with <boost/md5.hpp> after it becomes mainstream.
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+
+// To be increased whenever the format of the cached layers or the inputs hashed by PrintObject::cache_key() change.
+static constexpr const char *PrintObjectCacheVersion = "1";
+
+// Entries are named by the 32 hex digits of the MD5 hash of their inputs.
+static bool is_cache_entry_name(const std::string &name)
+{
+    return name.size() == 32 && std::all_of(name.begin(), name.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+PrintObjectCache::PrintObjectCache(const std::string &dir, size_t max_size) : m_dir(dir), m_max_size(max_size)
+{
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(dir, ec);
+    if (ec || ! boost::filesystem::is_directory(dir))
+        throw Slic3r::RuntimeError(std::string("Cannot create the cache directory ") + dir + (ec ? ": " + ec.message() : std::string()));
+    this->trim();
+}
+
+bool PrintObjectCache::load(const std::string &key, std::string &data) const
+{
+    const boost::filesystem::path path = boost::filesystem::path(m_dir) / key;
+    boost::nowide::ifstream ifs(path.string(), std::ios::binary);
+    if (! ifs)
+        return false;
+    ifs.seekg(0, std::ios::end);
+    const std::streamoff size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    data.resize(size_t(std::max<std::streamoff>(size, 0)));
+    if (! ifs.read(data.data(), data.size())) {
+        BOOST_LOG_TRIVIAL(warning) << "Failed reading the cache entry " << path.string();
+        data.clear();
+        return false;
+    }
+    // Mark the entry as the most recently used.
+    boost::system::error_code ec;
+    boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+    return true;
+}
+
+bool PrintObjectCache::contains(const std::string &key) const
+{
+    boost::system::error_code ec;
+    return boost::filesystem::is_regular_file(boost::filesystem::path(m_dir) / key, ec);
+}
+
+void PrintObjectCache::store(const std::string &key, const std::string &data)
+{
+    assert(is_cache_entry_name(key));
+    const boost::filesystem::path path = boost::filesystem::path(m_dir) / key;
+    // Renaming a temporary file is atomic on the same file system.
+    const boost::filesystem::path temp = boost::filesystem::path(m_dir) / (key + boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp").string());
+    boost::system::error_code ec;
+    {
+        boost::nowide::ofstream ofs(temp.string(), std::ios::binary);
+        ofs.write(data.data(), data.size());
+        ofs.close();
+        if (! ofs) {
+            BOOST_LOG_TRIVIAL(warning) << "Failed writing the cache entry " << temp.string();
+            boost::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    boost::filesystem::rename(temp, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(warning) << "Failed renaming the cache entry " << temp.string() << ": " << ec.message();
+        boost::filesystem::remove(temp, ec);
+        return;
+    }
+    this->trim();
+}
+
+void PrintObjectCache::remove(const std::string &key)
+{
+    boost::system::error_code ec;
+    boost::filesystem::remove(boost::filesystem::path(m_dir) / key, ec);
+}
+
+void PrintObjectCache::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    struct Entry {
+        boost::filesystem::path path;
+        std::time_t             time;
+        uintmax_t               size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t          total_size = 0;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(m_dir, ec), end; ! ec && it != end; it.increment(ec)) {
+        // Only touch the files looking like cache entries, leave the temporary files of the entries being written alone.
+        if (! is_cache_entry_name(it->path().filename().string()))
+            continue;
+        boost::system::error_code ec_entry;
+        Entry entry { it->path(), boost::filesystem::last_write_time(it->path(), ec_entry), 0 };
+        if (! ec_entry)
+            entry.size = boost::filesystem::file_size(it->path(), ec_entry);
+        if (! ec_entry) {
+            total_size += entry.size;
+            entries.emplace_back(std::move(entry));
+        }
+    }
+    if (total_size <= m_max_size)
+        return;
+
+    // Remove the least recently used entries first.
+    std::sort(entries.begin(), entries.end(), [](const Entry &l, const Entry &r) { return l.time < r.time; });
+    for (const Entry &entry : entries) {
+        if (total_size <= m_max_size)
+            break;
+        boost::system::error_code ec_entry;
+        if (boost::filesystem::remove(entry.path, ec_entry))
+            total_size -= entry.size;
+    }
+}
+
+// Binary serialization of the layers in the native format of the machine.
+class CacheWriter
+{
+public:
+    template<typename T> void scalar(const T v) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only scalars are written directly");
+        m_data.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+    void                size(size_t n) { this->scalar(uint64_t(n)); }
+    std::string&        data() { return m_data; }
+
+private:
+    std::string         m_data;
+};
+
+// Throws Slic3r::RuntimeError on a truncated or corrupted entry.
+class CacheReader
+{
+public:
+    explicit CacheReader(const std::string &data) : m_ptr(data.data()), m_end(data.data() + data.size()) {}
+
+    template<typename T> T scalar() {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only scalars are read directly");
+        if (size_t(m_end - m_ptr) < sizeof(T))
+            throw Slic3r::RuntimeError("Truncated cache entry");
+        T v;
+        memcpy(&v, m_ptr, sizeof(T));
+        m_ptr += sizeof(T);
+        return v;
+    }
+    // Number of items of a container. Each item occupies at least a byte, which limits the size of a corrupted entry.
+    size_t size() {
+        auto n = this->scalar<uint64_t>();
+        if (n > uint64_t(m_end - m_ptr))
+            throw Slic3r::RuntimeError("Corrupted cache entry");
+        return size_t(n);
+    }
+    bool at_end() const { return m_ptr == m_end; }
+
+private:
+    const char *m_ptr;
+    const char *m_end;
+};
+
+template<typename T, typename Alloc> static void cache_write(CacheWriter &w, const std::vector<T, Alloc> &v);
+template<typename T, typename Alloc> static void cache_read(CacheReader &r, std::vector<T, Alloc> &v);
+
+static void cache_write(CacheWriter &w, const Point &pt) { w.scalar(pt.x()); w.scalar(pt.y()); }
+static void cache_read(CacheReader &r, Point &pt) { pt.x() = r.scalar<coord_t>(); pt.y() = r.scalar<coord_t>(); }
+
+static void cache_write(CacheWriter &w, const Polygon &polygon) { cache_write(w, polygon.points); }
+static void cache_read(CacheReader &r, Polygon &polygon) { cache_read(r, polygon.points); }
+
+static void cache_write(CacheWriter &w, const Polyline &polyline)
+{
+    cache_write(w, polyline.points);
+    w.size(polyline.z.size());
+    for (coord_t z : polyline.z)
+        w.scalar(z);
+}
+static void cache_read(CacheReader &r, Polyline &polyline)
+{
+    cache_read(r, polyline.points);
+    polyline.z.assign(r.size(), 0);
+    for (coord_t &z : polyline.z)
+        z = r.scalar<coord_t>();
+}
+
+static void cache_write(CacheWriter &w, const ExPolygon &expoly) { cache_write(w, expoly.contour); cache_write(w, expoly.holes); }
+static void cache_read(CacheReader &r, ExPolygon &expoly) { cache_read(r, expoly.contour); cache_read(r, expoly.holes); }
+
+static void cache_write(CacheWriter &w, const BoundingBox &bbox)
+{
+    cache_write(w, bbox.min);
+    cache_write(w, bbox.max);
+    w.scalar(bbox.defined);
+}
+static void cache_read(CacheReader &r, BoundingBox &bbox)
+{
+    cache_read(r, bbox.min);
+    cache_read(r, bbox.max);
+    bbox.defined = r.scalar<bool>();
+}
+
+static void cache_write(CacheWriter &w, const CurledLine &line)
+{
+    cache_write(w, line.a);
+    cache_write(w, line.b);
+    w.scalar(line.curled_height);
+}
+static void cache_read(CacheReader &r, CurledLine &line)
+{
+    cache_read(r, line.a);
+    cache_read(r, line.b);
+    line.curled_height = r.scalar<float>();
+}
+
+static void cache_write(CacheWriter &w, const SurfaceCollection &surfaces)
+{
+    w.size(surfaces.surfaces.size());
+    for (const Surface &surface : surfaces.surfaces) {
+        w.scalar(surface.surface_type);
+        cache_write(w, surface.expolygon);
+        w.scalar(surface.thickness);
+        w.scalar(surface.thickness_layers);
+        w.scalar(surface.bridge_angle);
+        w.scalar(surface.extra_perimeters);
+        w.scalar(surface.distance_to_top);
+    }
+}
+static void cache_read(CacheReader &r, SurfaceCollection &surfaces)
+{
+    surfaces.surfaces.clear();
+    for (size_t i = r.size(); i > 0; -- i) {
+        Surface &surface = surfaces.surfaces.emplace_back(r.scalar<SurfaceType>(), ExPolygon());
+        cache_read(r, surface.expolygon);
+        surface.thickness        = r.scalar<double>();
+        surface.thickness_layers = r.scalar<unsigned short>();
+        surface.bridge_angle     = r.scalar<double>();
+        surface.extra_perimeters = r.scalar<unsigned short>();
+        surface.distance_to_top  = r.scalar<float>();
+    }
+}
+
+// ExtrusionRole does not expose its bit mask, it is stored as a set of the modifiers.
+static void cache_write(CacheWriter &w, const ExtrusionRole role)
+{
+    uint16_t bits = 0;
+    for (uint16_t i = 0; i < uint16_t(ExtrusionRoleModifier::Count); ++ i)
+        if (role.has(ExtrusionRoleModifier(i)))
+            bits |= uint16_t(1 << i);
+    w.scalar(bits);
+}
+static ExtrusionRole cache_read_extrusion_role(CacheReader &r)
+{
+    const auto             bits = r.scalar<uint16_t>();
+    ExtrusionRoleModifiers role;
+    for (uint16_t i = 0; i < uint16_t(ExtrusionRoleModifier::Count); ++ i)
+        if (bits & (1 << i))
+            role = role | ExtrusionRoleModifier(i);
+    return role;
+}
+
+enum class CachedExtrusionType : uint8_t {
+    Path,
+    PathOriented,
+    MultiPath,
+    Loop,
+    Collection,
+};
+
+static void cache_write(CacheWriter &w, const ExtrusionPath &path)
+{
+    cache_write(w, path.role());
+    w.scalar(path.mm3_per_mm);
+    w.scalar(path.width);
+    w.scalar(path.height);
+    w.scalar(path.distance_to_top);
+    cache_write(w, path.polyline);
+}
+template<typename PathType>
+static PathType cache_read_extrusion_path(CacheReader &r)
+{
+    const ExtrusionRole role       = cache_read_extrusion_role(r);
+    const auto          mm3_per_mm = r.scalar<double>();
+    const auto          width      = r.scalar<float>();
+    const auto          height     = r.scalar<float>();
+    PathType            path(role, mm3_per_mm, width, height);
+    path.distance_to_top = r.scalar<float>();
+    cache_read(r, path.polyline);
+    return path;
+}
+
+static void cache_write(CacheWriter &w, const ExtrusionPaths &paths)
+{
+    w.size(paths.size());
+    for (const ExtrusionPath &path : paths)
+        cache_write(w, path);
+}
+static void cache_read(CacheReader &r, ExtrusionPaths &paths)
+{
+    paths.clear();
+    size_t n = r.size();
+    paths.reserve(n);
+    for (; n > 0; -- n)
+        paths.emplace_back(cache_read_extrusion_path<ExtrusionPath>(r));
+}
+
+static void cache_write(CacheWriter &w, const ExtrusionEntityCollection &collection);
+static void cache_read(CacheReader &r, ExtrusionEntityCollection &collection);
+
+static void cache_write(CacheWriter &w, const ExtrusionEntity &entity)
+{
+    if (typeid(entity) == typeid(ExtrusionPath)) {
+        w.scalar(CachedExtrusionType::Path);
+        cache_write(w, static_cast<const ExtrusionPath&>(entity));
+    } else if (typeid(entity) == typeid(ExtrusionPathOriented)) {
+        w.scalar(CachedExtrusionType::PathOriented);
+        cache_write(w, static_cast<const ExtrusionPath&>(entity));
+    } else if (typeid(entity) == typeid(ExtrusionMultiPath)) {
+        w.scalar(CachedExtrusionType::MultiPath);
+        cache_write(w, static_cast<const ExtrusionMultiPath&>(entity).paths);
+    } else if (typeid(entity) == typeid(ExtrusionLoop)) {
+        const auto &loop = static_cast<const ExtrusionLoop&>(entity);
+        w.scalar(CachedExtrusionType::Loop);
+        w.scalar(loop.loop_role());
+        cache_write(w, loop.paths);
+    } else if (typeid(entity) == typeid(ExtrusionEntityCollection)) {
+        w.scalar(CachedExtrusionType::Collection);
+        cache_write(w, static_cast<const ExtrusionEntityCollection&>(entity));
+    } else
+        throw Slic3r::LogicError("Unknown type of an extrusion entity to be cached");
+}
+static ExtrusionEntity* cache_read_extrusion_entity(CacheReader &r)
+{
+    switch (r.scalar<CachedExtrusionType>()) {
+    case CachedExtrusionType::Path:
+        return new ExtrusionPath(cache_read_extrusion_path<ExtrusionPath>(r));
+    case CachedExtrusionType::PathOriented:
+        return new ExtrusionPathOriented(cache_read_extrusion_path<ExtrusionPathOriented>(r));
+    case CachedExtrusionType::MultiPath: {
+        auto multipath = std::make_unique<ExtrusionMultiPath>();
+        cache_read(r, multipath->paths);
+        return multipath.release();
+    }
+    case CachedExtrusionType::Loop: {
+        auto loop = std::make_unique<ExtrusionLoop>(r.scalar<ExtrusionLoopRole>());
+        cache_read(r, loop->paths);
+        return loop.release();
+    }
+    case CachedExtrusionType::Collection: {
+        auto collection = std::make_unique<ExtrusionEntityCollection>();
+        cache_read(r, *collection);
+        return collection.release();
+    }
+    default:
+        throw Slic3r::RuntimeError("Corrupted cache entry");
+    }
+}
+
+static void cache_write(CacheWriter &w, const ExtrusionEntityCollection &collection)
+{
+    w.scalar(collection.no_sort);
+    w.size(collection.entities.size());
+    for (const ExtrusionEntity *entity : collection.entities)
+        cache_write(w, *entity);
+}
+static void cache_read(CacheReader &r, ExtrusionEntityCollection &collection)
+{
+    collection.clear();
+    collection.no_sort = r.scalar<bool>();
+    size_t n = r.size();
+    collection.entities.reserve(n);
+    for (; n > 0; -- n)
+        collection.entities.emplace_back(cache_read_extrusion_entity(r));
+}
+
+template<typename T, typename Alloc> static void cache_write(CacheWriter &w, const std::vector<T, Alloc> &v)
+{
+    w.size(v.size());
+    for (const T &item : v)
+        cache_write(w, item);
+}
+template<typename T, typename Alloc> static void cache_read(CacheReader &r, std::vector<T, Alloc> &v)
+{
+    v.assign(r.size(), T());
+    for (T &item : v)
+        cache_read(r, item);
+}
+
+static void cache_write(CacheWriter &w, const ExtrusionRange &range) { w.scalar(*range.begin()); w.scalar(*range.end()); }
+static ExtrusionRange cache_read_range(CacheReader &r)
+{
+    const auto begin = r.scalar<uint32_t>();
+    const auto end   = r.scalar<uint32_t>();
+    if (begin > end)
+        throw Slic3r::RuntimeError("Corrupted cache entry");
+    return { begin, end };
+}
+
+static void cache_write(CacheWriter &w, const LayerExtrusionRange &range) { w.scalar(range.region()); cache_write(w, static_cast<const ExtrusionRange&>(range)); }
+static LayerExtrusionRange cache_read_layer_range(CacheReader &r)
+{
+    const auto region = r.scalar<uint32_t>();
+    return { region, cache_read_range(r) };
+}
+
+static void cache_write(CacheWriter &w, const LayerSlice &lslice)
+{
+    cache_write(w, lslice.bbox);
+    for (const LayerSlice::Links *links : { &lslice.overlaps_above, &lslice.overlaps_below }) {
+        w.size(links->size());
+        for (const LayerSlice::Link &link : *links) {
+            w.scalar(link.slice_idx);
+            w.scalar(link.area);
+        }
+    }
+    w.size(lslice.islands.size());
+    for (const LayerIsland &island : lslice.islands) {
+        cache_write(w, island.perimeters);
+        cache_write(w, island.thin_fills);
+        w.size(island.fills.size());
+        for (const LayerExtrusionRange &range : island.fills)
+            cache_write(w, range);
+        cache_write(w, island.fill_expolygons);
+        w.scalar(island.fill_region_id);
+    }
+}
+static void cache_read(CacheReader &r, LayerSlice &lslice)
+{
+    cache_read(r, lslice.bbox);
+    for (LayerSlice::Links *links : { &lslice.overlaps_above, &lslice.overlaps_below }) {
+        links->clear();
+        for (size_t i = r.size(); i > 0; -- i) {
+            LayerSlice::Link &link = links->emplace_back();
+            link.slice_idx = r.scalar<int32_t>();
+            link.area      = r.scalar<float>();
+        }
+    }
+    lslice.islands.clear();
+    for (size_t i = r.size(); i > 0; -- i) {
+        LayerIsland &island = lslice.islands.emplace_back();
+        island.perimeters = cache_read_layer_range(r);
+        island.thin_fills = cache_read_range(r);
+        for (size_t j = r.size(); j > 0; -- j)
+            island.fills.push_back(cache_read_layer_range(r));
+        island.fill_expolygons = cache_read_range(r);
+        island.fill_region_id  = r.scalar<uint32_t>();
+    }
+}
+
+// MD5 of the inputs of the PrintObject steps.
+class CacheKeyHasher
+{
+public:
+    void bytes(const void *data, size_t size) { m_md5.process_bytes(data, size); }
+    template<typename T> void scalar(const T v) {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only scalars are hashed directly");
+        this->bytes(&v, sizeof(T));
+    }
+    void size(size_t n) { this->scalar(uint64_t(n)); }
+    void string(const std::string &s) { this->size(s.size()); this->bytes(s.data(), s.size()); }
+    void transform(const Transform3d &trafo) { this->bytes(trafo.matrix().data(), 16 * sizeof(double)); }
+    void config(const ConfigBase &config) {
+        for (const t_config_option_key &opt_key : config.keys())
+            this->option(config, opt_key);
+    }
+    void option(const ConfigBase &config, const t_config_option_key &opt_key) {
+        this->string(opt_key);
+        this->string(config.opt_serialize(opt_key));
+    }
+
+    std::string hex_digest() {
+        using boost::uuids::detail::md5;
+        md5::digest_type digest{};
+        m_md5.get_digest(digest);
+        std::string out;
+        boost::algorithm::hex(digest, digest + std::size(digest), std::back_inserter(out));
+        return out;
+    }
+
+private:
+    boost::uuids::detail::md5 m_md5;
+};
+
+std::string PrintObject::cache_key(PrintObjectStep last_step) const
+{
+    // The nonplanar surfaces are not cached.
+    if (m_config.use_nonplanar_layers)
+        return {};
+
+    CacheKeyHasher hasher;
+    hasher.string(PrintObjectCacheVersion);
+    hasher.string(SLIC3R_VERSION);
+    hasher.string(SLIC3R_BUILD_ID);
+    hasher.scalar(last_step);
+
+    // Geometry of the object, including the modifiers, support blockers / enforcers and the painting.
+    const ModelObject &model_object = *this->model_object();
+    hasher.size(model_object.volumes.size());
+    for (const ModelVolume *volume : model_object.volumes) {
+        hasher.scalar(volume->type());
+        const indexed_triangle_set &its = volume->mesh().its;
+        hasher.size(its.vertices.size());
+        hasher.bytes(its.vertices.data(), its.vertices.size() * sizeof(stl_vertex));
+        hasher.size(its.indices.size());
+        hasher.bytes(its.indices.data(), its.indices.size() * sizeof(stl_triangle_vertex_indices));
+        hasher.transform(volume->get_matrix());
+        hasher.config(volume->config.get());
+        for (const FacetsAnnotation *facets : { &volume->supported_facets, &volume->seam_facets, &volume->mmu_segmentation_facets }) {
+            const auto &[triangles, bitstream] = facets->get_data();
+            hasher.size(triangles.size());
+            for (const std::pair<int, int> &triangle : triangles) {
+                hasher.scalar(triangle.first);
+                hasher.scalar(triangle.second);
+            }
+            hasher.size(bitstream.size());
+            for (bool bit : bitstream)
+                hasher.scalar(bit);
+        }
+    }
+    hasher.size(model_object.layer_config_ranges.size());
+    for (const auto &[range, config] : model_object.layer_config_ranges) {
+        hasher.scalar(range.first);
+        hasher.scalar(range.second);
+        hasher.config(config.get());
+    }
+    const std::vector<coordf_t> &layer_height_profile = model_object.layer_height_profile.get();
+    hasher.size(layer_height_profile.size());
+    hasher.bytes(layer_height_profile.data(), layer_height_profile.size() * sizeof(coordf_t));
+
+    // Placement of the object.
+    hasher.transform(m_trafo);
+    hasher.scalar(m_center_offset.x());
+    hasher.scalar(m_center_offset.y());
+    for (int i = 0; i < 3; ++ i)
+        hasher.scalar(m_size[i]);
+
+    // The options, which may influence any of the steps up to last_step. Unknown options invalidate all the steps.
+    std::vector<PrintObjectStep> steps;
+    std::vector<PrintStep>       print_steps;
+    auto relevant = [last_step, &steps](bool known) {
+        return ! known || std::any_of(steps.begin(), steps.end(), [last_step](PrintObjectStep step) { return step <= last_step; });
+    };
+    auto hash_object_config = [this, &hasher, &steps, &print_steps, &relevant](const ConfigBase &config) {
+        for (const t_config_option_key &opt_key : config.keys()) {
+            steps.clear();
+            print_steps.clear();
+            if (relevant(this->steps_influenced_by_config_option(opt_key, steps, print_steps)))
+                hasher.option(config, opt_key);
+        }
+    };
+    hash_object_config(m_config);
+    hasher.size(this->num_printing_regions());
+    for (size_t region_id = 0; region_id < this->num_printing_regions(); ++ region_id)
+        hash_object_config(this->printing_region(region_id).config());
+    for (const t_config_option_key &opt_key : m_print->config().keys()) {
+        steps.clear();
+        print_steps.clear();
+        if (relevant(Print::steps_invalidated_by_config_option(opt_key, print_steps, steps)))
+            hasher.option(m_print->config(), opt_key);
+    }
+    if (last_step >= posEstimateCurledExtrusions)
+        // The curled extrusions are estimated if enabled for any region of the Print.
+        hasher.scalar(std::any_of(m_print->m_print_regions.begin(), m_print->m_print_regions.end(),
+            [](const PrintRegion *region) { return region->config().enable_dynamic_overhang_speeds.getBool(); }));
+
+    return hasher.hex_digest();
+}
+
+void PrintObject::store_in_cache(PrintObjectStep last_step) const
+{
+    PrintObjectCache *cache = m_print->object_cache();
+    if (cache == nullptr)
+        return;
+    const std::string key = this->cache_key(last_step);
+    if (key.empty() || cache->contains(key))
+        return;
+
+    CacheWriter w;
+    auto write_layer = [&w](const Layer &layer) {
+        w.size(layer.id());
+        w.scalar(layer.slice_z);
+        w.scalar(layer.print_z);
+        w.scalar(layer.height);
+        cache_write(w, layer.curled_lines);
+        cache_write(w, layer.lslices);
+        w.size(layer.lslice_indices_sorted_by_print_order.size());
+        for (size_t idx : layer.lslice_indices_sorted_by_print_order)
+            w.size(idx);
+        cache_write(w, layer.lslices_ex);
+        w.size(layer.regions().size());
+        for (const LayerRegion *layerm : layer.regions()) {
+            w.size(layerm->region().print_object_region_id());
+            cache_write(w, layerm->m_raw_slices);
+            cache_write(w, layerm->m_slices);
+            cache_write(w, layerm->m_fill_expolygons);
+            cache_write(w, layerm->m_fill_expolygons_bboxes);
+            cache_write(w, layerm->m_fill_expolygons_composite);
+            cache_write(w, layerm->m_fill_expolygons_composite_bboxes);
+            cache_write(w, layerm->m_fill_surfaces);
+            cache_write(w, layerm->m_thin_fills);
+            cache_write(w, layerm->m_unsupported_bridge_edges);
+            cache_write(w, layerm->m_perimeters);
+            cache_write(w, layerm->m_fills);
+        }
+    };
+
+    for (const Layer *layer : m_layers)
+        for (const LayerRegion *layerm : layer->regions())
+            if (layerm->region().print_object_region_id() < 0 ||
+                size_t(layerm->region().print_object_region_id()) >= this->num_printing_regions() ||
+                &this->printing_region(layerm->region().print_object_region_id()) != &layerm->region())
+                // The region cannot be restored.
+                return;
+    w.scalar(m_typed_slices);
+    w.size(m_layers.size());
+    for (const Layer *layer : m_layers)
+        write_layer(*layer);
+    if (last_step >= posSupportMaterial) {
+        w.size(m_support_layers.size());
+        for (const SupportLayer *layer : m_support_layers) {
+            w.size(layer->interface_id());
+            write_layer(*layer);
+            cache_write(w, layer->support_islands);
+            cache_write(w, layer->support_islands_bboxes);
+            cache_write(w, layer->support_fills);
+        }
+    }
+    cache->store(key, w.data());
+    BOOST_LOG_TRIVIAL(debug) << "Stored " << w.data().size() << " bytes of the results of PrintObject " << this->model_object()->name << " in the cache entry " << key;
+}
+
+bool PrintObject::load_from_cache(PrintObjectStep last_step)
+{
+    PrintObjectCache *cache = m_print->object_cache();
+    if (cache == nullptr)
+        return false;
+    const std::string key = this->cache_key(last_step);
+    std::string       data;
+    if (key.empty() || ! cache->load(key, data))
+        return false;
+
+    bool             typed_slices = false;
+    LayerPtrs        layers;
+    SupportLayerPtrs support_layers;
+    try {
+        CacheReader r(data);
+        auto read_layer = [this, &r](Layer &layer) {
+            cache_read(r, layer.curled_lines);
+            cache_read(r, layer.lslices);
+            layer.lslice_indices_sorted_by_print_order.assign(r.size(), 0);
+            for (size_t &idx : layer.lslice_indices_sorted_by_print_order)
+                idx = size_t(r.scalar<uint64_t>());
+            cache_read(r, layer.lslices_ex);
+            for (size_t i = r.size(); i > 0; -- i) {
+                const size_t region_id = r.size();
+                if (region_id >= this->num_printing_regions())
+                    throw Slic3r::RuntimeError("Corrupted cache entry");
+                LayerRegion *layerm = layer.add_region(&this->printing_region(region_id));
+                cache_read(r, layerm->m_raw_slices);
+                cache_read(r, layerm->m_slices);
+                cache_read(r, layerm->m_fill_expolygons);
+                cache_read(r, layerm->m_fill_expolygons_bboxes);
+                cache_read(r, layerm->m_fill_expolygons_composite);
+                cache_read(r, layerm->m_fill_expolygons_composite_bboxes);
+                cache_read(r, layerm->m_fill_surfaces);
+                cache_read(r, layerm->m_thin_fills);
+                cache_read(r, layerm->m_unsupported_bridge_edges);
+                cache_read(r, layerm->m_perimeters);
+                cache_read(r, layerm->m_fills);
+            }
+        };
+        typed_slices = r.scalar<bool>();
+        for (size_t i = r.size(); i > 0; -- i) {
+            const size_t id      = size_t(r.scalar<uint64_t>());
+            const auto   slice_z = r.scalar<coordf_t>();
+            const auto   print_z = r.scalar<coordf_t>();
+            const auto   height  = r.scalar<coordf_t>();
+            layers.emplace_back(new Layer(id, this, height, print_z, slice_z));
+            read_layer(*layers.back());
+        }
+        if (last_step >= posSupportMaterial)
+            for (size_t i = r.size(); i > 0; -- i) {
+                const size_t interface_id = size_t(r.scalar<uint64_t>());
+                const size_t id           = size_t(r.scalar<uint64_t>());
+                const auto   slice_z      = r.scalar<coordf_t>();
+                const auto   print_z      = r.scalar<coordf_t>();
+                const auto   height       = r.scalar<coordf_t>();
+                SupportLayer *layer = support_layers.emplace_back(new SupportLayer(id, interface_id, this, height, print_z, slice_z));
+                read_layer(*layer);
+                cache_read(r, layer->support_islands);
+                cache_read(r, layer->support_islands_bboxes);
+                cache_read(r, layer->support_fills);
+            }
+        if (! r.at_end() || layers.empty())
+            throw Slic3r::RuntimeError("Corrupted cache entry");
+    } catch (const std::exception &ex) {
+        BOOST_LOG_TRIVIAL(warning) << "Removing the invalid cache entry " << key << ": " << ex.what();
+        for (Layer *layer : layers)
+            delete layer;
+        for (SupportLayer *layer : support_layers)
+            delete layer;
+        cache->remove(key);
+        return false;
+    }
+
+    for (size_t i = 0; i < layers.size(); ++ i) {
+        layers[i]->lower_layer = i == 0 ? nullptr : layers[i - 1];
+        layers[i]->upper_layer = i + 1 == layers.size() ? nullptr : layers[i + 1];
+    }
+    this->clear_layers();
+    m_layers       = std::move(layers);
+    m_typed_slices = typed_slices;
+    if (last_step >= posSupportMaterial) {
+        this->clear_support_layers();
+        m_support_layers = std::move(support_layers);
+    }
+    BOOST_LOG_TRIVIAL(info) << "Restored the results of PrintObject " << this->model_object()->name << " from the cache entry " << key;
+    return true;
+}
+
+void PrintObject::restore_from_cache()
+{
+    if (m_print->object_cache() == nullptr || this->is_step_done(posSlice) || ! this->load_from_cache(posEstimateCurledExtrusions))
+        return;
+    // The support spots are not cached, they are searched for on the restored layers if needed.
+    for (PrintObjectStep step : { posSlice, posPerimeters, posPrepareInfill, posInfill, posIroning, posSupportMaterial, posEstimateCurledExtrusions }) {
+        this->set_started(step);
+        this->set_done(step);
+    }
+}
+
+} // namespace Slic3r
@@ -0,0 +1,46 @@
+#ifndef slic3r_PrintObjectCache_hpp_
+#define slic3r_PrintObjectCache_hpp_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace Slic3r {
+
+// Persistent cache of the results of the PrintObject steps, stored in a directory on disk.
+// Each entry is a file named by a hash of all the inputs of the steps it contains, see PrintObject::cache_key(),
+// thus the entries are never invalidated, the least recently used entries are removed once the total size
+// of the entries exceeds the limit. The entries are written in the native binary format of the machine,
+// the cache is not meant to be shared between different builds or platforms.
+// The cache may be shared by multiple Print instances processed concurrently, all the methods are thread safe.
+// I/O errors are logged and reported as a cache miss, they never fail the slicing.
+class PrintObjectCache
+{
+public:
+    // Creates the directory if it does not exist, throws Slic3r::RuntimeError if it cannot be created.
+    PrintObjectCache(const std::string &dir, size_t max_size);
+
+    const std::string&  dir()      const { return m_dir; }
+    size_t              max_size() const { return m_max_size; }
+
+    // Returns false if there is no entry of the given key.
+    // A loaded entry is marked as the most recently used.
+    bool                load(const std::string &key, std::string &data) const;
+    bool                contains(const std::string &key) const;
+    // Stores the entry atomically, so that a concurrent or interrupted slicing never sees a partially written entry,
+    // then removes the least recently used entries exceeding the size limit.
+    void                store(const std::string &key, const std::string &data);
+    void                remove(const std::string &key);
+
+private:
+    void                trim();
+
+    std::string         m_dir;
+    size_t              m_max_size;
+    // Synchronizes the trimming.
+    std::mutex          m_mutex;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_PrintObjectCache_hpp_
@@ -5,6 +5,7 @@
 #include "MultiMaterialSegmentation.hpp"
 #include "Print.hpp"
 #include "ShortestPath.hpp"
+#include "Trace.hpp"
 #include "AABBMesh.hpp"
 
 #include <boost/log/trivial.hpp>
@@ -498,30 +499,35 @@ void PrintObject::slice()
 {
     if (! this->set_started(posSlice))
         return;
+    SLIC3R_TRACE_ZONE("PrintObject::slice");
     m_print->set_status(10, _u8L("Processing triangulated mesh"));
     std::vector<coordf_t> layer_height_profile;
     this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
     m_print->throw_if_canceled();
     m_typed_slices = false;
     this->clear_layers();
-    m_layers = new_layers(this, generate_object_layers(m_slicing_params, layer_height_profile));
-    this->slice_volumes();
-    m_print->throw_if_canceled();
+    // The same object may have been sliced with the same parameters before, see Print::set_object_cache().
+    if (! this->load_from_cache(posSlice)) {
+        m_layers = new_layers(this, generate_object_layers(m_slicing_params, layer_height_profile));
+        this->slice_volumes();
+        m_print->throw_if_canceled();
 #if 0
-    // Layer::slicing_errors is no more set since 1.41.1 or possibly earlier, thus this code
-    // was not really functional for a long day and nobody missed it.
-    // Could we reuse this fixing code one day?
-
-    // Fix the model.
-    //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
-    std::string warning = fix_slicing_errors(m_layers, [this](){ m_print->throw_if_canceled(); });
-    m_print->throw_if_canceled();
-    if (! warning.empty())
-        BOOST_LOG_TRIVIAL(info) << warning;
+        // Layer::slicing_errors is no more set since 1.41.1 or possibly earlier, thus this code
+        // was not really functional for a long day and nobody missed it.
+        // Could we reuse this fixing code one day?
+
+        // Fix the model.
+        //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
+        std::string warning = fix_slicing_errors(m_layers, [this](){ m_print->throw_if_canceled(); });
+        m_print->throw_if_canceled();
+        if (! warning.empty())
+            BOOST_LOG_TRIVIAL(info) << warning;
 #endif
-    this->lslices_were_updated();
-    if (m_layers.empty())
-        throw Slic3r::SlicingError("No layers were detected. You might want to repair your STL file(s) or check their size or thickness and retry.\n");    
+        this->lslices_were_updated();
+        if (m_layers.empty())
+            throw Slic3r::SlicingError("No layers were detected. You might want to repair your STL file(s) or check their size or thickness and retry.\n");    
+        this->store_in_cache(posSlice);
+    }
     this->set_done(posSlice);
 }
 
@@ -689,6 +695,7 @@ void apply_mm_segmentation(PrintObject &print_object, ThrowOnCancel throw_on_can
 // this should be idempotent
 void PrintObject::slice_volumes()
 {
+    SLIC3R_TRACE_ZONE("PrintObject::slice_volumes");
     BOOST_LOG_TRIVIAL(info) << "Slicing volumes..." << log_memory_info();
     const Print *print                      = this->print();
     const auto   throw_on_cancel_callback   = std::function<void()>([print](){ print->throw_if_canceled(); });
@@ -854,47 +861,24 @@ PrintObject::find_nonplanar_surfaces()
     for (ModelVolumePtrs::const_iterator it = volumes.begin(); it != volumes.end(); ++ it) {
         //only check non modifier volumes
         if (! (*it)->is_modifier()) {
-            const TriangleMesh tmesh = (*it)->mesh();
-            AABBMesh mesh(tmesh, true);
-            std::map<int, NonplanarFacet> facets;
-
-            // store all meshes with slope <= nonplanar_layers_angle in map. Map is necessary to keep facet ID
-            for (int face_id = 0; face_id < mesh.indices().size(); ++ face_id) {
-                auto &face = mesh.indices(face_id);
-                Vec3d normal = mesh.normal_by_face_id(face_id);
-
-                //TODO check if normals exist
-                if (normal.z() >= std::cos(m_config.nonplanar_layers_angle.value * 3.14159265/180.0)) {
-                    //copy facet
-                    NonplanarFacet new_facet;
-                    new_facet.normal.x = normal.x();
-                    new_facet.normal.y = normal.y();
-                    new_facet.normal.z = normal.z();
-
-                    Vec3i neighbor = mesh.face_neighbor_index()[face_id];
-                    its_triangle vertex = its_triangle_vertices(*mesh.get_triangle_mesh(), face_id);
-                    for (int j=0; j<=2 ;j++) {
-                        new_facet.vertex[j].x = vertex[j].x();
-                        new_facet.vertex[j].y = vertex[j].y();
-                        new_facet.vertex[j].z = vertex[j].z();
-                        new_facet.neighbor[j] = neighbor[j];
-                    }
-                    new_facet.calculate_stats();
-                    facets[face_id] = new_facet;
-                }
-            }
-
-            // create nonplanar surface from facets
-            NonplanarSurface nf = NonplanarSurface(facets);
+            const TriangleMesh &tmesh = (*it)->mesh();
             BOOST_LOG_TRIVIAL(debug) << "Find nonplanar surfaces - moving surfaces by z=" << -tmesh.stats().min.z();
-            nf.translate(0, 0, -tmesh.stats().min.z());
+            // the mesh buffers are shared with the model volume, the surfaces only keep the IDs of their facets
+            auto mesh = std::make_shared<const NonplanarMesh>((*it)->mesh_ptr(), -tmesh.stats().min.z());
+
+            // collect all facets with slope <= nonplanar_layers_angle, sorted by facet ID
+            std::vector<int> facets;
+            const double min_normal_z = std::cos(m_config.nonplanar_layers_angle.value * 3.14159265/180.0);
+            for (int face_id = 0; face_id < int(mesh->facets_count()); ++ face_id)
+                if (mesh->normal(face_id).z() >= min_normal_z)
+                    facets.emplace_back(face_id);
 
             // group surfaces and attach all nonplanar surfaces to the PrintObject
-            m_nonplanar_surfaces = nf.group_surfaces();
+            m_nonplanar_surfaces = NonplanarSurface::group_surfaces(mesh, facets);
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
             for (size_t id = 0; id < m_nonplanar_surfaces.size(); ++ id) {
-                auto& surface = m_nonplanar_surfaces[id];
+                const NonplanarSurface &surface = *m_nonplanar_surfaces[id];
                 Surfaces surfaces;
                 surfaces_append(surfaces, surface.horizontal_projection(), SurfaceType::stTopNonplanar);
                 SurfaceCollection c(surfaces);
@@ -904,7 +888,7 @@ PrintObject::find_nonplanar_surfaces()
 
             // check for surfaces that are actually flat
             for (NonplanarSurfaces::iterator it = m_nonplanar_surfaces.begin(); it!=m_nonplanar_surfaces.end();) {
-                if((*it).stats.min.z == (*it).stats.max.z) {
+                if((*it)->stats.min.z == (*it)->stats.max.z) {
                     BOOST_LOG_TRIVIAL(trace) << "Find nonplanar surfaces - deleted one surface with same min/max Z height";
                     it = m_nonplanar_surfaces.erase(it);
                 } else {
@@ -914,7 +898,7 @@ PrintObject::find_nonplanar_surfaces()
 
             // check if surfaces maintain maximum printing height, if not, erase it
             for (NonplanarSurfaces::iterator it = m_nonplanar_surfaces.begin(); it!=m_nonplanar_surfaces.end();) {
-                if((*it).check_max_printing_height(m_config.nonplanar_layers_height.value)) {
+                if((*it)->check_max_printing_height(m_config.nonplanar_layers_height.value)) {
                     BOOST_LOG_TRIVIAL(trace) << "Find nonplanar surfaces - deleted one surface due to max printing height constraint";
                     it = m_nonplanar_surfaces.erase(it);
                 }else {
@@ -924,7 +908,7 @@ PrintObject::find_nonplanar_surfaces()
 
             // check if surfaces area is not too small
             for (NonplanarSurfaces::iterator it = m_nonplanar_surfaces.begin(); it!=m_nonplanar_surfaces.end();) {
-                if((*it).check_surface_area()) {
+                if((*it)->check_surface_area()) {
                     BOOST_LOG_TRIVIAL(trace) << "Find nonplanar surfaces - deleted one surface due to print area too small";
                     it = m_nonplanar_surfaces.erase(it);
                 }else {
@@ -934,7 +918,7 @@ PrintObject::find_nonplanar_surfaces()
 
             // check if surfaces areas collide
             for (NonplanarSurfaces::iterator it = m_nonplanar_surfaces.begin(); it!=m_nonplanar_surfaces.end();) {
-                if(check_nonplanar_collisions((*it))) {
+                if(check_nonplanar_collisions(**it)) {
                     BOOST_LOG_TRIVIAL(trace) << "Find nonplanar surfaces - deleted one surface due to collision";
                     it = m_nonplanar_surfaces.erase(it);
                 } else {
@@ -947,7 +931,7 @@ PrintObject::find_nonplanar_surfaces()
             BOOST_LOG_TRIVIAL(info) << "Find nonplanar surfaces - found " << m_nonplanar_surfaces.size() << " in " << (*it)->name;
 
             for (size_t id = 0; id < m_nonplanar_surfaces.size(); ++ id) {
-                auto& surface = m_nonplanar_surfaces[id];
+                const NonplanarSurface &surface = *m_nonplanar_surfaces[id];
                 BOOST_LOG_TRIVIAL(debug) << "Find nonplanar surfaces - surface" << id << " at Z [min=" << surface.stats.min.z << ", max=" << surface.stats.max.z << "]";
 
 #ifdef SLIC3R_DEBUG_SLICE_PROCESSING
@@ -2,6 +2,7 @@
 #define SLARASTER_CPP
 
 #include <functional>
+#include <memory>
 
 #include <libslic3r/SLA/RasterBase.hpp>
 #include <libslic3r/SLA/AGGRaster.hpp>
@@ -33,6 +34,122 @@ EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
     return EncodedRaster(std::move(buf), "png");
 }
 
+namespace {
+
+void append_u32_be(std::vector<uint8_t> &buf, uint32_t v)
+{
+    buf.push_back(uint8_t(v >> 24));
+    buf.push_back(uint8_t(v >> 16));
+    buf.push_back(uint8_t(v >> 8));
+    buf.push_back(uint8_t(v));
+}
+
+void write_u32_be(uint8_t *dst, uint32_t v)
+{
+    dst[0] = uint8_t(v >> 24);
+    dst[1] = uint8_t(v >> 16);
+    dst[2] = uint8_t(v >> 8);
+    dst[3] = uint8_t(v);
+}
+
+// Close the chunk whose length field starts at chunk_begin: fill in the
+// length and append the CRC over the chunk type and data.
+void finish_png_chunk(std::vector<uint8_t> &buf, size_t chunk_begin)
+{
+    size_t datalen = buf.size() - chunk_begin - 8;
+    write_u32_be(buf.data() + chunk_begin, uint32_t(datalen));
+    mz_ulong crc = mz_crc32(MZ_CRC32_INIT, buf.data() + chunk_begin + 4, datalen + 4);
+    append_u32_be(buf, uint32_t(crc));
+}
+
+void begin_png_chunk(std::vector<uint8_t> &buf, const char *type)
+{
+    append_u32_be(buf, 0);
+    buf.insert(buf.end(), type, type + 4);
+}
+
+mz_bool append_to_vector(const void *data, int len, void *user)
+{
+    auto &buf = *static_cast<std::vector<uint8_t> *>(user);
+    auto  ptr = static_cast<const uint8_t *>(data);
+    buf.insert(buf.end(), ptr, ptr + len);
+    return MZ_TRUE;
+}
+
+struct TdeflDeleter {
+    void operator()(tdefl_compressor *c) const { tdefl_compressor_free(c); }
+};
+
+} // namespace
+
+EncodedRaster FastPNGRasterEncoder::operator()(const void *ptr, size_t w,
+                                               size_t h, size_t num_components)
+{
+    static const uint8_t color_types[] = {0, 0, 4, 2, 6};
+    if (ptr == nullptr || w == 0 || h == 0 || num_components < 1 || num_components > 4)
+        return EncodedRaster({}, "png");
+
+    static const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+    std::vector<uint8_t> buf;
+    // Masks typically compress to a few percent of the raw size.
+    buf.reserve(1024 + w * h * num_components / 16);
+    buf.insert(buf.end(), std::begin(signature), std::end(signature));
+
+    size_t chunk = buf.size();
+    begin_png_chunk(buf, "IHDR");
+    append_u32_be(buf, uint32_t(w));
+    append_u32_be(buf, uint32_t(h));
+    buf.push_back(8);                           // bit depth
+    buf.push_back(color_types[num_components]);
+    buf.push_back(0);                           // deflate
+    buf.push_back(0);                           // adaptive filtering
+    buf.push_back(0);                           // no interlace
+    finish_png_chunk(buf, chunk);
+
+    chunk = buf.size();
+    begin_png_chunk(buf, "IDAT");
+
+    std::unique_ptr<tdefl_compressor, TdeflDeleter> comp(tdefl_compressor_alloc());
+    if (!comp) return EncodedRaster({}, "png");
+
+    mz_uint flags = tdefl_create_comp_flags_from_zip_params(MZ_BEST_SPEED, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY);
+    if (tdefl_init(comp.get(), append_to_vector, &buf, int(flags)) != TDEFL_STATUS_OKAY)
+        return EncodedRaster({}, "png");
+
+    const size_t   stride = w * num_components;
+    const auto    *src    = static_cast<const uint8_t *>(ptr);
+    std::vector<uint8_t> row(stride + 1);
+
+    for (size_t y = 0; y < h; ++y) {
+        const uint8_t *line = src + y * stride;
+        if (y == 0) {
+            row[0] = 0;
+            std::copy(line, line + stride, row.begin() + 1);
+        } else {
+            // Up filter: rows of a mask differ from their predecessor only
+            // around the contour edges, everything else becomes zero.
+            row[0] = 2;
+            const uint8_t *prev = line - stride;
+            for (size_t x = 0; x < stride; ++x)
+                row[x + 1] = uint8_t(line[x] - prev[x]);
+        }
+
+        tdefl_flush flush = y + 1 == h ? TDEFL_FINISH : TDEFL_NO_FLUSH;
+        tdefl_status st = tdefl_compress_buffer(comp.get(), row.data(), row.size(), flush);
+        if (st != TDEFL_STATUS_OKAY && st != TDEFL_STATUS_DONE)
+            return EncodedRaster({}, "png");
+    }
+
+    finish_png_chunk(buf, chunk);
+
+    chunk = buf.size();
+    begin_png_chunk(buf, "IEND");
+    finish_png_chunk(buf, chunk);
+
+    return EncodedRaster(std::move(buf), "png");
+}
+
 std::ostream &operator<<(std::ostream &stream, const EncodedRaster &bytes)
 {
     stream.write(reinterpret_cast<const char *>(bytes.data()),
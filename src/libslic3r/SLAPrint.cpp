@@ -8,6 +8,7 @@
 
 #include "Geometry.hpp"
 #include "Thread.hpp"
+#include "Trace.hpp"
 
 #include <unordered_set>
 #include <numeric>
@@ -628,6 +629,7 @@ void SLAPrint::process()
         return;
 
     name_tbb_thread_pool_threads_set_locale();
+    SLIC3R_TRACE_ZONE("SLAPrint::process");
 
     // Assumption: at this point the print objects should be populated only with
     // the model objects we have to process and the instances are also filtered
@@ -769,6 +771,8 @@ bool SLAPrint::invalidate_state_by_config_options(const std::vector<t_config_opt
         "display_mirror_y",
         "display_orientation",
         "sla_archive_format",
+        "sla_archive_compression",
+        "sla_archive_fast_png",
         "sla_output_precision"
     };
 
@@ -547,6 +547,14 @@ public:
     void export_print(const std::string    &fname,
                       const ThumbnailsList &thumbnails,
                       const std::string    &projectname = "");
+
+    // Write the rasterized layers into an archive at fname while slicing instead of keeping them in memory until
+    // export_print() completes the archive. Only used by the archive formats supporting it, empty fname disables it.
+    void set_export_stream(const std::string &fname, const std::string &projectname = "")
+    {
+        m_export_stream_fname       = fname;
+        m_export_stream_projectname = projectname;
+    }
     
 private:
     
@@ -568,6 +576,9 @@ private:
     
     // The archive object which collects the raster images after slicing
     std::unique_ptr<SLAArchiveWriter>     m_archiver;
+    // Archive to stream the raster images into, see set_export_stream().
+    std::string                     m_export_stream_fname;
+    std::string                     m_export_stream_projectname;
     
     // Estimated print time, material consumed.
     SLAPrintStatistics              m_print_statistics;
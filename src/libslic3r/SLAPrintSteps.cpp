@@ -29,6 +29,7 @@
 #include <boost/log/trivial.hpp>
 
 #include "I18N.hpp"
+#include "Trace.hpp"
 
 #include <libnest2d/tools/benchmark.h>
 #include "format.hpp"
@@ -1156,6 +1157,8 @@ void SLAPrint::Steps::rasterize()
         PrintLayer& printlayer = m_print->m_printer_input[idx];
         if(canceled()) return;
 
+        SLIC3R_TRACE_ZONE("SLAPrint::rasterize_layer", "layer", int64_t(idx));
+
         for (const ExPolygon& poly : printlayer.transformed_slices())
             raster.draw(poly);
 
@@ -1175,6 +1178,7 @@ void SLAPrint::Steps::rasterize()
     if(canceled()) return;
 
     // Print all the layers in parallel
+    m_print->m_archiver->set_stream_target(m_print->m_export_stream_fname, m_print->m_export_stream_projectname);
     m_print->m_archiver->draw_layers(m_print->m_printer_input.size(), lvlfn,
                                     [this]() { return canceled(); }, ex_tbb);
 }
@@ -1201,6 +1205,14 @@ double SLAPrint::Steps::progressrange(SLAPrintStep step) const
 
 void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 {
+    // Trace zone names indexed by SLAPrintObjectStep.
+    static constexpr const char *trace_names[] = {
+        "SLAPrintObject::mesh_assembly", "SLAPrintObject::hollow_model", "SLAPrintObject::drill_holes", "SLAPrintObject::slice_model",
+        "SLAPrintObject::support_points", "SLAPrintObject::support_tree", "SLAPrintObject::generate_pad", "SLAPrintObject::slice_supports"
+    };
+    static_assert(std::size(trace_names) == slaposCount);
+    SLIC3R_TRACE_ZONE(step < slaposCount ? trace_names[step] : "SLAPrintObject::unknown", "object", int64_t(obj.id().id));
+
     switch(step) {
     case slaposAssembly: mesh_assembly(obj); break;
     case slaposHollowing: hollow_model(obj); break;
@@ -1216,6 +1228,8 @@ void SLAPrint::Steps::execute(SLAPrintObjectStep step, SLAPrintObject &obj)
 
 void SLAPrint::Steps::execute(SLAPrintStep step)
 {
+    SLIC3R_TRACE_ZONE(step == slapsMergeSlicesAndEval ? "SLAPrint::merge_slices_and_eval_stats" : "SLAPrint::rasterize");
+
     switch (step) {
     case slapsMergeSlicesAndEval: merge_slices_and_eval_stats(); break;
     case slapsRasterize: rasterize(); break;
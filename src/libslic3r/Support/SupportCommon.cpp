@@ -1493,6 +1493,7 @@ void generate_support_toolpaths(
             SupportLayer               &support_layer = *support_layers[support_layer_id];
             assert(support_layer.support_fills.entities.empty());
             SupportGeneratorLayer      &raft_layer    = *raft_layers[support_layer_id];
+            ExtrusionEntityArena::Scope arena_scope(&support_layer.extrusion_arena());
 
             std::unique_ptr<Fill> filler_interface = std::unique_ptr<Fill>(Fill::new_from_type(support_params.raft_interface_fill_pattern));
             std::unique_ptr<Fill> filler_support   = std::unique_ptr<Fill>(Fill::new_from_type(support_params.base_fill_pattern));
@@ -1628,6 +1629,7 @@ void generate_support_toolpaths(
         {
             SupportLayer &support_layer = *support_layers[support_layer_id];
             LayerCache   &layer_cache   = layer_caches[support_layer_id];
+            ExtrusionEntityArena::Scope arena_scope(&support_layer.extrusion_arena());
             const float   support_interface_angle = config.support_material_style.value == smsGrid ?
                 support_params.interface_angle : support_params.raft_interface_angle(support_layer.interface_id());
 
@@ -1863,6 +1865,7 @@ void generate_support_toolpaths(
         for (size_t support_layer_id = range.begin(); support_layer_id < range.end(); ++ support_layer_id) {
             SupportLayer &support_layer = *support_layers[support_layer_id];
             LayerCache   &layer_cache   = layer_caches[support_layer_id];
+            ExtrusionEntityArena::Scope arena_scope(&support_layer.extrusion_arena());
             // For all extrusion types at this print_z, ordered by decreasing layer height:
             for (LayerCacheItem &layer_cache_item : layer_cache.nonempty) {
                 // Trim the extrusion height from the bottom by the overlapping layers.
@@ -849,12 +849,73 @@ coord_t TreeModelVolumes::ceilRadius(const coord_t radius) const
     return out;
 }
 
+TreeModelVolumes::CacheStats TreeModelVolumes::cache_stats() const
+{
+    CacheStats out;
+    for (const RadiusLayerPolygonCache *cache : { &m_collision_cache, &m_collision_cache_holefree, &m_avoidance_cache, &m_avoidance_cache_slow,
+            &m_avoidance_cache_to_model, &m_avoidance_cache_to_model_slow, &m_placeable_areas_cache, &m_avoidance_cache_holefree,
+            &m_avoidance_cache_holefree_to_model, &m_wall_restrictions_cache, &m_wall_restrictions_cache_min })
+        out += cache->stats();
+    return out;
+}
+
+thread_local std::array<TreeModelVolumes::RadiusLayerPolygonCache::StatsSlot, 16> TreeModelVolumes::RadiusLayerPolygonCache::s_stats_slots;
+
+uint64_t TreeModelVolumes::RadiusLayerPolygonCache::next_id()
+{
+    // Zero marks an unused slot of s_stats_slots.
+    static std::atomic<uint64_t> last_id { 0 };
+    return ++ last_id;
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons)
+{
+    assert(layer_idx >= 0);
+    allocate_layers(layer_idx + 1);
+    Layer &layer = *m_layers[layer_idx];
+    tbb::spin_mutex::scoped_lock lock;
+    if (! lock.try_acquire(layer.mutex)) {
+        ++ this->local_stats().contended;
+        lock.acquire(layer.mutex);
+    }
+    if (has(layer, radius))
+        return;
+    // Construct the new entry before publishing it to the readers.
+    size_t n = layer.num_entries.load(std::memory_order_relaxed);
+    assert(layer.entries.size() == n);
+    layer.entries.push_back({ radius, std::make_unique<Polygons>(std::move(polygons)) });
+    layer.num_entries.store(n + 1, std::memory_order_release);
+}
+
 void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layers)
 {
-    if (num_layers > m_data.size()) {
-        if (num_layers > m_data.capacity())
-            reserve_power_of_2(m_data, num_layers);
-        m_data.resize(num_layers, {});
+    if (num_layers <= m_num_layers.load(std::memory_order_acquire))
+        return;
+    std::unique_lock<std::mutex> lock(m_allocation_mutex, std::try_to_lock);
+    if (! lock.owns_lock()) {
+        ++ this->local_stats().contended;
+        lock.lock();
+    }
+    if (size_t num_allocated = m_num_layers.load(std::memory_order_relaxed); num_layers > num_allocated) {
+        m_layers.grow_to_at_least(num_layers);
+        for (size_t i = num_allocated; i < num_layers; ++ i)
+            m_layers[i] = std::make_unique<Layer>();
+        m_num_layers.store(num_layers, std::memory_order_release);
+    }
+}
+
+void TreeModelVolumes::RadiusLayerPolygonCache::clear_all_but_radius0()
+{
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx) {
+        Layer &layer = *m_layers[layer_idx];
+        if (layer.entries.size() > 1) {
+            // Keep the entry of the smallest radius, its polygons are not moved.
+            auto  it   = std::min_element(layer.entries.begin(), layer.entries.end(), [](const Entry &l, const Entry &r) { return l.radius < r.radius; });
+            Entry keep = std::move(*it);
+            layer.entries.clear();
+            layer.entries.push_back(std::move(keep));
+            layer.num_entries = 1;
+        }
     }
 }
 
@@ -862,12 +923,13 @@ void TreeModelVolumes::RadiusLayerPolygonCache::allocate_layers(size_t num_layer
 std::vector<std::pair<TreeModelVolumes::RadiusLayerPair, std::reference_wrapper<const Polygons>>> TreeModelVolumes::RadiusLayerPolygonCache::sorted() const
 {
     std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> out;
-    for (auto &layer : m_data) {
-        auto layer_idx = LayerIndex(&layer - m_data.data());
-        for (auto &radius_polygons : layer)
-            out.emplace_back(std::make_pair(radius_polygons.first, layer_idx), radius_polygons.second);
+    for (size_t layer_idx = 0; layer_idx < m_num_layers; ++ layer_idx) {
+        const Layer &layer = *m_layers[layer_idx];
+        size_t       begin = out.size();
+        for (size_t i = 0, n = layer.num_entries.load(std::memory_order_acquire); i < n; ++ i)
+            out.emplace_back(std::make_pair(layer.entries[i].radius, LayerIndex(layer_idx)), *layer.entries[i].polygons);
+        std::sort(out.begin() + begin, out.end(), [](auto &l, auto &r){ return l.first.first < r.first.first; });
     }
-    assert(std::is_sorted(out.begin(), out.end(), [](auto &l, auto &r){ return l.first.second < r.first.second || (l.first.second == r.first.second) && l.first.first < r.first.first; }));
     return out;
 }
 
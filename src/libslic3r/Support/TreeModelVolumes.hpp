@@ -9,11 +9,18 @@
 #ifndef slic3r_TreeModelVolumes_hpp
 #define slic3r_TreeModelVolumes_hpp
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
 
+#include <tbb/concurrent_vector.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/spin_mutex.h>
+
 #include "TreeSupportCommon.hpp"
 
 #include "../Point.hpp"
@@ -195,43 +202,81 @@ private:
      * \brief Convenience typedef for the keys to the caches
      */
     using RadiusLayerPair             = std::pair<coord_t, LayerIndex>;
+public:
+    // Counters of the cache lookups, summed over the threads.
+    struct CacheStats {
+        size_t hits      { 0 };
+        size_t misses    { 0 };
+        // Insertions, which had to wait for another thread inserting into the same layer or allocating layers.
+        size_t contended { 0 };
+
+        CacheStats& operator+=(const CacheStats &rhs) { hits += rhs.hits; misses += rhs.misses; contended += rhs.contended; return *this; }
+    };
+    // Statistics of all the caches, for profiling of the tree support generation.
+    // Not thread safe, to be called between the parallel sections only.
+    CacheStats cache_stats() const;
+
+private:
+    // Cache of Polygons indexed by layer and radius, accessed concurrently by the tree support threads.
+    // The cache is sharded by layer: Lookups do not lock at all, insertions only lock the layer they insert into,
+    // thus the threads working on different layers or looking up already calculated areas do not block each other.
     class RadiusLayerPolygonCache {
-        // Map from radius to Polygons. Cache of one layer collision regions.
-        using LayerData = std::map<coord_t, Polygons>;
-        // Vector of layers, at each layer map of radius to Polygons.
-        // Reference to Polygons returned shall be stable to insertion.
-        using Layers = std::vector<LayerData>;
+        // Polygons of a single radius. The polygons are allocated separately, so that a reference returned
+        // stays valid while other threads append entries to the same layer. clear() invalidates all references,
+        // clear_all_but_radius0() invalidates all references but those to the smallest radius of each layer.
+        struct Entry {
+            coord_t                   radius;
+            std::unique_ptr<Polygons> polygons;
+        };
+        // Entries of one layer in the order of insertion, each radius is stored at most once.
+        // The first num_entries entries are fully constructed and they are never modified,
+        // thus they may be read without locking while another thread appends a new entry under the mutex.
+        struct Layer {
+            tbb::concurrent_vector<Entry> entries;
+            std::atomic<size_t>           num_entries { 0 };
+            tbb::spin_mutex               mutex;
+        };
     public:
         RadiusLayerPolygonCache() = default;
-        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) : m_data(std::move(rhs.m_data)) {}
-        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) { m_data = std::move(rhs.m_data); return *this; }
+        // The counters are copied, as a moved from enumerable_thread_specific could not be used anymore.
+        // Both caches get new identifiers, as the addresses of their counters change.
+        RadiusLayerPolygonCache(RadiusLayerPolygonCache &&rhs) :
+            m_layers(std::move(rhs.m_layers)), m_num_layers(rhs.m_num_layers.exchange(0)), m_stats(rhs.m_stats) {
+            rhs.m_stats.clear();
+            rhs.m_id = next_id();
+        }
+        RadiusLayerPolygonCache& operator=(RadiusLayerPolygonCache &&rhs) {
+            m_layers     = std::move(rhs.m_layers);
+            m_num_layers = rhs.m_num_layers.exchange(0);
+            m_stats      = rhs.m_stats;
+            m_id         = next_id();
+            rhs.m_stats.clear();
+            rhs.m_id     = next_id();
+            return *this;
+        }
 
         RadiusLayerPolygonCache(const RadiusLayerPolygonCache&) = delete;
         RadiusLayerPolygonCache& operator=(const RadiusLayerPolygonCache&) = delete;
 
         void insert(std::vector<std::pair<RadiusLayerPair, Polygons>> &&in) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first.second).emplace(d.first.first, std::move(d.second));
+                this->insert(d.first.second, d.first.first, std::move(d.second));
         }
         // by layer
         void insert(std::vector<std::pair<coord_t, Polygons>> &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             for (auto &d : in)
-                this->get_allocate_layer_data(d.first).emplace(radius, std::move(d.second));
+                this->insert(d.first, radius, std::move(d.second));
         }
         void insert(std::vector<Polygons> &&in, coord_t first_layer_idx, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             allocate_layers(first_layer_idx + in.size());
             for (auto &d : in)
-                m_data[first_layer_idx ++].emplace(radius, std::move(d));
+                this->insert(first_layer_idx ++, radius, std::move(d));
         }
         void insert(LayerPolygonCache &&in, coord_t radius) {
-            std::lock_guard<std::mutex> guard(m_mutex);
             LayerIndex i = in.begin();
             allocate_layers(i + LayerIndex(in.size()));
             for (auto &d : in.polygons_mutable())
-                m_data[i ++].emplace(radius, std::move(d));
+                this->insert(i ++, radius, std::move(d));
         }
         /*!
          * \brief Checks a cache for a given RadiusLayerPair and returns it if it is found
@@ -239,29 +284,28 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         std::optional<std::reference_wrapper<const Polygons>> getArea(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
-                return std::optional<std::reference_wrapper<const Polygons>>{};
-            const auto &layer = m_data[key.second];
-            auto it = layer.find(key.first);
-            return it == layer.end() ? 
-                std::optional<std::reference_wrapper<const Polygons>>{} : std::optional<std::reference_wrapper<const Polygons>>{ it->second };
+            if (const Layer *layer = this->layer(key.second); layer)
+                for (size_t i = 0, n = layer->num_entries.load(std::memory_order_acquire); i < n; ++ i)
+                    if (const Entry &entry = layer->entries[i]; entry.radius == key.first) {
+                        ++ this->local_stats().hits;
+                        return std::optional<std::reference_wrapper<const Polygons>>{ *entry.polygons };
+                    }
+            ++ this->local_stats().misses;
+            return std::optional<std::reference_wrapper<const Polygons>>{};
         }
         // Get a collision area at a given layer for a radius that is a lower or equial to the key radius.
         std::optional<std::pair<coord_t, std::reference_wrapper<const Polygons>>> get_lower_bound_area(const TreeModelVolumes::RadiusLayerPair &key) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            if (key.second >= LayerIndex(m_data.size()))
+            const Entry *best = nullptr;
+            if (const Layer *layer = this->layer(key.second); layer)
+                for (size_t i = 0, n = layer->num_entries.load(std::memory_order_acquire); i < n; ++ i)
+                    if (const Entry &entry = layer->entries[i]; entry.radius <= key.first && (best == nullptr || entry.radius > best->radius))
+                        best = &entry;
+            if (best == nullptr) {
+                ++ this->local_stats().misses;
                 return {};
-            const auto &layer = m_data[key.second];
-            if (layer.empty())
-                return {};
-            auto it = layer.lower_bound(key.first);
-            if (it == layer.end() || it->first != key.first) {
-                if (it == layer.begin())
-                    return {};
-                -- it;
             }
-            return std::make_pair(it->first, std::reference_wrapper<const Polygons>(it->second));
+            ++ this->local_stats().hits;
+            return std::make_pair(best->radius, std::reference_wrapper<const Polygons>(*best->polygons));
         }
         /*!
          * \brief Get the highest already calculated layer in the cache.
@@ -271,10 +315,9 @@ private:
          * \return A wrapped optional reference of the requested area (if it was found, an empty optional if nothing was found)
          */
         LayerIndex getMaxCalculatedLayer(coord_t radius) const {
-            std::lock_guard<std::mutex> guard(m_mutex);
-            auto layer_idx = LayerIndex(m_data.size()) - 1;
+            auto layer_idx = LayerIndex(m_num_layers.load(std::memory_order_acquire)) - 1;
             for (; layer_idx > 0; -- layer_idx)
-                if (const auto &layer = m_data[layer_idx]; layer.find(radius) != layer.end())
+                if (this->has(*m_layers[layer_idx], radius))
                     break;
             // The placeable on model areas do not exist on layer 0, as there can not be model below it. As such it may be possible that layer 1 is available, but layer 0 does not exist.
             return layer_idx == 0 ? -1 : layer_idx;
@@ -283,25 +326,55 @@ private:
         // For debugging purposes, sorted by layer index, then by radius.
         [[nodiscard]] std::vector<std::pair<RadiusLayerPair, std::reference_wrapper<const Polygons>>> sorted() const;
 
-        void clear() { m_data.clear(); }
-        void clear_all_but_radius0() { 
-            for (LayerData &l : m_data) {
-                auto begin = l.begin();
-                auto end = l.end();
-                if (begin != end && ++ begin != end)
-                    l.erase(begin, end);
-            }
-        }
+        // Hits, misses and contended insertions since the cache was created.
+        // Not thread safe, to be called between the parallel sections only.
+        CacheStats stats() const { return m_stats.combine([](const CacheStats &l, const CacheStats &r) { CacheStats out = l; return out += r; }); }
+
+        // Not thread safe, to be called between the parallel sections only.
+        void clear() { m_layers.clear(); m_num_layers = 0; }
+        void clear_all_but_radius0();
 
     private:
-        LayerData&          get_allocate_layer_data(LayerIndex layer_idx) {
-            allocate_layers(layer_idx + 1);
-            return m_data[layer_idx];
+        // Returns nullptr if the layer was not allocated yet.
+        const Layer*        layer(LayerIndex layer_idx) const {
+            return layer_idx >= 0 && size_t(layer_idx) < m_num_layers.load(std::memory_order_acquire) ? m_layers[layer_idx].get() : nullptr;
+        }
+        static bool         has(const Layer &layer, coord_t radius) {
+            for (size_t i = 0, n = layer.num_entries.load(std::memory_order_acquire); i < n; ++ i)
+                if (layer.entries[i].radius == radius)
+                    return true;
+            return false;
         }
+        // Insert polygons unless the radius is already cached at the layer, the first insertion wins.
+        void                insert(LayerIndex layer_idx, coord_t radius, Polygons &&polygons);
         void                allocate_layers(size_t num_layers);
 
-        Layers              m_data;
-        mutable std::mutex  m_mutex;
+        // Counters of the current thread for this cache. Looking up the thread specific counters of m_stats for each
+        // cache lookup would be expensive, thus each thread remembers its counters of the recently used caches
+        // in a small table indexed by the cache identifier.
+        CacheStats&         local_stats() const {
+            StatsSlot &slot = s_stats_slots[m_id % s_stats_slots.size()];
+            if (slot.cache_id != m_id)
+                slot = { m_id, &m_stats.local() };
+            return *slot.stats;
+        }
+        static uint64_t     next_id();
+
+        struct StatsSlot {
+            uint64_t    cache_id { 0 };
+            CacheStats *stats    { nullptr };
+        };
+        static thread_local std::array<StatsSlot, 16>   s_stats_slots;
+
+        // Layers are allocated under m_allocation_mutex and published by storing m_num_layers.
+        // A concurrent_vector never relocates its elements, thus a layer may be accessed while the vector grows.
+        tbb::concurrent_vector<std::unique_ptr<Layer>>  m_layers;
+        std::atomic<size_t>                             m_num_layers { 0 };
+        std::mutex                                      m_allocation_mutex;
+        // Counted per thread, so that the counting does not make the threads fight over a cache line.
+        mutable tbb::enumerable_thread_specific<CacheStats> m_stats;
+        // Unique over the lifetime of the process, so that a slot of s_stats_slots is never matched by another cache.
+        uint64_t                                        m_id { next_id() };
     };
 
 
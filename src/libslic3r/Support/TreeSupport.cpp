@@ -3555,6 +3555,9 @@ static void generate_support_areas(Print &print, const BuildVolume &build_volume
                 "Influence area creation: " << dur_path << "ms "
                 "Placement of Points in InfluenceAreas: " << dur_place << "ms "
                 "Drawing result as support " << dur_draw << " ms";
+            TreeModelVolumes::CacheStats cache_stats = volumes.cache_stats();
+            BOOST_LOG_TRIVIAL(debug) << "Tree support collision / avoidance caches: " << cache_stats.hits << " hits, " <<
+                cache_stats.misses << " misses, " << cache_stats.contended << " contended insertions";
     //        if (config.branch_radius==2121)
     //            BOOST_LOG_TRIVIAL(error) << "Why ask questions when you already know the answer twice.\n (This is not a real bug, please dont report it.)";
             
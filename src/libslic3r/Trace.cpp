@@ -0,0 +1,179 @@
+#include "Trace.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include <boost/nowide/fstream.hpp>
+
+#include "Thread.hpp"
+
+namespace Slic3r {
+namespace Trace {
+
+namespace detail {
+    std::atomic<bool> enabled { false };
+}
+
+namespace {
+
+struct Event
+{
+    const char *name;
+    const char *arg_names[2];
+    int64_t     arg_values[2];
+    // Nanoseconds since start().
+    int64_t     begin;
+    // -1 while the zone is running.
+    int64_t     end;
+    uint32_t    depth;
+};
+
+// Zones recorded by a single thread. The buffers are never released, so that a thread may keep a pointer to its buffer.
+struct ThreadBuffer
+{
+    int                 id;
+    std::string         name;
+    // Only contended by start() and export_chrome_trace().
+    std::mutex          mutex;
+    std::vector<Event>  events;
+    // Number of the running zones.
+    uint32_t            depth { 0 };
+    // Incremented by start(), so that a zone started before start() is not finished into the new recording.
+    uint32_t            generation { 0 };
+};
+
+struct Registry
+{
+    std::mutex                                  mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>>  buffers;
+    std::atomic<int64_t>                        epoch { 0 };
+};
+
+// Never destructed, threads may still record while the static objects are being destructed.
+Registry& registry()
+{
+    static Registry *registry = new Registry;
+    return *registry;
+}
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThreadBuffer& this_thread_buffer()
+{
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (buffer == nullptr) {
+        Registry &reg = registry();
+        std::scoped_lock lock(reg.mutex);
+        buffer = reg.buffers.emplace_back(std::make_unique<ThreadBuffer>()).get();
+        buffer->id = int(reg.buffers.size());
+        if (std::optional<std::string> name = get_current_thread_name(); name && ! name->empty())
+            buffer->name = *name;
+        else
+            buffer->name = "thread " + std::to_string(buffer->id);
+    }
+    return *buffer;
+}
+
+std::string escape_json(const char *str)
+{
+    std::string out;
+    for (; *str != 0; ++ str) {
+        if (*str == '"' || *str == '\\')
+            out += '\\';
+        out += *str;
+    }
+    return out;
+}
+
+} // namespace
+
+void start()
+{
+    Registry &reg = registry();
+    {
+        std::scoped_lock lock(reg.mutex);
+        for (std::unique_ptr<ThreadBuffer> &buffer : reg.buffers) {
+            std::scoped_lock buffer_lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->depth = 0;
+            ++ buffer->generation;
+        }
+        reg.epoch = now();
+    }
+    detail::enabled = true;
+}
+
+void stop()
+{
+    detail::enabled = false;
+}
+
+void Zone::begin(const char *name, const char *arg_name, int64_t arg_value, const char *arg2_name, int64_t arg2_value)
+{
+    ThreadBuffer &buffer = this_thread_buffer();
+    const int64_t begin  = now() - registry().epoch.load(std::memory_order_relaxed);
+    std::scoped_lock lock(buffer.mutex);
+    m_event      = buffer.events.size();
+    m_generation = buffer.generation;
+    buffer.events.push_back({ name, { arg_name, arg2_name }, { arg_value, arg2_value }, begin, -1, buffer.depth ++ });
+}
+
+void Zone::end()
+{
+    ThreadBuffer &buffer = this_thread_buffer();
+    const int64_t end    = now() - registry().epoch.load(std::memory_order_relaxed);
+    std::scoped_lock lock(buffer.mutex);
+    if (buffer.generation == m_generation && m_event < buffer.events.size()) {
+        buffer.events[m_event].end = end;
+        -- buffer.depth;
+    }
+}
+
+bool export_chrome_trace(const std::string &path)
+{
+    std::ostringstream out;
+    out.imbue(std::locale::classic());
+    out << std::fixed << std::setprecision(3) << "{\n\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [";
+    bool first = true;
+    auto separator = [&first]() { const char *sep = first ? "\n" : ",\n"; first = false; return sep; };
+    {
+        Registry &reg = registry();
+        std::scoped_lock lock(reg.mutex);
+        for (const std::unique_ptr<ThreadBuffer> &buffer : reg.buffers) {
+            std::scoped_lock buffer_lock(buffer->mutex);
+            if (buffer->events.empty())
+                continue;
+            out << separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+                << ", \"args\": {\"name\": \"" << escape_json(buffer->name.c_str()) << "\"}}";
+            for (const Event &event : buffer->events) {
+                if (event.end < 0)
+                    continue;
+                // Timestamps in microseconds.
+                out << separator() << "{\"name\": \"" << escape_json(event.name) << "\", \"cat\": \"slic3r\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->id
+                    << ", \"ts\": " << double(event.begin) * 1e-3 << ", \"dur\": " << double(event.end - event.begin) * 1e-3
+                    << ", \"args\": {\"depth\": " << event.depth;
+                for (int i = 0; i < 2; ++ i)
+                    if (event.arg_names[i])
+                        out << ", \"" << escape_json(event.arg_names[i]) << "\": " << event.arg_values[i];
+                out << "}}";
+            }
+        }
+    }
+    out << "\n]\n}\n";
+
+    boost::nowide::ofstream file(path);
+    file << out.str();
+    file.close();
+    return bool(file);
+}
+
+} // namespace Trace
+} // namespace Slic3r
@@ -0,0 +1,64 @@
+#ifndef slic3r_Trace_hpp_
+#define slic3r_Trace_hpp_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Slic3r {
+namespace Trace {
+
+// Runtime enabled tracing of the slicing steps. The zones are recorded per thread into buffers, which are
+// exported as a Chrome trace (JSON trace event format), to be opened by chrome://tracing or https://ui.perfetto.dev
+// Zones nest by their time intervals on a thread. If tracing is disabled, a zone costs a single relaxed atomic load.
+
+namespace detail {
+    extern std::atomic<bool> enabled;
+}
+
+inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+// Discards the previously recorded zones and starts recording.
+void start();
+// Stops recording, the recorded zones are kept until the next start().
+void stop();
+// Writes the recorded zones into a file in the Chrome trace format.
+// To be called once the traced work finished, a zone still running is not exported.
+// Returns false if the file could not be written.
+bool export_chrome_trace(const std::string &path);
+
+// Records the time interval of its lifetime on the calling thread, optionally with up to two integer arguments,
+// for example the layer index and the region ID. The name and the argument names shall be string literals,
+// only their pointers are stored.
+class Zone
+{
+public:
+    explicit Zone(const char *name) { if (enabled()) this->begin(name, nullptr, 0, nullptr, 0); }
+    Zone(const char *name, const char *arg_name, int64_t arg_value)
+        { if (enabled()) this->begin(name, arg_name, arg_value, nullptr, 0); }
+    Zone(const char *name, const char *arg_name, int64_t arg_value, const char *arg2_name, int64_t arg2_value)
+        { if (enabled()) this->begin(name, arg_name, arg_value, arg2_name, arg2_value); }
+    ~Zone() { if (m_event != size_t(-1)) this->end(); }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    void begin(const char *name, const char *arg_name, int64_t arg_value, const char *arg2_name, int64_t arg2_value);
+    void end();
+
+    // Index of the event in the buffer of the thread, -1 if not recording.
+    size_t   m_event      { size_t(-1) };
+    // Recording the event belongs to, see start().
+    uint32_t m_generation { 0 };
+};
+
+} // namespace Trace
+} // namespace Slic3r
+
+#define SLIC3R_TRACE_CAT2(a, b) a##b
+#define SLIC3R_TRACE_CAT(a, b) SLIC3R_TRACE_CAT2(a, b)
+// Traces the rest of the enclosing scope: SLIC3R_TRACE_ZONE("name") or SLIC3R_TRACE_ZONE("name", "layer", layer_id).
+#define SLIC3R_TRACE_ZONE(...) ::Slic3r::Trace::Zone SLIC3R_TRACE_CAT(slic3r_trace_zone_, __LINE__)(__VA_ARGS__)
+
+#endif // slic3r_Trace_hpp_
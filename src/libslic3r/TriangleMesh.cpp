@@ -206,7 +206,11 @@ bool TriangleMesh::ReadSTLFile(const char* input_file, bool repair)
 
     m_stats.number_of_parts         = stl.stats.number_of_parts;
 
-    stl_generate_shared_vertices(&stl, this->its);
+    if (repair)
+        stl_generate_shared_vertices(&stl, this->its);
+    else
+        // The facet neighbors are not known without the repair.
+        stl_generate_shared_vertices_exact(&stl, this->its);
     return true;
 }
 
@@ -3,6 +3,7 @@
 #include "Exception.hpp"
 #include "Zipper.hpp"
 #include "miniz_extension.hpp"
+#include "ParallelZipWriter.hpp"
 #include <boost/log/trivial.hpp>
 #include "I18N.hpp"
 
@@ -17,6 +18,8 @@ namespace Slic3r {
 class Zipper::Impl: public MZ_Archive {
 public:
     std::string m_zipname;
+    // Compresses the entries on worker threads and writes them into arch.
+    std::unique_ptr<ParallelZipWriter> m_writer;
 
     std::string formatted_errorstr() const
     {
@@ -47,6 +50,15 @@ Zipper::Zipper(const std::string &zipfname, e_compression compression)
     if (!open_zip_writer(&m_impl->arch, zipfname)) {
         m_impl->blow_up();
     }
+
+    int level = MZ_NO_COMPRESSION;
+    switch (m_compression) {
+    case NO_COMPRESSION: level = MZ_NO_COMPRESSION; break;
+    case FAST_COMPRESSION: level = MZ_BEST_SPEED; break;
+    case DEFAULT_COMPRESSION: level = MZ_DEFAULT_LEVEL; break;
+    case TIGHT_COMPRESSION: level = MZ_BEST_COMPRESSION; break;
+    }
+    m_impl->m_writer = std::make_unique<ParallelZipWriter>(m_impl->arch, level);
 }
 
 Zipper::~Zipper()
@@ -57,10 +69,14 @@ Zipper::~Zipper()
             BOOST_LOG_TRIVIAL(error) << m_impl->formatted_errorstr();
         }
 
-        if(!mz_zip_writer_finalize_archive(&m_impl->arch))
+        if(!m_impl->m_writer->flush() ||
+           !mz_zip_writer_finalize_archive(&m_impl->arch))
             BOOST_LOG_TRIVIAL(error) << m_impl->formatted_errorstr();
     }
 
+    // The compression tasks have to finish before the archive is released.
+    m_impl->m_writer.reset();
+
     // The file should be closed no matter what...
     if(!close_zip_writer(&m_impl->arch))
         BOOST_LOG_TRIVIAL(error) << m_impl->formatted_errorstr();
@@ -93,14 +109,8 @@ void Zipper::add_entry(const std::string &name, const void *data, size_t l)
     if(!m_impl->is_alive()) return;
 
     finish_entry();
-    mz_uint cmpr = MZ_NO_COMPRESSION;
-    switch (m_compression) {
-    case NO_COMPRESSION: cmpr = MZ_NO_COMPRESSION; break;
-    case FAST_COMPRESSION: cmpr = MZ_BEST_SPEED; break;
-    case TIGHT_COMPRESSION: cmpr = MZ_BEST_COMPRESSION; break;
-    }
 
-    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
+    if(!m_impl->m_writer->add_entry(name, data, l))
         m_impl->blow_up();
 
     m_entry.clear();
@@ -112,18 +122,8 @@ void Zipper::finish_entry()
     if(!m_impl->is_alive()) return;
 
     if(!m_data.empty() && !m_entry.empty()) {
-        mz_uint compression = MZ_NO_COMPRESSION;
-
-        switch (m_compression) {
-        case NO_COMPRESSION: compression = MZ_NO_COMPRESSION; break;
-        case FAST_COMPRESSION: compression = MZ_BEST_SPEED; break;
-        case TIGHT_COMPRESSION: compression = MZ_BEST_COMPRESSION; break;
-        }
-
-        if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
-                                  m_data.c_str(),
-                                  m_data.size(),
-                                  compression)) m_impl->blow_up();
+        if(!m_impl->m_writer->add_entry(m_entry, std::move(m_data)))
+            m_impl->blow_up();
     }
 
     m_data.clear();
@@ -134,7 +134,8 @@ void Zipper::finalize()
 {
     finish_entry();
 
-    if(m_impl->is_alive()) if(!mz_zip_writer_finalize_archive(&m_impl->arch))
+    if(m_impl->is_alive()) if(!m_impl->m_writer->flush() ||
+                              !mz_zip_writer_finalize_archive(&m_impl->arch))
         m_impl->blow_up();
 }
 
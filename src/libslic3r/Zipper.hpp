@@ -10,10 +10,11 @@ namespace Slic3r {
 // Class for creating zip archives.
 class Zipper {
 public:
-    // Three compression levels supported
+    // Four compression levels supported
     enum e_compression {
         NO_COMPRESSION,
         FAST_COMPRESSION,
+        DEFAULT_COMPRESSION,
         TIGHT_COMPRESSION
     };
 
@@ -48,6 +49,7 @@ public:
     void add_entry(const std::string& name);
 
     /// Add a new binary file entry with an instantly given byte buffer.
+    /// The buffer is copied, the entry is compressed on a worker thread.
     /// This method throws exactly like finish_entry() does.
     void add_entry(const std::string& name, const void* data, size_t bytes);
 
@@ -77,11 +79,15 @@ public:
     /// If the buffer was written, but no entry was added, the buffer will be
     /// cleared after this call.
     ///
-    /// This method will throw a runtime exception if an error occures. The
-    /// entry will still be open (with the data intact) but the state of the
-    /// file is up to minz after the erroneous write.
+    /// The entries are compressed on worker threads and written into the
+    /// archive in the order they were added, thus an error writing an entry
+    /// is reported by a later call. This method will throw a runtime exception
+    /// if an error occures, the state of the file is up to minz after the
+    /// erroneous write.
     void finish_entry();
 
+    /// Wait for the entries to be compressed, write them and finalize the
+    /// archive. Throws like finish_entry() does.
     void finalize();
 
     const std::string & get_filename() const;
@@ -1120,15 +1120,8 @@ std::string log_memory_info(bool ignore_loglevel)
     #endif
         // Now get peak memory usage.
         out += "; Peak memory usage: ";
-        rusage memory_info;
-        if (getrusage(RUSAGE_SELF, &memory_info) == 0)
-        {
-            size_t peak_mem_usage = (size_t)memory_info.ru_maxrss;
-            #ifdef __linux__
-                peak_mem_usage *= 1024;// getrusage returns the value in kB on linux
-            #endif
+        if (size_t peak_mem_usage = peak_memory_usage(); peak_mem_usage > 0)
             out += format_memsize_MB(peak_mem_usage);
-        }
         else
             out += "N/A";
 #endif
@@ -1136,6 +1129,26 @@ std::string log_memory_info(bool ignore_loglevel)
     return out;
 }
 
+// Returns the peak resident memory of the process in bytes, zero if not available.
+size_t peak_memory_usage()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return size_t(pmc.PeakWorkingSetSize);
+#elif defined(__linux__) or defined(__APPLE__)
+    rusage memory_info;
+    if (getrusage(RUSAGE_SELF, &memory_info) == 0) {
+        size_t peak_mem_usage = (size_t)memory_info.ru_maxrss;
+    #ifdef __linux__
+        peak_mem_usage *= 1024;// getrusage returns the value in kB on linux
+    #endif
+        return peak_mem_usage;
+    }
+#endif
+    return 0;
+}
+
 // Returns the size of physical memory (RAM) in bytes.
 // http://nadeausoftware.com/articles/2012/09/c_c_tip_how_get_physical_memory_size_system
 size_t total_physical_memory()
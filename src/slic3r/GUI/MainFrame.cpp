@@ -21,6 +21,7 @@
 #include "libslic3r/Polygon.hpp"
 #include "libslic3r/SLAPrint.hpp"
 #include "libslic3r/PresetBundle.hpp"
+#include "libslic3r/Trace.hpp"
 
 #include "Tab.hpp"
 #include "ProgressStatusBar.hpp"
@@ -1166,6 +1167,19 @@ static wxMenu* generate_help_menu()
         [](wxCommandEvent&) { wxGetApp().system_info(); });
     append_menu_item(helpMenu, wxID_ANY, _L("Show &Configuration Folder"), _L("Show user configuration folder (datadir)"),
         [](wxCommandEvent&) { Slic3r::GUI::desktop_open_datadir_folder(); });
+    append_menu_check_item(helpMenu, wxID_ANY, _L("Record Slicing &Trace"),
+        _L("Record the time spent in the slicing steps until unchecked, then save it in the Chrome trace format"),
+        [](wxCommandEvent&) {
+            if (! Trace::enabled()) {
+                Trace::start();
+                return;
+            }
+            Trace::stop();
+            wxFileDialog dlg(wxGetApp().mainframe, _L("Save slicing trace as:"), wxGetApp().app_config->get_last_dir(), "trace.json",
+                "JSON (*.json)|*.json;*.JSON", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+            if (dlg.ShowModal() == wxID_OK && ! Trace::export_chrome_trace(into_u8(dlg.GetPath())))
+                show_error(wxGetApp().mainframe, _L("Failed to save the slicing trace."));
+        }, nullptr);
     append_menu_item(helpMenu, wxID_ANY, _L("Report an I&ssue"), wxString::Format(_L("Report an issue on %s"), SLIC3R_APP_NAME),
         [](wxCommandEvent&) { wxGetApp().open_browser_with_warning_dialog("https://github.com/prusa3d/slic3r/issues/new", nullptr, false); });
     if (wxGetApp().is_editor())
@@ -221,6 +221,10 @@ void PreferencesDialog::build()
 	// Add "General" tab
 	m_optgroup_general = create_options_tab(L("General"), tabs);
 	m_optgroup_general->m_on_change = [this](t_config_option_key opt_key, boost::any value) {
+		if (opt_key == "archive_compression") {
+			m_values[opt_key] = ConfigOptionEnum<ArchiveCompression>::get_enum_names()[boost::any_cast<int>(value)];
+			return;
+		}
 		if (auto it = m_values.find(opt_key); it != m_values.end()) {
 			m_values.erase(it); // we shouldn't change value, if some of those parameters were selected, and then deselected
 			return;
@@ -268,6 +272,16 @@ void PreferencesDialog::build()
 			L("If enabled, allows the Reload from disk command to automatically find and load the files when invoked."),
 			app_config->get_bool("export_sources_full_pathnames"));
 
+		append_enum_option<ArchiveCompression>(m_optgroup_general, "archive_compression",
+			L("Compression of project files"),
+			L("Compression level of the saved 3mf projects. Fast compression saves large projects quicker, "
+			  "maximum compression produces the smallest files, but takes considerably longer."),
+			new ConfigOptionEnum<ArchiveCompression>(archive_compression_from_string(app_config->get("archive_compression"))),
+			{ { "fast", L("Fast") },
+			  { "default", L("Default") },
+			  { "max", L("Maximum") }
+			});
+
 #ifdef _WIN32
 		// Please keep in sync with ConfigWizard
 		append_bool_option(m_optgroup_general, "associate_3mf",
@@ -798,6 +812,10 @@ void PreferencesDialog::revert(wxEvent&)
 			m_optgroup_gui->set_value(key, s_keys_map_NotifyReleaseMode.at(app_config->get(key)));
 			continue;
 		}
+		if (key == "archive_compression") {
+			m_optgroup_general->set_value(key, int(archive_compression_from_string(app_config->get("archive_compression"))));
+			continue;
+		}
 		if (key == "old_settings_layout_mode") {
 			m_rb_old_settings_layout_mode->SetValue(app_config->get_bool(key));
 			m_settings_layout_changed = false;
@@ -1676,6 +1676,7 @@ void TabPrint::build()
         optgroup = page->new_optgroup(L("Output file"));
         optgroup->append_single_option_line("gcode_comments");
         optgroup->append_single_option_line("gcode_label_objects");
+        optgroup->append_single_option_line("gcode_single_pass");
         Option option = optgroup->get_option("output_filename_format");
         option.opt.full_width = true;
         optgroup->append_single_option_line(option);
@@ -2728,6 +2729,8 @@ void TabPrinter::build_sla()
 
     optgroup = page->new_optgroup(L("Output"));
     optgroup->append_single_option_line("sla_archive_format");
+    optgroup->append_single_option_line("sla_archive_compression");
+    optgroup->append_single_option_line("sla_archive_fast_png");
     optgroup->append_single_option_line("sla_output_precision");
 
     build_print_host_upload_group(page.get());
@@ -100,6 +100,43 @@ SCENARIO("Cooling unit tests", "[Cooling]") {
         }
     }
 
+    WHEN("G-code block 4 is tokenized in advance") {
+        const std::string gcode_src =
+            "G1 X50 F2500\n"
+            "G1 F3000;_EXTRUDE_SET_SPEED\n"
+            "G1 X100 E1\n"
+            ";_EXTRUDE_END\n"
+            "G1 E4 F400";
+        config.set_deserialize_strict({ { "slowdown_below_layer_time", 10 } });
+        GCode gcodegen;
+        auto buffer = make_cooling_buffer(gcodegen, config);
+        GCode gcodegen2;
+        auto buffer2 = make_cooling_buffer(gcodegen2, config);
+        GCodeLayerLines lines;
+        lines.parse(gcode_src, 'E', gcodegen2.writer().toolchange_prefix());
+        THEN("the output matches the output of the G-code tokenized by the cooling buffer") {
+            std::string gcode  = buffer->process_layer(gcode_src, 0, true);
+            std::string gcode2 = buffer2->process_layer(std::string(gcode_src), std::move(lines), 0, true);
+            REQUIRE(gcode.find("F3000") == gcode.npos);
+            REQUIRE(gcode == gcode2);
+        }
+    }
+
+    WHEN("G4 dwell lines are tokenized") {
+        GCode gcodegen;
+        GCodeLayerLines lines;
+        lines.parse("G4 S2\nG4 P500\nG4 ; no wait\n", 'E', gcodegen.writer().toolchange_prefix());
+        THEN("S is read in seconds, P in milliseconds") {
+            REQUIRE(lines.size() == 3);
+            REQUIRE(lines[0].type == GCodeLayerLine::TYPE_G4);
+            REQUIRE(lines[0].time == Approx(2.f));
+            REQUIRE(lines[1].type == GCodeLayerLine::TYPE_G4);
+            REQUIRE(lines[1].time == Approx(0.5f));
+            REQUIRE(lines[2].type == GCodeLayerLine::TYPE_G4);
+            REQUIRE(lines[2].time == 0.f);
+        }
+    }
+
     WHEN("G-code block 1") {
         THEN("fan is not activated when elapsed time is greater than fan threshold") {
             config.set_deserialize_strict({
@@ -407,3 +407,34 @@ TEST_CASE("ExtrusionEntityCollection: Chained path with no explicit starting poi
     auto chained   = chain_polylines(polylines);
     REQUIRE(chained == target);
 }
+
+SCENARIO("ExtrusionEntityArena", "[ExtrusionEntity]") {
+    GIVEN("An arena bound to the current thread") {
+        auto arena = std::make_unique<ExtrusionEntityArena>();
+        ExtrusionEntityCollection collection;
+        {
+            ExtrusionEntityArena::Scope arena_scope(arena.get());
+            collection.append(random_paths(1000));
+        }
+        THEN("the entities are allocated from the arena") {
+            REQUIRE(arena->num_allocations() == 1000);
+            REQUIRE(arena->num_blocks() > 0);
+            REQUIRE(arena->num_blocks() < 100);
+        }
+        WHEN("the entities are cloned outside of the scope") {
+            collection.append(collection);
+            THEN("the arena is not used") {
+                REQUIRE(arena->num_allocations() == 1000);
+            }
+        }
+        WHEN("the arena is destroyed before its entities") {
+            arena.reset();
+            THEN("the entities stay valid") {
+                double length = 0;
+                for (const ExtrusionEntity *entity : collection.entities)
+                    length += entity->length();
+                REQUIRE(length > 0);
+            }
+        }
+    }
+}
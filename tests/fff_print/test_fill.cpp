@@ -31,6 +31,18 @@ TEST_CASE("Fill: adjusted solid distance") {
 }
 #endif
 
+TEST_CASE("Fill: band spans", "[Fill]") {
+    // Square 100x100 with a 40x40 hole in its center.
+    Polygons ring { Polygon({ {0, 0}, {100, 0}, {100, 100}, {0, 100} }), Polygon({ {30, 30}, {30, 70}, {70, 70}, {70, 30} }) };
+    std::vector<Fill::Spans> spans = Fill::band_spans(ring, { {10., 20.}, {20., 40.}, {50., 50.}, {90., 110.}, {200., 300.} });
+    REQUIRE(spans.size() == 5);
+    CHECK(spans[0] == Fill::Spans{ {0., 100.} });
+    CHECK(spans[1] == Fill::Spans{ {0., 100.} });
+    CHECK(spans[2] == Fill::Spans{ {0., 30.}, {70., 100.} });
+    CHECK(spans[3] == Fill::Spans{ {0., 100.} });
+    CHECK(spans[4].empty());
+}
+
 TEST_CASE("Fill: Pattern Path Length", "[Fill]") {
     std::unique_ptr<Slic3r::Fill> filler(Slic3r::Fill::new_from_type("rectilinear"));
     filler->angle = float(-(PI)/2.0);
@@ -30,6 +30,30 @@ SCENARIO("PrintObject: Perimeter generation", "[PrintObject]") {
     }
 }
 
+SCENARIO("Print: Objects of a multi-object plate are processed concurrently", "[Print]") {
+    GIVEN("A plate of distinct objects and default config") {
+        const std::initializer_list<TestMesh> meshes { TestMesh::cube_20x20x20, TestMesh::cube_2x20x10, TestMesh::pyramid, TestMesh::step, TestMesh::overhang, TestMesh::_40x10 };
+        WHEN("the plate is processed") {
+            Slic3r::Print print;
+            Slic3r::Test::init_and_process_print(meshes, print, { { "support_material", 1 } });
+            THEN("each object is sliced and has the same layers as if it was processed alone") {
+                REQUIRE(print.objects().size() == meshes.size());
+                auto it_mesh = meshes.begin();
+                for (const PrintObject *object : print.objects()) {
+                    Slic3r::Print print_single;
+                    Slic3r::Test::init_and_process_print({ *it_mesh ++ }, print_single, { { "support_material", 1 } });
+                    const PrintObject &object_single = *print_single.objects().front();
+                    REQUIRE(object->layers().size() == object_single.layers().size());
+                    REQUIRE(object->support_layers().size() == object_single.support_layers().size());
+                    for (size_t layer_idx = 0; layer_idx < object->layers().size(); ++ layer_idx)
+                        REQUIRE(object->layers()[layer_idx]->regions().front()->perimeters().items_count() ==
+                                object_single.layers()[layer_idx]->regions().front()->perimeters().items_count());
+                }
+            }
+        }
+    }
+}
+
 SCENARIO("Print: Skirt generation", "[Print]") {
     GIVEN("20mm cube and default config") {
         WHEN("Skirts is set to 2 loops")  {
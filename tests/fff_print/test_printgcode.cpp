@@ -6,7 +6,11 @@
 #include "test_data.hpp"
 
 #include <algorithm>
+#include <sstream>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/regex.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/nowide/cstdio.hpp>
 
 using namespace Slic3r;
 using namespace Slic3r::Test;
@@ -267,5 +271,88 @@ SCENARIO( "PrintGCode basic functionality", "[PrintGCode]") {
 				REQUIRE(z == Approx(20.));
 			}
         }
+
+        WHEN("the G-code is written in a single pass") {
+            auto export_gcode = [](bool single_pass) {
+                return ::Test::slice({ TestMesh::cube_20x20x20 }, {
+                    { "gcode_flavor",       "marlin2" },
+                    { "remaining_times",    true },
+                    { "gcode_single_pass",  single_pass }
+                });
+            };
+            // Drop the progress lines and the lines, which were reserved for them, and the padding of the backpatched lines.
+            auto normalize = [](const std::string &gcode) {
+                std::string out;
+                std::istringstream is(gcode);
+                for (std::string line; std::getline(is, line);) {
+                    line.erase(line.find_last_not_of(' ') + 1);
+                    if (line != ";" && ! boost::starts_with(line, "M73 "))
+                        out += line + "\n";
+                }
+                return out;
+            };
+            std::string gcode_two_pass   = export_gcode(false);
+            std::string gcode_single_pass = export_gcode(true);
+            THEN("progress is reported") {
+                REQUIRE(gcode_single_pass.find("M73 P0 R") != std::string::npos);
+                REQUIRE(gcode_single_pass.find("M73 P100 R0") != std::string::npos);
+            }
+            THEN("the statistics are backpatched") {
+                REQUIRE(gcode_single_pass.find("; estimated printing time (normal mode) = ") != std::string::npos);
+                REQUIRE(gcode_single_pass.find("; filament used [mm] = ") != std::string::npos);
+            }
+            THEN("the G-code matches the G-code written in two passes") {
+                REQUIRE(normalize(gcode_single_pass) == normalize(gcode_two_pass));
+            }
+        }
+    }
+}
+
+TEST_CASE("GCodeReader: parallel parsing of a file matches sequential parsing", "[GCodeReader]") {
+    std::string gcode = ::Test::slice({ TestMesh::cube_20x20x20 }, {
+        { "gcode_comments",             true },
+        { "use_relative_e_distances",   true }
+    });
+    // Mix the line endings and leave the last line unterminated. Repeat the G-code for the file to be split into multiple blocks.
+    std::string text;
+    size_t      line_idx = 0;
+    while (text.size() < 4 * 1024 * 1024)
+        for (char c : gcode)
+            if (c == '\n')
+                text += (++ line_idx % 3 == 0) ? "\r\n" : (line_idx % 3 == 1) ? "\n" : "\n\n";
+            else
+                text += c;
+    text += "G1 X1 Y2 E0.5";
+    boost::filesystem::path temp = boost::filesystem::unique_path();
+    {
+        FILE *f = boost::nowide::fopen(temp.string().c_str(), "wb");
+        REQUIRE(f != nullptr);
+        fwrite(text.data(), 1, text.size(), f);
+        fclose(f);
     }
+
+    auto parse = [&temp](bool parallel, std::vector<size_t> &lines_ends) {
+        GCodeReader reader;
+        DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+        config.set_deserialize_strict({ { "use_relative_e_distances", true } });
+        reader.apply_config(config);
+        std::vector<std::string> lines;
+        auto callback = [&lines](GCodeReader &reader, const GCodeReader::GCodeLine &line) {
+            std::ostringstream ss;
+            ss << line.raw() << '|' << line.has_x() << line.has_y() << line.has_z() << line.has_e() << line.has_f()
+               << '|' << line.x() << ' ' << line.y() << ' ' << line.e() << '|' << reader.x() << ' ' << reader.y() << ' ' << reader.e();
+            lines.emplace_back(ss.str());
+        };
+        bool result = parallel ? reader.parse_file_parallel(temp.string(), callback, lines_ends) : reader.parse_file(temp.string(), callback, lines_ends);
+        REQUIRE(result);
+        return lines;
+    };
+    std::vector<size_t>      lines_ends, lines_ends_parallel;
+    std::vector<std::string> lines          = parse(false, lines_ends);
+    std::vector<std::string> lines_parallel = parse(true, lines_ends_parallel);
+    boost::nowide::remove(temp.string().c_str());
+
+    REQUIRE(! lines.empty());
+    REQUIRE(lines_parallel == lines);
+    REQUIRE(lines_ends_parallel == lines_ends);
 }
@@ -3,6 +3,9 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/PrintObjectCache.hpp"
+
+#include <boost/filesystem.hpp>
 
 #include "test_data.hpp"
 
@@ -87,3 +90,82 @@ SCENARIO("PrintObject: object layer heights", "[PrintObject]") {
 #endif
     }
 }
+
+SCENARIO("PrintObject: layers with the same slices share their extrusions", "[PrintObject]") {
+    auto fills = [](const Layer &layer) { return layer.regions().front()->fills().as_polylines(); };
+    GIVEN("20mm cube with a rectilinear infill") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {
+            { "fill_density", "20%" },
+            { "fill_pattern", "rectilinear" }
+        });
+        SpanOfConstPtrs<Layer> layers = print.objects().front()->layers();
+        THEN("Layers above the first layer have the perimeters of the second layer") {
+            for (size_t i = 2; i < layers.size(); ++ i) {
+                REQUIRE(&layers[i]->perimeters_source() == layers[1]);
+                REQUIRE(layers[i]->regions().front()->perimeters().as_polylines() == layers[1]->regions().front()->perimeters().as_polylines());
+            }
+        }
+        THEN("Sparse infill alternates its direction between the layers") {
+            for (size_t i = 20; i < 40; ++ i) {
+                REQUIRE(fills(*layers[i]) == fills(*layers[i - 2]));
+                REQUIRE(fills(*layers[i]) != fills(*layers[i - 1]));
+            }
+        }
+    }
+    GIVEN("20mm cube with a gyroid infill") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({TestMesh::cube_20x20x20}, print, {
+            { "fill_density", "20%" },
+            { "fill_pattern", "gyroid" }
+        });
+        SpanOfConstPtrs<Layer> layers = print.objects().front()->layers();
+        THEN("Sparse infill is generated for each layer") {
+            for (size_t i = 20; i < 40; ++ i)
+                REQUIRE(fills(*layers[i]) != fills(*layers[i - 2]));
+        }
+    }
+}
+
+SCENARIO("PrintObject: restoring the results from the object cache", "[PrintObject]") {
+    GIVEN("An overhang sliced with supports and a cache directory") {
+        boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        auto cache  = std::make_shared<PrintObjectCache>(dir.string(), 64 * 1024 * 1024);
+        auto config = DynamicPrintConfig::full_print_config_with({
+            { "support_material",   1 },
+            { "fill_density",       "20%" }
+        });
+        // G-code without the comments, which contain the time of export.
+        auto slice = [&cache](const DynamicPrintConfig &config) {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            Slic3r::Test::init_print({TestMesh::overhang}, print, model, config);
+            print.set_object_cache(cache);
+            std::istringstream gcode(Slic3r::Test::gcode(print));
+            std::string        out;
+            for (std::string line; std::getline(gcode, line);)
+                if (! line.empty() && line.front() != ';')
+                    out += line + "\n";
+            return out;
+        };
+        std::string gcode_sliced = slice(config);
+        WHEN("the object is sliced again with the same config") {
+            std::string gcode_restored = slice(config);
+            THEN("the cache holds the sliced layers and the full results") {
+                REQUIRE(std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator()) == 2);
+            }
+            THEN("the G-code is the same") {
+                REQUIRE(gcode_restored == gcode_sliced);
+            }
+        }
+        WHEN("the object is sliced again with a different infill density") {
+            config.set_deserialize_strict({ { "fill_density", "40%" } });
+            std::string gcode_changed = slice(config);
+            THEN("the sliced layers are reused, the infill is recalculated") {
+                REQUIRE(std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator()) == 3);
+                REQUIRE(gcode_changed != gcode_sliced);
+            }
+        }
+        boost::filesystem::remove_all(dir);
+    }
+}
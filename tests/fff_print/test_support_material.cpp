@@ -1,7 +1,12 @@
 #include <catch2/catch.hpp>
 
+#include "libslic3r/BuildVolume.hpp"
 #include "libslic3r/GCodeReader.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/Support/TreeModelVolumes.hpp"
+#include "libslic3r/Support/TreeSupportCommon.hpp"
+
+#include <tbb/parallel_for.h>
 
 #include "test_data.hpp" // get access to init_print, etc
 
@@ -119,6 +124,74 @@ SCENARIO("SupportMaterial: support_layers_z and contact_distance", "[SupportMate
     }
 }
 
+SCENARIO("SupportMaterial: tree support collision cache filled and looked up concurrently", "[SupportMaterial]")
+{
+    using namespace Slic3r::FFFTreeSupport;
+    GIVEN("Sliced 20mm cube") {
+        Slic3r::Print print;
+        Slic3r::Test::init_and_process_print({ TestMesh::cube_20x20x20 }, print, {
+            { "support_material",       1 },
+            { "support_material_style", "tree" }
+        });
+        const PrintObject &object = *print.objects().front();
+        const BuildVolume  build_volume{ print.config().bed_shape.values, print.config().max_print_height.value };
+        const TreeSupportSettings config{ TreeSupportMeshGroupSettings{ object }, object.slicing_parameters() };
+        auto make_volumes = [&]() {
+            return TreeModelVolumes{ object, build_volume, config.maximum_move_distance, config.maximum_move_distance_slow, 0 };
+        };
+
+        struct Lookup {
+            coord_t    radius;
+            LayerIndex layer_idx;
+            bool       min_xy_dist;
+        };
+        std::vector<Lookup> keys;
+        for (LayerIndex layer_idx = 0; layer_idx < LayerIndex(object.layer_count()); ++ layer_idx)
+            for (coord_t radius : { coord_t(0), config.getRadius(0), config.getRadius(10) })
+                for (bool min_xy_dist : { false, true })
+                    keys.push_back({ radius, layer_idx, min_xy_dist });
+        // Each key is requested multiple times, interleaved with the other keys, so that the threads race
+        // to calculate, insert and look up the same areas.
+        const size_t num_repeats = 4;
+        std::vector<Lookup> lookups;
+        for (size_t i = 0; i < num_repeats * keys.size(); ++ i)
+            lookups.push_back(keys[(i * 7919) % keys.size()]);
+
+        WHEN("the collision areas are requested from parallel threads") {
+            TreeModelVolumes volumes = make_volumes();
+            std::vector<const Polygons*> results(lookups.size(), nullptr);
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, lookups.size(), 8),
+                [&volumes, &lookups, &results](const tbb::blocked_range<size_t> &range) {
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    results[i] = &volumes.getCollision(lookups[i].radius, lookups[i].layer_idx, lookups[i].min_xy_dist);
+            });
+            THEN("repeated lookups of a key return the same cached area") {
+                bool same = true;
+                for (size_t i = 0; i < lookups.size(); ++ i)
+                    if (results[i] != &volumes.getCollision(lookups[i].radius, lookups[i].layer_idx, lookups[i].min_xy_dist))
+                        same = false;
+                REQUIRE(same);
+            }
+            THEN("the areas match the areas calculated by a single thread") {
+                TreeModelVolumes serial = make_volumes();
+                bool equal = true;
+                for (size_t i = 0; i < lookups.size(); ++ i)
+                    if (*results[i] != serial.getCollision(lookups[i].radius, lookups[i].layer_idx, lookups[i].min_xy_dist))
+                        equal = false;
+                REQUIRE(equal);
+            }
+            THEN("all the lookups are counted by the instance looked up") {
+                TreeModelVolumes::CacheStats stats = volumes.cache_stats();
+                REQUIRE(stats.hits >= lookups.size());
+                REQUIRE(stats.misses > 0);
+                TreeModelVolumes other = make_volumes();
+                REQUIRE(other.cache_stats().hits == 0);
+                REQUIRE(other.cache_stats().misses == 0);
+            }
+        }
+    }
+}
+
 #if 0
 // Test 8.
 TEST_CASE("SupportMaterial: forced support is generated", "[SupportMaterial]")
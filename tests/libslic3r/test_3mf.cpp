@@ -3,6 +3,7 @@
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/3mf.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/Zipper.hpp"
 
 #include <boost/filesystem/operations.hpp>
 
@@ -80,6 +81,48 @@ SCENARIO("Export+Import geometry to/from 3mf file cycle", "[3mf]") {
     }
 }
 
+SCENARIO("Export+Import geometry to/from 3mf file with all compression levels", "[3mf]") {
+    GIVEN("model with a geometry file spanning multiple compressed blocks") {
+        Model src_model;
+        std::string src_file = std::string(TEST_DATA_DIR) + "/test_3mf/Prusa.stl";
+        load_stl(src_file.c_str(), &src_model);
+        for (size_t i = 0; i < 40; ++ i)
+            src_model.add_object(*src_model.objects.front());
+        src_model.add_default_instances();
+        TriangleMesh src_mesh = src_model.mesh();
+
+        WHEN("model is saved+loaded to/from 3mf file with fast, default and maximum compression") {
+            std::string test_file = std::string(TEST_DATA_DIR) + "/test_3mf/prusa_compressed.3mf";
+            std::vector<uintmax_t> file_sizes;
+            std::vector<size_t>    num_objects, num_vertices, num_facets;
+            for (ArchiveCompression compression : { ArchiveCompression::Fast, ArchiveCompression::Default, ArchiveCompression::Max }) {
+                if (store_3mf(test_file.c_str(), &src_model, nullptr, false, nullptr, true, compression))
+                    file_sizes.emplace_back(boost::filesystem::file_size(test_file));
+                Model dst_model;
+                DynamicPrintConfig dst_config;
+                ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+                if (load_3mf(test_file.c_str(), dst_config, ctxt, &dst_model, false)) {
+                    TriangleMesh dst_mesh = dst_model.mesh();
+                    num_objects.emplace_back(dst_model.objects.size());
+                    num_vertices.emplace_back(dst_mesh.its.vertices.size());
+                    num_facets.emplace_back(dst_mesh.its.indices.size());
+                }
+                boost::filesystem::remove(test_file);
+            }
+            THEN("the model is loaded back with all the compression levels") {
+                REQUIRE(num_objects == std::vector<size_t>(3, src_model.objects.size()));
+                REQUIRE(num_vertices == std::vector<size_t>(3, src_mesh.its.vertices.size()));
+                REQUIRE(num_facets == std::vector<size_t>(3, src_mesh.its.indices.size()));
+            }
+            THEN("higher compression levels produce smaller files") {
+                REQUIRE(file_sizes.size() == 3);
+                REQUIRE(file_sizes[1] <= file_sizes[0]);
+                REQUIRE(file_sizes[2] <= file_sizes[1]);
+            }
+        }
+    }
+}
+
 SCENARIO("2D convex hull of sinking object", "[3mf]") {
     GIVEN("model") {
         // load a model
@@ -131,3 +174,163 @@ SCENARIO("2D convex hull of sinking object", "[3mf]") {
     }
 }
 
+
+// Model XML with a single mesh object for testing the parallel parsing of the mesh elements against the XML parser.
+struct MeshXML
+{
+    std::vector<std::string> vertices;
+    std::vector<std::string> triangles;
+    // Inserted at the start of the content of the <vertices> and <triangles> elements.
+    std::string              vertices_prefix;
+    std::string              triangles_prefix;
+
+    std::string xml() const {
+        std::string out =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<model unit=\"millimeter\" xml:lang=\"en-US\" xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" "
+            "xmlns:slic3rpe=\"http://schemas.slic3r.org/3mf/2017/06\">\n"
+            " <resources>\n  <object id=\"1\" type=\"model\">\n   <mesh>\n    <vertices>" + vertices_prefix + "\n";
+        for (const std::string &v : vertices)
+            out += "     " + v + "\n";
+        out += "    </vertices>\n    <triangles>" + triangles_prefix + "\n";
+        for (const std::string &t : triangles)
+            out += "     " + t + "\n";
+        out += "    </triangles>\n   </mesh>\n  </object>\n </resources>\n <build>\n  <item objectid=\"1\"/>\n </build>\n</model>\n";
+        return out;
+    }
+
+    // A comment inside the mesh elements makes the importer leave the whole model XML to the XML parser.
+    MeshXML with_xml_parser() const {
+        MeshXML out = *this;
+        out.vertices_prefix  += "<!-- parsed by expat -->";
+        out.triangles_prefix += "<!-- parsed by expat -->";
+        return out;
+    }
+};
+
+// Store the model XML into a 3MF archive and load it.
+static bool load_3mf_model_xml(const std::string &xml, Model &model)
+{
+    boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.3mf");
+    {
+        Zipper zipper(path.string());
+        zipper.add_entry("3D/3dmodel.model", xml.data(), xml.size());
+        zipper.finalize();
+    }
+    DynamicPrintConfig        config;
+    ConfigSubstitutionContext ctxt{ ForwardCompatibilitySubstitutionRule::Disable };
+    bool ret = load_3mf(path.string().c_str(), config, ctxt, &model, false);
+    boost::filesystem::remove(path);
+    return ret;
+}
+
+static bool models_equal(const Model &lhs, const Model &rhs)
+{
+    if (lhs.objects.size() != rhs.objects.size())
+        return false;
+    for (size_t i = 0; i < lhs.objects.size(); ++ i) {
+        const ModelVolumePtrs &lvolumes = lhs.objects[i]->volumes;
+        const ModelVolumePtrs &rvolumes = rhs.objects[i]->volumes;
+        if (lvolumes.size() != rvolumes.size())
+            return false;
+        for (size_t j = 0; j < lvolumes.size(); ++ j) {
+            const ModelVolume &l = *lvolumes[j];
+            const ModelVolume &r = *rvolumes[j];
+            if (l.mesh().its.vertices != r.mesh().its.vertices || l.mesh().its.indices != r.mesh().its.indices ||
+                l.supported_facets.get_data() != r.supported_facets.get_data() ||
+                l.seam_facets.get_data() != r.seam_facets.get_data() ||
+                l.mmu_segmentation_facets.get_data() != r.mmu_segmentation_facets.get_data())
+                return false;
+        }
+    }
+    return true;
+}
+
+static MeshXML tetrahedron_xml()
+{
+    MeshXML mesh;
+    mesh.vertices  = { "<vertex x=\"0\" y=\"0\" z=\"0\"/>", "<vertex x=\"10.5\" y=\"0\" z=\"0\"/>",
+                       "<vertex x=\"0\" y=\"10.25\" z=\"0\"/>", "<vertex x=\"0\" y=\"0\" z=\"10.125\"/>" };
+    mesh.triangles = { "<triangle v1=\"0\" v2=\"2\" v3=\"1\"/>", "<triangle v1=\"0\" v2=\"1\" v3=\"3\"/>",
+                       "<triangle v1=\"0\" v2=\"3\" v3=\"2\"/>", "<triangle v1=\"1\" v2=\"2\" v3=\"3\"/>" };
+    return mesh;
+}
+
+SCENARIO("Parallel parsing of the 3mf mesh elements matches the XML parser", "[3mf]") {
+    GIVEN("a tetrahedron") {
+        const MeshXML mesh = tetrahedron_xml();
+        Model model, model_xml_parser;
+        REQUIRE(load_3mf_model_xml(mesh.xml(), model));
+        REQUIRE(load_3mf_model_xml(mesh.with_xml_parser().xml(), model_xml_parser));
+        THEN("the meshes match") {
+            REQUIRE(model.objects.size() == 1);
+            REQUIRE(model.objects.front()->volumes.front()->mesh().its.indices.size() == 4);
+            REQUIRE(models_equal(model, model_xml_parser));
+        }
+    }
+    GIVEN("entity references in the attribute values of a vertex") {
+        MeshXML mesh_entities = tetrahedron_xml();
+        mesh_entities.vertices[1] = "<vertex x=\"10&#46;5\" y=\"&#48;\" z=\"0\"/>";
+        Model model, model_entities;
+        REQUIRE(load_3mf_model_xml(tetrahedron_xml().xml(), model));
+        REQUIRE(load_3mf_model_xml(mesh_entities.xml(), model_entities));
+        THEN("the vertices are left to the XML parser and the meshes match") {
+            REQUIRE(models_equal(model, model_entities));
+        }
+    }
+    GIVEN("CDATA and comments inside the mesh elements") {
+        MeshXML mesh_cdata = tetrahedron_xml();
+        mesh_cdata.vertices_prefix  = "<![CDATA[ ]]>";
+        mesh_cdata.triangles_prefix = "<!-- comment -->";
+        Model model, model_cdata;
+        REQUIRE(load_3mf_model_xml(tetrahedron_xml().xml(), model));
+        REQUIRE(load_3mf_model_xml(mesh_cdata.xml(), model_cdata));
+        THEN("the model is left to the XML parser and the meshes match") {
+            REQUIRE(models_equal(model, model_cdata));
+        }
+    }
+    GIVEN("a mesh larger than a single chunk of 1 MB") {
+        // A wavy sheet of n x n vertices.
+        const int n = 200;
+        MeshXML mesh;
+        char buf[256];
+        for (int j = 0; j < n; ++ j)
+            for (int i = 0; i < n; ++ i) {
+                sprintf(buf, "<vertex x=\"%.3f\" y=\"%.3f\" z=\"%.4f\"/>", 0.5 * i, 0.5 * j, std::sin(0.1 * i) * std::cos(0.1 * j));
+                mesh.vertices.emplace_back(buf);
+            }
+        for (int j = 0; j + 1 < n; ++ j)
+            for (int i = 0; i + 1 < n; ++ i) {
+                const int v = j * n + i;
+                sprintf(buf, "<triangle v1=\"%d\" v2=\"%d\" v3=\"%d\"/>", v, v + 1, v + n + 1);
+                mesh.triangles.emplace_back(buf);
+                sprintf(buf, "<triangle v1=\"%d\" v2=\"%d\" v3=\"%d\"/>", v, v + n + 1, v + n);
+                mesh.triangles.emplace_back(buf);
+            }
+        const std::string xml = mesh.xml();
+        REQUIRE(xml.size() > 2 * 1024 * 1024);
+        Model model, model_xml_parser;
+        REQUIRE(load_3mf_model_xml(xml, model));
+        REQUIRE(load_3mf_model_xml(mesh.with_xml_parser().xml(), model_xml_parser));
+        THEN("the chunks are merged in order and the meshes match") {
+            REQUIRE(model.objects.front()->volumes.front()->mesh().its.indices.size() == size_t(2 * (n - 1) * (n - 1)));
+            REQUIRE(models_equal(model, model_xml_parser));
+        }
+    }
+    GIVEN("triangles with painted supports, seam and multi-material segmentation") {
+        MeshXML mesh = tetrahedron_xml();
+        mesh.triangles[0] = "<triangle v1=\"0\" v2=\"2\" v3=\"1\" slic3rpe:custom_supports=\"4\"/>";
+        mesh.triangles[1] = "<triangle v1=\"0\" v2=\"1\" v3=\"3\" slic3rpe:custom_seam=\"8\"/>";
+        mesh.triangles[2] = "<triangle v1=\"0\" v2=\"3\" v3=\"2\" slic3rpe:mmu_segmentation=\"8\" slic3rpe:custom_supports=\"8\"/>";
+        Model model, model_xml_parser;
+        REQUIRE(load_3mf_model_xml(mesh.xml(), model));
+        REQUIRE(load_3mf_model_xml(mesh.with_xml_parser().xml(), model_xml_parser));
+        THEN("the painting matches") {
+            const ModelVolume &volume = *model.objects.front()->volumes.front();
+            REQUIRE(! volume.supported_facets.empty());
+            REQUIRE(! volume.seam_facets.empty());
+            REQUIRE(! volume.mmu_segmentation_facets.empty());
+            REQUIRE(models_equal(model, model_xml_parser));
+        }
+    }
+}
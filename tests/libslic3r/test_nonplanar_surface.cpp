@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+#include <test_utils.hpp>
+
+#include <libslic3r/NonplanarSurface.hpp>
+#include <libslic3r/TriangleMesh.hpp>
+
+using namespace Slic3r;
+
+// Height field of n x n cells of the size cell_size, starting at (x0, 0), gently waving in Z.
+static indexed_triangle_set make_wave_grid(int n, float x0, float cell_size)
+{
+    indexed_triangle_set its;
+    for (int j = 0; j <= n; ++ j)
+        for (int i = 0; i <= n; ++ i)
+            its.vertices.emplace_back(x0 + i * cell_size, j * cell_size, 1.f + 0.2f * std::sin(0.1f * float(i + j)));
+    auto vertex_id = [n](int i, int j) { return j * (n + 1) + i; };
+    for (int j = 0; j < n; ++ j)
+        for (int i = 0; i < n; ++ i) {
+            its.indices.emplace_back(vertex_id(i, j), vertex_id(i + 1, j), vertex_id(i + 1, j + 1));
+            its.indices.emplace_back(vertex_id(i, j), vertex_id(i + 1, j + 1), vertex_id(i, j + 1));
+        }
+    return its;
+}
+
+static std::vector<int> all_facets(const NonplanarMesh &mesh)
+{
+    std::vector<int> facets(mesh.facets_count());
+    std::iota(facets.begin(), facets.end(), 0);
+    return facets;
+}
+
+TEST_CASE("Nonplanar surfaces are grouped by edge connectivity", "[NonplanarSurface]")
+{
+    indexed_triangle_set its = make_wave_grid(10, 0.f, 1.f);
+    its_merge(its, make_wave_grid(5, 20.f, 1.f));
+    auto mesh = std::make_shared<const NonplanarMesh>(std::make_shared<const TriangleMesh>(std::move(its)), -1.f);
+
+    NonplanarSurfaces surfaces = NonplanarSurface::group_surfaces(mesh, all_facets(*mesh));
+
+    REQUIRE(surfaces.size() == 2);
+    // The surface containing the first facet is returned last.
+    REQUIRE(surfaces.back()->facets.size() == 200);
+    REQUIRE(surfaces.back()->facets.front() == 0);
+    REQUIRE(surfaces.front()->facets.size() == 50);
+    REQUIRE(std::is_sorted(surfaces.front()->facets.begin(), surfaces.front()->facets.end()));
+    // Both surfaces share the same mesh.
+    REQUIRE(surfaces.front()->mesh == surfaces.back()->mesh);
+    // Mesh is shifted down by z_offset.
+    REQUIRE(surfaces.back()->stats.min.z == Approx(0.f));
+    REQUIRE(surfaces.back()->stats.max.x == Approx(10.f));
+    REQUIRE(surfaces.front()->stats.min.x == Approx(20.f));
+}
+
+TEST_CASE("Large connected nonplanar surface is grouped without recursion", "[NonplanarSurface]")
+{
+    auto mesh = std::make_shared<const NonplanarMesh>(std::make_shared<const TriangleMesh>(make_wave_grid(300, 0.f, 0.1f)), 0.f);
+    NonplanarSurfaces surfaces = NonplanarSurface::group_surfaces(mesh, all_facets(*mesh));
+    REQUIRE(surfaces.size() == 1);
+    REQUIRE(surfaces.front()->facets.size() == 2 * 300 * 300);
+}
+
+TEST_CASE("Nonplanar surface facet queries", "[NonplanarSurface]")
+{
+    auto mesh = std::make_shared<const NonplanarMesh>(std::make_shared<const TriangleMesh>(make_wave_grid(20, 0.f, 1.f)), 0.f);
+    // Skip every other row of cells, the facets of the remaining rows are not edge connected.
+    std::vector<int> facets;
+    for (int facet_id : all_facets(*mesh))
+        if ((facet_id / 40) % 2 == 0)
+            facets.emplace_back(facet_id);
+    NonplanarSurfaces surfaces = NonplanarSurface::group_surfaces(mesh, facets);
+    REQUIRE(surfaces.size() == 10);
+
+    // The lowest row of cells.
+    const NonplanarSurface &surface = *surfaces.back();
+    std::vector<int> at = surface.facets_at(Vec2f(3.7f, 0.2f));
+    // Bounding boxes of both triangles of the cell contain the point.
+    REQUIRE(at == std::vector<int>{ 6, 7 });
+    REQUIRE(surface.facets_at(Vec2f(3.7f, 1.5f)).empty());
+
+    std::vector<int> in_box = surface.facets_in_box(Vec2f(3.5f, 0.2f), Vec2f(5.5f, 0.4f));
+    REQUIRE(in_box == std::vector<int>{ 6, 7, 8, 9, 10, 11 });
+}
@@ -304,3 +304,45 @@ SCENARIO("Placeholder parser variables", "[PlaceholderParser]") {
     }
     SECTION("if else completely empty") { REQUIRE(parser.process("{if false then elsif false then else endif}", 0, nullptr, nullptr, nullptr) == ""); }
 }
+
+SCENARIO("Placeholder parser compiled programs", "[PlaceholderParser]") {
+    PlaceholderParser parser;
+    auto              config = DynamicPrintConfig::full_print_config();
+    config.set_deserialize_strict({ { "nozzle_diameter", "0.6,0.6,0.6,0.6" }, { "temperature", "357,359,363,378" } });
+    parser.apply_config(config);
+    parser.set("foo", 0);
+    parser.set("bar", 2);
+
+    auto interpret = [&parser](const std::string &templ) { return parser.interpret(templ, 0, nullptr, nullptr, nullptr); };
+
+    SECTION("text and variable references") {
+        std::string templ = ";LAYER [foo]\n;Z:{bar}\nM104 S{temperature[1]} [temperature_[foo]] {temperature[ 2 ]}";
+        REQUIRE(parser.process(templ) == interpret(templ));
+        REQUIRE(parser.process(templ) == ";LAYER 0\n;Z:2\nM104 S359 357 363");
+    }
+    SECTION("if spanning multiple blocks") {
+        std::string templ = "{if bar == 2}two [foo]{if foo == 0} zero{endif}{else}other{endif} {bar}";
+        REQUIRE(parser.process(templ) == interpret(templ));
+        REQUIRE(parser.process(templ) == "two 0 zero 2");
+    }
+    SECTION("braces inside string literals and regular expressions") {
+        std::string templ = "{if \"a}b\" =~ /.*}.*/}match{endif} {\"c}\"}";
+        REQUIRE(parser.process(templ) == "match c}");
+    }
+    SECTION("leading white spaces are dropped") { REQUIRE(parser.process(" \n {bar} ") == interpret(" \n {bar} ")); }
+    SECTION("local variables are shared by the blocks") { REQUIRE(parser.process("{local a = 5}{a}{a + 1}") == "56"); }
+    SECTION("compiled program is reused") {
+        PlaceholderParser::ProgramPtr program = PlaceholderParser::compile("Z{bar}");
+        REQUIRE(parser.process(*program, 0, nullptr, nullptr, nullptr) == "Z2");
+        parser.set("bar", 3);
+        REQUIRE(parser.process(*program, 0, nullptr, nullptr, nullptr) == "Z3");
+    }
+    SECTION("errors are reported relative to the whole template") {
+        std::string templ = "G1\n{bar}\n{nonexistent}";
+        std::string error_compiled, error_interpreted;
+        try { parser.process(templ); } catch (const std::exception &ex) { error_compiled = ex.what(); }
+        try { interpret(templ); } catch (const std::exception &ex) { error_interpreted = ex.what(); }
+        REQUIRE(! error_compiled.empty());
+        REQUIRE(error_compiled == error_interpreted);
+    }
+}
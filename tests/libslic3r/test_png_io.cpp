@@ -53,3 +53,29 @@ TEST_CASE("PNG read", "[PNG]") {
         REQUIRE(sum == rstsum);
     }
 }
+
+TEST_CASE("Fast PNG encoder output decodes to the original raster", "[PNG]") {
+    auto rst = create_raster({320, 240});
+    rst.draw(ExPolygon{make_circle(scaled(60.), scaled(0.1))});
+
+    auto enc_rst = rst.encode(sla::FastPNGRasterEncoder{});
+    REQUIRE(enc_rst.extension() == "png");
+    REQUIRE(Slic3r::png::is_png({enc_rst.data(), enc_rst.size()}));
+
+    png::ImageGreyscale img;
+    REQUIRE(png::decode_png({enc_rst.data(), enc_rst.size()}, img));
+
+    REQUIRE(img.rows == rst.resolution().height_px);
+    REQUIRE(img.cols == rst.resolution().width_px);
+
+    size_t mismatches = 0, lit = 0;
+    for (size_t r = 0; r < img.rows; ++r)
+        for (size_t c = 0; c < img.cols; ++c) {
+            uint8_t px = rst.read_pixel(c, r);
+            lit += px > 0;
+            mismatches += img.get(r, c) != px;
+        }
+
+    REQUIRE(lit > 0);
+    REQUIRE(mismatches == 0);
+}
@@ -26,3 +26,71 @@ SCENARIO("Simplify polyline", "[Polyline]")
         }
     }
 }
+
+SCENARIO("Nonplanar polyline keeps its Z coordinates", "[Polyline]")
+{
+    GIVEN("polyline rising along X") {
+        auto polyline = Polyline{ {0,0}, {100,0}, {200,0} };
+        polyline.z = { 0, 100, 200 };
+        WHEN("reversed") {
+            polyline.reverse();
+            THEN("Z is reversed together with the points") {
+                REQUIRE(polyline.z == std::vector<coord_t>{ 200, 100, 0 });
+            }
+        }
+        WHEN("clipped at the end") {
+            polyline.clip_end(50.);
+            THEN("Z of the new end point is interpolated") {
+                REQUIRE(polyline.points.back() == Point(150, 0));
+                REQUIRE(polyline.z == std::vector<coord_t>{ 0, 100, 150 });
+            }
+        }
+        WHEN("split in the middle of a segment") {
+            Polyline p1, p2;
+            polyline.split_at({ 50, 0 }, &p1, &p2);
+            THEN("both parts share the interpolated Z of the split point") {
+                REQUIRE(p1.z == std::vector<coord_t>{ 0, 50 });
+                REQUIRE(p2.z == std::vector<coord_t>{ 50, 100, 200 });
+            }
+        }
+        WHEN("simplified") {
+            polyline.simplify(10.);
+            THEN("it is not simplified as it is not planar") {
+                REQUIRE(polyline.size() == 3);
+                REQUIRE(polyline.z.size() == 3);
+            }
+        }
+        WHEN("mixing points at the Z of the layer with points at a single other Z") {
+            polyline = Polyline{ {0,0}, {100,50}, {200,100}, {300,50}, {400,0} };
+            polyline.z = { -1, 100, 100, 100, -1 };
+            polyline.simplify(10.);
+            THEN("it is simplified and the retained points keep their Z") {
+                REQUIRE(polyline.points == Points{ {0,0}, {200,100}, {400,0} });
+                REQUIRE(polyline.z == std::vector<coord_t>{ -1, 100, -1 });
+            }
+        }
+        WHEN("a planar polyline is appended") {
+            polyline.append(Polyline{ {200,0}, {300,0} });
+            THEN("its points are placed at the Z of the layer") {
+                REQUIRE(polyline.z == std::vector<coord_t>{ 0, 100, 200, -1, -1 });
+            }
+        }
+        WHEN("a duplicate point is removed") {
+            polyline = Polyline{ {0,0}, {100,0}, {100,0}, {100,0}, {200,0} };
+            polyline.z = { 0, 100, 100, 150, 200 };
+            bool removed = polyline.remove_duplicate_points();
+            THEN("its Z is removed with it and a point at another Z is kept") {
+                REQUIRE(removed);
+                REQUIRE(polyline.points == Points{ {0,0}, {100,0}, {100,0}, {200,0} });
+                REQUIRE(polyline.z == std::vector<coord_t>{ 0, 100, 150, 200 });
+            }
+        }
+        WHEN("cleared") {
+            polyline.clear();
+            THEN("Z is cleared together with the points") {
+                REQUIRE(polyline.empty());
+                REQUIRE(! polyline.has_z());
+            }
+        }
+    }
+}
@@ -2,6 +2,10 @@
 
 #include "libslic3r/Model.hpp"
 #include "libslic3r/Format/STL.hpp"
+#include "libslic3r/TriangleMesh.hpp"
+
+#include <array>
+#include <limits>
 
 using namespace Slic3r;
 
@@ -35,8 +39,7 @@ SCENARIO("Reading an STL file", "[stl]") {
 				REQUIRE(is_approx(model.objects.front()->volumes.front()->mesh().size(), Vec3d(20, 20, 20)));
 			}
 		}
-#if 0
-		// ASCII STLs ending with just carriage returns are not supported. These were used by the old Macs, while the Unix based MacOS uses LFs as any other Unix.
+		// ASCII STLs ending with just carriage returns were used by the old Macs, while the Unix based MacOS uses LFs as any other Unix.
 		WHEN("line endings CR") {
 			Slic3r::Model model;
 			THEN("load should succeed") {
@@ -44,8 +47,6 @@ SCENARIO("Reading an STL file", "[stl]") {
 				REQUIRE(is_approx(model.objects.front()->volumes.front()->mesh().size(), Vec3d(20, 20, 20)));
 			}
 		}
-
-#endif
 		WHEN("nonstandard STL file (text after ending tags, invalid normals, for example infinities)") {
 			Slic3r::Model model;
 			THEN("load should succeed") {
@@ -54,4 +55,41 @@ SCENARIO("Reading an STL file", "[stl]") {
 			}
 		}
 	}
+	GIVEN("a binary STL file read without repair") {
+		TriangleMesh mesh;
+		REQUIRE(mesh.ReadSTLFile(stl_path("Geräte/20mmbox-čřšřěá.stl").c_str(), false));
+		THEN("the corners of the facets are merged into shared vertices") {
+			REQUIRE(mesh.its.indices.size() == 12);
+			REQUIRE(mesh.its.vertices.size() == 8);
+			REQUIRE(is_approx(mesh.size(), Vec3d(20, 20, 20)));
+		}
+	}
+}
+
+static void stl_add_tetrahedron(stl_file &stl, const stl_vertex &origin)
+{
+	const stl_vertex p[4] = { origin, origin + stl_vertex(1, 0, 0), origin + stl_vertex(0, 1, 0), origin + stl_vertex(0, 0, 1) };
+	for (const std::array<int, 3> &f : { std::array<int, 3>{ 0, 2, 1 }, { 0, 1, 3 }, { 0, 3, 2 }, { 1, 2, 3 } }) {
+		stl_facet facet;
+		facet.normal = stl_normal::Zero();
+		for (int i = 0; i < 3; ++ i)
+			facet.vertex[i] = p[f[i]];
+		facet.extra[0] = facet.extra[1] = 0;
+		stl.facet_start.emplace_back(facet);
+		stl.neighbors_start.emplace_back();
+		++ stl.stats.number_of_facets;
+	}
+}
+
+SCENARIO("Generating shared vertices of a mesh without repair", "[stl]") {
+	GIVEN("a facet corner with a NaN coordinate") {
+		stl_file stl;
+		stl_add_tetrahedron(stl, stl_vertex(0, 0, 0));
+		stl.facet_start[3].vertex[2] = stl_vertex(std::numeric_limits<float>::quiet_NaN(), 0, 1);
+		indexed_triangle_set its;
+		stl_generate_shared_vertices_exact(&stl, its);
+		THEN("the corner is welded into a vertex of its own") {
+			REQUIRE(its.vertices.size() == 5);
+		}
+	}
 }
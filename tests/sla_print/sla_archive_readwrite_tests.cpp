@@ -68,3 +68,80 @@ TEST_CASE("Archive export test", "[sla_archives]") {
         }
     }
 }
+
+TEST_CASE("Archive export with layers streamed while rasterizing", "[sla_archives]") {
+    auto registry = registered_sla_archives();
+
+    for (const ArchiveEntry &entry : registry) {
+        if (std::string(entry.id) != "SL1" && std::string(entry.id) != "SL1SVG")
+            continue;
+
+        INFO(std::string("Testing archive type: ") + entry.id);
+        SLAPrint print;
+        SLAFullPrintConfig fullcfg;
+
+        auto m = Model::read_from_file(TEST_DATA_DIR PATH_SEPARATOR + std::string("20mm_cube.obj"), nullptr);
+
+        fullcfg.printer_technology.setInt(ptSLA);
+        fullcfg.set("sla_archive_format", entry.id);
+        fullcfg.set("supports_enable", false);
+        fullcfg.set("pad_enable", false);
+
+        DynamicPrintConfig cfg;
+        cfg.apply(fullcfg);
+
+        auto outputfname = std::string("output_streamed.") + entry.ext;
+        print.set_status_callback([](const PrintBase::SlicingStatus&) {});
+        print.set_export_stream(outputfname, "20mm_cube");
+        print.apply(m, cfg);
+        print.process();
+
+        // The layers are being written into a temporary file until the export completes the archive.
+        REQUIRE(boost::filesystem::exists(outputfname + ".tmp"));
+
+        ThumbnailsList thumbnails;
+        print.export_print(outputfname, thumbnails, "20mm_cube");
+
+        REQUIRE(boost::filesystem::exists(outputfname));
+        REQUIRE(! boost::filesystem::exists(outputfname + ".tmp"));
+
+        // Exporting again copies the completed archive.
+        auto outputfname2 = std::string("output_streamed2.") + entry.ext;
+        print.export_print(outputfname2, thumbnails, "20mm_cube");
+        REQUIRE(boost::filesystem::file_size(outputfname2) == boost::filesystem::file_size(outputfname));
+
+        indexed_triangle_set its;
+        DynamicPrintConfig   cfg_read;
+        import_sla_archive(outputfname, "", its, cfg_read);
+        REQUIRE(!its.empty());
+
+        double vol_written = m.mesh().volume();
+        double rel_err     = std::abs(vol_written - its_volume(its)) / vol_written;
+        REQUIRE(rel_err < 0.1);
+    }
+}
+
+TEST_CASE("Streamed archive is removed if it is not exported", "[sla_archives]") {
+    SLAFullPrintConfig fullcfg;
+    fullcfg.printer_technology.setInt(ptSLA);
+    fullcfg.set("sla_archive_format", "SL1");
+    fullcfg.set("supports_enable", false);
+    fullcfg.set("pad_enable", false);
+
+    DynamicPrintConfig cfg;
+    cfg.apply(fullcfg);
+
+    auto m = Model::read_from_file(TEST_DATA_DIR PATH_SEPARATOR + std::string("20mm_cube.obj"), nullptr);
+    auto outputfname = std::string("output_not_exported.sl1");
+    {
+        SLAPrint print;
+        print.set_status_callback([](const PrintBase::SlicingStatus&) {});
+        print.set_export_stream(outputfname, "20mm_cube");
+        print.apply(m, cfg);
+        print.process();
+        REQUIRE(boost::filesystem::exists(outputfname + ".tmp"));
+    }
+
+    REQUIRE(! boost::filesystem::exists(outputfname + ".tmp"));
+    REQUIRE(! boost::filesystem::exists(outputfname));
+}